@@ -57,6 +57,20 @@ typedef enum pers_lldb_purpose_e_
 sint_t pers_lldb_open(str_t const * dbPathname, pers_lldb_purpose_e ePurpose, bool_t bForceCreationIfNotPresent) ;
 
 
+/**
+ * @brief open or create a key-value database with a maximum value size
+ * @note : the maximum value size is stored when the DB is created, an existing DB keeps its maximum value size
+ *
+ * @param dbPathname                    [in] absolute path to DB
+ * @param ePurpose                      [in] see pers_lldb_purpose_e
+ * @param bForceCreationIfNotPresent    [in] if true, the DB is created if it does not exist
+ * @param maxValueSize                  [in] maximum size of a key's data in a created DB
+ *
+ * @return >=0 for success, negative value otherway (see pers_error_codes.h)
+ */
+sint_t pers_lldb_open_with_max_value_size(str_t const * dbPathname, pers_lldb_purpose_e ePurpose, bool_t bForceCreationIfNotPresent, sint_t maxValueSize) ;
+
+
 /**
  * @brief write a key-value pair into database
  * @note : DB type is identified from dbPathname (based on extension)
@@ -82,6 +96,22 @@ sint_t pers_lldb_close(sint_t handlerDB) ;
  */
 sint_t pers_lldb_write_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * key, str_t const * data, sint_t dataSize) ;
 
+/**
+ * @brief write several key-value pairs into database with one lock of the database
+ * @note : no key is written if one of the parameters is invalid, in write through mode the database is synced once for all keys.
+ *          If writing a key fails, the keys before it are written and their number is returned (keys[returned value] failed).
+ *
+ * @param handlerDB     [in] handler obtained with pers_lldb_open
+ * @param ePurpose      [in] see pers_lldb_purpose_e
+ * @param keys          [in] keys' names
+ * @param data          [in] buffers with keys' data
+ * @param dataSizes     [in] sizes of keys' data
+ * @param count         [in] number of keys
+ *
+ * @return number of written keys (less than count if writing a key failed), or negative value if no key was written (see pers_error_codes.h)
+ */
+sint_t pers_lldb_write_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, str_t const * const * data, sint_t const * dataSizes, sint_t count) ;
+
 
 /**
  * @brief read a key's value from database
@@ -97,6 +127,47 @@ sint_t pers_lldb_write_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
  */
 sint_t pers_lldb_read_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * key, pstr_t dataBuffer_out, sint_t bufSize) ;
 
+/**
+ * @brief read the values of several keys from database with one lock of the database
+ * @note : a key which is not found or does not fit into its buffer does not fail the other keys
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param keys              [in] keys' names
+ * @param dataBuffers_out   [out]buffers where to return the read data
+ * @param bufSizes          [in] sizes of dataBuffers_out
+ * @param results_out       [out]read size, or negative value (see pers_error_codes.h) of every key
+ * @param count             [in] number of keys
+ *
+ * @return number of keys read, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, pstr_t const * dataBuffers_out, sint_t const * bufSizes,
+                           sint_t * results_out, sint_t count) ;
+
+/**
+ * @brief return a read-only view of a key's value without copying it
+ * @note : the view stays valid until it is released with pers_lldb_release_view
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param key               [in] key's name
+ * @param data_out          [out]returns the address of the value
+ *
+ * @return size of the value, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_key_view(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * key, void const ** data_out) ;
+
+/**
+ * @brief release a view returned by pers_lldb_read_key_view
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param data              [in] address returned by pers_lldb_read_key_view
+ *
+ * @return 0 for success, negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_release_view(sint_t handlerDB, pers_lldb_purpose_e ePurpose, void const * data) ;
+
 /**
  * @brief read a key's value from database
  * @note : DB type is identified from dbPathname (based on extension)
@@ -124,6 +195,7 @@ sint_t pers_lldb_delete_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_
 /**
  * @brief Find the buffer's size needed to accomodate the listing of keys' names in database
  * @note : DB type is identified from dbPathname (based on extension)
+ * @note : the first call lists all keys (O(n)), the size is then updated by every write and delete
  *
  * @param handlerDB         [in] handler obtained with pers_lldb_open
  * @param ePurpose          [in] see pers_lldb_purpose_e
@@ -148,6 +220,67 @@ sint_t pers_lldb_get_size_keys_list(sint_t handlerDB, pers_lldb_purpose_e ePurpo
  sint_t pers_lldb_get_keys_list(sint_t handlerDB, pers_lldb_purpose_e ePurpose, pstr_t listingBuffer_out, sint_t bufSize) ;
 
 
+/**
+ * @brief Open the key cursor of a handle
+ * @note : every handle has one cursor, opening it again restarts the listing
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param prefix            [in] only keys starting with prefix are returned, NIL for all keys
+ *
+ * @return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_iter_open(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * prefix) ;
+
+
+/**
+ * @brief Return the next key of the cursor opened with pers_lldb_iter_open
+ * @note : if keyBuffer_out is too small, PERS_COM_ERR_BUFFER_TOO_SMALL is returned and the cursor stays at the key
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param keyBuffer_out     [out]buffer where to return the key (null terminated)
+ * @param bufSize           [in] size of keyBuffer_out
+ *
+ * @return length of the key, 0 if all keys were returned, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_iter_next(sint_t handlerDB, pers_lldb_purpose_e ePurpose, pstr_t keyBuffer_out, sint_t bufSize) ;
+
+
+/**
+ * @brief Close the key cursor of a handle
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ *
+ * @return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_iter_close(sint_t handlerDB, pers_lldb_purpose_e ePurpose) ;
+
+
+/**
+ * @brief Compact the database file: the data of all keys is moved to the start of the file and the file is truncated
+ * @note : can be called while the database is opened by other processes
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ *
+ * @return number of bytes the file was reduced by, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_compact(sint_t handlerDB, pers_lldb_purpose_e ePurpose) ;
+
+
+/**
+ * @brief Get the maximum size of a key's data in the database
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ *
+ * @return maximum size, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_get_max_value_size(sint_t handlerDB, pers_lldb_purpose_e ePurpose) ;
+
+
 
 #ifdef __cplusplus
 }
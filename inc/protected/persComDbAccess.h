@@ -39,7 +39,7 @@ extern "C"
 /** \defgroup PERS_DB_ACCESS_IF_VERSION Interface version
  *  \{
  */
-#define PERS_COM_DB_ACCESS_INTERFACE_VERSION  (0x05000000U)
+#define PERS_COM_DB_ACCESS_INTERFACE_VERSION  (0x05020000U)
 /** \} */ 
 
 
@@ -49,7 +49,8 @@ extern "C"
  */
 /* maximum data size for a key type resourceID */
 #define PERS_DB_MAX_LENGTH_KEY_NAME 128   /**< Max. length of the key identifier */
-#define PERS_DB_MAX_SIZE_KEY_DATA   8028  /**< Max. size of the key entry (slot definition) */
+#define PERS_DB_MAX_SIZE_KEY_DATA   8028  /**< Max. size of the key entry (slot definition) of a DB created with persComDbOpen */
+#define PERS_DB_MAX_SIZE_KEY_DATA_LIMIT (4 * 1024 * 1024)  /**< Upper limit for the max. size of the key entry of a DB created with persComDbOpenWithMaxValueSize */
 /** \} */
 
 
@@ -68,14 +69,36 @@ int persComDbgetMaxKeyValueSize(void);
 /**
  * \brief Obtain a handler to DB indicated by dbPathname
  * \note : DB is created if it does not exist and (bForceCreationIfNotPresent != 0)
+ * \note : a frozen image of read-only data (built offline with pers_frozen_db_builder) is detected and opened read only
  *
  * \param dbPathname    [in] absolute path to database (length limited to \ref PERS_ORG_MAX_LENGTH_PATH_FILENAME)
- * \param bOption       [in] bitfield option: 0x01: create if not exists, 0x02: write through, 0x04: read only
+ * \param bOption       [in] bitfield option: 0x01: create if not exists, 0x02: write through, 0x04: read only, 0x08: compress values
  * \Remarks the support of the option depends from backend database realisation
  * \return >= 0 for valid handler, negative value for error (\ref PERS_COM_ERROR_CODES_DEFINES)
  */
 signed int persComDbOpen(char const * dbPathname, unsigned char bOption);
 
+/**
+ * \brief Obtain a handler to DB indicated by dbPathname, a created DB supports keys with a data size up to maxValueSize
+ * \note : the max. size is stored in the DB when it is created, an existing DB keeps the max. size it was created with
+ * \note : data larger than \ref PERS_DB_MAX_SIZE_KEY_DATA is not cached, it is written directly to the DB file
+ *
+ * \param dbPathname    [in] absolute path to database (length limited to \ref PERS_ORG_MAX_LENGTH_PATH_FILENAME)
+ * \param bOption       [in] bitfield option: 0x01: create if not exists, 0x02: write through, 0x04: read only, 0x08: compress values
+ * \param maxValueSize  [in] max. size of key's data in a created DB (limited to \ref PERS_DB_MAX_SIZE_KEY_DATA_LIMIT)
+ * \return >= 0 for valid handler, negative value for error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbOpenWithMaxValueSize(char const * dbPathname, unsigned char bOption, signed int maxValueSize);
+
+/**
+ * \brief returns the max key data size supported by an opened database
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ *
+ * \return max size in byte, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbGetMaxValueSize(signed int handlerDB);
+
 /**
  * \brief Close handler to DB
  *
@@ -91,12 +114,29 @@ signed int persComDbClose(signed int handlerDB) ;
  * \param handlerDB     [in] handler obtained with persComDbOpen
  * \param key           [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
  * \param data          [in] buffer with key's data
- * \param dataSize      [in] size of key's data (max allowed \ref PERS_DB_MAX_SIZE_KEY_DATA)
+ * \param dataSize      [in] size of key's data (max allowed \ref persComDbGetMaxValueSize)
  *
  * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
  */
 signed int persComDbWriteKey(signed int handlerDB, char const * key, char const * data, signed int dataSize) ;
 
+/**
+ * \brief write several key-value pairs into local/shared database at once
+ * \note : the database is locked once for all keys, in write through mode the data is synced once after the last key.
+ *          No key is written if one of the parameters is invalid. If writing a key fails, the keys before it are written
+ *          and their number is returned: keys[returned value] is the key which failed.
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param keys          [in] keys' names (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param data          [in] buffers with keys' data
+ * \param dataSizes     [in] sizes of keys' data (max allowed \ref persComDbGetMaxValueSize)
+ * \param count         [in] number of keys
+ *
+ * \return number of written keys (less than count if writing a key failed), or negative value if no key was written
+ *         (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbWriteKeys(signed int handlerDB, char const * const * keys, char const * const * data, signed int const * dataSizes, signed int count) ;
+
 
 /**
  * \brief read a key's value from local/shared database
@@ -110,6 +150,50 @@ signed int persComDbWriteKey(signed int handlerDB, char const * key, char const
  */
 signed int persComDbReadKey(signed int handlerDB, char const * key, char* dataBuffer_out, signed int dataBufferSize) ;
 
+/**
+ * \brief read the values of several keys from local/shared database at once
+ * \note : the database is locked once for all keys. A key which is not found or does not fit into its buffer
+ *          does not fail the other keys, the result of every key is returned in results_out.
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param keys              [in] keys' names (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param dataBuffers_out   [out]buffers where to return the read data
+ * \param bufferSizes       [in] sizes of dataBuffers_out
+ * \param results_out       [out]read size of every key, or PERS_COM_ERR_NOT_FOUND, PERS_COM_ERR_BUFFER_TOO_SMALL or another negative value
+ * \param count             [in] number of keys
+ *
+ * \return number of keys read, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReadKeys(signed int handlerDB, char const * const * keys, char * const * dataBuffers_out, signed int const * bufferSizes,
+                             signed int * results_out, signed int count) ;
+
+/**
+ * \brief return a read-only view of a key's value in local/shared database without copying it
+ * \note : the value stored in the database file or a frozen image is not copied, the view points into the mapped file.
+ *          The value stays unchanged until the view is released with \ref persComDbReleaseView, even if the key is written
+ *          or deleted meanwhile. Views must be released before the database is closed, the database is not compacted
+ *          while views of any running process are pending (the views of a process which ended are released).
+ *          Cached (not yet written back) and small values and values read while the views of all processes
+ *          pin the maximum number of values are returned as copy.
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param key               [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param data_out          [out]returns the address of the value (must not be modified)
+ *
+ * \return size of the value, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReadKeyView(signed int handlerDB, char const * key, void const ** data_out) ;
+
+/**
+ * \brief release a view returned by persComDbReadKeyView
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param data              [in] address returned by persComDbReadKeyView
+ *
+ * \return 0 for success, negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReleaseView(signed int handlerDB, void const * data) ;
+
 /**
  * \brief read a key's value from local/shared database
  *
@@ -133,6 +217,8 @@ signed int persComDbDeleteKey(signed int handlerDB, char const * key) ;
 
 /**
  * \brief Find the buffer's size needed to accomodate the list of keys' names in local/shared database
+ * \note : the first call after the database was opened by the first process lists all keys, its cost grows
+ *          with the number of keys. Later calls return the size kept up to date by every write and delete.
  *
  * \param handlerDB     [in] handler obtained with persComDbOpen
  *
@@ -152,6 +238,56 @@ signed int persComDbGetSizeKeysList(signed int handlerDB) ;
  */
 signed int persComDbGetKeysList(signed int handlerDB, char* listBuffer_out, signed int listBufferSize) ;
 
+
+/**
+ * \brief Open a cursor which returns the keys' names in local/shared database one by one
+ * \note : unlike \ref persComDbGetKeysList no buffer for all keys is needed. Every handle has one cursor,
+ *          opening it again restarts the listing.
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param prefix        [in] only keys starting with prefix are returned, NULL for all keys
+ *
+ * \return 0 for success, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbIterOpen(signed int handlerDB, char const * prefix) ;
+
+
+/**
+ * \brief Obtain the next key's name of the cursor opened with persComDbIterOpen
+ * \note : keys written or deleted while the cursor is open may or may not be returned. Writing other keys
+ *          in write through mode does not make the cursor skip or repeat the unmodified keys.
+ *          If keyBuffer_out is too small the cursor stays at the key.
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param keyBuffer_out     [out]buffer where to return the key's name (null terminated)
+ * \param keyBufferSize     [in] size of keyBuffer_out (\ref PERS_DB_MAX_LENGTH_KEY_NAME is always enough)
+ *
+ * \return length of the key's name, 0 if all keys were returned, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbIterNext(signed int handlerDB, char* keyBuffer_out, signed int keyBufferSize) ;
+
+
+/**
+ * \brief Close the cursor opened with persComDbIterOpen
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ *
+ * \return 0 for success, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbIterClose(signed int handlerDB) ;
+
+
+/**
+ * \brief Compact a local/shared database
+ * \note : the space of deleted and overwritten keys is released and the database file is truncated,
+ *          the database can stay opened by other processes during the compaction
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ *
+ * \return >=0 for the number of bytes reclaimed, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbCompact(signed int handlerDB) ;
+
 /** \} */ /* End of PERS_DB_ACCESS_FUNCTIONS */
 
 
@@ -233,6 +233,26 @@ sint_t pers_lldb_open(str_t const * dbPathname, pers_lldb_purpose_e ePurpose, bo
     return returnValue ;
 }/*DG C7MR2R-ISQP Metric 10-SSW_PersCommon_0001*/ /*DG C7MR2R-ISQP Metric 6-SSW_PersCommon_1005*/
 
+/**
+ * \brief open or create a key-value database with a maximum value size
+ * \note : the records of the itzam backend hold PERS_DB_MAX_SIZE_KEY_DATA bytes, larger sizes are not supported
+ *
+ * \param dbPathname                    [in] absolute path to DB
+ * \param ePurpose                      [in] see pers_lldb_purpose_e
+ * \param bForceCreationIfNotPresent    [in] if true, the DB is created if it does not exist
+ * \param maxValueSize                  [in] maximum size of a key's data in a created DB
+ *
+ * \return >=0 for success, negative value otherway (see pers_error_codes.h)
+ */
+sint_t pers_lldb_open_with_max_value_size(str_t const * dbPathname, pers_lldb_purpose_e ePurpose, bool_t bForceCreationIfNotPresent, sint_t maxValueSize)
+{
+    if((PersLldbPurpose_DB == ePurpose) && (maxValueSize > PERS_DB_MAX_SIZE_KEY_DATA))
+    {
+        return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+    }
+    return pers_lldb_open(dbPathname, ePurpose, bForceCreationIfNotPresent) ;
+}
+
 
 /**
  * \brief write a key-value pair into database
@@ -342,6 +362,42 @@ sint_t pers_lldb_write_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
 }
 
 
+/**
+ * \brief write several key-value pairs into database
+ * \note : the keys are written one after the other, the btree has no batch insertion
+ *
+ * \param handlerDB     [in] handler obtained with pers_lldb_open
+ * \param ePurpose      [in] see pers_lldb_purpose_e
+ * \param keys          [in] keys' names
+ * \param data          [in] buffers with keys' data
+ * \param dataSizes     [in] sizes of keys' data
+ * \param count         [in] number of keys
+ *
+ * \return number of written keys, or negative value otherway (see pers_error_codes.h)
+ */
+sint_t pers_lldb_write_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, str_t const * const * data, sint_t const * dataSizes, sint_t count)
+{
+    sint_t eErrorCode = PERS_COM_SUCCESS ;
+    sint_t i = 0 ;
+
+    if((NIL == keys) || (NIL == data) || (NIL == dataSizes) || (count <= 0))
+    {
+        eErrorCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    for(i = 0; (eErrorCode >= 0) && (i < count); i++)
+    {
+        eErrorCode = pers_lldb_write_key(handlerDB, ePurpose, keys[i], data[i], dataSizes[i]) ;
+    }
+    /* keys[i - 1] failed: the keys before it are written */
+    if((eErrorCode < 0) && (i > 1))
+    {
+        eErrorCode = i - 1 ;
+    }
+
+    return (eErrorCode >= 0) ? i : eErrorCode ;
+}
+
+
 /**
  * \brief read a key's value from database
  * \note : DB type is identified from dbPathname (based on extension)
@@ -380,6 +436,106 @@ sint_t pers_lldb_read_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
     return eErrorCode ;
 }
 
+
+/**
+ * \brief read the values of several keys from database
+ * \note : the keys are read one after the other, a key which is not found does not fail the other keys
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param keys              [in] keys' names
+ * \param dataBuffers_out   [out]buffers where to return the read data
+ * \param bufSizes          [in] sizes of dataBuffers_out
+ * \param results_out       [out]read size, or negative value (see pers_error_codes.h) of every key
+ * \param count             [in] number of keys
+ *
+ * \return number of keys read, or negative value otherway (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, pstr_t const * dataBuffers_out, sint_t const * bufSizes,
+                           sint_t * results_out, sint_t count)
+{
+    sint_t eErrorCode = PERS_COM_SUCCESS ;
+    sint_t i = 0 ;
+
+    if((NIL == keys) || (NIL == dataBuffers_out) || (NIL == bufSizes) || (NIL == results_out) || (count <= 0))
+    {
+        eErrorCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    for(i = 0; (eErrorCode >= 0) && (i < count); i++)
+    {
+        results_out[i] = pers_lldb_read_key(handlerDB, ePurpose, keys[i], dataBuffers_out[i], bufSizes[i]) ;
+        if(results_out[i] > bufSizes[i])
+        {
+            results_out[i] = PERS_COM_ERR_BUFFER_TOO_SMALL ;
+        }
+        if(results_out[i] >= 0)
+        {
+            eErrorCode++ ;
+        }
+    }
+
+    return eErrorCode ;
+}
+
+/**
+ * \brief return a view of a key's value
+ * \note : the itzam records are not mapped, the view is a copy of the value freed by pers_lldb_release_view
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param key               [in] key's name
+ * \param data_out          [out]returns the address of the value
+ *
+ * \return size of the value, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_key_view(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * key, void const ** data_out)
+{
+    sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM ;
+    pstr_t copy = NIL ;
+
+    if((PersLldbPurpose_DB == ePurpose) && (NIL != key) && (NIL != data_out))
+    {
+        eErrorCode = pers_lldb_get_key_size(handlerDB, ePurpose, key) ;
+    }
+    if(eErrorCode >= 0)
+    {
+        copy = (pstr_t)malloc((eErrorCode > 0) ? (size_t)eErrorCode : 1) ;
+        if(NIL == copy)
+        {
+            return PERS_COM_ERR_MALLOC ;
+        }
+        eErrorCode = pers_lldb_read_key(handlerDB, ePurpose, key, copy, eErrorCode) ;
+        if(eErrorCode >= 0)
+        {
+            *data_out = copy ;
+        }
+        else
+        {
+            free(copy) ;
+        }
+    }
+    return eErrorCode ;
+}
+
+/**
+ * \brief releases a view returned by pers_lldb_read_key_view
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param data              [in] address returned by pers_lldb_read_key_view
+ *
+ * \return 0 for success, negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_release_view(sint_t handlerDB, pers_lldb_purpose_e ePurpose, void const * data)
+{
+    if((PersLldbPurpose_DB != ePurpose) || (NIL == data) || (handlerDB < 0))
+    {
+        return PERS_COM_ERR_INVALID_PARAM ;
+    }
+    free((void*)data) ;
+    return PERS_COM_SUCCESS ;
+}
+
 /**
  * \brief read a key's value from database
  * \note : DB type is identified from dbPathname (based on extension)
@@ -517,6 +673,100 @@ sint_t pers_lldb_get_size_keys_list(sint_t handlerDB, pers_lldb_purpose_e ePurpo
     return eErrorCode ;
 }
 
+/**
+ * \brief Open the key cursor of a handle
+ * \note : not supported by the itzam backend
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param prefix            [in] only keys starting with prefix are returned
+ *
+ * \return PERS_COM_ERR_OPERATION_NOT_SUPPORTED
+ */
+sint_t pers_lldb_iter_open(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * prefix)
+{
+    (void)handlerDB ;
+    (void)ePurpose ;
+    (void)prefix ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+/**
+ * \brief Return the next key of the cursor opened with pers_lldb_iter_open
+ * \note : not supported by the itzam backend
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param keyBuffer_out     [out]buffer where to return the key
+ * \param bufSize           [in] size of keyBuffer_out
+ *
+ * \return PERS_COM_ERR_OPERATION_NOT_SUPPORTED
+ */
+sint_t pers_lldb_iter_next(sint_t handlerDB, pers_lldb_purpose_e ePurpose, pstr_t keyBuffer_out, sint_t bufSize)
+{
+    (void)handlerDB ;
+    (void)ePurpose ;
+    (void)keyBuffer_out ;
+    (void)bufSize ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+/**
+ * \brief Close the key cursor of a handle
+ * \note : not supported by the itzam backend
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ *
+ * \return PERS_COM_ERR_OPERATION_NOT_SUPPORTED
+ */
+sint_t pers_lldb_iter_close(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+    (void)handlerDB ;
+    (void)ePurpose ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+/**
+ * \brief Compact the database file
+ * \note : not supported by the itzam backend
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ *
+ * \return PERS_COM_ERR_OPERATION_NOT_SUPPORTED
+ */
+sint_t pers_lldb_compact(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+    (void)handlerDB ;
+    (void)ePurpose ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+/**
+ * \brief Return the maximum size of a key's data
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ *
+ * \return maximum size, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_get_max_value_size(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+    lldb_handler_s* pLldbHandler = NIL ;
+
+    if((handlerDB >= 0) && lldb_handles_Lock())
+    {
+        pLldbHandler = lldb_handles_FindInUseHandle(handlerDB) ;
+        (void)lldb_handles_Unlock() ;
+    }
+    if(NIL == pLldbHandler)
+    {
+        return PERS_COM_ERR_INVALID_PARAM ;
+    }
+    return (PersLldbPurpose_RCT == ePurpose) ? (sint_t)sizeof(PersistenceConfigurationKey_s) : PERS_DB_MAX_SIZE_KEY_DATA ;
+}
+
 static sint_t DeleteDataFromItzamDB( sint_t dbHandler, pconststr_t key ) 
 {
     bool_t bCanContinue = true ;
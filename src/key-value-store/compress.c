@@ -0,0 +1,220 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * Copyright
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           compress.c
+ * @ingroup        Persistence key value store
+ * @brief          Value compression used by databases opened with the compression option
+ * @see
+ */
+
+/*
+ * The stream format is the one of LZF by Marc Lehmann:
+ * - control byte 000LLLLL: literal run of L + 1 bytes follows
+ * - control byte LLLOOOOO: back reference of L + 2 bytes (L < 7) at distance ((O << 8) | next byte) + 1
+ * - control byte 111OOOOO: back reference of next byte + 9 bytes at distance ((O << 8) | byte after next) + 1
+ */
+
+#include "compress.h"
+#include <string.h>
+
+
+#define COMPRESS_HASH_LOG      13
+#define COMPRESS_HASH_SIZE     (1 << COMPRESS_HASH_LOG)
+#define COMPRESS_MAX_LITERALS  (1 << 5)
+#define COMPRESS_MAX_DISTANCE  (1 << 13)
+#define COMPRESS_MIN_MATCH     3
+#define COMPRESS_MAX_MATCH     (7 + 255 + 2)
+
+
+static uint32_t compressHash(const uint8_t *p)
+{
+   uint32_t v = ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | (uint32_t) p[2];
+
+   return (v * 2654435761U) >> (32 - COMPRESS_HASH_LOG);
+}
+
+
+/* writes the pending literals in runs of up to COMPRESS_MAX_LITERALS bytes, returns NULL if they do not fit */
+static uint8_t* compressLiterals(uint8_t *op, const uint8_t *outEnd, const uint8_t *literals, uint32_t count)
+{
+   uint32_t run;
+
+   while (count > 0)
+   {
+      run = (count > COMPRESS_MAX_LITERALS) ? COMPRESS_MAX_LITERALS : count;
+      if ((size_t) (outEnd - op) < run + 1)
+      {
+         return NULL;
+      }
+      *op++ = (uint8_t) (run - 1);
+      memcpy(op, literals, run);
+      op += run;
+      literals += run;
+      count -= run;
+   }
+   return op;
+}
+
+
+uint32_t pcoCompress(const void *in, uint32_t inSize, void *out, uint32_t outSize)
+{
+   const uint8_t *ip = (const uint8_t*) in;
+   const uint8_t *inEnd = ip + inSize;
+   const uint8_t *literals = ip;
+   const uint8_t *ref;
+   uint8_t *op = (uint8_t*) out;
+   const uint8_t *outEnd = op + outSize;
+   uint32_t table[COMPRESS_HASH_SIZE]; /* position + 1 of the last occurrence of every hashed 3 byte sequence */
+   uint32_t distance;
+   uint32_t length;
+   uint32_t maxLength;
+   uint32_t h;
+
+   if (outSize < PERS_COM_COMPRESS_HEADER_SIZE)
+   {
+      return 0;
+   }
+   memcpy(op, &inSize, sizeof(inSize));
+   op += PERS_COM_COMPRESS_HEADER_SIZE;
+   memset(table, 0, sizeof(table));
+
+   while (inEnd - ip >= COMPRESS_MIN_MATCH)
+   {
+      h = compressHash(ip);
+      ref = (table[h] != 0) ? (const uint8_t*) in + table[h] - 1 : NULL;
+      table[h] = (uint32_t) (ip - (const uint8_t*) in) + 1;
+      if (ref == NULL || (uint32_t) (ip - ref) > COMPRESS_MAX_DISTANCE || memcmp(ref, ip, COMPRESS_MIN_MATCH) != 0)
+      {
+         ip++;
+         continue;
+      }
+      maxLength = (inEnd - ip > COMPRESS_MAX_MATCH) ? COMPRESS_MAX_MATCH : (uint32_t) (inEnd - ip);
+      length = COMPRESS_MIN_MATCH;
+      while (length < maxLength && ref[length] == ip[length])
+      {
+         length++;
+      }
+
+      op = compressLiterals(op, outEnd, literals, (uint32_t) (ip - literals));
+      if (op == NULL || outEnd - op < 3)
+      {
+         return 0;
+      }
+      distance = (uint32_t) (ip - ref) - 1;
+      if (length - 2 < 7)
+      {
+         *op++ = (uint8_t) (((length - 2) << 5) | (distance >> 8));
+      }
+      else
+      {
+         *op++ = (uint8_t) ((7 << 5) | (distance >> 8));
+         *op++ = (uint8_t) (length - 2 - 7);
+      }
+      *op++ = (uint8_t) distance;
+
+      //index the sequences inside the match, later matches can start there
+      for (ip++, length--; length > 0; ip++, length--)
+      {
+         if (inEnd - ip >= COMPRESS_MIN_MATCH)
+         {
+            table[compressHash(ip)] = (uint32_t) (ip - (const uint8_t*) in) + 1;
+         }
+      }
+      literals = ip;
+   }
+
+   op = compressLiterals(op, outEnd, literals, (uint32_t) (inEnd - literals));
+   if (op == NULL)
+   {
+      return 0;
+   }
+   return (uint32_t) (op - (uint8_t*) out);
+}
+
+
+int32_t pcoDecompress(const void *in, uint32_t inSize, void *out, uint32_t outSize)
+{
+   const uint8_t *ip = (const uint8_t*) in + PERS_COM_COMPRESS_HEADER_SIZE;
+   const uint8_t *inEnd = (const uint8_t*) in + inSize;
+   uint8_t *op = (uint8_t*) out;
+   uint8_t *outEnd;
+   const uint8_t *ref;
+   uint32_t size = pcoGetDecompressedSize(in, inSize);
+   uint32_t control;
+   uint32_t distance;
+   uint32_t length;
+
+   if (inSize < PERS_COM_COMPRESS_HEADER_SIZE || size > outSize)
+   {
+      return -1;
+   }
+   outEnd = op + size;
+
+   while (ip < inEnd)
+   {
+      control = *ip++;
+      if (control < COMPRESS_MAX_LITERALS)
+      {
+         length = control + 1;
+         if ((size_t) (inEnd - ip) < length || (size_t) (outEnd - op) < length)
+         {
+            return -1;
+         }
+         memcpy(op, ip, length);
+         ip += length;
+         op += length;
+      }
+      else
+      {
+         length = control >> 5;
+         if (length == 7)
+         {
+            if (ip >= inEnd)
+            {
+               return -1;
+            }
+            length += *ip++;
+         }
+         length += 2;
+         if (ip >= inEnd)
+         {
+            return -1;
+         }
+         distance = ((control & 0x1f) << 8) + *ip++ + 1;
+         if ((size_t) (op - (uint8_t*) out) < distance || (size_t) (outEnd - op) < length)
+         {
+            return -1;
+         }
+         ref = op - distance;
+         //the reference can overlap the output: copy byte by byte
+         while (length-- > 0)
+         {
+            *op++ = *ref++;
+         }
+      }
+   }
+
+   return (op == outEnd) ? (int32_t) size : -1;
+}
+
+
+uint32_t pcoGetDecompressedSize(const void *in, uint32_t inSize)
+{
+   uint32_t size = 0;
+
+   if (inSize >= PERS_COM_COMPRESS_HEADER_SIZE)
+   {
+      memcpy(&size, in, sizeof(size));
+   }
+   return size;
+}
@@ -0,0 +1,62 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * Copyright
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           compress.h
+ * @ingroup        Persistence key value store
+ * @brief          Header of the value compression used by databases opened with the compression option
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define PERS_COM_COMPRESS_INTERFACE_VERSION  (0x01000000U)
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A compressed value starts with its uncompressed size (uint32_t), followed by the LZ77 stream.
+ * The format is stored in database files and must never be changed.
+ */
+#define PERS_COM_COMPRESS_HEADER_SIZE  sizeof(uint32_t)
+
+/**
+ * Compresses inSize bytes of in into out (LZF like LZ77 with a 8 KB window).
+ * Returns the size of the compressed value (header and stream) or 0 if it does not fit into outSize bytes:
+ * pass an outSize smaller than inSize to keep only values that get smaller.
+ */
+uint32_t pcoCompress(const void *in, uint32_t inSize, void *out, uint32_t outSize);
+
+/**
+ * Decompresses the compressed value of inSize bytes into out.
+ * Returns the uncompressed size or -1 if the value is corrupt or does not fit into outSize bytes.
+ */
+int32_t pcoDecompress(const void *in, uint32_t inSize, void *out, uint32_t outSize);
+
+/**
+ * Returns the uncompressed size stored in the header of a compressed value of inSize bytes (0 if the header is incomplete)
+ */
+uint32_t pcoGetDecompressedSize(const void *in, uint32_t inSize);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMPRESS_H */
@@ -53,9 +53,22 @@
 
 #include "crc32.h"
 #include <stdio.h>
+#include <stdint.h>
 #include <sys/stat.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PCO_CRC32C_SSE42
+#include <nmmintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__AARCH64EL__)
+#define PCO_CRC32C_ARMV8
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
 
 enum crc32ConstantDefinition
 {
@@ -131,3 +144,179 @@ unsigned int pcoCrc32(unsigned int crc, const unsigned char *buf, size_t theSize
    }
    return rval;
 }
+
+
+
+/*
+ * CRC-32C (Castagnoli)
+ *
+ * polynomial $82f63b78 (reversed representation of $1edc6f41)
+ * The software kernel uses slicing-by-8: eight tables derived from the byte table
+ * allow to process 8 input bytes per iteration with independent table lookups.
+ */
+#define CRC32C_POLYNOMIAL 0x82F63B78U
+
+static uint32_t crc32c_tab[8][256];
+
+static pcoChecksumFunc crc32cKernel = NULL;
+
+static pthread_once_t crc32cInitOnce = PTHREAD_ONCE_INIT;
+
+
+static unsigned int crc32cSlicingBy8(unsigned int crc, const unsigned char *buf, size_t theSize)
+{
+   const unsigned char *p = buf;
+   uint32_t lo = 0;
+   uint32_t hi = 0;
+
+   while (theSize >= 8)
+   {
+      lo = crc ^ ((uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24));
+      hi = (uint32_t) p[4] | ((uint32_t) p[5] << 8) | ((uint32_t) p[6] << 16) | ((uint32_t) p[7] << 24);
+      crc = crc32c_tab[7][lo & 0xFF] ^ crc32c_tab[6][(lo >> 8) & 0xFF] ^ crc32c_tab[5][(lo >> 16) & 0xFF] ^ crc32c_tab[4][lo >> 24]
+          ^ crc32c_tab[3][hi & 0xFF] ^ crc32c_tab[2][(hi >> 8) & 0xFF] ^ crc32c_tab[1][(hi >> 16) & 0xFF] ^ crc32c_tab[0][hi >> 24];
+      p += 8;
+      theSize -= 8;
+   }
+   while (theSize--)
+   {
+      crc = crc32c_tab[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+   }
+   return crc;
+}
+
+
+#ifdef PCO_CRC32C_SSE42
+__attribute__((target("sse4.2")))
+static unsigned int crc32cHardware(unsigned int crc, const unsigned char *buf, size_t theSize)
+{
+   const unsigned char *p = buf;
+
+#ifdef __x86_64__
+   while (theSize >= 8)
+   {
+      uint64_t word;
+      memcpy(&word, p, sizeof(word));
+      crc = (unsigned int) _mm_crc32_u64(crc, word);
+      p += 8;
+      theSize -= 8;
+   }
+#endif
+   while (theSize >= 4)
+   {
+      uint32_t word;
+      memcpy(&word, p, sizeof(word));
+      crc = _mm_crc32_u32(crc, word);
+      p += 4;
+      theSize -= 4;
+   }
+   while (theSize--)
+   {
+      crc = _mm_crc32_u8(crc, *p++);
+   }
+   return crc;
+}
+
+
+static int crc32cHardwareSupported(void)
+{
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("sse4.2");
+}
+#endif
+
+
+#ifdef PCO_CRC32C_ARMV8
+__attribute__((target("+crc")))
+static unsigned int crc32cHardware(unsigned int crc, const unsigned char *buf, size_t theSize)
+{
+   const unsigned char *p = buf;
+
+   while (theSize >= 8)
+   {
+      uint64_t word;
+      memcpy(&word, p, sizeof(word));
+      __asm__("crc32cx %w0, %w0, %x1" : "+r" (crc) : "r" (word));
+      p += 8;
+      theSize -= 8;
+   }
+   while (theSize--)
+   {
+      __asm__("crc32cb %w0, %w0, %w1" : "+r" (crc) : "r" ((uint32_t) *p++));
+   }
+   return crc;
+}
+
+
+static int crc32cHardwareSupported(void)
+{
+   return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+#endif
+
+
+static void crc32cInit(void)
+{
+   uint32_t i = 0;
+   uint32_t k = 0;
+   uint32_t c = 0;
+
+   for (i = 0; i < 256; i++)
+   {
+      c = i;
+      for (k = 0; k < 8; k++)
+      {
+         c = (c & 1) ? (c >> 1) ^ CRC32C_POLYNOMIAL : (c >> 1);
+      }
+      crc32c_tab[0][i] = c;
+   }
+   for (i = 0; i < 256; i++)
+   {
+      c = crc32c_tab[0][i];
+      for (k = 1; k < 8; k++)
+      {
+         c = crc32c_tab[0][c & 0xFF] ^ (c >> 8);
+         crc32c_tab[k][i] = c;
+      }
+   }
+
+   crc32cKernel = crc32cSlicingBy8;
+#if defined(PCO_CRC32C_SSE42) || defined(PCO_CRC32C_ARMV8)
+   if (crc32cHardwareSupported())
+   {
+      crc32cKernel = crc32cHardware;
+   }
+#endif
+}
+
+
+unsigned int pcoCrc32c(unsigned int crc, const unsigned char *buf, size_t theSize)
+{
+   unsigned int rval = 0;
+
+   if (buf != 0)
+   {
+      pthread_once(&crc32cInitOnce, crc32cInit);
+      rval = crc32cKernel(crc ^ ~0U, buf, theSize) ^ ~0U;
+   }
+   return rval;
+}
+
+
+pcoChecksumFunc pcoGetChecksumFunc(unsigned int algorithm)
+{
+   pcoChecksumFunc func = NULL;
+
+   switch (algorithm)
+   {
+      case PERS_COM_CHECKSUM_CRC32:
+         func = pcoCrc32;
+         break;
+      case PERS_COM_CHECKSUM_CRC32C:
+         func = pcoCrc32c;
+         break;
+      default:
+         break;
+   }
+   return func;
+}
@@ -26,13 +26,39 @@ extern "C" {
 #endif
 
 
-#define PERS_COM_CRC32_INTERFACE_VERSION  (0x01000000U)
+#define PERS_COM_CRC32_INTERFACE_VERSION  (0x01010000U)
 #define CHKSUMBUFSIZE 64
 
 #include <string.h>
 #include <stdio.h>
 
+/**
+ * Checksum algorithm identifiers.
+ * These values are stored in database files and must never be changed.
+ */
+#define PERS_COM_CHECKSUM_CRC32   0  /* CRC-32 as calculated by pcoCrc32 (table driven, byte at a time) */
+#define PERS_COM_CHECKSUM_CRC32C  1  /* CRC-32C (Castagnoli) as calculated by pcoCrc32c */
+
+/**
+ * Checksum function: continues the checksum crc (0 for a new checksum) over theSize bytes of buf
+ */
+typedef unsigned int (*pcoChecksumFunc)(unsigned int crc, const unsigned char *buf, size_t theSize);
+
 unsigned int pcoCrc32(unsigned int crc, const unsigned char *buf, size_t theSize);
+
+/**
+ * CRC-32C (Castagnoli) checksum.
+ * Uses the SSE4.2 (x86) or ARMv8 (aarch64) CRC32C instructions if the CPU supports them,
+ * otherwise a slicing-by-8 table implementation. The kernel is selected once at runtime.
+ */
+unsigned int pcoCrc32c(unsigned int crc, const unsigned char *buf, size_t theSize);
+
+/**
+ * Returns the checksum function for one of the PERS_COM_CHECKSUM_* algorithm identifiers
+ * or NULL if the algorithm is unknown
+ */
+pcoChecksumFunc pcoGetChecksumFunc(unsigned int algorithm);
+
 int pcoCalcCrc32Csum(int fd, int startOffset);
 
 
@@ -0,0 +1,605 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * Copyright
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           frozendb.c
+ * @ingroup        Persistence key value store
+ * @brief          Frozen (immutable) database image used for read-only default data
+ * @see
+ */
+
+/*
+ * The index is a minimal perfect hash (compress, hash and displace):
+ * the mixed key hash selects a bucket and two values f1 and f2 in [0, keyCount),
+ * the slot of a key in the entry table is (f1 + d0 * f2 + d1) % keyCount with the displacement pair (d0, d1) of its bucket.
+ * The builder places the buckets with most keys first and searches a displacement pair for every bucket
+ * which moves all its keys to free slots.
+ */
+
+#include "./frozendb.h"
+#include "./kissdb.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <dlt.h>
+
+DLT_IMPORT_CONTEXT (persComLldbDLTCtx)
+
+
+/* number of d0 values tried for a bucket before the builder restarts with the next seed */
+#define FROZENDB_MAX_D0          256
+#define FROZENDB_MAX_SEEDS       16
+#define FROZENDB_KEY_HASH_ALGORITHM PERS_COM_KEY_HASH_WYHASH
+
+
+/* key of the builder: mixed key hash and its bucket */
+typedef struct
+{
+   uint64_t mixed;
+   uint32_t bucket;
+   uint32_t item;
+} FrozenDB_BuildKey_s;
+
+
+/* items of a database file of version 2.x filled by frozenAddVersion2Item */
+typedef struct
+{
+   FrozenDB_Item_s* items;
+   uint32_t count;
+   uint32_t capacity;
+} FrozenDB_Version2_s;
+
+
+/* murmur3 64 bit finalizer */
+static uint64_t frozenMix(uint64_t h)
+{
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+   h *= 0xc4ceb9fe1a85ec53ULL;
+   h ^= h >> 33;
+   return h;
+}
+
+
+static uint32_t frozenGetBucket(uint64_t mixed, uint32_t bucketCount)
+{
+   return (uint32_t) (mixed >> 32) % bucketCount;
+}
+
+
+static uint32_t frozenGetSlot(uint64_t mixed, uint32_t keyCount, uint32_t d0, uint32_t d1)
+{
+   uint64_t f1 = (uint32_t) mixed % keyCount;
+   uint64_t f2 = (uint32_t) ((mixed * 0x9e3779b97f4a7c15ULL) >> 32) % keyCount;
+
+   return (uint32_t) ((f1 + (uint64_t) d0 * f2 + d1) % keyCount);
+}
+
+
+static int frozenIsEntryValid(const FROZENDB* db, const FrozenDB_Entry_s* entry)
+{
+   return (uint64_t) entry->keyOffset + entry->keyLength + 1 + entry->valueSize <= db->header->dataSize;
+}
+
+
+int FROZENDB_open(FROZENDB* db, const char* path)
+{
+   FrozenDB_Header_s header;
+   struct stat sb;
+   void* map;
+   int fd;
+
+   memset(db, 0, sizeof(FROZENDB));
+   fd = open(path, O_RDONLY | O_CLOEXEC);
+   if (fd == -1)
+   {
+      return FROZENDB_ERROR_NOT_FROZEN;
+   }
+   if (fstat(fd, &sb) != 0 || (size_t) sb.st_size < sizeof(FrozenDB_Header_s)
+       || pread(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header)
+       || memcmp(header.magic, FROZENDB_MAGIC, FROZENDB_MAGIC_SIZE) != 0)
+   {
+      close(fd);
+      return FROZENDB_ERROR_NOT_FROZEN;
+   }
+
+   //the tables must be inside of the file, a file with keys needs buckets
+   if (header.version != FROZENDB_VERSION || pcoGetKeyHashFunc(header.keyHashAlgorithm) == NULL
+       || (header.keyCount > 0 && header.bucketCount == 0)
+       || header.displacementOffset < sizeof(FrozenDB_Header_s)
+       || header.entryOffset < header.displacementOffset + (uint64_t) header.bucketCount * 2 * sizeof(uint32_t)
+       || header.dataOffset < header.entryOffset + (uint64_t) header.keyCount * sizeof(FrozenDB_Entry_s)
+       || header.dataOffset + header.dataSize > (uint64_t) sb.st_size
+       || (header.displacementOffset % sizeof(uint32_t)) != 0 || (header.entryOffset % sizeof(uint32_t)) != 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": frozen image <"); DLT_STRING(path); DLT_STRING("> has a wrong version or is corrupt"));
+      close(fd);
+      return FROZENDB_ERROR_CORRUPT_FILE;
+   }
+
+   map = mmap(NULL, (size_t) sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd); //the mapping keeps the file open
+   if (map == MAP_FAILED)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": mmap of frozen image <"); DLT_STRING(path); DLT_STRING("> failed: "); DLT_STRING(strerror(errno)));
+      return FROZENDB_ERROR_IO;
+   }
+
+   db->map = (const char*) map;
+   db->mapSize = (size_t) sb.st_size;
+   db->header = (const FrozenDB_Header_s*) db->map;
+   db->displacements = (const uint32_t*) (db->map + header.displacementOffset);
+   db->entries = (const FrozenDB_Entry_s*) (db->map + header.entryOffset);
+   db->data = db->map + header.dataOffset;
+   db->keyHash = pcoGetKeyHashFunc(header.keyHashAlgorithm);
+   return 0;
+}
+
+
+void FROZENDB_close(FROZENDB* db)
+{
+   if (db->map != NULL)
+   {
+      munmap((void*) db->map, db->mapSize);
+   }
+   memset(db, 0, sizeof(FROZENDB));
+}
+
+
+int FROZENDB_get(const FROZENDB* db, const char* key, const void** value, uint32_t* valueSize)
+{
+   const FrozenDB_Header_s* header = db->header;
+   const FrozenDB_Entry_s* entry;
+   size_t keyLength;
+   uint64_t hash;
+   uint64_t mixed;
+   uint32_t bucket;
+
+   if (header->keyCount == 0)
+   {
+      return 1;
+   }
+   keyLength = strlen(key);
+   hash = db->keyHash(key, keyLength);
+   mixed = frozenMix(hash ^ header->seed);
+   bucket = frozenGetBucket(mixed, header->bucketCount);
+   entry = &db->entries[frozenGetSlot(mixed, header->keyCount, db->displacements[2 * bucket], db->displacements[2 * bucket + 1])];
+
+   if (entry->keyHash != (uint32_t) hash || entry->keyLength != keyLength || !frozenIsEntryValid(db, entry)
+       || memcmp(db->data + entry->keyOffset, key, keyLength) != 0)
+   {
+      return 1;
+   }
+   *value = db->data + entry->keyOffset + keyLength + 1;
+   *valueSize = entry->valueSize;
+   return 0;
+}
+
+
+const char* FROZENDB_getKey(const FROZENDB* db, uint32_t index, uint32_t* keyLength)
+{
+   const FrozenDB_Entry_s* entry = &db->entries[index];
+
+   if (!frozenIsEntryValid(db, entry))
+   {
+      return NULL;
+   }
+   *keyLength = entry->keyLength;
+   return db->data + entry->keyOffset;
+}
+
+
+static int frozenCompareBuildKeys(const void* a, const void* b)
+{
+   const FrozenDB_BuildKey_s* ka = (const FrozenDB_BuildKey_s*) a;
+   const FrozenDB_BuildKey_s* kb = (const FrozenDB_BuildKey_s*) b;
+
+   if (ka->bucket != kb->bucket)
+   {
+      return (ka->bucket < kb->bucket) ? -1 : 1;
+   }
+   if (ka->mixed != kb->mixed)
+   {
+      return (ka->mixed < kb->mixed) ? -1 : 1;
+   }
+   return 0;
+}
+
+
+/* bucket with its first key in the sorted keys of the builder, sorted by the number of keys (largest first) */
+typedef struct
+{
+   uint32_t bucket;
+   uint32_t first;
+   uint32_t count;
+} FrozenDB_BuildBucket_s;
+
+
+static int frozenCompareBuildBuckets(const void* a, const void* b)
+{
+   const FrozenDB_BuildBucket_s* ba = (const FrozenDB_BuildBucket_s*) a;
+   const FrozenDB_BuildBucket_s* bb = (const FrozenDB_BuildBucket_s*) b;
+
+   if (ba->count != bb->count)
+   {
+      return (ba->count > bb->count) ? -1 : 1;
+   }
+   return (ba->bucket < bb->bucket) ? -1 : (ba->bucket > bb->bucket);
+}
+
+
+/*
+ * searches the displacement pairs of all buckets for one seed, slotItem returns the item of every slot
+ * returns 0 on success, 1 if a bucket cannot be placed with this seed
+ */
+static int frozenPlaceBuckets(FrozenDB_BuildKey_s* keys, FrozenDB_BuildBucket_s* buckets, uint32_t keyCount, uint32_t bucketCount,
+                              uint32_t* displacements, uint32_t* slotItem, uint8_t* taken, uint32_t* slots)
+{
+   uint32_t b;
+   uint32_t i;
+   uint32_t d0;
+   uint32_t d1;
+   uint32_t placed;
+   FrozenDB_BuildBucket_s* bucket;
+
+   memset(taken, 0, keyCount);
+   memset(displacements, 0, (size_t) bucketCount * 2 * sizeof(uint32_t));
+   for (b = 0; b < bucketCount && buckets[b].count > 0; b++)
+   {
+      bucket = &buckets[b];
+      placed = 0;
+      for (d0 = 0; d0 < FROZENDB_MAX_D0 && placed == 0; d0++)
+      {
+         for (d1 = 0; d1 < keyCount && placed == 0; d1++)
+         {
+            for (i = 0; i < bucket->count; i++)
+            {
+               slots[i] = frozenGetSlot(keys[bucket->first + i].mixed, keyCount, d0, d1);
+               if (taken[slots[i]])
+               {
+                  break;
+               }
+               taken[slots[i]] = 1; //marked to detect two keys of the bucket in the same slot
+            }
+            if (i == bucket->count)
+            {
+               placed = 1;
+               displacements[2 * bucket->bucket] = d0;
+               displacements[2 * bucket->bucket + 1] = d1;
+               for (i = 0; i < bucket->count; i++)
+               {
+                  slotItem[slots[i]] = keys[bucket->first + i].item;
+               }
+            }
+            else
+            {
+               while (i-- > 0)
+               {
+                  taken[slots[i]] = 0;
+               }
+            }
+         }
+      }
+      if (placed == 0)
+      {
+         return 1;
+      }
+   }
+   return 0;
+}
+
+
+static int frozenWriteImage(const char* path, const FrozenDB_Item_s* items, const uint64_t* hashes, FrozenDB_Header_s* header,
+                            const uint32_t* displacements, const uint32_t* slotItem)
+{
+   FrozenDB_Entry_s entry;
+   uint32_t* dataOffsets;
+   uint64_t offset = 0;
+   uint32_t i;
+   FILE* file;
+   int ret = 0;
+   const char terminator = '\0';
+
+   dataOffsets = (uint32_t*) malloc(((size_t) header->keyCount + 1) * sizeof(uint32_t));
+   if (dataOffsets == NULL)
+   {
+      return FROZENDB_ERROR_MALLOC;
+   }
+   //the keys and values are stored in the order of the items
+   for (i = 0; i < header->keyCount; i++)
+   {
+      dataOffsets[i] = (uint32_t) offset;
+      offset += strlen(items[i].key) + 1 + items[i].valueSize;
+      if (offset > UINT32_MAX)
+      {
+         free(dataOffsets);
+         return FROZENDB_ERROR_INVALID_PARAMETERS;
+      }
+   }
+   header->dataSize = offset;
+
+   file = fopen(path, "wb");
+   if (file == NULL)
+   {
+      free(dataOffsets);
+      return FROZENDB_ERROR_IO;
+   }
+   if (fwrite(header, sizeof(FrozenDB_Header_s), 1, file) != 1
+       || fwrite(displacements, sizeof(uint32_t) * 2, header->bucketCount, file) != header->bucketCount)
+   {
+      ret = FROZENDB_ERROR_IO;
+   }
+   for (i = 0; i < header->keyCount && ret == 0; i++)
+   {
+      entry.keyHash = (uint32_t) hashes[slotItem[i]];
+      entry.keyOffset = dataOffsets[slotItem[i]];
+      entry.keyLength = (uint32_t) strlen(items[slotItem[i]].key);
+      entry.valueSize = items[slotItem[i]].valueSize;
+      if (fwrite(&entry, sizeof(entry), 1, file) != 1)
+      {
+         ret = FROZENDB_ERROR_IO;
+      }
+   }
+   for (i = 0; i < header->keyCount && ret == 0; i++)
+   {
+      if (fwrite(items[i].key, strlen(items[i].key), 1, file) != 1 || fwrite(&terminator, 1, 1, file) != 1
+          || (items[i].valueSize > 0 && fwrite(items[i].value, items[i].valueSize, 1, file) != 1))
+      {
+         ret = FROZENDB_ERROR_IO;
+      }
+   }
+   if (fflush(file) != 0 || fsync(fileno(file)) != 0)
+   {
+      ret = FROZENDB_ERROR_IO;
+   }
+   if (fclose(file) != 0)
+   {
+      ret = FROZENDB_ERROR_IO;
+   }
+   free(dataOffsets);
+   return ret;
+}
+
+
+int FROZENDB_build(const char* path, const FrozenDB_Item_s* items, uint32_t count, uint32_t maxValueSize)
+{
+   FrozenDB_Header_s header;
+   FrozenDB_BuildKey_s* keys = NULL;
+   FrozenDB_BuildBucket_s* buckets = NULL;
+   pcoKeyHashFunc keyHash = pcoGetKeyHashFunc(FROZENDB_KEY_HASH_ALGORITHM);
+   uint64_t* hashes = NULL;
+   uint32_t* displacements = NULL;
+   uint32_t* slotItem = NULL;
+   uint32_t* slots = NULL;
+   uint8_t* taken = NULL;
+   uint32_t bucketCount = (count + FROZENDB_KEYS_PER_BUCKET - 1) / FROZENDB_KEYS_PER_BUCKET;
+   uint32_t seed;
+   uint32_t i;
+   uint32_t b;
+   char* tmpPath = NULL;
+   int ret = 1;
+
+   if (path == NULL || (items == NULL && count > 0))
+   {
+      return FROZENDB_ERROR_INVALID_PARAMETERS;
+   }
+   if (bucketCount == 0)
+   {
+      bucketCount = 1;
+   }
+
+   keys = (FrozenDB_BuildKey_s*) malloc(((size_t) count + 1) * sizeof(FrozenDB_BuildKey_s));
+   buckets = (FrozenDB_BuildBucket_s*) malloc((size_t) bucketCount * sizeof(FrozenDB_BuildBucket_s));
+   hashes = (uint64_t*) malloc(((size_t) count + 1) * sizeof(uint64_t));
+   displacements = (uint32_t*) malloc((size_t) bucketCount * 2 * sizeof(uint32_t));
+   slotItem = (uint32_t*) malloc(((size_t) count + 1) * sizeof(uint32_t));
+   slots = (uint32_t*) malloc(((size_t) count + 1) * sizeof(uint32_t));
+   taken = (uint8_t*) malloc((size_t) count + 1);
+   tmpPath = (char*) malloc(strlen(path) + sizeof(".tmp"));
+   if (keys == NULL || buckets == NULL || hashes == NULL || displacements == NULL || slotItem == NULL || slots == NULL || taken == NULL || tmpPath == NULL)
+   {
+      ret = FROZENDB_ERROR_MALLOC;
+   }
+
+   for (i = 0; i < count && ret == 1; i++)
+   {
+      if (items[i].key == NULL || (items[i].value == NULL && items[i].valueSize > 0))
+      {
+         ret = FROZENDB_ERROR_INVALID_PARAMETERS;
+      }
+      else
+      {
+         hashes[i] = keyHash(items[i].key, strlen(items[i].key));
+      }
+   }
+
+   for (seed = 0; seed < FROZENDB_MAX_SEEDS && ret == 1; seed++)
+   {
+      for (i = 0; i < count; i++)
+      {
+         keys[i].mixed = frozenMix(hashes[i] ^ seed);
+         keys[i].bucket = frozenGetBucket(keys[i].mixed, bucketCount);
+         keys[i].item = i;
+      }
+      qsort(keys, count, sizeof(FrozenDB_BuildKey_s), frozenCompareBuildKeys);
+      for (i = 1; i < count; i++)
+      {
+         if (keys[i].mixed == keys[i - 1].mixed)
+         {
+            //the same key hash: the keys can never be placed in different slots
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": keys with the same hash: <"); DLT_STRING(items[keys[i].item].key);
+                    DLT_STRING(">, <"); DLT_STRING(items[keys[i - 1].item].key); DLT_STRING(">"));
+            ret = FROZENDB_ERROR_INVALID_PARAMETERS;
+            break;
+         }
+      }
+      if (ret != 1)
+      {
+         break;
+      }
+
+      for (b = 0; b < bucketCount; b++)
+      {
+         buckets[b].bucket = b;
+         buckets[b].first = 0;
+         buckets[b].count = 0;
+      }
+      for (i = count; i-- > 0;)
+      {
+         buckets[keys[i].bucket].first = i;
+         buckets[keys[i].bucket].count++;
+      }
+      qsort(buckets, bucketCount, sizeof(FrozenDB_BuildBucket_s), frozenCompareBuildBuckets);
+
+      if (frozenPlaceBuckets(keys, buckets, count, bucketCount, displacements, slotItem, taken, slots) == 0)
+      {
+         memset(&header, 0, sizeof(header));
+         memcpy(header.magic, FROZENDB_MAGIC, FROZENDB_MAGIC_SIZE);
+         header.version = FROZENDB_VERSION;
+         header.keyHashAlgorithm = FROZENDB_KEY_HASH_ALGORITHM;
+         header.keyCount = count;
+         header.bucketCount = bucketCount;
+         header.maxValueSize = maxValueSize;
+         header.seed = seed;
+         header.displacementOffset = sizeof(FrozenDB_Header_s);
+         header.entryOffset = header.displacementOffset + (uint64_t) bucketCount * 2 * sizeof(uint32_t);
+         header.dataOffset = header.entryOffset + (uint64_t) count * sizeof(FrozenDB_Entry_s);
+
+         (void) snprintf(tmpPath, strlen(path) + sizeof(".tmp"), "%s.tmp", path);
+         ret = frozenWriteImage(tmpPath, items, hashes, &header, displacements, slotItem);
+         if (ret == 0 && rename(tmpPath, path) != 0)
+         {
+            ret = FROZENDB_ERROR_IO;
+         }
+         if (ret != 0)
+         {
+            (void) remove(tmpPath);
+         }
+      }
+   }
+   if (ret == 1)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": no minimal perfect hash found for "); DLT_INT(count); DLT_STRING(" keys"));
+      ret = FROZENDB_ERROR_INVALID_PARAMETERS;
+   }
+
+   free(keys);
+   free(buckets);
+   free(hashes);
+   free(displacements);
+   free(slotItem);
+   free(slots);
+   free(taken);
+   free(tmpPath);
+   return ret;
+}
+
+
+
+
+/* copies a key and its value read by KISSDB_readVersion2 */
+static int frozenAddVersion2Item(void* arg, const char* key, const void* value, uint32_t valueSize)
+{
+   FrozenDB_Version2_s* version2 = (FrozenDB_Version2_s*) arg;
+   FrozenDB_Item_s* item;
+   void* copy;
+
+   if (version2->count >= version2->capacity) //the file was modified since the keys were counted
+   {
+      return FROZENDB_ERROR_IO;
+   }
+   item = &version2->items[version2->count];
+   item->key = strdup(key);
+   copy = malloc((size_t) valueSize + 1);
+   if (item->key == NULL || copy == NULL)
+   {
+      free((void*) item->key);
+      free(copy);
+      return FROZENDB_ERROR_MALLOC;
+   }
+   memcpy(copy, value, valueSize);
+   item->value = copy;
+   item->valueSize = valueSize;
+   version2->count++;
+   return 0;
+}
+
+
+int FROZENDB_readVersion2(const char* path, FrozenDB_Item_s** items, uint32_t* count, uint32_t* maxValueSize)
+{
+   FrozenDB_Version2_s version2 = { NULL, 0, 0 };
+   uint64_t valueSize = 0;
+   int ret;
+
+   *items = NULL;
+   *count = 0;
+   ret = KISSDB_readVersion2(path, &valueSize, NULL, NULL);
+   if (ret == KISSDB_ERROR_WRONG_DATABASE_VERSION)
+   {
+      return FROZENDB_ERROR_INVALID_PARAMETERS;
+   }
+   if (ret < 0)
+   {
+      return (ret == KISSDB_ERROR_CORRUPT_DBFILE) ? FROZENDB_ERROR_CORRUPT_FILE : FROZENDB_ERROR_IO;
+   }
+   version2.items = (FrozenDB_Item_s*) calloc((size_t) ret + 1, sizeof(FrozenDB_Item_s));
+   if (version2.items == NULL)
+   {
+      return FROZENDB_ERROR_MALLOC;
+   }
+   version2.capacity = (uint32_t) ret;
+   ret = KISSDB_readVersion2(path, NULL, frozenAddVersion2Item, &version2);
+   if (ret < 0)
+   {
+      FROZENDB_freeItems(version2.items, version2.count);
+      return (ret == FROZENDB_ERROR_MALLOC) ? FROZENDB_ERROR_MALLOC : FROZENDB_ERROR_IO;
+   }
+   *items = version2.items;
+   *count = version2.count;
+   *maxValueSize = (uint32_t) valueSize;
+   return 0;
+}
+
+
+void FROZENDB_freeItems(FrozenDB_Item_s* items, uint32_t count)
+{
+   uint32_t i;
+
+   for (i = 0; items != NULL && i < count; i++)
+   {
+      free((void*) items[i].key);
+      free((void*) items[i].value);
+   }
+   free(items);
+}
+
+
+int FROZENDB_buildFromVersion2(const char* path, const char* version2Path)
+{
+   FrozenDB_Item_s* items = NULL;
+   uint32_t count = 0;
+   uint32_t maxValueSize = 0;
+   int ret = FROZENDB_readVersion2(version2Path, &items, &count, &maxValueSize);
+
+   if (ret == 0)
+   {
+      ret = FROZENDB_build(path, items, count, maxValueSize);
+   }
+   FROZENDB_freeItems(items, count);
+   return (ret == 0) ? (int) count : ret;
+}
@@ -0,0 +1,215 @@
+#ifndef FROZENDB_H
+#define FROZENDB_H
+
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * Copyright
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           frozendb.h
+ * @ingroup        Persistence key value store
+ * @brief          Header of the frozen (immutable) database image used for read-only default data
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define PERS_COM_FROZENDB_INTERFACE_VERSION  (0x01000000U)
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../keyhash.h"
+
+/**
+ * A frozen image starts with FROZENDB_MAGIC, pers_lldb_open checks it to open the file as frozen image instead of KISSDB
+ */
+#define FROZENDB_MAGIC "PCOFROZN"
+#define FROZENDB_MAGIC_SIZE 8
+
+/**
+ * Version of the frozen image format, files with another version are not opened
+ */
+#define FROZENDB_VERSION 1
+
+/**
+ * Average number of keys per bucket of the minimal perfect hash index (one displacement pair per bucket)
+ */
+#define FROZENDB_KEYS_PER_BUCKET 4
+
+/**
+ * Header of a frozen image, followed by the displacement table (bucketCount pairs of uint32_t),
+ * the entry table (keyCount entries) and the data area.
+ * The image is written once by FROZENDB_build and is never modified.
+ */
+typedef struct
+{
+   char magic[FROZENDB_MAGIC_SIZE];
+   uint32_t version;
+   uint32_t keyHashAlgorithm; /* PERS_COM_KEY_HASH_* of the index */
+   uint32_t keyCount;
+   uint32_t bucketCount;
+   uint32_t maxValueSize; /* maximum value size of the database the image was built from */
+   uint32_t seed; /* mixed into the key hash, chosen by FROZENDB_build so that the displacement search succeeds */
+   uint64_t displacementOffset;
+   uint64_t entryOffset;
+   uint64_t dataOffset;
+   uint64_t dataSize;
+} FrozenDB_Header_s;
+
+/**
+ * Entry of a key: the slot of the key in the entry table is given by the minimal perfect hash of the key.
+ * The key is stored in the data area followed by '\0' and the value.
+ */
+typedef struct
+{
+   uint32_t keyHash; /* low 32 bits of the key hash, rejects most missing keys without reading the data area */
+   uint32_t keyOffset; /* offset of the key in the data area */
+   uint32_t keyLength;
+   uint32_t valueSize;
+} FrozenDB_Entry_s;
+
+/**
+ * Key and value passed to FROZENDB_build
+ */
+typedef struct
+{
+   const char* key; /* null terminated */
+   const void* value;
+   uint32_t valueSize;
+} FrozenDB_Item_s;
+
+/**
+ * Opened frozen image: the file is mapped read only, no shared memory and no locks are used
+ */
+typedef struct
+{
+   const char* map;
+   size_t mapSize;
+   const FrozenDB_Header_s* header;
+   const uint32_t* displacements;
+   const FrozenDB_Entry_s* entries;
+   const char* data;
+   pcoKeyHashFunc keyHash; /* key hash function for header->keyHashAlgorithm */
+} FROZENDB;
+
+/**
+ * The file is not a frozen image (missing, too small or without FROZENDB_MAGIC)
+ */
+#define FROZENDB_ERROR_NOT_FROZEN -1
+
+/**
+ * I/O error
+ */
+#define FROZENDB_ERROR_IO -2
+
+/**
+ * Out of memory
+ */
+#define FROZENDB_ERROR_MALLOC -3
+
+/**
+ * Invalid parameters (e.g. two keys with the same key hash passed to FROZENDB_build)
+ */
+#define FROZENDB_ERROR_INVALID_PARAMETERS -4
+
+/**
+ * The frozen image has a wrong version or appears corrupt
+ */
+#define FROZENDB_ERROR_CORRUPT_FILE -5
+
+
+/**
+ * Opens a frozen image
+ *
+ * @param db Frozen image struct
+ * @param path Path to file
+ * @return 0 on success, FROZENDB_ERROR_NOT_FROZEN if the file is no frozen image, negative on error
+ */
+int FROZENDB_open(FROZENDB* db, const char* path);
+
+/**
+ * Closes a frozen image
+ *
+ * @param db Frozen image struct
+ */
+void FROZENDB_close(FROZENDB* db);
+
+/**
+ * Looks up a key: one hash of the key, one displacement pair and one entry are read, the key is compared once
+ *
+ * @param db Frozen image struct
+ * @param key Key (null terminated)
+ * @param value Returns the address of the value in the mapped image
+ * @param valueSize Returns the size of the value
+ * @return 0 on success, 1 if the key was not found
+ */
+int FROZENDB_get(const FROZENDB* db, const char* key, const void** value, uint32_t* valueSize);
+
+/**
+ * Returns the key stored in the entry index (0 <= index < header->keyCount) or NULL if the entry is corrupt
+ *
+ * @param db Frozen image struct
+ * @param index Index of the entry
+ * @param keyLength Returns the length of the key
+ */
+const char* FROZENDB_getKey(const FROZENDB* db, uint32_t index, uint32_t* keyLength);
+
+/**
+ * Writes a frozen image of count items
+ *
+ * Keys must be unique. The minimal perfect hash index is built in memory, the image is written to a temporary file
+ * which is renamed to path.
+ *
+ * @param path Path to file
+ * @param items Keys and values
+ * @param count Number of items
+ * @param maxValueSize Maximum value size returned for the image
+ * @return 0 on success, negative on error
+ */
+int FROZENDB_build(const char* path, const FrozenDB_Item_s* items, uint32_t count, uint32_t maxValueSize);
+
+/**
+ * Reads the keys and values of a database file of version 2.x (see KISSDB_readVersion2) into allocated items
+ *
+ * @param path Path to the database file
+ * @param items Returns the keys and values, freed by FROZENDB_freeItems
+ * @param count Returns the number of items
+ * @param maxValueSize Returns the maximum value size of the database file
+ * @return 0 on success, FROZENDB_ERROR_INVALID_PARAMETERS if the file is not of version 2.x, negative on error
+ */
+int FROZENDB_readVersion2(const char* path, FrozenDB_Item_s** items, uint32_t* count, uint32_t* maxValueSize);
+
+/**
+ * Frees the items returned by FROZENDB_readVersion2
+ *
+ * @param items Keys and values
+ * @param count Number of items
+ */
+void FROZENDB_freeItems(FrozenDB_Item_s* items, uint32_t count);
+
+/**
+ * Writes a frozen image of the keys of a database file of version 2.x, the database file is not modified
+ *
+ * @param path Path to the frozen image
+ * @param version2Path Path to the database file
+ * @return number of keys written to the image, FROZENDB_ERROR_INVALID_PARAMETERS if the file is not of version 2.x, negative on error
+ */
+int FROZENDB_buildFromVersion2(const char* path, const char* version2Path);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FROZENDB_H */
@@ -39,6 +39,7 @@
 #include <semaphore.h>
 #include <dlt.h>
 #include <dirent.h>
+#include <signal.h>
 #include "persComErrors.h"
 
 //
@@ -57,16 +58,441 @@ inline long long getNsDuration(struct timespec* start, struct timespec* end)
 }
 #endif
 
-/* djb2 hash function */
-static uint64_t KISSDB_hash(const void* b, unsigned long len)
+/*
+ * linear hashing: returns the number of the hashtable (bucket) for a hash with htNum hashtables
+ * with htNum = 2^level + split hashtables, the buckets below split have already been split and use one more hash bit
+ */
+static uint32_t getHashtableNumberOf(uint32_t htNum, uint64_t hash)
+{
+   uint32_t level = 1;
+   uint32_t bucket = 0;
+
+   while ((level << 1) <= htNum)
+   {
+      level <<= 1;
+   }
+   bucket = (uint32_t) (hash & ((level << 1) - 1));
+   if (bucket >= htNum)
+   {
+      bucket = (uint32_t) (hash & (level - 1));
+   }
+   return bucket;
+}
+
+/* returns the number of the hashtable (bucket) for a hash */
+static uint32_t getHashtableNumber(KISSDB* db, uint64_t hash)
+{
+   return getHashtableNumberOf(db->shared->htNum, hash);
+}
+
+/* returns the first slot of the probe sequence for a hash inside a hashtable */
+static uint32_t getHashtableSlot(KISSDB* db, uint64_t hash)
+{
+   return (uint32_t) ((hash >> 32) % db->htSize);
+}
+
+/* stores the key length and the parts of the key hash used by the index in a hashtable slot */
+static void setSlotKey(Hashtable_slot_s* entry, uint64_t hash, unsigned long klen)
+{
+   entry->keyLength = (uint8_t) klen;
+   entry->bucketHash = (uint16_t) hash;
+   entry->fingerprint = (uint32_t) (hash >> 32);
+}
+
+/*
+ * returns the key hash stored in a hashtable slot
+ * the bits in between are not stored, they are neither used for the hashtable number nor for the first slot
+ */
+static uint64_t getSlotHash(const Hashtable_slot_s* entry)
+{
+   return ((uint64_t) entry->fingerprint << 32) | entry->bucketHash;
+}
+
+/* marks a hashtable as modified since the last checkpoint */
+static void setHashtableDirty(KISSDB* db, uint32_t htNumber)
+{
+   db->shared->htDirty[htNumber >> 3] |= (uint8_t) (1 << (htNumber & 7));
+}
+
+/* checks if a hashtable was modified since the last checkpoint */
+static Kdb_bool isHashtableDirty(KISSDB* db, uint32_t htNumber)
+{
+   return (db->shared->htDirty[htNumber >> 3] & (1 << (htNumber & 7))) ? Kdb_true : Kdb_false;
+}
+
+/* marks the hashtable containing a slot as modified since the last checkpoint */
+static void setSlotDirty(KISSDB* db, const Hashtable_slot_s* slot)
+{
+   setHashtableDirty(db, (uint32_t) (((const char*) slot - (const char*) db->hashTables) / sizeof(Hashtable_s)));
+}
+
+/* marks a hashtable as copied from the file into the shared memory */
+static void setHashtableLoaded(KISSDB* db, uint32_t htNumber)
+{
+   db->shared->htLoaded[htNumber >> 3] |= (uint8_t) (1 << (htNumber & 7));
+}
+
+/* checks if a hashtable was already copied from the file into the shared memory */
+static Kdb_bool isHashtableLoaded(KISSDB* db, uint32_t htNumber)
+{
+   return (db->shared->htLoaded[htNumber >> 3] & (1 << (htNumber & 7))) ? Kdb_true : Kdb_false;
+}
+
+/*
+ * returns the offset of a hashtable in the database file or -1 if the link to it is invalid
+ * the offsets are looked up along the links of the hashtables (the link of a hashtable not loaded yet is read from the file)
+ * and kept in the shared information
+ */
+static int64_t getHashtableFileOffset(KISSDB* db, uint32_t htNumber)
+{
+   int64_t link = 0;
+   int64_t offset = 0;
+
+   if (db->shared->htOffsetCount == 0)
+   {
+      db->shared->htOffset[0] = KISSDB_HEADER_SIZE;
+      db->shared->htOffsetCount = 1;
+   }
+   while (db->shared->htOffsetCount <= htNumber)
+   {
+      offset = db->shared->htOffset[db->shared->htOffsetCount - 1];
+      if (isHashtableLoaded(db, db->shared->htOffsetCount - 1) == Kdb_true)
+      {
+         link = db->hashTables[db->shared->htOffsetCount - 1].slots[db->htSize].offsetA;
+      }
+      else
+      {
+         link = ((Hashtable_s*) (db->mappedDb + offset))->slots[db->htSize].offsetA;
+      }
+      if (link < (int64_t) KISSDB_HEADER_SIZE || (uint64_t) link + db->htSizeBytes > db->dbMappedSize)
+      {
+         return -1;
+      }
+      db->shared->htOffset[db->shared->htOffsetCount++] = link;
+   }
+   return db->shared->htOffset[htNumber];
+}
+
+/* checks the delimiters of a hashtable in the database file */
+static Kdb_bool isHashtableDelimiterValid(const Hashtable_s* htptr)
+{
+   return (htptr->delimStart == HASHTABLE_START_DELIMITER || htptr->delimEnd == HASHTABLE_END_DELIMITER) ? Kdb_true : Kdb_false;
+}
+
+/*
+ * copies a hashtable from the database file into the shared memory
+ * the open checks the links and delimiters of all hashtables before they are loaded lazily and recovers a damaged file,
+ * a hashtable which became invalid while the file is open is loaded without slots
+ */
+static void loadHashtable(KISSDB* db, uint32_t htNumber)
+{
+   Hashtable_s* hashtable = &db->hashTables[htNumber];
+   Hashtable_s* htptr = NULL;
+   int64_t offset = getHashtableFileOffset(db, htNumber);
+
+   if (offset > 0)
+   {
+      htptr = (Hashtable_s*) (db->mappedDb + offset);
+   }
+   if (htptr != NULL && isHashtableDelimiterValid(htptr) == Kdb_true)
+   {
+      memcpy(hashtable, htptr, db->htSizeBytes);
+   }
+   else
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": hashtable is invalid: "); DLT_INT(htNumber));
+      memset(hashtable, 0, db->htSizeBytes);
+      hashtable->delimStart = HASHTABLE_START_DELIMITER;
+      hashtable->delimEnd = HASHTABLE_END_DELIMITER;
+   }
+   setHashtableLoaded(db, htNumber);
+}
+
+/* returns a hashtable in the shared memory, the hashtables of a correctly closed file are loaded on their first access */
+static Hashtable_s* getHashtable(KISSDB* db, uint32_t htNumber)
+{
+   if (isHashtableLoaded(db, htNumber) == Kdb_false)
+   {
+      loadHashtable(db, htNumber);
+   }
+   return &db->hashTables[htNumber];
+}
+
+/* loads all hashtables not loaded yet, needed before all slots are checked or modified */
+static void loadAllHashtables(KISSDB* db)
+{
+   uint32_t i = 0;
+
+   for (i = 0; i < db->shared->htNum; i++)
+   {
+      getHashtable(db, i);
+   }
+}
+
+/* marks all hashtables as modified since the last checkpoint */
+static void setAllHashtablesDirty(KISSDB* db)
+{
+   loadAllHashtables(db);
+   memset(db->shared->htDirty, 0xFF, sizeof(db->shared->htDirty));
+}
+
+/* returns the fields of a data block stored behind its key field */
+static DataBlockInfo_s* getDataBlockInfo(KISSDB* db, DataBlock_s* block)
+{
+   return (DataBlockInfo_s*) (block->key + db->keyFieldSize);
+}
+
+/* returns the value area of a data block */
+static char* getDataBlockValue(KISSDB* db, DataBlock_s* block)
+{
+   return (char*) block + db->dataBlockHeaderSize;
+}
+
+/* returns the smallest data block size class which can store a value with valueSize bytes */
+static uint32_t getDataBlockSize(KISSDB* db, uint64_t valueSize)
+{
+   uint32_t blockSize = db->minBlockSize;
+   while (blockSize < db->dataBlockHeaderSize + valueSize + sizeof(int64_t))
+   {
+      blockSize <<= 1;
+   }
+   return blockSize;
+}
+
+/* checks if blockSize is a size class that can be used for data blocks of this database */
+static Kdb_bool isValidDataBlockSize(KISSDB* db, uint32_t blockSize)
+{
+   uint32_t sizeClass = blockSize / db->minBlockSize;
+
+   if (blockSize < db->minBlockSize || blockSize > getDataBlockSize(db, db->valSize)
+         || blockSize % db->minBlockSize != 0 || (sizeClass & (sizeClass - 1)) != 0)
+   {
+      return Kdb_false;
+   }
+   return Kdb_true;
+}
+
+/*
+ * sets the data block geometry of the database: the key field of keyFieldSize bytes and the smallest size class minBlockSize
+ * returns KISSDB_ERROR_CORRUPT_DBFILE if the geometry does not fit the key and value size of the database
+ */
+static int setDataBlockGeometry(KISSDB* db, uint64_t keyFieldSize, uint64_t minBlockSize)
+{
+   if (keyFieldSize < db->keySize || keyFieldSize > PERS_DB_MAX_LENGTH_KEY_NAME || keyFieldSize % sizeof(int64_t) != 0
+         || minBlockSize < KISSDB_DATA_BLOCK_ALIGNMENT || minBlockSize > KISSDB_MIN_DATA_BLOCK_SIZE << 1
+         || minBlockSize % KISSDB_DATA_BLOCK_ALIGNMENT != 0)
+   {
+      return KISSDB_ERROR_CORRUPT_DBFILE;
+   }
+   db->keyFieldSize = (uint32_t) keyFieldSize;
+   db->dataBlockHeaderSize = (uint32_t) (sizeof(DataBlock_s) + keyFieldSize + sizeof(DataBlockInfo_s));
+   db->minBlockSize = (uint32_t) minBlockSize;
+   if (db->minBlockSize < db->dataBlockHeaderSize + sizeof(int64_t)
+         || getDataBlockSize(db, db->valSize) > (db->minBlockSize << (KISSDB_FREE_LIST_COUNT - 1)))
+   {
+      return KISSDB_ERROR_CORRUPT_DBFILE;
+   }
+   return 0;
+}
+
+/* returns a pointer to the end delimiter which is stored in the last 8 bytes of a data block */
+static int64_t* getDataBlockEndDelimiter(KISSDB* db, DataBlock_s* block)
+{
+   return (int64_t*) ((char*) block + getDataBlockInfo(db, block)->blockSize - sizeof(int64_t));
+}
+
+/* returns the size of the value area of a data block */
+static uint32_t getDataBlockValueAreaSize(KISSDB* db, DataBlock_s* block)
+{
+   return getDataBlockInfo(db, block)->blockSize - db->dataBlockHeaderSize - sizeof(int64_t);
+}
+
+/*
+ * crc over key, datasize, blocksize, sequence and the used part of the value area of a data block
+ */
+static uint64_t getDataBlockCrc(KISSDB* db, DataBlock_s* block)
 {
-   unsigned long i;
-   uint64_t hash = 5381;
-   for (i = 0; i < len; ++i)
+   uint64_t crc = 0x00;
+   uint32_t valueAreaSize = getDataBlockValueAreaSize(db, block);
+   uint32_t coveredValueSize = valueAreaSize;
+
+   if (getDataBlockInfo(db, block)->valSize <= valueAreaSize)
+   {
+      coveredValueSize = getDataBlockInfo(db, block)->valSize;
+   }
+   crc = (uint32_t) db->checksum(crc, (unsigned char*) block->key,
+                                 db->dataBlockHeaderSize - offsetof(DataBlock_s, key) + coveredValueSize);
+   return crc;
+}
+
+/* crc over all slots of a hashtable */
+static uint64_t getHashtableCrc(KISSDB* db, Hashtable_s* hashtable)
+{
+   uint64_t crc = 0x00;
+   crc = (uint64_t) db->checksum(crc, (unsigned char*) hashtable->slots, sizeof(hashtable->slots));
+   return crc;
+}
+
+/*
+ * checks if a data block with the given delimiters is stored at offset in the mapped area
+ * returns Kdb_false if the size class in the block header is invalid or the block exceeds the mapped area
+ */
+static Kdb_bool isDataBlock(KISSDB* db, DataBlock_s* block, int64_t offset, int64_t mappedSize, int64_t delimStart, int64_t delimEnd)
+{
+   if (offset + (int64_t) db->minBlockSize > mappedSize
+         || isValidDataBlockSize(db, getDataBlockInfo(db, block)->blockSize) == Kdb_false
+         || offset + (int64_t) getDataBlockInfo(db, block)->blockSize > mappedSize)
+   {
+      return Kdb_false;
+   }
+   if (block->delimStart == delimStart || *getDataBlockEndDelimiter(db, block) == delimEnd)
+   {
+      return Kdb_true;
+   }
+   return Kdb_false;
+}
+
+/* returns the size of a valid or deleted data block stored at offset in the mapped area or 0 if there is no data block */
+static uint32_t getDataBlockSizeAt(KISSDB* db, DataBlock_s* block, int64_t offset, int64_t mappedSize)
+{
+   if (isDataBlock(db, block, offset, mappedSize, DATA_BLOCK_A_START_DELIMITER, DATA_BLOCK_A_END_DELIMITER)
+         || isDataBlock(db, block, offset, mappedSize, DATA_BLOCK_B_START_DELIMITER, DATA_BLOCK_B_END_DELIMITER)
+         || isDataBlock(db, block, offset, mappedSize, DATA_BLOCK_A_DELETED_START_DELIMITER, DATA_BLOCK_A_DELETED_END_DELIMITER)
+         || isDataBlock(db, block, offset, mappedSize, DATA_BLOCK_B_DELETED_START_DELIMITER, DATA_BLOCK_B_DELETED_END_DELIMITER))
+   {
+      return getDataBlockInfo(db, block)->blockSize;
+   }
+   return 0;
+}
+
+/* checks the delimiters, the size class and the checksum of a data block with a valid value stored at offset in the mapped area */
+static Kdb_bool isValidDataBlock(KISSDB* db, DataBlock_s* block, int64_t offset, int64_t mappedSize, int64_t delimStart, int64_t delimEnd)
+{
+   if (offset < KISSDB_HEADER_SIZE || isDataBlock(db, block, offset, mappedSize, delimStart, delimEnd) == Kdb_false)
+   {
+      return Kdb_false;
+   }
+   return (block->crc == getDataBlockCrc(db, block)) ? Kdb_true : Kdb_false;
+}
+
+/* returns Kdb_true if the valid data block B of a key holds a newer (or the same) value than the valid data block A */
+static Kdb_bool isDataBlockBNewer(KISSDB* db, DataBlock_s* dataA, DataBlock_s* dataB)
+{
+   return ((int32_t) (getDataBlockInfo(db, dataB)->sequence - getDataBlockInfo(db, dataA)->sequence) >= 0) ? Kdb_true : Kdb_false; //sequence numbers may wrap around
+}
+
+/* checks if two data blocks store the same key */
+static Kdb_bool isSameKey(KISSDB* db, DataBlock_s* dataA, DataBlock_s* dataB)
+{
+   return (strncmp(dataA->key, dataB->key, db->keyFieldSize) == 0) ? Kdb_true : Kdb_false;
+}
+
+/* checks if a used slot stores the value of its key inline */
+static Kdb_bool isSlotInline(const Hashtable_slot_s* slot)
+{
+   return (slot->current & KISSDB_SLOT_INLINE) ? Kdb_true : Kdb_false;
+}
+
+/* returns the file offset of data block B of a used slot */
+static int64_t getSlotOffsetB(KISSDB* db, const Hashtable_slot_s* slot)
+{
+   return (isSlotInline(slot) == Kdb_true) ? slot->offsetA + db->minBlockSize : slot->offsetB;
+}
+
+/* returns the file offset of the data block with the latest value of a used slot */
+static int64_t getSlotCurrentOffset(KISSDB* db, const Hashtable_slot_s* slot)
+{
+   return (slot->current & KISSDB_SLOT_CURRENT_B) ? getSlotOffsetB(db, slot) : slot->offsetA;
+}
+
+/* removes the inline value of a used slot: offsetB points to data block B again */
+static void clearSlotInlineValue(KISSDB* db, Hashtable_slot_s* slot)
+{
+   if (isSlotInline(slot) == Kdb_true)
+   {
+      slot->offsetB = getSlotOffsetB(db, slot);
+      slot->current &= KISSDB_SLOT_CURRENT_B;
+   }
+}
+
+/* returns the checksum of a key which is stored with an inline value */
+static uint32_t getInlineKeyCheck(KISSDB* db, const void* key, unsigned long klen)
+{
+   return (uint32_t) db->checksum(0, (const unsigned char*) key, klen);
+}
+
+/* returns the checksum of the key stored behind the inline value of a slot */
+static uint32_t getSlotInlineKeyCheck(const Hashtable_slot_s* slot)
+{
+   uint32_t keyCheck = 0;
+
+   memcpy(&keyCheck, (const char*) &slot->offsetB + KISSDB_INLINE_VALUE_SIZE, sizeof(keyCheck));
+   return keyCheck;
+}
+
+/*
+ * stores a value of up to KISSDB_INLINE_VALUE_SIZE bytes inline in the slot of its key after the data blocks were written
+ * the value is only stored if the data blocks have the smallest size class,
+ * the checksum of the key behind the value lets KISSDB_get return it without comparing the key stored in the data block
+ */
+static void setSlotInlineValue(KISSDB* db, Hashtable_slot_s* slot, const void* key, const void* value, uint32_t valueSize, uint32_t valueFlags)
+{
+   uint32_t keyCheck = 0;
+
+   clearSlotInlineValue(db, slot);
+   if (valueSize > KISSDB_INLINE_VALUE_SIZE || valueFlags != 0 || slot->offsetB - slot->offsetA != (int64_t) db->minBlockSize)
    {
-      hash = ((hash << 5) + hash) + (uint64_t) (((const uint8_t*) b)[i]);
+      return;
+   }
+   keyCheck = getInlineKeyCheck(db, key, slot->keyLength);
+   slot->offsetB = 0;
+   memcpy(&slot->offsetB, value, valueSize);
+   memcpy((char*) &slot->offsetB + KISSDB_INLINE_VALUE_SIZE, &keyCheck, sizeof(keyCheck));
+   slot->current |= (uint8_t) (KISSDB_SLOT_INLINE | (valueSize << 4));
+}
+
+/* returns the size of the inline value of a slot */
+static uint32_t getSlotInlineValueSize(const Hashtable_slot_s* slot)
+{
+   return (uint32_t) (slot->current >> 4);
+}
+
+/*
+ * sets the inline values of all slots from the current data blocks of their keys
+ * (after a power loss the inline values can be older than the data blocks)
+ */
+static void setAllSlotInlineValues(KISSDB* db)
+{
+   Hashtable_slot_s* slot;
+   DataBlock_s* block;
+   int64_t offset;
+   uint32_t i = 0;
+   uint32_t k = 0;
+
+   loadAllHashtables(db);
+   for (i = 0; i < db->shared->htNum; i++)
+   {
+      for (k = 0; k < db->htSize; k++)
+      {
+         slot = &db->hashTables[i].slots[k];
+         if (slot->offsetA > 0 && isSlotInline(slot) == Kdb_true)
+         {
+            clearSlotInlineValue(db, slot);
+            setSlotDirty(db, slot);
+         }
+         offset = getSlotCurrentOffset(db, slot);
+         if (slot->offsetA <= 0 || offset < (int64_t) KISSDB_HEADER_SIZE || offset + db->minBlockSize > db->dbMappedSize) //unused or deleted slot
+         {
+            continue;
+         }
+         block = (DataBlock_s*) (db->mappedDb + offset);
+         if (getDataBlockInfo(db, block)->valSize <= KISSDB_INLINE_VALUE_SIZE)
+         {
+            setSlotInlineValue(db, slot, block->key, getDataBlockValue(db, block), getDataBlockInfo(db, block)->valSize, getDataBlockInfo(db, block)->valFlags);
+            setSlotDirty(db, slot);
+         }
+      }
    }
-   return hash;
 }
 
 #if 1
@@ -227,46 +653,331 @@ Kdb_bool remapSharedHashtable(int shmem, Hashtable_s** shmem_ptr, size_t oldLeng
    return Kdb_true;
 }
 
-#if 0
-void printKdb(KISSDB* db)
+/* checks the links and delimiters of the first htNum hashtables in the database file (their offsets are kept in the shared information) */
+static Kdb_bool checkHashtableLinks(KISSDB* db, uint32_t htNum)
 {
-   printf("START ############################### \n");
-   printf("db->htSize:  %d \n", db->htSize);
-   printf("db->cacheReferenced: %d \n", db->cacheReferenced);
-   printf("db->keySize:  %" PRId64 " \n", db->keySize);
-   printf("db->valSize:  %" PRId64 " \n", db->valSize);
-   printf("db->htSizeBytes:  %" PRId64 " \n", db->htSizeBytes);
-   printf("db->htMappedSize:  %" PRId64 " \n", db->htMappedSize);
-   printf("db->dbMappedSize:  %" PRId64 " \n", db->dbMappedSize);
-   printf("db->shmCreator:  %d \n", db->shmCreator);
-   printf("db->alreadyOpen:  %d \n", db->alreadyOpen);
-   printf("db->hashTables:  %p \n", db->hashTables);
-   printf("db->mappedDb:  %p \n", db->mappedDb);
-   printf("db->sharedCache:  %p \n", db->sharedCache);
-   printf("db->sharedFd:  %d \n", db->sharedFd);
-   printf("db->htFd:  %d \n", db->htFd);
-   printf("db->sharedCacheFd:  %d \n", db->sharedCacheFd);
-   printf("db->semName:  %s \n", db->semName);
-   printf("db->sharedName:  %s \n", db->sharedName);
-   printf("db->cacheName:  %s \n", db->cacheName);
-   printf("db->htName:  %s \n", db->htName);
-   printf("db->shared:  %p \n", db->shared);
-   printf("db->tbl:  %p \n", db->tbl[0]);
-   printf("db->kdbSem:  %p \n", db->kdbSem);
-   printf("db->fd:  %d \n", db->fd);
-   printf("END ############################### \n");
-}
-#endif
+   int64_t offset = 0;
+   uint32_t i = 0;
 
+   for (i = 0; i < htNum; i++)
+   {
+      offset = getHashtableFileOffset(db, i);
+      if (offset <= 0 || isHashtableDelimiterValid((Hashtable_s*) (db->mappedDb + offset)) == Kdb_false)
+      {
+         return Kdb_false;
+      }
+   }
+   return Kdb_true;
+}
 
-int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint16_t hash_table_size, uint64_t key_size, uint64_t value_size)
+/*
+ * determines the hashtables of the database file and sizes the shared memory for all of them at once
+ * the hashtables of a file that was closed correctly are loaded on their first access (lazy is set) if all their links are valid,
+ * the hashtables of other files are found along their links and loaded (the number of hashtables in the header can be outdated)
+ * a file with an invalid link is marked as not closed correctly, the open recovers it like a file after a power loss
+ */
+static int openHashtables(KISSDB* db, Kdb_bool* lazy)
 {
+   Header_s* header = (Header_s*) db->mappedDb;
    Hashtable_s* htptr;
-   int ret = 0;
-   Kdb_bool htFound;
-   Kdb_bool tmpCreator;
-   off_t offset = 0;
-   size_t firstMappSize;
+   Kdb_bool temp;
+   int64_t offset = KISSDB_HEADER_SIZE;
+   uint64_t htNum = 0;
+
+   *(lazy) = Kdb_false;
+   memset(db->shared->htLoaded, 0, sizeof(db->shared->htLoaded));
+   db->shared->htOffsetCount = 0;
+   if (header->closeFailed == 0x00 && header->closeOk == 0x01
+         && header->htCount > 0 && header->htCount <= HASHTABLE_MAX_COUNT
+         && KISSDB_HEADER_SIZE + header->htCount * db->htSizeBytes <= db->dbMappedSize)
+   {
+      htNum = header->htCount;
+      *(lazy) = Kdb_true;
+      if (checkHashtableLinks(db, (uint32_t) htNum) == Kdb_false)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": hashtable link or delimiters are invalid -> rebuild of hashtables!"));
+         if (db->shared->openMode != KISSDB_OPEN_MODE_RDONLY)
+         {
+            header->closeFailed = 0x01;
+         }
+         htNum = 0;
+         *(lazy) = Kdb_false;
+         db->shared->htOffsetCount = 0;
+      }
+   }
+   if (*(lazy) == Kdb_false)
+   {
+      //read until all linked hashtables have been found
+      while (htNum < HASHTABLE_MAX_COUNT && offset >= (int64_t) KISSDB_HEADER_SIZE && (uint64_t) offset + db->htSizeBytes <= db->dbMappedSize)
+      {
+         htptr = (Hashtable_s*) (db->mappedDb + offset);
+         //check for existing start OR end delimiter of hashtable
+         if (htptr->delimStart != HASHTABLE_START_DELIMITER && htptr->delimEnd != HASHTABLE_END_DELIMITER)
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": hashtable delimiters are invalid -> rebuild not possible!"));
+            break;
+         }
+         db->shared->htOffset[htNum++] = offset;
+         offset = htptr->slots[db->htSize].offsetA; //follow link to next hashtable
+      }
+      db->shared->htOffsetCount = (uint32_t) htNum;
+   }
+
+   //the shared memory is resized once for all hashtables
+   if (db->htSizeBytes * htNum > db->htMappedSize)
+   {
+      if (db->htFd <= 0)
+      {
+         db->htFd = kdbShmemOpen(db->htName,  db->htMappedSize, &temp);
+         if(db->htFd < 0)
+         {
+            return KISSDB_ERROR_OPEN_SHM;
+         }
+      }
+      if (resizeKdbShmem(db->htFd, &db->hashTables, db->htMappedSize, db->htSizeBytes * htNum) == Kdb_false)
+      {
+         return KISSDB_ERROR_RESIZE_SHM;
+      }
+      db->shared->htShmSize = db->htSizeBytes * htNum;
+      db->htMappedSize = db->shared->htShmSize;
+   }
+   db->shared->htNum = (uint16_t) htNum;
+   if (*(lazy) == Kdb_false)
+   {
+      loadAllHashtables(db);
+   }
+   return 0;
+}
+
+
+/*
+ * takes the end of the data of a file which was not closed correctly from the header, the preallocated area behind it is reused
+ * (the whole file is kept if the end in the header is invalid)
+ */
+static void recoverDataEnd(KISSDB* db)
+{
+   uint64_t dataEnd = ((Header_s*) db->mappedDb)->dataEnd;
+
+   if (dataEnd >= KISSDB_HEADER_SIZE + sizeof(Hashtable_s) && dataEnd <= db->shared->mappedDbSize
+         && dataEnd % KISSDB_DATA_BLOCK_ALIGNMENT == 0)
+   {
+      db->shared->dataEnd = dataEnd;
+   }
+}
+
+
+/*
+ * remaps the database file of this process to size bytes
+ * while values of this process are pinned by views the mapping is not moved: if it cannot be resized in place,
+ * the file is mapped again and the old mapping is kept until the last view of the process is released
+ */
+static int remapDatabaseFile(KISSDB* db, uint64_t size)
+{
+   Kdb_mapping_s* retired;
+   char* map;
+
+   if (db->viewPins == 0)
+   {
+      map = mremap(db->mappedDb, db->dbMappedSize, size, MREMAP_MAYMOVE);
+   }
+   else
+   {
+      map = mremap(db->mappedDb, db->dbMappedSize, size, 0);
+      if (map == MAP_FAILED)
+      {
+         retired = (Kdb_mapping_s*) realloc(db->retiredMappings, (db->retiredCount + 1) * sizeof(Kdb_mapping_s));
+         if (retired == NULL)
+         {
+            return KISSDB_ERROR_MALLOC;
+         }
+         db->retiredMappings = retired;
+         map = (char*) mmap(NULL, size, (db->shared->openMode != KISSDB_OPEN_MODE_RDONLY) ? (PROT_WRITE | PROT_READ) : PROT_READ, MAP_SHARED, db->fd, 0);
+         if (map != MAP_FAILED)
+         {
+            retired[db->retiredCount].map = db->mappedDb;
+            retired[db->retiredCount].size = db->dbMappedSize;
+            db->retiredCount++;
+         }
+      }
+   }
+   if (map == MAP_FAILED)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":mremap error: !"), DLT_STRING(strerror(errno)));
+      return KISSDB_ERROR_IO;
+   }
+   db->mappedDb = map;
+   db->dbMappedSize = size;
+   return 0;
+}
+
+/* unmaps the mappings which were replaced while values of this process were pinned by views */
+static void unmapRetiredMappings(KISSDB* db)
+{
+   uint32_t i = 0;
+
+   for (i = 0; i < db->retiredCount; i++)
+   {
+      munmap(db->retiredMappings[i].map, db->retiredMappings[i].size);
+   }
+   free(db->retiredMappings);
+   db->retiredMappings = NULL;
+   db->retiredCount = 0;
+}
+
+/* returns the file offset of an address in a mapping of the database file of this process or -1 */
+static int64_t getViewOffset(KISSDB* db, const void* value)
+{
+   const char* ptr = (const char*) value;
+   uint32_t i = 0;
+
+   if (ptr >= db->mappedDb && ptr < db->mappedDb + db->dbMappedSize)
+   {
+      return ptr - db->mappedDb;
+   }
+   for (i = 0; i < db->retiredCount; i++)
+   {
+      if (ptr >= db->retiredMappings[i].map && ptr < db->retiredMappings[i].map + db->retiredMappings[i].size)
+      {
+         return ptr - db->retiredMappings[i].map;
+      }
+   }
+   return -1;
+}
+
+/* returns the pin of a value viewed by a process or NULL (pid 0 and value 0 return an unused pin) */
+static Kdb_view_pin_s* findViewPin(KISSDB* db, int32_t pid, int64_t value)
+{
+   uint32_t i = 0;
+
+   for (i = 0; i < KISSDB_VIEW_PIN_COUNT; i++)
+   {
+      if (db->shared->viewPin[i].pid == pid && db->shared->viewPin[i].value == value)
+      {
+         return &db->shared->viewPin[i];
+      }
+   }
+   return NULL;
+}
+
+/* removes count views from a pin, the pin is unused after its last view */
+static void unpinView(KISSDB* db, Kdb_view_pin_s* pin, uint32_t count)
+{
+   pin->count -= count;
+   db->shared->viewPins -= count;
+   if (pin->count == 0)
+   {
+      memset(pin, 0, sizeof(Kdb_view_pin_s));
+   }
+}
+
+/*
+ * releases the pins of processes which ended without releasing their views
+ * (the pinned data block pairs released meanwhile are added to the free lists by the next write or delete)
+ */
+static void reclaimViewPins(KISSDB* db)
+{
+   Kdb_view_pin_s* pin;
+   uint32_t i = 0;
+
+   for (i = 0; i < KISSDB_VIEW_PIN_COUNT && db->shared->viewPins > 0; i++)
+   {
+      pin = &db->shared->viewPin[i];
+      if (pin->pid != 0 && pin->pid != (int32_t) getpid() && kill((pid_t) pin->pid, 0) != 0 && errno == ESRCH)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": views of ended process released: "); DLT_INT(pin->pid));
+         unpinView(db, pin, pin->count);
+      }
+   }
+}
+
+/*
+ * pins the data block pair at offset pair for a view of the value at file offset value by this process
+ * returns Kdb_false if all pins are used by running processes
+ */
+static Kdb_bool pinView(KISSDB* db, int64_t pair, int64_t value)
+{
+   int32_t pid = (int32_t) getpid();
+   Kdb_view_pin_s* pin = findViewPin(db, pid, value);
+
+   if (pin == NULL)
+   {
+      pin = findViewPin(db, 0, 0);
+      if (pin == NULL)
+      {
+         reclaimViewPins(db);
+         pin = findViewPin(db, 0, 0);
+      }
+      if (pin == NULL)
+      {
+         return Kdb_false;
+      }
+      pin->pid = pid;
+      pin->pair = pair;
+      pin->value = value;
+   }
+   pin->count++;
+   db->shared->viewPins++;
+   db->viewPins++;
+   return Kdb_true;
+}
+
+/* checks if a data block pair is pinned by views */
+static Kdb_bool isDualDataBlockPinned(KISSDB* db, int64_t offset)
+{
+   uint32_t i = 0;
+
+   for (i = 0; i < KISSDB_VIEW_PIN_COUNT && db->shared->viewPins > 0; i++)
+   {
+      if (db->shared->viewPin[i].pid != 0 && db->shared->viewPin[i].pair == offset)
+      {
+         return Kdb_true;
+      }
+   }
+   return Kdb_false;
+}
+
+
+#if 0
+void printKdb(KISSDB* db)
+{
+   printf("START ############################### \n");
+   printf("db->htSize:  %d \n", db->htSize);
+   printf("db->cacheReferenced: %d \n", db->cacheReferenced);
+   printf("db->keySize:  %" PRId64 " \n", db->keySize);
+   printf("db->valSize:  %" PRId64 " \n", db->valSize);
+   printf("db->htSizeBytes:  %" PRId64 " \n", db->htSizeBytes);
+   printf("db->htMappedSize:  %" PRId64 " \n", db->htMappedSize);
+   printf("db->dbMappedSize:  %" PRId64 " \n", db->dbMappedSize);
+   printf("db->shmCreator:  %d \n", db->shmCreator);
+   printf("db->alreadyOpen:  %d \n", db->alreadyOpen);
+   printf("db->hashTables:  %p \n", db->hashTables);
+   printf("db->mappedDb:  %p \n", db->mappedDb);
+   printf("db->sharedCache:  %p \n", db->sharedCache);
+   printf("db->sharedFd:  %d \n", db->sharedFd);
+   printf("db->htFd:  %d \n", db->htFd);
+   printf("db->sharedCacheFd:  %d \n", db->sharedCacheFd);
+   printf("db->semName:  %s \n", db->semName);
+   printf("db->sharedName:  %s \n", db->sharedName);
+   printf("db->cacheName:  %s \n", db->cacheName);
+   printf("db->htName:  %s \n", db->htName);
+   printf("db->shared:  %p \n", db->shared);
+   printf("db->tbl:  %p \n", db->tbl[0]);
+   printf("db->kdbSem:  %p \n", db->kdbSem);
+   printf("db->fd:  %d \n", db->fd);
+   printf("END ############################### \n");
+}
+#endif
+
+
+int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint16_t hash_table_size, uint64_t key_size, uint64_t value_size)
+{
+   int ret = 0;
+   Kdb_bool closeFailed = Kdb_false;
+   Kdb_bool checkpointRecovered = Kdb_false;
+   Kdb_bool lazyLoaded = Kdb_false;
+   Kdb_bool tmpCreator;
+   off_t offset = 0;
+   size_t firstMappSize;
    struct stat sb;
 
    if (db->alreadyOpen == Kdb_false) //check if this instance has already opened the db before
@@ -305,17 +1016,27 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
          db->shared->refCount = 0;
          db->shared->htNum = 0;
          db->shared->mappedDbSize = 0;
+         db->shared->dataEnd = 0;
          db->shared->writeMode = writeMode;
          db->shared->openMode = openMode;
+         memset(db->shared->htDirty, 0, sizeof(db->shared->htDirty));
+         memset(db->shared->htLoaded, 0, sizeof(db->shared->htLoaded));
+         db->shared->htOffsetCount = 0;
+         db->shared->viewPins = 0;
+         memset(db->shared->viewPin, 0, sizeof(db->shared->viewPin));
+         db->shared->deferredCount = 0;
+         db->shared->keyListValid = Kdb_false;
       }
       else
       {
          Kdb_wrlock(&db->shared->rwlock);
+         reclaimViewPins(db);
       }
    }
    else
    {
       Kdb_wrlock(&db->shared->rwlock);
+      reclaimViewPins(db);
    }
 
    switch (db->shared->openMode)
@@ -374,6 +1095,11 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
          //update mapped size
          db->shared->mappedDbSize = (uint64_t)sb.st_size;
          db->dbMappedSize = db->shared->mappedDbSize;
+         if (db->shmCreator == Kdb_true)
+         {
+            //a file closed correctly ends with its data, the end of the data of a file not closed correctly is taken from the header
+            db->shared->dataEnd = (uint64_t) sb.st_size;
+         }
       }
    }
 
@@ -385,7 +1111,7 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
    if ( offset < KISSDB_HEADER_SIZE)
    {
       /* write header if not already present */
-      if ((hash_table_size) && (key_size) && (value_size))
+      if ((hash_table_size) && (key_size) && (key_size <= PERS_DB_MAX_LENGTH_KEY_NAME) && (value_size) && (value_size <= KISSDB_MAX_VALUE_SIZE))
       {
          ret = writeHeader(db, &hash_table_size, &key_size, &value_size);
          if(0 != ret)
@@ -456,61 +1182,14 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
     */
    if (db->shmCreator == Kdb_true )
    {
-      uint64_t offset = KISSDB_HEADER_SIZE;
       //only read hashtables from file if file is larger than header + hashtable size
       if(db->shared->mappedDbSize >= ( KISSDB_HEADER_SIZE + db->htSizeBytes) )
       {
-         htptr = (Hashtable_s*) ( db->mappedDb + KISSDB_HEADER_SIZE);
-         htFound = Kdb_true;
-         while (htFound && offset < db->dbMappedSize )
+         ret = openHashtables(db, &lazyLoaded);
+         if (ret != 0)
          {
-            //check for existing start OR end delimiter of hashtable
-            if (htptr->delimStart == HASHTABLE_START_DELIMITER || htptr->delimEnd == HASHTABLE_END_DELIMITER)
-            {
-               //if new size would exceed old shared memory size-> allocate additional memory page to shared memory
-               Kdb_bool result = Kdb_false;
-               if ( (db->htSizeBytes * (db->shared->htNum + 1)) > db->htMappedSize)
-               {
-                  Kdb_bool temp;
-                  if (db->htFd <= 0)
-                  {
-                     db->htFd = kdbShmemOpen(db->htName,  db->htMappedSize, &temp);
-                     if(db->htFd < 0)
-                     {
-                        return KISSDB_ERROR_OPEN_SHM;
-                     }
-                  }
-                  result = resizeKdbShmem(db->htFd, &db->hashTables, db->htMappedSize, db->htMappedSize + db->htSizeBytes);
-                  if (result == Kdb_false)
-                  {
-                     return KISSDB_ERROR_RESIZE_SHM;
-                  }
-                  else
-                  {
-                     db->shared->htShmSize = db->htMappedSize + db->htSizeBytes;
-                     db->htMappedSize = db->shared->htShmSize;
-                  }
-               }
-               // copy the current hashtable read from file to (htadress + (htsize  * htcount)) in memory
-               memcpy(((uint8_t*) db->hashTables) + (db->htSizeBytes * db->shared->htNum), htptr, db->htSizeBytes);
-               ++db->shared->htNum;
-
-               //read until all linked hashtables have been read
-               if (htptr->slots[db->htSize].offsetA ) //if a offset to a further hashtable exists
-               {
-                  htptr = (Hashtable_s*) (db->mappedDb + htptr->slots[db->htSize].offsetA); //follow link to next hashtable
-                  offset = htptr->slots[db->htSize].offsetA;
-               }
-               else //no link to next hashtable or link is invalid
-               {
-                  htFound = Kdb_false;
-               }
-            }
-            else //delimiters of first hashtable or linked hashtable are invalid
-            {
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": hashtable delimiters are invalid -> rebuild not possible!"));
-               htFound = Kdb_false;
-            }
+            Kdb_unlock(&db->shared->rwlock);
+            return ret;
          }
       }
       /*
@@ -521,7 +1200,14 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
          if (checkErrorFlags(db) != 0)
          {
             DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": database was not closed correctly in last lifecycle!"));
-            if (verifyHashtableCS(db) != 0)
+            closeFailed = Kdb_true;
+            recoverDataEnd(db);
+            if (recoverFromCheckpoint(db) == 0)
+            {
+               DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": hashtables recovered from checkpoint!"));
+               checkpointRecovered = Kdb_true;
+            }
+            else if (verifyHashtableCS(db) != 0)
             {
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": A hashtable is invalid -> Start rebuild of hashtables!"));
                if (rebuildHashtables(db) != 0) //hashtables are corrupt, walk through the database and search for data blocks -> then rebuild the hashtables
@@ -542,7 +1228,47 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
                recoverDataBlocks(db);
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":End datablock check / recovery!"));
             }
+            //the recovered hashtables are all in the shared memory, their offsets are looked up again along their links
+            memset(db->shared->htLoaded, 0xFF, sizeof(db->shared->htLoaded));
+            db->shared->htOffsetCount = 0;
+         }
+      }
+      if (lazyLoaded == Kdb_true)
+      {
+         db->shared->htUsedSlots = (uint32_t) ((Header_s*) db->mappedDb)->htUsedSlots;
+      }
+      else
+      {
+         db->shared->htUsedSlots = countHashtableSlots(db);
+      }
+
+      if (db->shared->openMode != KISSDB_OPEN_MODE_RDONLY)
+      {
+         /* the free lists stored in the header are only valid if the file was closed correctly or recovered from a checkpoint */
+         if (closeFailed == Kdb_true && checkpointRecovered == Kdb_false)
+         {
+            if (rebuildFreeLists(db) != 0) //released data blocks are not reused until the next rebuild
+            {
+               DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": rebuild of free lists failed!"));
+            }
+         }
+         else
+         {
+            memcpy(db->shared->freeList, ((Header_s*) db->mappedDb)->freeList, sizeof(db->shared->freeList));
+         }
+
+         //inline values are set from the data blocks after a power loss
+         if (closeFailed == Kdb_true)
+         {
+            setAllSlotInlineValues(db);
+         }
+
+         //the first checkpoint of this lifecycle persists the recovered hashtables
+         if (closeFailed == Kdb_true && checkpointRecovered == Kdb_false)
+         {
+            setAllHashtablesDirty(db);
          }
+         checkpointHashtables(db);
       }
    }
    else
@@ -567,12 +1293,28 @@ int KISSDB_close(KISSDB* db)
    printf("  START: KISSDB_CLOSE \n");
 #endif
 
-   Hashtable_s* htptr = NULL;
    Header_s* ptr = 0;
-   uint64_t  crc = 0;
+   Kdb_view_pin_s* pin;
+   uint32_t count = 0;
+   uint32_t i = 0;
+   int ret = 0;
 
    Kdb_wrlock(&db->shared->rwlock);
 
+   //views which were not released are invalid after the close
+   for (i = 0; i < KISSDB_VIEW_PIN_COUNT && db->viewPins > 0; i++)
+   {
+      pin = &db->shared->viewPin[i];
+      if (pin->pid == (int32_t) getpid())
+      {
+         count = (pin->count < db->viewPins) ? pin->count : db->viewPins;
+         db->viewPins -= count;
+         unpinView(db, pin, count);
+      }
+   }
+   db->viewPins = 0;
+   unmapRetiredMappings(db);
+
    //if no other instance has opened the database
    if( db->shared->refCount == 0)
    {
@@ -589,43 +1331,25 @@ int KISSDB_close(KISSDB* db)
                db->htMappedSize = db->shared->htShmSize;
             }
          }
-         //remap database file if in the meanwhile another process added new data (key value pairs / hashtables) to the file (only happens if writethrough is used)
-         if (db->dbMappedSize < db->shared->mappedDbSize)
+         //remap database file if in the meanwhile another process added new data (key value pairs / hashtables) to the file (only happens if writethrough is used) or compacted it
+         if (db->dbMappedSize != db->shared->mappedDbSize)
          {
-            db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize, MREMAP_MAYMOVE);
-            if (db->mappedDb == MAP_FAILED)
-            {
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":mremap error: !"), DLT_STRING(strerror(errno)));
-               return KISSDB_ERROR_IO;
-            }
-            else
+            ret = remapDatabaseFile(db, db->shared->mappedDbSize);
+            if (ret != 0)
             {
-               db->dbMappedSize = db->shared->mappedDbSize;
+               return ret;
             }
          }
 
-         // generate checksum for every hashtable and write crc to file
+         // generate checksum for every modified hashtable and write it with its crc to file
          if (db->fd)
          {
-            int i = 0;
-            int offset = sizeof(Header_s); //offset in file to first hashtable
-            if (db->shared->htNum > 0) //if hashtables exist
-            {
-               //write hashtables and crc to file
-               for (i = 0; i < db->shared->htNum; i++)
-               {
-                  crc = 0;
-                  crc = (uint64_t) pcoCrc32(crc, (unsigned char*) db->hashTables[i].slots, sizeof(db->hashTables[i].slots));
-                  db->hashTables[i].crc = crc;
-                  htptr = (Hashtable_s*) (db->mappedDb +  offset);
-                  //copy hashtable and generated crc from shared memory to mapped hashtable in file
-                  memcpy(htptr, &db->hashTables[i], db->htSizeBytes);
-                  offset = db->hashTables[i].slots[db->htSize].offsetA;
-               }
-            }
+            writeHashtables(db, Kdb_true);
          }
-         //update header (close flags)
+         //update header (close flags), the checkpoint and the journal are only used while the database is open
          ptr = (Header_s*) db->mappedDb;
+         ptr->checkpoint = 0;
+         ptr->journalCount = 0;
          ptr->closeFailed = 0x00; //remove closeFailed flag
          ptr->closeOk = 0x01;     //set closeOk flag
          msync(db->mappedDb, KISSDB_HEADER_SIZE, MS_SYNC);
@@ -635,6 +1359,15 @@ int KISSDB_close(KISSDB* db)
       munmap(db->mappedDb, db->dbMappedSize);
       db->mappedDb = NULL;
 
+      //cut off the preallocated area behind the end of the data
+      if (db->shared->openMode != KISSDB_OPEN_MODE_RDONLY && db->shared->dataEnd < db->shared->mappedDbSize)
+      {
+         if (ftruncate(db->fd, (off_t) db->shared->dataEnd) < 0)
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": ftruncate error: "), DLT_STRING(strerror(errno)));
+         }
+      }
+
       //unmap shared hashtables
       munmap(db->hashTables, db->htMappedSize);
       db->hashTables = NULL;
@@ -815,123 +1548,108 @@ int KISSDB_close(KISSDB* db)
 }
 
 
-int KISSDB_get(KISSDB* db, const void* key, void* vbuf, uint32_t bufsize, uint32_t* vsize)
+/*
+ * searches a key in the hashtable selected by its hash (linear probing starting at the hashed slot)
+ * slot returns the slot of the key, freeSlot (optional) the first deleted slot on the probe path
+ * or the empty slot that ended the search (NULL if the hashtable has no free slot)
+ * the key length and key hash are compared first, the key in the data block is only read if they match
+ * with matchInline a slot with an inline value matches by key length, key hash and the checksum of the key (without reading the data block)
+ * returns 0 if the key was found, 1 if the key is not in the database, negative on error
+ */
+static int findHashtableSlot(KISSDB* db, const void* key, unsigned long klen, uint64_t hash,
+                             Hashtable_slot_s** slot, Hashtable_slot_s** freeSlot, Kdb_bool matchInline)
 {
-   const uint8_t* kptr;
    DataBlock_s* block;
    Hashtable_slot_s* hashTable;
+   Hashtable_slot_s* entry;
    int64_t offset;
-   Kdb_bool bCanContinue = Kdb_true;
-   Kdb_bool bKeyFound = Kdb_false;
-   uint64_t hash = 0;
-   unsigned long klen, i;
+   uint32_t first = 0;
+   uint32_t k = 0;
+   uint32_t keyCheck = 0;
+   Kdb_bool keyChecked = Kdb_false;
 
-   klen = strlen(key);
-   hash = KISSDB_hash(key, klen) % (uint64_t) db->htSize;
-
-   if(db->htMappedSize < db->shared->htShmSize)
+   *(slot) = NULL;
+   if (freeSlot != NULL)
    {
-      if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
-      {
-         return KISSDB_ERROR_RESIZE_SHM;
-      }
-      else
-      {
-         db->htMappedSize = db->shared->htShmSize;
-      }
+      *(freeSlot) = NULL;
+   }
+   if (db->shared->htNum == 0)
+   {
+      return 1; /* not found */
    }
 
-   hashTable = db->hashTables[0].slots; //pointer to first hashtable in memory at first slot
-
-   if (db->dbMappedSize < db->shared->mappedDbSize)
+   hashTable = getHashtable(db, getHashtableNumber(db, hash))->slots;
+   first = getHashtableSlot(db, hash);
+   for (k = 0; k < db->htSize; k++)
    {
-      db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize, MREMAP_MAYMOVE);
-      if (db->mappedDb == MAP_FAILED)
+      entry = &hashTable[(first + k) % db->htSize];
+      if (entry->offsetA == 0) //empty slot -> end of probe sequence
       {
-         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":mremap error: !"), DLT_STRING(strerror(errno)));
-         return KISSDB_ERROR_IO;
+         if (freeSlot != NULL && *(freeSlot) == NULL)
+         {
+            *(freeSlot) = entry;
+         }
+         return 1; /* not found */
       }
-      else
+      if (entry->offsetA < 0) //deleted or invalidated data -> continue with next slot
       {
-         db->dbMappedSize = db->shared->mappedDbSize;
+         if (freeSlot != NULL && *(freeSlot) == NULL)
+         {
+            *(freeSlot) = entry;
+         }
+         continue;
       }
-   }
-
-
-   for (i = 0; i < db->shared->htNum; ++i)
-   {
-      //get information about current valid offset to latest written data
-      offset = (hashTable[hash].current == 0x00) ? hashTable[hash].offsetA : hashTable[hash].offsetB; // if 0x00 -> offsetA is latest else offsetB is latest
-      if(offset < 0) //deleted or invalidated data but search in next hashtable
+      //compare key length and key hash first: the data block is only read if they match
+      if (entry->keyLength != klen || entry->fingerprint != (uint32_t) (hash >> 32) || entry->bucketHash != (uint16_t) hash)
       {
-         bCanContinue = Kdb_false; //deleted datablock -> do not compare the key
+         continue;
       }
-      else
+      if (matchInline == Kdb_true && isSlotInline(entry) == Kdb_true)
       {
-         bCanContinue = Kdb_true; //possible match -> compare the key
-      }
-
-      if(Kdb_true == bCanContinue)
-      {
-         if( abs(offset) > db->dbMappedSize )
-         {
-            return KISSDB_ERROR_IO;
-         }
-         if (offset >= KISSDB_HEADER_SIZE) //if a valid offset is available in the slot
+         if (keyChecked == Kdb_false) //the checksum is only calculated if a slot with an inline value is reached
          {
-            block = (DataBlock_s*) (db->mappedDb +  offset);
-            kptr = (const uint8_t*) key;
-            if (klen > 0)
-            {
-               if (memcmp(kptr, block->key, klen)
-                     || strlen(block->key) != klen) //if search key does not match with key in file
-               {
-                  bKeyFound = Kdb_false;
-               }
-               else
-               {
-                  bKeyFound = Kdb_true;
-               }
-            }
-            if(Kdb_true == bKeyFound)
-            {
-               //copy found value if buffer is big enough
-               if(bufsize >= block->valSize)
-               {
-                  memcpy(vbuf, block->value, block->valSize);
-               }
-               *(vsize) = block->valSize;
-               return 0; /* success */
-            }
+            keyCheck = getInlineKeyCheck(db, key, klen);
+            keyChecked = Kdb_true;
          }
-         else
+         if (getSlotInlineKeyCheck(entry) != keyCheck) //another key with the same key length and key hash
          {
-            return 1; /* not found */
+            continue;
          }
+         *(slot) = entry;
+         return 0; /* found */
+      }
+      //get information about current valid offset to latest written data
+      offset = getSlotCurrentOffset(db, entry);
+      if (offset < KISSDB_HEADER_SIZE || offset > db->dbMappedSize)
+      {
+         return KISSDB_ERROR_IO;
+      }
+      block = (DataBlock_s*) (db->mappedDb + offset);
+      if (klen > 0 && memcmp(key, block->key, klen) == 0 && strnlen(block->key, db->keyFieldSize) == klen) //search key matches with key in file
+      {
+         *(slot) = entry;
+         return 0; /* found */
       }
-      hashTable = (Hashtable_slot_s*) ((char*) hashTable + sizeof(Hashtable_s));  //pointer to the next memory-hashtable
    }
    return 1; /* not found */
 }
 
 
-int KISSDB_delete(KISSDB* db, const void* key, int32_t* bytesDeleted)
+uint64_t KISSDB_getKeyHash(KISSDB* db, const void* key)
+{
+   return db->keyHash(key, strlen(key));
+}
+
+
+int KISSDB_get(KISSDB* db, const void* key, uint64_t hash, void* vbuf, uint32_t bufsize, uint32_t* vsize, uint32_t* vflags)
 {
-   const uint8_t* kptr;
-   DataBlock_s* backupBlock;
    DataBlock_s* block;
-   Hashtable_slot_s* hashTable;
-   int64_t backupOffset = 0;
-   int64_t offset = 0;
-   Kdb_bool bCanContinue = Kdb_true;
-   Kdb_bool bKeyFound = Kdb_false;
-   uint64_t hash = 0;
-   uint64_t crc = 0x00;
-   unsigned long klen, i;
+   Hashtable_slot_s* slot;
+   int64_t offset;
+   int ret = 0;
+   unsigned long klen;
 
    klen = strlen(key);
-   hash = KISSDB_hash(key, klen) % (uint64_t) db->htSize;
-   *(bytesDeleted) = PERS_COM_ERR_NOT_FOUND;
 
    if(db->htMappedSize < db->shared->htShmSize)
    {
@@ -945,143 +1663,56 @@ int KISSDB_delete(KISSDB* db, const void* key, int32_t* bytesDeleted)
       }
    }
 
-   hashTable = db->hashTables->slots; //pointer to current hashtable in memory
-
-   //remap database file if in the meanwhile another process added new data (key value pairs / hashtables) to the file
-   if (db->dbMappedSize < db->shared->mappedDbSize)
+   if (db->dbMappedSize != db->shared->mappedDbSize)
    {
-      db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize, MREMAP_MAYMOVE);
-      if (db->mappedDb == MAP_FAILED)
+      ret = remapDatabaseFile(db, db->shared->mappedDbSize);
+      if (ret != 0)
       {
-         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":mremap error: !"), DLT_STRING(strerror(errno)));
-         return KISSDB_ERROR_IO;
+         return ret;
       }
-      db->dbMappedSize = db->shared->mappedDbSize;
    }
 
-   for (i = 0; i < db->shared->htNum; ++i)
+   ret = findHashtableSlot(db, key, klen, hash, &slot, NULL, Kdb_true);
+   if (ret != 0)
    {
-      //get information about current valid offset to latest written data
-      if (hashTable[hash].current == 0x00) //valid is offsetA
-      {
-         offset = hashTable[hash].offsetA;
-         backupOffset = hashTable[hash].offsetB;
-      }
-      else
-      {
-         offset = hashTable[hash].offsetB;
-         backupOffset = hashTable[hash].offsetA;
-      }
-      if (offset < 0) //deleted or invalidated data but search in next hashtable
-      {
-         bCanContinue = Kdb_false;
-      }
-      else
+      return ret; /* not found or error */
+   }
+   if (isSlotInline(slot) == Kdb_true) //small values are read from the slot
+   {
+      if (bufsize >= getSlotInlineValueSize(slot))
       {
-         bCanContinue = Kdb_true;
+         memcpy(vbuf, &slot->offsetB, getSlotInlineValueSize(slot));
       }
-      if (Kdb_true == bCanContinue)
+      *(vsize) = getSlotInlineValueSize(slot);
+      if (vflags != NULL)
       {
-         if (offset >= KISSDB_HEADER_SIZE)
-         {
-            if( abs(offset) > db->dbMappedSize || abs(backupOffset) >  db->dbMappedSize)
-            {
-               return KISSDB_ERROR_IO;
-            }
-
-            block = (DataBlock_s*) (db->mappedDb +  offset);
-            kptr = (const uint8_t*) key;  //pointer to search key
-            if (klen > 0)
-            {
-               if (memcmp(kptr, block->key, klen) || strlen(block->key) != klen) //if search key does not match with key in file
-               {
-                  bKeyFound = Kdb_false;
-               }
-               else
-               {
-                  bKeyFound = Kdb_true;
-               }
-            }
-            /* data to be deleted was found
-             write "deleted block delimiters" for both blocks and delete key / value */
-            if (Kdb_true == bKeyFound)
-            {
-               block->delimStart = (offset < backupOffset) ? DATA_BLOCK_A_DELETED_START_DELIMITER : DATA_BLOCK_B_DELETED_START_DELIMITER;
-               //memset(block->key,   0, db->keySize); //do not delete key -> used in hashtable rebuild
-               memset(block->value, 0, db->valSize);
-               block->valSize = 0;
-               crc = 0x00;
-               crc = (uint32_t) pcoCrc32(crc, (unsigned char*)block->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t) );
-               block->crc = crc;
-               block->delimEnd = (offset < backupOffset) ? DATA_BLOCK_A_DELETED_END_DELIMITER : DATA_BLOCK_B_DELETED_END_DELIMITER;
-
-               backupBlock = (DataBlock_s*) (db->mappedDb +  backupOffset);  //map data and backup block
-
-               backupBlock->delimStart = (backupOffset < offset) ? DATA_BLOCK_A_DELETED_START_DELIMITER : DATA_BLOCK_B_DELETED_START_DELIMITER;
-               //memset(backupBlock->key,   0, db->keySize);
-               memset(backupBlock->value, 0, db->valSize);
-               backupBlock->valSize = 0;
-               crc = 0x00;
-               crc = (uint32_t) pcoCrc32(crc, (unsigned char*)backupBlock->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t) );
-               backupBlock->crc = crc;
-               backupBlock->delimEnd = (backupOffset < offset) ? DATA_BLOCK_A_DELETED_END_DELIMITER : DATA_BLOCK_B_DELETED_END_DELIMITER;
-
-
-               //negate offsetB, delete checksums and current flag in memory
-               hashTable[hash].offsetA = -hashTable[hash].offsetA; //negate offset in hashtable that points to the data
-               hashTable[hash].offsetB = -hashTable[hash].offsetB;
-               hashTable[hash].current = 0x00;
-
-               *(bytesDeleted) = block->valSize;
-               return 0; /* success */
-            }
-         }
-         else
-         {
-            return 1; /* not found */ //if no offset is found at hashed position in slots
-         }
+         *(vflags) = 0;
       }
-      hashTable = (Hashtable_slot_s*) ((char*) hashTable + sizeof(Hashtable_s));  //pointer to the next memory-hashtable
+      return 0; /* success */
    }
-   return 1; /* not found */
+   offset = getSlotCurrentOffset(db, slot);
+   block = (DataBlock_s*) (db->mappedDb +  offset);
+   //copy found value if buffer is big enough
+   if(bufsize >= getDataBlockInfo(db, block)->valSize)
+   {
+      memcpy(vbuf, getDataBlockValue(db, block), getDataBlockInfo(db, block)->valSize);
+   }
+   *(vsize) = getDataBlockInfo(db, block)->valSize;
+   if (vflags != NULL)
+   {
+      *(vflags) = getDataBlockInfo(db, block)->valFlags;
+   }
+   return 0; /* success */
 }
 
-// To improve write amplifiction: sort the keys at writeback for sequential write
-//return offset where key would be written if Kissdb_put with same key is called
-//int determineKeyOffset(KISSDB* db, const void* key)
-//{
-//   /*
-//    * - hash the key,
-//    * - go through hashtables and get corresponding offset to hash
-//    * - if offset is negative return the inverse offset
-//    * - if key matches at file offset return this offset
-//    */
-//   return 0;
-//}
-
 
-
-
-int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, int32_t* bytesWritten)
+int KISSDB_getView(KISSDB* db, const void* key, uint64_t hash, const void** value, uint32_t* vsize, uint32_t* vflags)
 {
-   const uint8_t* kptr;
-   DataBlock_s* backupBlock;
    DataBlock_s* block;
-   Hashtable_s* hashtable;
-   Hashtable_s* htptr;
-   Hashtable_slot_s* hashTable;
-   int64_t offset, backupOffset, endoffset;
-   Kdb_bool bKeyFound = Kdb_false;
-   Kdb_bool result = Kdb_false;
-   Kdb_bool temp = Kdb_false;
-   uint64_t crc = 0x00;
-   uint64_t hash = 0;
-   unsigned long klen, i;
-
-   klen = strlen(key);
-   hash = KISSDB_hash(key, klen) % (uint64_t) db->htSize;
-   *(bytesWritten) = 0;
+   Hashtable_slot_s* slot;
+   int ret = 0;
 
+   *(value) = NULL;
    if(db->htMappedSize < db->shared->htShmSize)
    {
       if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
@@ -1094,1277 +1725,3239 @@ int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, in
       }
    }
 
-   hashTable = db->hashTables->slots; //pointer to current hashtable in memory
-
-   //remap database file (only necessary here in writethrough mode) if in the meanwhile another process added new data (key value pairs / hashtables) to the file
-   if (db->dbMappedSize < db->shared->mappedDbSize)
+   if (db->dbMappedSize != db->shared->mappedDbSize)
    {
-      db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize, MREMAP_MAYMOVE);
-      if (db->mappedDb == MAP_FAILED)
+      ret = remapDatabaseFile(db, db->shared->mappedDbSize);
+      if (ret != 0)
       {
-         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":mremap error: !"), DLT_STRING(strerror(errno)));
-         return KISSDB_ERROR_IO;
+         return ret;
       }
-      db->dbMappedSize = db->shared->mappedDbSize;
    }
 
-
-   for (i = 0; i < db->shared->htNum; ++i)
+   ret = findHashtableSlot(db, key, strlen(key), hash, &slot, NULL, Kdb_true);
+   if (ret != 0)
+   {
+      return ret; /* not found or error */
+   }
+   if (isSlotInline(slot) == Kdb_true)
    {
-      offset = hashTable[hash].offsetA;   //fileoffset to data in file
-      if (offset >= KISSDB_HEADER_SIZE || offset < 0) //if a key with same hash is already in this slot or the same key must be overwritten
+      *(vsize) = getSlotInlineValueSize(slot);
+      if (vflags != NULL)
       {
-         if( abs(offset) > db->dbMappedSize )
-         {
-            return KISSDB_ERROR_IO;
-         }
-
-         // if slot is marked as deleted, use this slot and negate the offset in order to reuse the existing data block
-         if(offset < 0)
-         {
-            offset = -offset; //get original offset where data was deleted
-            //printf("Overwriting slot for key: [%s] which was deleted before, offsetA: %d \n",key, offset);
-            writeDualDataBlock(db, offset, i, key, klen, value, valueSize);
-            hashTable[hash].offsetA = offset; //write the offset to the data in the memory-hashtable slot
-            offset += sizeof(DataBlock_s);
-            hashTable[hash].offsetB = offset; //write the offset to the second databloxk in the memory-hashtable slot
-            hashTable[hash].current = 0x00;
-            *(bytesWritten) = valueSize;
-
-            return 0; /* success */
-         }
-         //overwrite existing if key matches
-         offset = (hashTable[hash].current == 0x00) ? hashTable[hash].offsetA : hashTable[hash].offsetB; // if 0x00 -> offsetA is latest else offsetB is latest
-         block = (DataBlock_s*) (db->mappedDb +  offset);
-         kptr = (const uint8_t*) key;  //pointer to search key
-         if (klen > 0)
-         {
-            if (memcmp(kptr, block->key, klen)
-                  || strlen(block->key) != klen) //if search key does not match with key in file
-            {
-               //if key does not match -> search in next hashtable
-               bKeyFound = Kdb_false;
-            }
-            else
-            {
-               bKeyFound = Kdb_true;
-            }
-         }
-         if(Kdb_true == bKeyFound)
-         {
-            backupOffset = (hashTable[hash].current == 0x00) ? hashTable[hash].offsetB : hashTable[hash].offsetA; // if 0x00 -> offsetB is latest backup  else offsetA is latest
-
-            //ALSO OVERWRITE LATEST VALID BLOCK to improve write amplification factor
-            block->delimStart = (offset < backupOffset) ? DATA_BLOCK_A_START_DELIMITER : DATA_BLOCK_B_START_DELIMITER;
-            block->valSize = valueSize;
-            memcpy(block->value,value, block->valSize);
-            block->htNum = i;
-            crc = 0x00;
-            crc = (uint32_t) pcoCrc32(crc, (unsigned char*)block->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t) );
-            block->crc = crc;
-            block->delimEnd = (offset < backupOffset) ? DATA_BLOCK_A_END_DELIMITER : DATA_BLOCK_B_END_DELIMITER;
-
-            //if key matches -> seek to currently non valid data block for this key
-            backupOffset = (hashTable[hash].current == 0x00) ? hashTable[hash].offsetB : hashTable[hash].offsetA; // if 0x00 -> offsetB is latest backup  else offsetA is latest
-            backupBlock = (DataBlock_s*) (db->mappedDb +  backupOffset);
-            //backupBlock->delimStart = DATA_BLOCK_START_DELIMITER;
-            backupBlock->delimStart = (backupOffset < offset) ? DATA_BLOCK_A_START_DELIMITER : DATA_BLOCK_B_START_DELIMITER;
-            backupBlock->valSize = valueSize;
-            memcpy(backupBlock->value,value, backupBlock->valSize);
-            backupBlock->htNum = i;
-            crc = 0x00;
-            crc = (uint32_t) pcoCrc32(crc, (unsigned char*)backupBlock->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t) );
-            backupBlock->crc = crc;
-            //backupBlock->delimEnd = DATA_BLOCK_END_DELIMITER;
-            backupBlock->delimEnd = (backupOffset < offset) ? DATA_BLOCK_A_END_DELIMITER : DATA_BLOCK_B_END_DELIMITER;
-            // check current flag and decide what parts of hashtable slot in file must be updated
-            hashTable[hash].current = (hashTable[hash].current == 0x00) ? 0x01 : 0x00; // if 0x00 -> offsetA is latest -> set to 0x01 else /offsetB is latest -> modify settings of A set 0x00
-            *(bytesWritten) = valueSize;
-
-            return 0; //success
-         }
-      }
-      else //if key is not already inserted
-      {
-         /* add new data if an empty hash table slot is discovered */
-         endoffset = db->shared->mappedDbSize;
-         if ( -1 == endoffset) //filepointer to the end of the file
-         {
-            return KISSDB_ERROR_IO;
-         }
-
-         //truncate file -> data + backup block
-         if( ftruncate(db->fd, endoffset + ( sizeof(DataBlock_s) * 2) ) < 0)
-         {
-            return KISSDB_ERROR_IO;
-         }
-
-         db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize + (sizeof(DataBlock_s) * 2), MREMAP_MAYMOVE);
-         if (db->mappedDb == MAP_FAILED)
-         {
-            DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":mremap error: !"),DLT_STRING(strerror(errno)));
-            return KISSDB_ERROR_IO;
-         }
+         *(vflags) = 0;
+      }
+      return 0; /* no view of inline values */
+   }
+   block = (DataBlock_s*) (db->mappedDb + getSlotCurrentOffset(db, slot));
+   *(vsize) = getDataBlockInfo(db, block)->valSize;
+   if (vflags != NULL)
+   {
+      *(vflags) = getDataBlockInfo(db, block)->valFlags;
+   }
+   if ((getDataBlockInfo(db, block)->valFlags & KISSDB_VALUE_COMPRESSED) == 0
+         && pinView(db, slot->offsetA, (int64_t) (getDataBlockValue(db, block) - db->mappedDb)) == Kdb_true)
+   {
+      *(value) = getDataBlockValue(db, block);
+   }
+   return 0; /* success */
+}
 
-         db->shared->mappedDbSize = db->shared->mappedDbSize + (sizeof(DataBlock_s) * 2); //shared info about database file size
-         db->dbMappedSize = db->shared->mappedDbSize; //local info about mapped size of file
 
-         writeDualDataBlock(db, endoffset, i, key, klen, value, valueSize);
+static int compareReadOffsets(const void* a, const void* b)
+{
+   int64_t offsetA = (*(KISSDB_Read_s* const*) a)->offset;
+   int64_t offsetB = (*(KISSDB_Read_s* const*) b)->offset;
+   return (offsetA > offsetB) - (offsetA < offsetB);
+}
 
-         //update hashtable entry
-         offset = endoffset + sizeof(DataBlock_s);
-         hashTable[hash].offsetA = endoffset; //write the offsetA to the data in the memory-hashtable slot
-         hashTable[hash].offsetB = offset;    //write the offset to the data in the memory-hashtable slot
-         hashTable[hash].current = 0x00;
 
-         *(bytesWritten) = valueSize;
-         return 0; /* success */
-      }
-      hashTable = (Hashtable_slot_s*) ((char*) hashTable + sizeof(Hashtable_s));  //pointer to the next memory-hashtable
-   }
+int KISSDB_getBatch(KISSDB* db, KISSDB_Read_s* reads, uint32_t count)
+{
+   DataBlock_s* block;
+   Hashtable_slot_s* slot;
+   KISSDB_Read_s** order;
+   uint32_t ordered = 0;
+   uint32_t i = 0;
+   int ret = 0;
 
-   //if new size would exceed old shared memory size for hashtables-> allocate additional memory to shared memory (+ db->htSizeBytes)
-   if( (db->htSizeBytes * (db->shared->htNum + 1)) > db->shared->htShmSize)
+   if(db->htMappedSize < db->shared->htShmSize)
    {
-      //munlockall();
-      if (db->htFd <= 0)
-      {
-         db->htFd = kdbShmemOpen(db->htName,  db->htMappedSize, &temp);
-         if(db->htFd < 0)
-         {
-            return KISSDB_ERROR_OPEN_SHM;
-         }
-      }
-      result = resizeKdbShmem(db->htFd, &db->hashTables, db->htMappedSize, db->htMappedSize + db->htSizeBytes);
-      if (result == Kdb_false)
+      if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
       {
          return KISSDB_ERROR_RESIZE_SHM;
       }
       else
       {
-         db->shared->htShmSize = db->htMappedSize + db->htSizeBytes;
          db->htMappedSize = db->shared->htShmSize;
       }
-      //mlockall(MCL_FUTURE);
    }
 
-   /* if no existing slots, add a new page of hash table entries */
-   endoffset = db->shared->mappedDbSize;
-   if ( -1 == endoffset) //filepointer to the end of the file
+   if (db->dbMappedSize != db->shared->mappedDbSize)
    {
-      return KISSDB_ERROR_IO;
+      ret = remapDatabaseFile(db, db->shared->mappedDbSize);
+      if (ret != 0)
+      {
+         return ret;
+      }
    }
-   //truncate file in order to save new hashtable + two Datablocks (this does not modify filedescriptor)
-   if (ftruncate(db->fd, endoffset + db->htSizeBytes + (sizeof(DataBlock_s) * 2)) < 0)
+
+   order = (KISSDB_Read_s**) malloc((count > 0 ? count : 1) * sizeof(KISSDB_Read_s*));
+   if (order == NULL)
    {
-      return KISSDB_ERROR_IO;
+      return KISSDB_ERROR_MALLOC;
    }
-
-   db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize + (db->htSizeBytes + (sizeof(DataBlock_s) * 2)), MREMAP_MAYMOVE);
-   if (db->mappedDb == MAP_FAILED)
+   //all keys are looked up first, inline values are read from their slots
+   for (i = 0; i < count; i++)
    {
-      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":mremap error: !"),DLT_STRING(strerror(errno)));
-      return KISSDB_ERROR_IO;
+      reads[i].vsize = 0;
+      reads[i].vflags = 0;
+      reads[i].offset = 0;
+      reads[i].result = findHashtableSlot(db, reads[i].key, strlen(reads[i].key), reads[i].hash, &slot, NULL, Kdb_true);
+      if (reads[i].result != 0)
+      {
+         continue; /* not found or error */
+      }
+      if (isSlotInline(slot) == Kdb_true)
+      {
+         reads[i].vsize = getSlotInlineValueSize(slot);
+         if (reads[i].bufsize >= reads[i].vsize)
+         {
+            memcpy(reads[i].vbuf, &slot->offsetB, reads[i].vsize);
+         }
+         continue;
+      }
+      reads[i].offset = getSlotCurrentOffset(db, slot);
+      order[ordered++] = &reads[i];
    }
-   db->shared->mappedDbSize = db->shared->mappedDbSize + (db->htSizeBytes + (sizeof(DataBlock_s) * 2));
-   db->dbMappedSize = db->shared->mappedDbSize;
-
-   //prepare new hashtable in shared memory
-   hashtable = &(db->hashTables[db->shared->htNum]);
-   memset(hashtable, 0, db->htSizeBytes); //hashtable init
-   hashtable->delimStart = HASHTABLE_START_DELIMITER;
-   hashtable->delimEnd = HASHTABLE_END_DELIMITER;
-   hashtable->crc = 0x00;
-   hashTable = hashtable->slots; //pointer to the next memory-hashtable
-   hashTable[hash].offsetA = endoffset + db->htSizeBytes; /* where new entry will go (behind the new Ht that gets written)*/
-   hashTable[hash].offsetB = hashTable[hash].offsetA + sizeof(DataBlock_s);//write the offset to the data in the memory-hashtable slot
-   hashTable[hash].current = 0x00;
-
-   htptr = (Hashtable_s*) (db->mappedDb + endoffset);
-   //copy hashtable in shared memory to mapped hashtable in file
-   memcpy(htptr, hashtable, db->htSizeBytes);
-   //write data behind new hashtable
-   writeDualDataBlock(db, endoffset + db->htSizeBytes, db->shared->htNum, key, klen, value, valueSize);
-   //if a hashtable exists, update link to new hashtable in previous hashtable
-   if (db->shared->htNum)
+   //the values are copied in the order of their data blocks in the file
+   qsort(order, ordered, sizeof(KISSDB_Read_s*), compareReadOffsets);
+   for (i = 0; i < ordered; i++)
    {
-      db->hashTables[db->shared->htNum -1].slots[HASHTABLE_SLOT_COUNT].offsetA = endoffset; //update link to new hashtable in previous hashtable
+      block = (DataBlock_s*) (db->mappedDb + order[i]->offset);
+      order[i]->vsize = getDataBlockInfo(db, block)->valSize;
+      order[i]->vflags = getDataBlockInfo(db, block)->valFlags;
+      if (order[i]->bufsize >= order[i]->vsize)
+      {
+         memcpy(order[i]->vbuf, getDataBlockValue(db, block), order[i]->vsize);
+      }
    }
-   ++db->shared->htNum;
+   free(order);
+   return 0;
+}
 
-   *(bytesWritten) = valueSize;
 
-   return 0; /* success */
+Kdb_bool KISSDB_isView(KISSDB* db, const void* value)
+{
+   return (db->viewPins > 0 && getViewOffset(db, value) >= 0) ? Kdb_true : Kdb_false;
 }
 
 
-
-#if 0
-/*
- * prints the offsets stored in the shared Hashtable
- */
-void printSharedHashtable(KISSDB* db)
+void KISSDB_releaseView(KISSDB* db, const void* value)
 {
-   unsigned long k=0;
-   int i = 0;
+   Kdb_view_pin_s* pin;
 
-   for(i =0 ; i< db->shared->htNum; i++)
+   if (db->viewPins > 0)
    {
-      for (k = 0; k <= db->htSize; k++)
+      pin = findViewPin(db, (int32_t) getpid(), getViewOffset(db, value));
+      if (pin != NULL)
       {
-         printf("ht[%d] offsetA  [%lu]: %" PRId64 " \n",i, k, db->hashTables[i].slots[k].offsetA);
-         printf("ht[%d] offsetB  [%lu]: %" PRId64 " \n",i, k, db->hashTables[i].slots[k].offsetB);
-         printf("ht[%d] current  [%lu]: %" PRIu64 " \n",i, k, db->hashTables[i].slots[k].current);
+         unpinView(db, pin, 1);
+      }
+      db->viewPins--;
+      if (db->viewPins == 0)
+      {
+         unmapRetiredMappings(db);
       }
    }
 }
-#endif
 
 
-void KISSDB_Iterator_init(KISSDB* db, KISSDB_Iterator* dbi)
+/*
+ * sets the end of the data in the file, new data blocks and hashtables are appended here
+ * the copy in the header is updated before the appended data is referenced by the journal or a checkpoint
+ */
+static void setDataEnd(KISSDB* db, uint64_t dataEnd)
 {
-   dbi->db = db;
-   dbi->h_no = 0;  // number of read hashtables
-   dbi->h_idx = 0; // index in current hashtable
+   db->shared->dataEnd = dataEnd;
+   ((Header_s*) db->mappedDb)->dataEnd = dataEnd;
 }
 
 
-int KISSDB_Iterator_next(KISSDB_Iterator* dbi, void* kbuf, void* vbuf)
+/*
+ * makes sure that the database file and the mapping of this process hold size bytes
+ * the file grows geometrically (see KISSDB_MIN_FILE_GROWTH): appending data rarely needs a system call and a remap of all processes,
+ * the new area is allocated with fallocate() if the file system supports it
+ */
+static int growDatabaseFile(KISSDB* db, uint64_t size)
 {
-   DataBlock_s* block;
-   Hashtable_slot_s* ht;
-   int retVal = KISSDB_ITERATOR_NEXT_ITEM_NOT_FOUND;
-   int64_t offset;
+   uint64_t growth = db->shared->mappedDbSize / 2;
+   uint64_t pageSize = (uint64_t) sysconf(_SC_PAGESIZE);
+   uint64_t newSize = 0;
+   int ret = 0;
 
-   if(dbi->db->htMappedSize < dbi->db->shared->htShmSize)
+   if (size > db->shared->mappedDbSize)
    {
-      if ( Kdb_false == remapSharedHashtable(dbi->db->htFd, &dbi->db->hashTables, dbi->db->htMappedSize, dbi->db->shared->htShmSize))
+      if (growth < KISSDB_MIN_FILE_GROWTH)
       {
-         return KISSDB_ERROR_RESIZE_SHM;
+         growth = KISSDB_MIN_FILE_GROWTH;
       }
-      else
+      else if (growth > KISSDB_MAX_FILE_GROWTH)
+      {
+         growth = KISSDB_MAX_FILE_GROWTH;
+      }
+      newSize = (size > db->shared->mappedDbSize + growth) ? size : db->shared->mappedDbSize + growth;
+      newSize = (newSize + pageSize - 1) & ~(pageSize - 1);
+      if (fallocate(db->fd, 0, (off_t) db->shared->mappedDbSize, (off_t) (newSize - db->shared->mappedDbSize)) < 0)
       {
-         dbi->db->htMappedSize = dbi->db->shared->htShmSize;
+         //file system without fallocate() support: the blocks of the new area are allocated when written
+         if (ftruncate(db->fd, (off_t) newSize) < 0)
+         {
+            return KISSDB_ERROR_IO;
+         }
       }
+      db->shared->mappedDbSize = newSize; //shared info about database file size
    }
-
-   //remap database file if in the meanwhile another process added new data (key value pairs / hashtables) to the file
-   if (dbi->db->dbMappedSize < dbi->db->shared->mappedDbSize)
+   if (db->dbMappedSize != db->shared->mappedDbSize)
    {
-      dbi->db->mappedDb = mremap(dbi->db->mappedDb, dbi->db->dbMappedSize, dbi->db->shared->mappedDbSize, MREMAP_MAYMOVE);
-      if (dbi->db->mappedDb == MAP_FAILED)
+      ret = remapDatabaseFile(db, db->shared->mappedDbSize);
+      if (ret != 0)
       {
-         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":mremap error: !"), DLT_STRING(strerror(errno)));
-         return KISSDB_ERROR_IO;
+         return ret;
       }
-      dbi->db->dbMappedSize = dbi->db->shared->mappedDbSize;
    }
+   return 0;
+}
 
-   if ((dbi->h_no < (dbi->db->shared->htNum)) && (dbi->h_idx < dbi->db->htSize))
-   {
-      ht = dbi->db->hashTables[dbi->h_no].slots; //pointer to first hashtable
+int KISSDB_reserve(KISSDB* db, const int* valueSizes, uint32_t count)
+{
+   uint64_t size = 0;
+   uint32_t i = 0;
 
-      while ( !(ht[dbi->h_idx].offsetA || ht[dbi->h_idx].offsetB) ) //until a offset was found
+   if (db->shared->openMode == KISSDB_OPEN_MODE_RDONLY)
+   {
+      return KISSDB_ERROR_ACCESS_VIOLATION;
+   }
+   for (i = 0; i < count; i++)
+   {
+      if (valueSizes[i] < 0 || (uint64_t) valueSizes[i] > db->valSize)
       {
-         if (++dbi->h_idx >= dbi->db->htSize)
-         {
-            dbi->h_idx = 0;
-            if (++dbi->h_no >= (dbi->db->shared->htNum))
-            {
-               return KISSDB_ITERATOR_NEXT_ITEM_NOT_FOUND;//0
-            }
-            else
-            {
-               ht = dbi->db->hashTables[dbi->h_no].slots;   //next hashtable
-            }
-         }
+         return KISSDB_ERROR_INVALID_PARAMETERS;
       }
-      if(ht[dbi->h_idx].current == 0x00)
+      size += 2 * (uint64_t) getDataBlockSize(db, (uint64_t) valueSizes[i]);
+   }
+   if(db->htMappedSize < db->shared->htShmSize)
+   {
+      if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
       {
-         offset = ht[dbi->h_idx].offsetA;
-      }
-      else
-      {
-         offset = ht[dbi->h_idx].offsetB;
-      }
-
-      if( abs(offset) > dbi->db->dbMappedSize )
-      {
-         return KISSDB_ERROR_IO;
+         return KISSDB_ERROR_RESIZE_SHM;
       }
-
-      retVal = KISSDB_ITERATOR_NEXT_ITEM_FOUND;
-      if (offset >= 0)
-      {                    
-          block = (DataBlock_s*) (dbi->db->mappedDb + offset);
-          memcpy(kbuf,block->key, dbi->db->keySize);
-
-          if (vbuf != NULL)
-          {
-             memcpy(vbuf, block->value, dbi->db->valSize);
-          }
-      }     
       else
       {
-          retVal = KISSDB_ITERATOR_DELETED_ITEM;
-      }
-      if (++dbi->h_idx >= dbi->db->htSize)
-      {
-         dbi->h_idx = 0;
-         ++dbi->h_no;
+         db->htMappedSize = db->shared->htShmSize;
       }
-      return retVal;//1
    }
-   return KISSDB_ITERATOR_NEXT_ITEM_NOT_FOUND;//0
+   return growDatabaseFile(db, db->shared->dataEnd + size);
 }
 
-
-
-
-int readHeader(KISSDB* db, uint16_t* htSize, uint64_t* keySize, uint64_t* valSize)
+/*
+ * appends a new pair of data blocks (A and B) with the size class blockSize at the end of the data
+ * offset returns the file offset of the new data block A
+ */
+static int appendDualDataBlock(KISSDB* db, uint32_t blockSize, int64_t* offset)
 {
-   Header_s* ptr = 0;
-   ptr = (Header_s*) db->mappedDb;
+   int ret = growDatabaseFile(db, db->shared->dataEnd + (blockSize * 2));
 
-   if ((ptr->KdbV[0] != 'K') || (ptr->KdbV[1] != 'd') || (ptr->KdbV[2] != 'B') )
-   {
-      return KISSDB_ERROR_CORRUPT_DBFILE;
-   }
-   if( (ptr->KdbV[3] != KISSDB_MAJOR_VERSION) || (ptr->KdbV[4] != '.') || (ptr->KdbV[5] != KISSDB_MINOR_VERSION))
+   if (ret != 0)
    {
-      return KISSDB_ERROR_WRONG_DATABASE_VERSION;
+      return ret;
    }
-   if (!ptr->htSize)
+   *(offset) = (int64_t) db->shared->dataEnd;
+   setDataEnd(db, db->shared->dataEnd + blockSize * 2);
+   return 0;
+}
+
+/*
+ * marks a pair of data blocks which is no longer referenced by a hashtable slot as deleted
+ * the key is removed, so the blocks are ignored during a rebuild of the hashtables
+ * clearValue: the value areas are cleared (a value pinned by a view is kept until the pair is reused)
+ */
+static void freeDualDataBlock(KISSDB* db, int64_t offset, Kdb_bool clearValue)
+{
+   DataBlock_s* block = (DataBlock_s*) (db->mappedDb + offset);
+   DataBlock_s* backupBlock = (DataBlock_s*) (db->mappedDb + offset + getDataBlockInfo(db, block)->blockSize);
+
+   block->delimStart = DATA_BLOCK_A_DELETED_START_DELIMITER;
+   memset(block->key, 0, db->keyFieldSize);
+   if (clearValue == Kdb_true)
    {
-      return KISSDB_ERROR_CORRUPT_DBFILE;
+      memset(getDataBlockValue(db, block), 0, getDataBlockValueAreaSize(db, block));
    }
-   (*htSize) = (uint16_t) ptr->htSize;
-   if (!ptr->keySize)
+   getDataBlockInfo(db, block)->valSize = 0;
+   getDataBlockInfo(db, block)->valFlags = 0;
+   getDataBlockInfo(db, block)->sequence = 0;
+   block->crc = getDataBlockCrc(db, block);
+   *getDataBlockEndDelimiter(db, block) = DATA_BLOCK_A_DELETED_END_DELIMITER;
+
+   backupBlock->delimStart = DATA_BLOCK_B_DELETED_START_DELIMITER;
+   memset(backupBlock->key, 0, db->keyFieldSize);
+   if (clearValue == Kdb_true)
    {
-      return KISSDB_ERROR_CORRUPT_DBFILE;
+      memset(getDataBlockValue(db, backupBlock), 0, getDataBlockValueAreaSize(db, backupBlock));
    }
-   (*keySize) = (uint64_t) ptr->keySize;
+   getDataBlockInfo(db, backupBlock)->valSize = 0;
+   getDataBlockInfo(db, backupBlock)->valFlags = 0;
+   getDataBlockInfo(db, backupBlock)->sequence = 0;
+   backupBlock->crc = getDataBlockCrc(db, backupBlock);
+   *getDataBlockEndDelimiter(db, backupBlock) = DATA_BLOCK_B_DELETED_END_DELIMITER;
+}
 
-   if (!ptr->valSize)
+/* returns the index of the free list for data blocks of the size class blockSize */
+static uint32_t getFreeListIndex(KISSDB* db, uint32_t blockSize)
+{
+   uint32_t index = 0;
+   while ((db->minBlockSize << index) < blockSize)
    {
-      return KISSDB_ERROR_CORRUPT_DBFILE;
+      ++index;
    }
-   (*valSize) = (uint64_t) ptr->valSize;
-   return 0;
+   return index;
 }
 
+/*
+ * sets the first released pair of a free list
+ * the copy in the header keeps the free lists valid after a power loss if the hashtables are recovered from a checkpoint
+ */
+static void setFreeListHead(KISSDB* db, uint32_t index, int64_t offset)
+{
+   db->shared->freeList[index] = offset;
+   ((Header_s*) db->mappedDb)->freeList[index] = offset;
+}
 
+/* empties all free lists */
+static void clearFreeLists(KISSDB* db)
+{
+   memset(db->shared->freeList, 0, sizeof(db->shared->freeList));
+   memset(((Header_s*) db->mappedDb)->freeList, 0, sizeof(((Header_s*) db->mappedDb)->freeList));
+}
 
-
-int writeHeader(KISSDB* db, uint16_t* htSize, uint64_t* keySize, uint64_t* valSize)
+/*
+ * marks a pair of data blocks which is no longer referenced by a hashtable slot as deleted and adds it to the free list of its size class
+ * the value area of data block A stores the offset of the next released pair in the free list
+ * while a value of the pair is pinned by views, the values stay untouched and the pair is added to the free list by releaseDeferredDataBlocks
+ * (a pinned pair is only released once, so the deferred pairs never exceed the pins)
+ */
+static void releaseDualDataBlock(KISSDB* db, int64_t offset)
 {
-   Header_s* ptr = 0;
-   int ret= 0;
+   DataBlock_s* block = (DataBlock_s*) (db->mappedDb + offset);
+   uint32_t index = getFreeListIndex(db, getDataBlockInfo(db, block)->blockSize);
 
-   //truncate file to needed size for header
-   ret = ftruncate(db->fd, KISSDB_HEADER_SIZE);
-   if (ret < 0)
+   if (isDualDataBlockPinned(db, offset) == Kdb_true)
    {
-      return KISSDB_ERROR_IO;
+      freeDualDataBlock(db, offset, Kdb_false);
+      if (db->shared->deferredCount < KISSDB_DEFERRED_RELEASE_COUNT)
+      {
+         db->shared->deferred[db->shared->deferredCount++] = offset;
+      }
+      else
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": deferred release list is full, data blocks reused after the next compaction: "); DLT_INT64(offset));
+      }
+      return;
    }
-   //mmap whole file for the first time
-   db->mappedDb = (void*) mmap(NULL, KISSDB_HEADER_SIZE, PROT_WRITE | PROT_READ, MAP_SHARED, db->fd, 0);
-   if (db->mappedDb == MAP_FAILED)
+   freeDualDataBlock(db, offset, Kdb_true);
+   if (index < KISSDB_FREE_LIST_COUNT)
    {
-      return KISSDB_ERROR_IO;
+      memcpy(getDataBlockValue(db, block), &db->shared->freeList[index], sizeof(int64_t));
+      setFreeListHead(db, index, offset);
    }
-   db->shared->mappedDbSize = KISSDB_HEADER_SIZE;
-   db->dbMappedSize = KISSDB_HEADER_SIZE;
-
-   ptr = (Header_s*) db->mappedDb;
-   ptr->KdbV[0] = 'K';
-   ptr->KdbV[1] = 'd';
-   ptr->KdbV[2] = 'B';
-   ptr->KdbV[3] = KISSDB_MAJOR_VERSION;
-   ptr->KdbV[4] = '.';
-   ptr->KdbV[5] = KISSDB_MINOR_VERSION;
-   ptr->KdbV[6] = '0';
-   ptr->KdbV[7] = '0';
-   ptr->checksum = 0x00;
-   ptr->closeFailed = 0x00; //remove closeFailed flag
-   ptr->closeOk = 0x01;     //set closeOk flag
-   ptr->htSize = (uint64_t)(*htSize);
-   ptr->keySize = (uint64_t)(*keySize);
-   ptr->valSize = (uint64_t)(*valSize);
-   msync(db->mappedDb, KISSDB_HEADER_SIZE, MS_SYNC);
-
-   return 0;
 }
 
-
-int checkErrorFlags(KISSDB* db)
+/*
+ * adds the pairs of data blocks released while their values were pinned by views to the free lists
+ * as soon as they are no longer pinned (called by every modification)
+ */
+static void releaseDeferredDataBlocks(KISSDB* db)
 {
-   Header_s* ptr;
-   ptr = (Header_s*) db->mappedDb;
+   uint32_t count = 0;
+   uint32_t i = 0;
 
-   //check if closeFailed flag is set or closeOk is not set
-   if(ptr->closeFailed == 0x01 || ptr->closeOk == 0x00 )
-   {
-#ifdef PFS_TEST
-      printf("CHECK ERROR FLAGS: CLOSE FAILED!\n");
-#endif
-      ptr->closeFailed = 0x01; //create close failed flags
-      ptr->closeOk = 0x00;
-      return KISSDB_ERROR_CORRUPT_DBFILE;
-   }
-   else
+   for (i = 0; i < db->shared->deferredCount; i++)
    {
-#ifdef PFS_TEST
-      printf("CHECK ERROR FLAGS: CLOSE OK!\n");
-#endif
-      ptr->closeFailed = 0x01; //NO: create close failed flag
-      ptr->closeOk = 0x00;
+      if (isDualDataBlockPinned(db, db->shared->deferred[i]) == Kdb_true)
+      {
+         db->shared->deferred[count++] = db->shared->deferred[i];
+      }
+      else
+      {
+         releaseDualDataBlock(db, db->shared->deferred[i]);
+      }
    }
-   msync(db->mappedDb, KISSDB_HEADER_SIZE, MS_SYNC);
-
-   return 0;
+   db->shared->deferredCount = count;
 }
 
-
-
-int searchProcFileSys(pid_t pid, const char* path)
+/*
+ * gets a pair of data blocks (A and B) with the size class blockSize for a new key-value pair
+ * a released pair from the free list of the size class is reused, the database file is only extended if the list is empty
+ * offset returns the file offset of data block A
+ */
+static int allocDualDataBlock(KISSDB* db, uint32_t blockSize, int64_t* offset)
 {
-   int rval = 0;
-   DIR* procdir;
-   struct dirent* procDirEnt;
-   char procPidDir[128] = {0};
-
-   memset(procPidDir, 0, 128);
-   snprintf(procPidDir, 128, "/proc/%d/fd", pid);
+   DataBlock_s* block;
+   int64_t head;
+   int64_t next;
+   uint32_t index = getFreeListIndex(db, blockSize);
 
-   if((procdir = opendir(procPidDir)) != NULL)  // search for open fd's
+   if (index < KISSDB_FREE_LIST_COUNT && db->shared->freeList[index] != 0)
    {
-      for(procDirEnt = readdir(procdir); NULL != procDirEnt; procDirEnt = readdir(procdir))
+      head = db->shared->freeList[index];
+      block = (DataBlock_s*) (db->mappedDb + head);
+      if (head >= (int64_t) (KISSDB_HEADER_SIZE + sizeof(Hashtable_s)) && head + 2 * (int64_t) blockSize <= db->dbMappedSize
+            && getDataBlockInfo(db, block)->blockSize == blockSize && block->delimStart == DATA_BLOCK_A_DELETED_START_DELIMITER)
       {
-         if(FILE_DIR_NOT_SELF_OR_PARENT(procDirEnt->d_name))
-         {
-            char buffer[128] = {0};
-            char fullPath[256] = {0};
-            memset(buffer, 0, 128);
-            memset(fullPath, 0, 256);
-
-            snprintf(fullPath, 256, "%s/%s", procPidDir, procDirEnt->d_name);
-            if(readlink(fullPath, buffer, 128) != -1)
-            {
-               if(strcmp(path, buffer) == 0)
-               {
-                  //printf("   FOUND         [%d]: %s | %s | %s\n", pid, path, fullPath, buffer);
-                  rval = 1;
-                  break;
-               }
-            }
-            else
-            {
-               printf("Error readlink: %s\n", strerror(errno));
-            }
-         }
+         *(offset) = head;
+         memcpy(&next, getDataBlockValue(db, block), sizeof(int64_t));
+         setFreeListHead(db, index, next); //next released pair becomes the head of the list
+         return 0;
       }
-      closedir(procdir);
+      //the blocks of the list are only lost until the free lists are rebuilt after the next power loss
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": invalid free list entry at file offset: "); DLT_INT64(head));
+      setFreeListHead(db, index, 0);
    }
-
-   return rval;
+   return appendDualDataBlock(db, blockSize, offset);
 }
 
-
-int searchOpenFDs(const char* path)
+/*
+ * records the pairs of data blocks which are written (offset) and released (releasedOffset) by a modification in the journal of the header
+ * (0 if there is no such pair), a full journal is cleared by a checkpoint of the hashtables first
+ * the journal is synced before a pair is released: the released pair must not be referenced by the hashtables of the last checkpoint
+ */
+static void journalDualDataBlock(KISSDB* db, int64_t offset, int64_t releasedOffset)
 {
-   DIR* dir;
-   struct dirent* ent;
-   int rval = 0;
-   int fd = -1;
+   Header_s* header = (Header_s*) db->mappedDb;
 
-   if ((dir = opendir(PIDFILEDIR)) != NULL)  // search for pidfiles
+   if (header->journalCount + 2 > KISSDB_JOURNAL_SIZE)
    {
-      for(ent = readdir(dir); NULL != ent; ent = readdir(dir))
-      {
-         if(FILE_DIR_NOT_SELF_OR_PARENT(ent->d_name))
-         {
-            if(strstr(ent->d_name, PIDFILE_PREFIX) != NULL)
-            {
-               // extract the PID form filename
-               char pidArray[10] = {0};
-               char* pidArrayPtr = pidArray;
-               pid_t pid = 0;
-               int start = strlen(PIDFILE_PREFIX);
-               memset(pidArray, 0, 10);
-
-               while(ent->d_name[start] != '.')
-               {
-                  *(pidArrayPtr)++ = ent->d_name[start++];
-               }
-               pid = atoi(pidArray);
-               if(getpid() != pid) // check only other pids not own
-               {
-                  if(searchProcFileSys(pid, path) == 1)
-                  {
-                     rval++;  // count number of open fd's
-                  }
-               }
-            }
-         }
-      }
-      closedir(dir);
+      checkpointHashtables(db);
    }
-   else
+   if (offset != 0)
    {
-      printf("Failed to open directory %s: %s\n", PIDFILEDIR, strerror(errno));
+      header->journal[header->journalCount++] = offset;
+   }
+   if (releasedOffset != 0)
+   {
+      header->journal[header->journalCount++] = releasedOffset;
+      msync(db->mappedDb, KISSDB_HEADER_SIZE, MS_SYNC);
    }
-
-   return rval;
 }
 
-int verifyHashtableCS(KISSDB* db)
+
+int KISSDB_delete(KISSDB* db, const void* key, uint64_t hash, int32_t* bytesDeleted)
 {
-   char* ptr;
-   Hashtable_s* hashtable;
-   int i = 0;
-   int ptrOffset=1;
-   int64_t offset = 0;
-   struct stat statBuf;
-   uint64_t crc = 0;
-   void* memory;
+   Hashtable_slot_s* slot;
+   int ret = 0;
+   unsigned long klen;
 
-   if (db->fd)
+   klen = strlen(key);
+   *(bytesDeleted) = PERS_COM_ERR_NOT_FOUND;
+
+   if(db->htMappedSize < db->shared->htShmSize)
    {
-      //map entire file into memory
-      fstat(db->fd, &statBuf);
-      memory = (void*) mmap(NULL, statBuf.st_size, PROT_WRITE | PROT_READ, MAP_SHARED, db->fd, 0);
-      if (memory == MAP_FAILED)
+      if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
       {
-         return KISSDB_ERROR_IO;
+         return KISSDB_ERROR_RESIZE_SHM;
       }
-      ptr = (char*) memory;
-      db->shared->htNum = 0;
-      //unmap previously allocated and maybe corrupted hashtables
-      munmap(db->hashTables, db->htMappedSize);
-      db->hashTables = (Hashtable_s*) getKdbShmemPtr(db->htFd, db->htSizeBytes);
-      if(db->hashTables == ((void*) -1))
+      else
       {
-         return KISSDB_ERROR_MAP_SHM;
+         db->htMappedSize = db->shared->htShmSize;
       }
-      db->htMappedSize = db->htSizeBytes; //size for first hashtable
-
-      //determine greatest common factor of hashtable and datablock used for pointer incrementation
-      ptrOffset = greatestCommonFactor(sizeof(DataBlock_s), sizeof(Hashtable_s) );
-
-      //offsets in mapped area to first hashtable
-      offset = sizeof(Header_s);
-      ptr += offset;
+   }
 
-      //get number of hashtables in file (search for hashtable delimiters) and copy the hashtables to memory
-      while (offset <= ((int64_t)statBuf.st_size - (int64_t)db->htSizeBytes)) //begin with offset for first hashtable
+   //remap database file if in the meanwhile another process added new data (key value pairs / hashtables) to the file or compacted it
+   if (db->dbMappedSize != db->shared->mappedDbSize)
+   {
+      ret = remapDatabaseFile(db, db->shared->mappedDbSize);
+      if (ret != 0)
       {
-         hashtable = (Hashtable_s*) ptr;
-         //if at least one of two hashtable delimiters are found
-         if (hashtable->delimStart == HASHTABLE_START_DELIMITER
-               || hashtable->delimEnd == HASHTABLE_END_DELIMITER)
-         {
-               //next hashtable to use
-               //rewrite delimiters to make sure that both exist
-               hashtable->delimStart = HASHTABLE_START_DELIMITER;
-               hashtable->delimEnd   = HASHTABLE_END_DELIMITER;
-               Kdb_bool result = Kdb_false;
-               //if new size would exceed old shared memory size-> allocate additional memory page to shared memory
-               if (db->htSizeBytes * (db->shared->htNum + 1) > db->htMappedSize)
+         return ret;
+      }
+   }
+
+   releaseDeferredDataBlocks(db);
+   ret = findHashtableSlot(db, key, klen, hash, &slot, NULL, Kdb_false);
+   if (ret != 0)
+   {
+      return ret; /* not found or error */
+   }
+
+   if (slot->offsetA < KISSDB_HEADER_SIZE || slot->offsetA > db->dbMappedSize)
+   {
+      return KISSDB_ERROR_IO;
+   }
+
+   /* data to be deleted was found
+    write "deleted block delimiters" for both blocks, delete key / value and add the blocks to the free list of their size class */
+   journalDualDataBlock(db, 0, slot->offsetA);
+   releaseDualDataBlock(db, slot->offsetA);
+
+   //the slot stays used to keep the probe sequence of other keys intact
+   slot->offsetA = KISSDB_SLOT_DELETED;
+   slot->offsetB = KISSDB_SLOT_DELETED;
+   slot->current = 0x00;
+   setSlotDirty(db, slot);
+
+   *(bytesDeleted) = 0;
+   return 0; /* success */
+}
+
+// To improve write amplifiction: sort the keys at writeback for sequential write
+//return offset where key would be written if Kissdb_put with same key is called
+//int determineKeyOffset(KISSDB* db, const void* key)
+//{
+//   /*
+//    * - hash the key,
+//    * - go through hashtables and get corresponding offset to hash
+//    * - if offset is negative return the inverse offset
+//    * - if key matches at file offset return this offset
+//    */
+//   return 0;
+//}
+
+
+
+
+int KISSDB_put(KISSDB* db, const void* key, uint64_t hash, const void* value, int valueSize, uint32_t valueFlags, int32_t* bytesWritten)
+{
+   DataBlock_s* backupBlock;
+   DataBlock_s* block;
+   Hashtable_slot_s* slot;
+   Hashtable_slot_s* freeSlot;
+   Hashtable_slot_s entry;
+   int64_t offset, backupOffset;
+   int ret = 0;
+   uint32_t blockSize = 0;
+   uint64_t crc = 0x00;
+   uint32_t htNum = 0;
+   unsigned long klen;
+
+   klen = strlen(key);
+   *(bytesWritten) = 0;
+   if (valueSize < 0 || (uint64_t) valueSize > db->valSize) //the size classes of the database end with the maximum value size
+   {
+      return KISSDB_ERROR_INVALID_PARAMETERS;
+   }
+   if (klen >= db->keySize) //the key and its terminating null must fit into the key field of the data blocks
+   {
+      return KISSDB_ERROR_INVALID_PARAMETERS;
+   }
+   blockSize = getDataBlockSize(db, valueSize); //size class needed for the new value
+
+   if(db->htMappedSize < db->shared->htShmSize)
+   {
+      if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
+      {
+         return KISSDB_ERROR_RESIZE_SHM;
+      }
+      else
+      {
+         db->htMappedSize = db->shared->htShmSize;
+      }
+   }
+
+   //remap database file (only necessary here in writethrough mode) if in the meanwhile another process added new data (key value pairs / hashtables) to the file or compacted it
+   if (db->dbMappedSize != db->shared->mappedDbSize)
+   {
+      ret = remapDatabaseFile(db, db->shared->mappedDbSize);
+      if (ret != 0)
+      {
+         return ret;
+      }
+   }
+
+   releaseDeferredDataBlocks(db);
+   /* if no hashtable exists, add the first hashtable */
+   htNum = db->shared->htNum;
+   if (db->shared->htNum == 0)
+   {
+      ret = addHashtable(db);
+      if (ret != 0)
+      {
+         return ret;
+      }
+   }
+
+   ret = findHashtableSlot(db, key, klen, hash, &slot, &freeSlot, Kdb_false);
+   if (ret < 0)
+   {
+      return ret;
+   }
+
+   if (ret == 0) //overwrite existing if key matches
+   {
+      clearSlotInlineValue(db, slot); //offsetB points to data block B while the data blocks are written
+      offset = getSlotCurrentOffset(db, slot);
+      block = (DataBlock_s*) (db->mappedDb +  offset);
+
+      //new value does not fit into the size class of the existing data blocks or the existing value is pinned by a view
+      if (getDataBlockInfo(db, block)->blockSize < blockSize || isDualDataBlockPinned(db, slot->offsetA) == Kdb_true)
+      {
+         //move the key-value pair to new data blocks and release the existing data blocks
+         ret = allocDualDataBlock(db, blockSize, &offset);
+         if (ret != 0)
+         {
+            return ret;
+         }
+         journalDualDataBlock(db, offset, slot->offsetA);
+         writeDualDataBlock(db, offset, blockSize, key, klen, value, valueSize, valueFlags);
+         releaseDualDataBlock(db, slot->offsetA);
+         slot->offsetA = offset;
+         slot->offsetB = offset + blockSize;
+         slot->current = 0x00;
+         setSlotInlineValue(db, slot, key, value, (uint32_t) valueSize, valueFlags);
+         setSlotDirty(db, slot);
+         *(bytesWritten) = valueSize;
+
+         return 0; //success
+      }
+
+      backupOffset = (slot->current & KISSDB_SLOT_CURRENT_B) ? slot->offsetA : slot->offsetB; // if offsetA is latest -> offsetB is latest backup else offsetA is latest
+
+      //if key matches -> only overwrite the currently non valid data block for this key
+      //the latest valid block stays untouched, so a power loss during the write still leaves the previous value
+      journalDualDataBlock(db, slot->offsetA, 0);
+      backupBlock = (DataBlock_s*) (db->mappedDb +  backupOffset);
+      backupBlock->delimStart = (backupOffset < offset) ? DATA_BLOCK_A_START_DELIMITER : DATA_BLOCK_B_START_DELIMITER;
+      //the key and the size class are written again: after an interrupted compaction the block can be a partly moved copy
+      memset(backupBlock->key, 0, db->keyFieldSize);
+      memcpy(backupBlock->key, key, klen);
+      getDataBlockInfo(db, backupBlock)->blockSize = getDataBlockInfo(db, block)->blockSize;
+      getDataBlockInfo(db, backupBlock)->valSize = valueSize;
+      getDataBlockInfo(db, backupBlock)->valFlags = valueFlags;
+      memcpy(getDataBlockValue(db, backupBlock), value, valueSize);
+      getDataBlockInfo(db, backupBlock)->sequence = getDataBlockInfo(db, block)->sequence + 1; //marks the block as the newer one during recovery
+      crc = getDataBlockCrc(db, backupBlock);
+      backupBlock->crc = crc;
+      *getDataBlockEndDelimiter(db, backupBlock) = (backupOffset < offset) ? DATA_BLOCK_A_END_DELIMITER : DATA_BLOCK_B_END_DELIMITER;
+      // check current flag and decide what parts of hashtable slot in file must be updated
+      slot->current ^= KISSDB_SLOT_CURRENT_B; // if offsetA is latest -> set KISSDB_SLOT_CURRENT_B else /offsetB is latest -> clear it
+      setSlotInlineValue(db, slot, key, value, (uint32_t) valueSize, valueFlags);
+      setSlotDirty(db, slot);
+      *(bytesWritten) = valueSize;
+
+      return 0; //success
+   }
+
+   /* key is not already inserted: add new data (released data blocks of any key are reused) */
+   ret = allocDualDataBlock(db, blockSize, &offset);
+   if (ret != 0)
+   {
+      return ret;
+   }
+   journalDualDataBlock(db, offset, 0);
+   writeDualDataBlock(db, offset, blockSize, key, klen, value, valueSize, valueFlags);
+
+   //update hashtable entry
+   entry.offsetA = offset; //write the offsetA to the data in the memory-hashtable slot
+   entry.offsetB = offset + blockSize; //write the offset to the data in the memory-hashtable slot
+   entry.current = 0x00;
+   setSlotKey(&entry, hash, klen);
+   setSlotInlineValue(db, &entry, key, value, (uint32_t) valueSize, valueFlags);
+   if (freeSlot != NULL) //a deleted slot on the probe path or the empty slot that ended it
+   {
+      if (freeSlot->offsetA == 0)
+      {
+         ++db->shared->htUsedSlots;
+      }
+      *(freeSlot) = entry;
+      setSlotDirty(db, freeSlot);
+   }
+   else //hashtable is full -> insertion splits hashtables until the slot fits
+   {
+      ret = insertHashtableSlot(db, hash, &entry);
+      if (ret != 0)
+      {
+         return ret;
+      }
+   }
+   *(bytesWritten) = valueSize;
+
+   //grow the index if the maximum load of the hashtables is exceeded
+   if ((uint64_t) db->shared->htUsedSlots * 100 > (uint64_t) db->shared->htNum * db->htSize * HASHTABLE_MAX_LOAD_PERCENT)
+   {
+      //slots of deleted keys are removed first: the index only grows if this frees less than a quarter of the maximum load
+      removeDeletedHashtableSlots(db);
+      if ((uint64_t) db->shared->htUsedSlots * 100 * 4 > (uint64_t) db->shared->htNum * db->htSize * HASHTABLE_MAX_LOAD_PERCENT * 3)
+      {
+         ret = splitHashtable(db);
+         if (ret != 0)
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": split of hashtable failed: "); DLT_INT(ret));
+         }
+      }
+   }
+   //a new checkpoint links the added hashtables in the file
+   if (db->shared->htNum != htNum)
+   {
+      checkpointHashtables(db);
+   }
+
+   return 0; /* success */
+}
+
+
+
+#if 0
+/*
+ * prints the offsets stored in the shared Hashtable
+ */
+void printSharedHashtable(KISSDB* db)
+{
+   unsigned long k=0;
+   int i = 0;
+
+   loadAllHashtables(db);
+   for(i =0 ; i< db->shared->htNum; i++)
+   {
+      for (k = 0; k <= db->htSize; k++)
+      {
+         printf("ht[%d] offsetA  [%lu]: %" PRId64 " \n",i, k, db->hashTables[i].slots[k].offsetA);
+         printf("ht[%d] offsetB  [%lu]: %" PRId64 " \n",i, k, db->hashTables[i].slots[k].offsetB);
+         printf("ht[%d] current  [%lu]: %u \n",i, k, db->hashTables[i].slots[k].current);
+      }
+   }
+}
+#endif
+
+
+void KISSDB_Iterator_init(KISSDB* db, KISSDB_Iterator* dbi)
+{
+   dbi->db = db;
+   dbi->h_no = 0;  // number of read hashtables
+   dbi->h_idx = 0; // index in current hashtable
+   dbi->hash = 0;
+   dbi->htNum = db->shared->htNum;
+   dbi->found = Kdb_false;
+}
+
+
+/* maps the hashtables and the database file again if another process has grown or compacted them */
+static int remapForIterator(KISSDB* db)
+{
+   if(db->htMappedSize < db->shared->htShmSize)
+   {
+      if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
+      {
+         return KISSDB_ERROR_RESIZE_SHM;
+      }
+      else
+      {
+         db->htMappedSize = db->shared->htShmSize;
+      }
+   }
+
+   //remap database file if in the meanwhile another process added new data (key value pairs / hashtables) to the file or compacted it
+   if (db->dbMappedSize != db->shared->mappedDbSize)
+   {
+      return remapDatabaseFile(db, db->shared->mappedDbSize);
+   }
+   return 0;
+}
+
+
+int KISSDB_Iterator_next(KISSDB_Iterator* dbi, void* kbuf, void* vbuf)
+{
+   DataBlock_s* block;
+   Hashtable_slot_s* ht;
+   int retVal = KISSDB_ITERATOR_NEXT_ITEM_NOT_FOUND;
+   int ret = 0;
+   int64_t offset;
+
+   ret = remapForIterator(dbi->db);
+   if (ret != 0)
+   {
+      return ret;
+   }
+
+   if ((dbi->h_no < (dbi->db->shared->htNum)) && (dbi->h_idx < dbi->db->htSize))
+   {
+      ht = getHashtable(dbi->db, dbi->h_no)->slots; //pointer to first hashtable
+
+      while ( !(ht[dbi->h_idx].offsetA || ht[dbi->h_idx].offsetB) ) //until a offset was found
+      {
+         if (++dbi->h_idx >= dbi->db->htSize)
+         {
+            dbi->h_idx = 0;
+            if (++dbi->h_no >= (dbi->db->shared->htNum))
+            {
+               return KISSDB_ITERATOR_NEXT_ITEM_NOT_FOUND;//0
+            }
+            else
+            {
+               ht = getHashtable(dbi->db, dbi->h_no)->slots;   //next hashtable
+            }
+         }
+      }
+      offset = getSlotCurrentOffset(dbi->db, &ht[dbi->h_idx]);
+
+      if( abs(offset) > dbi->db->dbMappedSize )
+      {
+         return KISSDB_ERROR_IO;
+      }
+
+      retVal = KISSDB_ITERATOR_NEXT_ITEM_FOUND;
+      dbi->hash = getSlotHash(&ht[dbi->h_idx]);
+      if (offset >= 0)
+      {                    
+          block = (DataBlock_s*) (dbi->db->mappedDb + offset);
+          memcpy(kbuf,block->key, dbi->db->keySize);
+
+          if (vbuf != NULL)
+          {
+             memcpy(vbuf, getDataBlockValue(dbi->db, block), getDataBlockInfo(dbi->db, block)->valSize);
+          }
+      }     
+      else
+      {
+          retVal = KISSDB_ITERATOR_DELETED_ITEM;
+      }
+      if (++dbi->h_idx >= dbi->db->htSize)
+      {
+         dbi->h_idx = 0;
+         ++dbi->h_no;
+      }
+      return retVal;//1
+   }
+   return KISSDB_ITERATOR_NEXT_ITEM_NOT_FOUND;//0
+}
+
+
+/*
+ * the keys are returned in a fixed order: by their hashtable number with the number of hashtables at KISSDB_Iterator_init,
+ * then by their slot hash and key. Hashtable splits and slots placed again by a write only change where a key is stored,
+ * not its position in this order, so each key is returned once even if keys are written during the iteration.
+ * Every call scans the hashtables holding the keys of one hashtable number at KISSDB_Iterator_init.
+ */
+int KISSDB_Iterator_nextStable(KISSDB_Iterator* dbi, void* kbuf, void* vbuf)
+{
+   KISSDB* db = dbi->db;
+   DataBlock_s* block;
+   DataBlock_s* next = NULL;
+   Hashtable_slot_s* ht;
+   uint64_t nextHash = 0;
+   uint64_t hash;
+   int64_t offset;
+   uint32_t htNumber;
+   uint32_t i;
+   int ret = 0;
+
+   ret = remapForIterator(db);
+   if (ret != 0)
+   {
+      return ret;
+   }
+
+   while (dbi->h_no < dbi->htNum)
+   {
+      for (htNumber = 0; htNumber < db->shared->htNum; htNumber++)
+      {
+         //the keys of hashtable h_no are now stored in the hashtables split from it, or in the hashtable it was merged into
+         if (getHashtableNumberOf(dbi->htNum, htNumber) != dbi->h_no && getHashtableNumberOf(db->shared->htNum, dbi->h_no) != htNumber)
+         {
+            continue;
+         }
+         ht = getHashtable(db, htNumber)->slots;
+         for (i = 0; i < db->htSize; i++)
+         {
+            if (!(ht[i].offsetA || ht[i].offsetB))
+            {
+               continue;
+            }
+            hash = getSlotHash(&ht[i]);
+            if (getHashtableNumberOf(dbi->htNum, hash) != dbi->h_no || (dbi->found == Kdb_true && hash < dbi->hash)
+                || (next != NULL && hash > nextHash))
+            {
+               continue;
+            }
+            offset = getSlotCurrentOffset(db, &ht[i]);
+            if (offset < 0) //deleted key
+            {
+               continue;
+            }
+            if (offset > db->dbMappedSize)
+            {
+               return KISSDB_ERROR_IO;
+            }
+            block = (DataBlock_s*) (db->mappedDb + offset);
+            if ((dbi->found == Kdb_true && hash == dbi->hash && strncmp(block->key, dbi->key, db->keySize) <= 0)
+                || (next != NULL && hash == nextHash && strncmp(block->key, next->key, db->keySize) >= 0))
+            {
+               continue;
+            }
+            next = block;
+            nextHash = hash;
+         }
+      }
+      if (next != NULL)
+      {
+         dbi->found = Kdb_true;
+         dbi->hash = nextHash;
+         memcpy(dbi->key, next->key, db->keySize);
+         memcpy(kbuf, next->key, db->keySize);
+         if (vbuf != NULL)
+         {
+            memcpy(vbuf, getDataBlockValue(db, next), getDataBlockInfo(db, next)->valSize);
+         }
+         return KISSDB_ITERATOR_NEXT_ITEM_FOUND;
+      }
+      dbi->found = Kdb_false;
+      dbi->h_no++;
+   }
+   return KISSDB_ITERATOR_NEXT_ITEM_NOT_FOUND;
+}
+
+
+
+
+/* algorithms of database files created by this process, set by KISSDB_setAlgorithms() */
+static uint32_t newFileChecksumAlgorithm = KISSDB_CHECKSUM_ALGORITHM;
+static uint32_t newFileKeyHashAlgorithm = KISSDB_KEY_HASH_ALGORITHM;
+
+int KISSDB_setAlgorithms(uint32_t checksumAlgorithm, uint32_t keyHashAlgorithm)
+{
+   if (pcoGetChecksumFunc(checksumAlgorithm) == NULL || pcoGetKeyHashFunc(keyHashAlgorithm) == NULL)
+   {
+      return KISSDB_ERROR_INVALID_PARAMETERS;
+   }
+   newFileChecksumAlgorithm = checksumAlgorithm;
+   newFileKeyHashAlgorithm = keyHashAlgorithm;
+   return 0;
+}
+
+
+/*
+ * Data block and hashtable of database files of version 2.x: the header (Header_s up to the delimiter) is followed
+ * by hashtables and by data block pairs A, B of DataBlock2_s, the last slot of a hashtable links to the next one.
+ * The checksum of a data block covers keySize + sizeof(uint32_t) + valSize + sizeof(uint64_t) bytes from the key on.
+ */
+typedef struct
+{
+   int64_t  delimStart;
+   uint64_t crc;
+   char     key[PERS_DB_MAX_LENGTH_KEY_NAME];
+   uint32_t valSize;
+   char     value[PERS_DB_MAX_SIZE_KEY_DATA];
+   uint64_t htNum;
+   int64_t  delimEnd;
+} DataBlock2_s; //8192 byte
+
+typedef struct
+{
+   int64_t offsetA; //negative if the key was deleted
+   int64_t offsetB;
+   uint64_t current; //0x00: offsetA points to the current data block, 0x01: offsetB
+} Hashtable2_slot_s;
+
+typedef struct
+{
+   int64_t delimStart;
+   uint64_t crc;
+   Hashtable2_slot_s slots[HASHTABLE_SLOT_COUNT + 1];
+   int64_t delimEnd;
+} Hashtable2_s;
+
+
+int KISSDB_getFileVersion(const char* path)
+{
+   char version[8];
+   int fd = open(path, O_RDONLY);
+   ssize_t bytesRead;
+
+   if (fd == -1)
+   {
+      return KISSDB_ERROR_IO;
+   }
+   bytesRead = pread(fd, version, sizeof(version), 0);
+   close(fd);
+   if (bytesRead != (ssize_t) sizeof(version))
+   {
+      return (bytesRead < 0) ? KISSDB_ERROR_IO : KISSDB_ERROR_CORRUPT_DBFILE;
+   }
+   if ((version[0] != 'K') || (version[1] != 'd') || (version[2] != 'B') || (version[4] != '.'))
+   {
+      return KISSDB_ERROR_CORRUPT_DBFILE;
+   }
+   return (int) version[3];
+}
+
+
+/* returns the data block of version 2.x at offset if it holds a value with a valid checksum, else NULL */
+static DataBlock2_s* getVersion2DataBlock(const char* mapped, uint64_t mappedSize, int64_t offset, const Header_s* header)
+{
+   DataBlock2_s* block;
+
+   if (offset < (int64_t) KISSDB_HEADER_SIZE || (uint64_t) offset + sizeof(DataBlock2_s) > mappedSize)
+   {
+      return NULL;
+   }
+   block = (DataBlock2_s*) (mapped + offset);
+   if ((block->delimStart != DATA_BLOCK_A_START_DELIMITER && block->delimStart != DATA_BLOCK_B_START_DELIMITER) || block->valSize > header->valSize
+       || block->crc != pcoCrc32(0, (unsigned char*) block->key, header->keySize + sizeof(uint32_t) + header->valSize + sizeof(uint64_t)))
+   {
+      return NULL;
+   }
+   return block;
+}
+
+
+int KISSDB_readVersion2(const char* path, uint64_t* valueSize, KISSDB_Version2Item_f item, void* arg)
+{
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME + 1];
+   const Header_s* header;
+   Hashtable2_s* hashtable;
+   Hashtable2_slot_s* slot;
+   DataBlock2_s* block;
+   char* mapped;
+   struct stat sb;
+   int64_t offset = KISSDB_HEADER_SIZE;
+   uint64_t htCount = 0;
+   uint64_t i = 0;
+   int count = 0;
+   int ret = 0;
+   int fd;
+
+   fd = open(path, O_RDONLY);
+   if (fd == -1)
+   {
+      return KISSDB_ERROR_IO;
+   }
+   if (fstat(fd, &sb) != 0 || sb.st_size < (off_t) KISSDB_HEADER_SIZE)
+   {
+      close(fd);
+      return KISSDB_ERROR_CORRUPT_DBFILE;
+   }
+   mapped = (char*) mmap(NULL, (size_t) sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd); //the mapping keeps the file open
+   if (mapped == MAP_FAILED)
+   {
+      return KISSDB_ERROR_IO;
+   }
+
+   //the hashtables of version 2.x have HASHTABLE_SLOT_COUNT slots, the data blocks store keys and values of at most the default size
+   header = (const Header_s*) mapped;
+   if ((header->KdbV[0] != 'K') || (header->KdbV[1] != 'd') || (header->KdbV[2] != 'B') || (header->KdbV[3] != KISSDB_MAJOR_VERSION_2) || (header->KdbV[4] != '.'))
+   {
+      munmap(mapped, (size_t) sb.st_size);
+      return KISSDB_ERROR_WRONG_DATABASE_VERSION;
+   }
+   if (header->htSize == 0 || header->htSize > HASHTABLE_SLOT_COUNT || header->keySize == 0 || header->keySize > PERS_DB_MAX_LENGTH_KEY_NAME
+       || header->valSize == 0 || header->valSize > PERS_DB_MAX_SIZE_KEY_DATA)
+   {
+      munmap(mapped, (size_t) sb.st_size);
+      return KISSDB_ERROR_CORRUPT_DBFILE;
+   }
+   if (valueSize != NULL)
+   {
+      *valueSize = header->valSize;
+   }
+
+   //a file without keys ends with its header, the link of the last hashtable is 0
+   while (offset != 0 && (uint64_t) offset + sizeof(Hashtable2_s) <= (uint64_t) sb.st_size && ret == 0)
+   {
+      hashtable = (Hashtable2_s*) (mapped + offset);
+      if (hashtable->delimStart != HASHTABLE_START_DELIMITER || hashtable->delimEnd != HASHTABLE_END_DELIMITER
+          || ++htCount > (uint64_t) sb.st_size / sizeof(Hashtable2_s))
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": invalid hashtable in <"); DLT_STRING(path); DLT_STRING("> at offset: "); DLT_INT64(offset));
+         ret = KISSDB_ERROR_CORRUPT_DBFILE;
+         break;
+      }
+      for (i = 0; i < header->htSize && ret == 0; i++)
+      {
+         slot = &hashtable->slots[i];
+         if (slot->offsetA <= 0) //unused slot or deleted key
+         {
+            continue;
+         }
+         block = getVersion2DataBlock(mapped, (uint64_t) sb.st_size, (slot->current == 0x00) ? slot->offsetA : slot->offsetB, header);
+         if (block == NULL)
+         {
+            block = getVersion2DataBlock(mapped, (uint64_t) sb.st_size, (slot->current == 0x00) ? slot->offsetB : slot->offsetA, header);
+         }
+         if (block == NULL)
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": no valid data block in <"); DLT_STRING(path); DLT_STRING("> at offset: "); DLT_INT64(slot->offsetA));
+            continue;
+         }
+         memcpy(key, block->key, header->keySize);
+         key[header->keySize] = '\0';
+         if (item != NULL)
+         {
+            ret = item(arg, key, block->value, block->valSize);
+         }
+         count++;
+      }
+      offset = hashtable->slots[header->htSize].offsetA;
+   }
+   munmap(mapped, (size_t) sb.st_size);
+   return (ret != 0) ? ret : count;
+}
+
+
+
+
+int readHeader(KISSDB* db, uint16_t* htSize, uint64_t* keySize, uint64_t* valSize)
+{
+   Header_s* ptr = 0;
+   ptr = (Header_s*) db->mappedDb;
+
+   if ((ptr->KdbV[0] != 'K') || (ptr->KdbV[1] != 'd') || (ptr->KdbV[2] != 'B') )
+   {
+      return KISSDB_ERROR_CORRUPT_DBFILE;
+   }
+   if( (ptr->KdbV[3] != KISSDB_MAJOR_VERSION) || (ptr->KdbV[4] != '.') || (ptr->KdbV[5] != KISSDB_MINOR_VERSION))
+   {
+      return KISSDB_ERROR_WRONG_DATABASE_VERSION;
+   }
+   db->checksum = pcoGetChecksumFunc((unsigned int) ptr->checksumAlgorithm);
+   if (db->checksum == NULL) //written with an unknown checksum algorithm
+   {
+      return KISSDB_ERROR_WRONG_DATABASE_VERSION;
+   }
+   db->checksumAlgorithm = (uint32_t) ptr->checksumAlgorithm;
+   db->keyHash = pcoGetKeyHashFunc((unsigned int) ptr->keyHashAlgorithm);
+   if (db->keyHash == NULL) //written with an unknown key hash algorithm
+   {
+      return KISSDB_ERROR_WRONG_DATABASE_VERSION;
+   }
+   db->keyHashAlgorithm = (uint32_t) ptr->keyHashAlgorithm;
+   if (!ptr->htSize)
+   {
+      return KISSDB_ERROR_CORRUPT_DBFILE;
+   }
+   (*htSize) = (uint16_t) ptr->htSize;
+   if (!ptr->keySize || ptr->keySize > PERS_DB_MAX_LENGTH_KEY_NAME)
+   {
+      return KISSDB_ERROR_CORRUPT_DBFILE;
+   }
+   (*keySize) = (uint64_t) ptr->keySize;
+
+   if (!ptr->valSize || ptr->valSize > KISSDB_MAX_VALUE_SIZE)
+   {
+      return KISSDB_ERROR_CORRUPT_DBFILE;
+   }
+   (*valSize) = (uint64_t) ptr->valSize;
+
+   db->keySize = ptr->keySize;
+   db->valSize = ptr->valSize;
+   return setDataBlockGeometry(db, ptr->keyFieldSize, ptr->minBlockSize);
+}
+
+
+
+
+int writeHeader(KISSDB* db, uint16_t* htSize, uint64_t* keySize, uint64_t* valSize)
+{
+   Header_s* ptr = 0;
+   int ret= 0;
+   uint64_t keyFieldSize = 0;
+   uint64_t recordSize = 0;
+
+   //the key field holds the longest key with its terminating null, data blocks of databases with small records get the record size as smallest size class
+   db->keySize = *(keySize);
+   db->valSize = *(valSize);
+   keyFieldSize = (*(keySize) + sizeof(int64_t) - 1) & ~((uint64_t) sizeof(int64_t) - 1);
+   recordSize = sizeof(DataBlock_s) + keyFieldSize + sizeof(DataBlockInfo_s) + *(valSize) + sizeof(int64_t);
+   recordSize = (recordSize + KISSDB_DATA_BLOCK_ALIGNMENT - 1) & ~((uint64_t) KISSDB_DATA_BLOCK_ALIGNMENT - 1);
+   ret = setDataBlockGeometry(db, keyFieldSize, (recordSize < 2 * KISSDB_MIN_DATA_BLOCK_SIZE) ? recordSize : KISSDB_MIN_DATA_BLOCK_SIZE);
+   if (ret != 0)
+   {
+      return KISSDB_ERROR_INVALID_PARAMETERS;
+   }
+
+   //truncate file to needed size for header
+   ret = ftruncate(db->fd, KISSDB_HEADER_SIZE);
+   if (ret < 0)
+   {
+      return KISSDB_ERROR_IO;
+   }
+   //mmap whole file for the first time
+   db->mappedDb = (void*) mmap(NULL, KISSDB_HEADER_SIZE, PROT_WRITE | PROT_READ, MAP_SHARED, db->fd, 0);
+   if (db->mappedDb == MAP_FAILED)
+   {
+      return KISSDB_ERROR_IO;
+   }
+   db->shared->mappedDbSize = KISSDB_HEADER_SIZE;
+   db->shared->dataEnd = KISSDB_HEADER_SIZE;
+   db->dbMappedSize = KISSDB_HEADER_SIZE;
+
+   ptr = (Header_s*) db->mappedDb;
+   ptr->KdbV[0] = 'K';
+   ptr->KdbV[1] = 'd';
+   ptr->KdbV[2] = 'B';
+   ptr->KdbV[3] = KISSDB_MAJOR_VERSION;
+   ptr->KdbV[4] = '.';
+   ptr->KdbV[5] = KISSDB_MINOR_VERSION;
+   ptr->KdbV[6] = '0';
+   ptr->KdbV[7] = '0';
+   ptr->checksum = 0x00;
+   ptr->closeFailed = 0x00; //remove closeFailed flag
+   ptr->closeOk = 0x01;     //set closeOk flag
+   ptr->htSize = (uint64_t)(*htSize);
+   ptr->keySize = (uint64_t)(*keySize);
+   ptr->valSize = (uint64_t)(*valSize);
+   ptr->keyFieldSize = db->keyFieldSize;
+   ptr->minBlockSize = db->minBlockSize;
+   ptr->checksumAlgorithm = newFileChecksumAlgorithm;
+   ptr->keyHashAlgorithm = newFileKeyHashAlgorithm;
+   ptr->dataEnd = KISSDB_HEADER_SIZE;
+   msync(db->mappedDb, KISSDB_HEADER_SIZE, MS_SYNC);
+   db->checksumAlgorithm = newFileChecksumAlgorithm;
+   db->checksum = pcoGetChecksumFunc(newFileChecksumAlgorithm);
+   db->keyHashAlgorithm = newFileKeyHashAlgorithm;
+   db->keyHash = pcoGetKeyHashFunc(newFileKeyHashAlgorithm);
+
+   return 0;
+}
+
+
+int checkErrorFlags(KISSDB* db)
+{
+   Header_s* ptr;
+   ptr = (Header_s*) db->mappedDb;
+
+   //check if closeFailed flag is set or closeOk is not set
+   if(ptr->closeFailed == 0x01 || ptr->closeOk == 0x00 )
+   {
+#ifdef PFS_TEST
+      printf("CHECK ERROR FLAGS: CLOSE FAILED!\n");
+#endif
+      ptr->closeFailed = 0x01; //create close failed flags
+      ptr->closeOk = 0x00;
+      return KISSDB_ERROR_CORRUPT_DBFILE;
+   }
+   else
+   {
+#ifdef PFS_TEST
+      printf("CHECK ERROR FLAGS: CLOSE OK!\n");
+#endif
+      ptr->closeFailed = 0x01; //NO: create close failed flag
+      ptr->closeOk = 0x00;
+   }
+   msync(db->mappedDb, KISSDB_HEADER_SIZE, MS_SYNC);
+
+   return 0;
+}
+
+
+
+int searchProcFileSys(pid_t pid, const char* path)
+{
+   int rval = 0;
+   DIR* procdir;
+   struct dirent* procDirEnt;
+   char procPidDir[128] = {0};
+
+   memset(procPidDir, 0, 128);
+   snprintf(procPidDir, 128, "/proc/%d/fd", pid);
+
+   if((procdir = opendir(procPidDir)) != NULL)  // search for open fd's
+   {
+      for(procDirEnt = readdir(procdir); NULL != procDirEnt; procDirEnt = readdir(procdir))
+      {
+         if(FILE_DIR_NOT_SELF_OR_PARENT(procDirEnt->d_name))
+         {
+            char buffer[128] = {0};
+            char fullPath[256] = {0};
+            memset(buffer, 0, 128);
+            memset(fullPath, 0, 256);
+
+            snprintf(fullPath, 256, "%s/%s", procPidDir, procDirEnt->d_name);
+            if(readlink(fullPath, buffer, 128) != -1)
+            {
+               if(strcmp(path, buffer) == 0)
+               {
+                  //printf("   FOUND         [%d]: %s | %s | %s\n", pid, path, fullPath, buffer);
+                  rval = 1;
+                  break;
+               }
+            }
+            else
+            {
+               printf("Error readlink: %s\n", strerror(errno));
+            }
+         }
+      }
+      closedir(procdir);
+   }
+
+   return rval;
+}
+
+
+int searchOpenFDs(const char* path)
+{
+   DIR* dir;
+   struct dirent* ent;
+   int rval = 0;
+   int fd = -1;
+
+   if ((dir = opendir(PIDFILEDIR)) != NULL)  // search for pidfiles
+   {
+      for(ent = readdir(dir); NULL != ent; ent = readdir(dir))
+      {
+         if(FILE_DIR_NOT_SELF_OR_PARENT(ent->d_name))
+         {
+            if(strstr(ent->d_name, PIDFILE_PREFIX) != NULL)
+            {
+               // extract the PID form filename
+               char pidArray[10] = {0};
+               char* pidArrayPtr = pidArray;
+               pid_t pid = 0;
+               int start = strlen(PIDFILE_PREFIX);
+               memset(pidArray, 0, 10);
+
+               while(ent->d_name[start] != '.')
                {
-                  result = resizeKdbShmem(db->htFd, &db->hashTables, db->htMappedSize, db->htMappedSize + db->htSizeBytes);
-                  if (result == Kdb_false)
-                  {
-                     return KISSDB_ERROR_RESIZE_SHM;
-                  }
-                  else
+                  *(pidArrayPtr)++ = ent->d_name[start++];
+               }
+               pid = atoi(pidArray);
+               if(getpid() != pid) // check only other pids not own
+               {
+                  if(searchProcFileSys(pid, path) == 1)
                   {
-                     db->shared->htShmSize = db->htMappedSize + db->htSizeBytes;
-                     db->htMappedSize = db->shared->htShmSize;
+                     rval++;  // count number of open fd's
                   }
                }
-               // copy the current hashtable read from file to (htadress + (htsize  * htcount)) in memory
-               memcpy(((uint8_t*) db->hashTables) + (db->htSizeBytes * db->shared->htNum), ptr, db->htSizeBytes);
-               ++db->shared->htNum;
+            }
+         }
+      }
+      closedir(dir);
+   }
+   else
+   {
+      printf("Failed to open directory %s: %s\n", PIDFILEDIR, strerror(errno));
+   }
+
+   return rval;
+}
+
+/* number of recovery threads set by KISSDB_setRecoveryThreads() (0: one thread per online CPU) */
+static uint32_t recoveryThreads = 0;
+
+void KISSDB_setRecoveryThreads(uint32_t threads)
+{
+   recoveryThreads = threads;
+}
+
+/* returns the number of threads used to recover a database file of size bytes */
+static uint32_t getRecoveryThreadCount(int64_t size)
+{
+   int64_t threads = (recoveryThreads > 0) ? (int64_t) recoveryThreads : (int64_t) sysconf(_SC_NPROCESSORS_ONLN);
+
+   if (threads > KISSDB_RECOVERY_MAX_THREADS)
+   {
+      threads = KISSDB_RECOVERY_MAX_THREADS;
+   }
+   if (threads > size / KISSDB_RECOVERY_MIN_RANGE_SIZE)
+   {
+      threads = size / KISSDB_RECOVERY_MIN_RANGE_SIZE;
+   }
+   return (threads < 1) ? 1 : (uint32_t) threads;
+}
+
+/*
+ * runs worker for count arguments of argSize bytes in parallel threads and waits for all of them
+ * the first worker runs on the calling thread, a worker whose thread cannot be created runs on the calling thread as well
+ */
+static void runRecoveryWorkers(void* (*worker)(void*), void* args, size_t argSize, uint32_t count)
+{
+   pthread_t threads[KISSDB_RECOVERY_MAX_THREADS];
+   Kdb_bool started[KISSDB_RECOVERY_MAX_THREADS] = { 0 };
+   uint32_t i = 0;
+
+   for (i = 1; i < count; i++)
+   {
+      started[i] = (pthread_create(&threads[i], NULL, worker, (char*) args + i * argSize) == 0) ? Kdb_true : Kdb_false;
+   }
+   worker(args);
+   for (i = 1; i < count; i++)
+   {
+      if (started[i] == Kdb_true)
+      {
+         pthread_join(threads[i], NULL);
+      }
+      else
+      {
+         worker((char*) args + i * argSize);
+      }
+   }
+}
+
+
+/* objects found by a scan of the database file */
+#define KDB_SCAN_HASHTABLE        0x01
+#define KDB_SCAN_DATA_BLOCK       0x02 /* data block of any kind (scan for hashtables only) */
+#define KDB_SCAN_PAIR             0x03 /* data block A (and data block B behind it) */
+#define KDB_SCAN_BLOCK_B          0x04 /* data block B without data block A in front of it */
+#define KDB_SCAN_DELETED_PAIR     0x05 /* deleted data block A (and deleted data block B behind it) */
+#define KDB_SCAN_DELETED_BLOCK_B  0x06 /* deleted data block B without deleted data block A in front of it */
+
+/* flags of the data blocks found by a scan */
+#define KDB_SCAN_HAS_B     0x01 /* data block B of the same size class follows data block A (with the same key if data block A is valid) */
+#define KDB_SCAN_VALID_A   0x02 /* checksum of data block A is valid */
+#define KDB_SCAN_VALID_B   0x04 /* checksum of data block B is valid */
+#define KDB_SCAN_RELEASED  0x08 /* deleted data blocks are released to the free lists (no key) */
+
+typedef struct
+{
+   int64_t offset;
+   uint32_t blockSize; /* size class of the data blocks (0 for a hashtable) */
+   uint8_t type;       /* KDB_SCAN_HASHTABLE ... KDB_SCAN_DELETED_BLOCK_B */
+   uint8_t flags;
+} Kdb_scan_item_s;
+
+/* file range scanned by one thread */
+typedef struct
+{
+   KISSDB* db;
+   char* memory;
+   int64_t mappedSize;
+   int64_t start;         /* objects starting in [start, end) are scanned */
+   int64_t end;
+   int64_t limit;         /* largest offset of an object */
+   int64_t syncEnd;       /* all objects starting before syncEnd are recorded, behind it only the objects used by the caller */
+   int64_t next;          /* offset behind the last object scanned */
+   Kdb_bool rebuild;      /* scan for the rebuild of the hashtables (data blocks with checksums) or for the hashtables only */
+   Kdb_scan_item_s* items;
+   uint32_t count;
+   uint32_t capacity;
+   int error;
+} Kdb_scan_range_s;
+
+/* returns the number of bytes covered by an object found by a scan */
+static int64_t getScanItemSize(const Kdb_scan_item_s* item)
+{
+   if (item->type == KDB_SCAN_HASHTABLE)
+   {
+      return sizeof(Hashtable_s);
+   }
+   if (item->type == KDB_SCAN_PAIR || item->type == KDB_SCAN_DELETED_PAIR)
+   {
+      return 2 * (int64_t) item->blockSize;
+   }
+   return item->blockSize;
+}
+
+static void addScanItem(Kdb_scan_range_s* range, int64_t offset, uint32_t blockSize, uint8_t type, uint8_t flags)
+{
+   Kdb_scan_item_s* items;
+
+   if (range->rebuild == Kdb_false && type != KDB_SCAN_HASHTABLE && offset >= range->syncEnd)
+   {
+      return;
+   }
+   if (range->count == range->capacity)
+   {
+      items = (Kdb_scan_item_s*) realloc(range->items, ((size_t) range->capacity * 2 + 64) * sizeof(Kdb_scan_item_s));
+      if (items == NULL)
+      {
+         range->error = KISSDB_ERROR_MALLOC;
+         return;
+      }
+      range->items = items;
+      range->capacity = range->capacity * 2 + 64;
+   }
+   range->items[range->count].offset = offset;
+   range->items[range->count].blockSize = blockSize;
+   range->items[range->count].type = type;
+   range->items[range->count].flags = flags;
+   range->count++;
+}
+
+/* returns KDB_SCAN_VALID_A or KDB_SCAN_VALID_B (valid) if the checksum of a data block is valid */
+static uint8_t getScanChecksumFlag(KISSDB* db, DataBlock_s* block, uint8_t valid)
+{
+   return (block->crc == getDataBlockCrc(db, block)) ? valid : 0;
+}
+
+/*
+ * worker scanning a file range for data blocks and hashtables
+ * all objects are aligned to the greatest common factor of the smallest size class and the hashtable size:
+ * the scan jumps behind every object found and steps over other areas by this factor
+ * a range can start inside of an object, scanDatabaseFile() drops the objects found before the end of the previous range
+ */
+static void* scanFileRange(void* arg)
+{
+   Kdb_scan_range_s* range = (Kdb_scan_range_s*) arg;
+   KISSDB* db = range->db;
+   DataBlock_s* data;
+   DataBlock_s* dataB;
+   Hashtable_s* hashtable;
+   int64_t offset = range->start;
+   int64_t ptrOffset = greatestCommonFactor(db->minBlockSize, sizeof(Hashtable_s));
+   uint32_t blockSize = 0;
+   uint8_t flags = 0;
+
+   while (offset < range->end && offset <= range->limit && range->error == 0)
+   {
+      data = (DataBlock_s*) (range->memory + offset);
+      hashtable = (Hashtable_s*) data;
+      if (range->rebuild == Kdb_false)
+      {
+         if (hashtable->delimStart == HASHTABLE_START_DELIMITER || hashtable->delimEnd == HASHTABLE_END_DELIMITER)
+         {
+            addScanItem(range, offset, 0, KDB_SCAN_HASHTABLE, 0);
+            offset += sizeof(Hashtable_s);
+         }
+         else if ((blockSize = getDataBlockSizeAt(db, data, offset, range->mappedSize)) != 0)
+         {
+            //jump behind data block (the value area is not searched for hashtable delimiters)
+            addScanItem(range, offset, blockSize, KDB_SCAN_DATA_BLOCK, 0);
+            offset += blockSize;
+         }
+         else
+         {
+            offset += ptrOffset;
+         }
+      }
+      else if (isDataBlock(db, data, offset, range->mappedSize, DATA_BLOCK_A_START_DELIMITER, DATA_BLOCK_A_END_DELIMITER))
+      {
+         blockSize = getDataBlockInfo(db, data)->blockSize;
+         flags = getScanChecksumFlag(db, data, KDB_SCAN_VALID_A);
+         dataB = (DataBlock_s*) ((char*) data + blockSize);
+         if (isDataBlock(db, dataB, offset + blockSize, range->mappedSize, DATA_BLOCK_B_START_DELIMITER, DATA_BLOCK_B_END_DELIMITER)
+               && getDataBlockInfo(db, dataB)->blockSize == blockSize && (!(flags & KDB_SCAN_VALID_A) || isSameKey(db, data, dataB) == Kdb_true))
+         {
+            flags |= KDB_SCAN_HAS_B | getScanChecksumFlag(db, dataB, KDB_SCAN_VALID_B);
+         }
+         addScanItem(range, offset, blockSize, KDB_SCAN_PAIR, flags);
+         offset += 2 * (int64_t) blockSize; //jump behind data block B
+      }
+      //data block B without data block A: this only can happen if the delimiters of data block A are corrupt
+      else if (isDataBlock(db, data, offset, range->mappedSize, DATA_BLOCK_B_START_DELIMITER, DATA_BLOCK_B_END_DELIMITER))
+      {
+         blockSize = getDataBlockInfo(db, data)->blockSize;
+         addScanItem(range, offset, blockSize, KDB_SCAN_BLOCK_B, getScanChecksumFlag(db, data, KDB_SCAN_VALID_B));
+         offset += blockSize;
+      }
+      else if (isDataBlock(db, data, offset, range->mappedSize, DATA_BLOCK_A_DELETED_START_DELIMITER, DATA_BLOCK_A_DELETED_END_DELIMITER))
+      {
+         blockSize = getDataBlockInfo(db, data)->blockSize;
+         dataB = (DataBlock_s*) ((char*) data + blockSize);
+         if (data->key[0] == '\0') //released data blocks are not referenced by any hashtable
+         {
+            flags = KDB_SCAN_RELEASED;
+         }
+         else
+         {
+            flags = getScanChecksumFlag(db, data, KDB_SCAN_VALID_A);
+            if (isDataBlock(db, dataB, offset + blockSize, range->mappedSize, DATA_BLOCK_B_DELETED_START_DELIMITER, DATA_BLOCK_B_DELETED_END_DELIMITER)
+                  && getDataBlockInfo(db, dataB)->blockSize == blockSize && (!(flags & KDB_SCAN_VALID_A) || isSameKey(db, data, dataB) == Kdb_true))
+            {
+               flags |= KDB_SCAN_HAS_B | getScanChecksumFlag(db, dataB, KDB_SCAN_VALID_B);
+            }
+         }
+         addScanItem(range, offset, blockSize, KDB_SCAN_DELETED_PAIR, flags);
+         offset += 2 * (int64_t) blockSize;
+      }
+      else if (isDataBlock(db, data, offset, range->mappedSize, DATA_BLOCK_B_DELETED_START_DELIMITER, DATA_BLOCK_B_DELETED_END_DELIMITER))
+      {
+         blockSize = getDataBlockInfo(db, data)->blockSize;
+         flags = (data->key[0] == '\0') ? KDB_SCAN_RELEASED : getScanChecksumFlag(db, data, KDB_SCAN_VALID_B);
+         addScanItem(range, offset, blockSize, KDB_SCAN_DELETED_BLOCK_B, flags);
+         offset += blockSize;
+      }
+      else if (offset <= range->mappedSize - (int64_t) sizeof(Hashtable_s)
+            && (hashtable->delimStart == HASHTABLE_START_DELIMITER || hashtable->delimEnd == HASHTABLE_END_DELIMITER))
+      {
+         addScanItem(range, offset, 0, KDB_SCAN_HASHTABLE, 0);
+         offset += sizeof(Hashtable_s);
+      }
+      else //no data block or hashtable found
+      {
+         offset += ptrOffset;
+      }
+   }
+   range->next = offset;
+   return NULL;
+}
+
+/*
+ * scans the database file from offset start for data blocks and hashtables, the objects found are returned in file order
+ * (with rebuild == Kdb_false the items contain all hashtables, the data blocks are only found to skip their value area)
+ * the file is divided into ranges scanned by parallel threads: the objects of a range are used from the offset behind the last object
+ * of the previous range, if this offset is inside of an object found in the range (e.g. a delimiter in a value), the range is scanned again from there
+ */
+static int scanDatabaseFile(KISSDB* db, char* memory, int64_t mappedSize, int64_t start, Kdb_bool rebuild, Kdb_scan_item_s** items, uint32_t* count)
+{
+   Kdb_scan_range_s ranges[KISSDB_RECOVERY_MAX_THREADS];
+   uint32_t first[KISSDB_RECOVERY_MAX_THREADS];
+   Kdb_scan_item_s* last;
+   int64_t ptrOffset = greatestCommonFactor(db->minBlockSize, sizeof(Hashtable_s));
+   int64_t maxObjectSize = 2 * (int64_t) getDataBlockSize(db, db->valSize);
+   int64_t rangeSize = 0;
+   int64_t syncOffset = start;
+   uint32_t threads = getRecoveryThreadCount(mappedSize - start);
+   uint32_t i = 0;
+   int ret = 0;
+
+   if (maxObjectSize < (int64_t) sizeof(Hashtable_s))
+   {
+      maxObjectSize = sizeof(Hashtable_s);
+   }
+   rangeSize = ((mappedSize - start) / threads + ptrOffset - 1) / ptrOffset * ptrOffset;
+   memset(ranges, 0, sizeof(ranges));
+   for (i = 0; i < threads; i++)
+   {
+      ranges[i].db = db;
+      ranges[i].memory = memory;
+      ranges[i].mappedSize = mappedSize;
+      ranges[i].start = start + i * rangeSize;
+      ranges[i].end = (i + 1 < threads) ? ranges[i].start + rangeSize : mappedSize;
+      ranges[i].limit = mappedSize - ((rebuild == Kdb_true) ? (int64_t) db->minBlockSize : (int64_t) db->htSizeBytes);
+      ranges[i].syncEnd = ranges[i].start + maxObjectSize + ptrOffset; //the previous range can end behind its end by the size of an object
+      ranges[i].rebuild = rebuild;
+   }
+   runRecoveryWorkers(scanFileRange, ranges, sizeof(Kdb_scan_range_s), threads);
+
+   //merge the ranges in file order
+   *(items) = NULL;
+   *(count) = 0;
+   for (i = 0; i < threads && ret == 0; i++)
+   {
+      first[i] = 0;
+      ret = ranges[i].error;
+      if (ret != 0 || syncOffset >= ranges[i].end)
+      {
+         first[i] = ranges[i].count; //the range is covered by the last object of a previous range
+         continue;
+      }
+      while (first[i] < ranges[i].count && ranges[i].items[first[i]].offset < syncOffset)
+      {
+         first[i]++;
+      }
+      last = (first[i] > 0) ? &ranges[i].items[first[i] - 1] : NULL;
+      if (last != NULL && last->offset + getScanItemSize(last) > syncOffset)
+      {
+         //the range was scanned out of step with the objects in the file
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": scanning file range again from offset: "); DLT_INT64(syncOffset));
+         ranges[i].count = 0;
+         ranges[i].start = syncOffset;
+         ranges[i].syncEnd = syncOffset;
+         scanFileRange(&ranges[i]);
+         ret = ranges[i].error;
+         first[i] = 0;
+      }
+      *(count) += ranges[i].count - first[i];
+      syncOffset = ranges[i].next;
+   }
+
+   if (ret == 0 && *(count) > 0)
+   {
+      *(items) = (Kdb_scan_item_s*) malloc(*(count) * sizeof(Kdb_scan_item_s));
+      if (*(items) == NULL)
+      {
+         ret = KISSDB_ERROR_MALLOC;
+      }
+      else
+      {
+         *(count) = 0;
+         for (i = 0; i < threads; i++)
+         {
+            memcpy(*(items) + *(count), ranges[i].items + first[i], (ranges[i].count - first[i]) * sizeof(Kdb_scan_item_s));
+            *(count) += ranges[i].count - first[i];
+         }
+      }
+   }
+   for (i = 0; i < threads; i++)
+   {
+      free(ranges[i].items);
+   }
+   if (ret != 0)
+   {
+      *(count) = 0;
+   }
+   return ret;
+}
+
+
+int verifyHashtableCS(KISSDB* db)
+{
+   char* ptr;
+   Hashtable_s* hashtable;
+   Kdb_scan_item_s* items = NULL;
+   int i = 0;
+   int ret = 0;
+   struct stat statBuf;
+   uint32_t count = 0;
+   uint32_t k = 0;
+   uint64_t crc = 0;
+   int64_t link = KISSDB_HEADER_SIZE;
+   Kdb_bool linked = Kdb_true;
+   void* memory;
+
+   if (db->fd)
+   {
+      //map entire file into memory
+      fstat(db->fd, &statBuf);
+      memory = (void*) mmap(NULL, statBuf.st_size, PROT_WRITE | PROT_READ, MAP_SHARED, db->fd, 0);
+      if (memory == MAP_FAILED)
+      {
+         return KISSDB_ERROR_IO;
+      }
+      db->shared->htNum = 0;
+      //unmap previously allocated and maybe corrupted hashtables
+      munmap(db->hashTables, db->htMappedSize);
+      db->hashTables = (Hashtable_s*) getKdbShmemPtr(db->htFd, db->htSizeBytes);
+      if(db->hashTables == ((void*) -1))
+      {
+         munmap(memory, statBuf.st_size);
+         return KISSDB_ERROR_MAP_SHM;
+      }
+      db->htMappedSize = db->htSizeBytes; //size for first hashtable
+
+      //get hashtables in file (search for hashtable delimiters, beginning with offset for first hashtable)
+      ret = scanDatabaseFile(db, (char*) memory, statBuf.st_size, sizeof(Header_s), Kdb_false, &items, &count);
+      for (k = 0; k < count && ret == 0; k++)
+      {
+         if (items[k].type != KDB_SCAN_HASHTABLE)
+         {
+            continue;
+         }
+         ptr = (char*) memory + items[k].offset;
+         hashtable = (Hashtable_s*) ptr;
+         //a hashtable not linked by the hashtable in front of it is an old copy (e.g. left by an interrupted compaction)
+         if (items[k].offset != link)
+         {
+            linked = Kdb_false;
+         }
+         link = hashtable->slots[db->htSize].offsetA;
+         //next hashtable to use
+         //rewrite delimiters to make sure that both exist
+         hashtable->delimStart = HASHTABLE_START_DELIMITER;
+         hashtable->delimEnd   = HASHTABLE_END_DELIMITER;
+         Kdb_bool result = Kdb_false;
+         //if new size would exceed old shared memory size-> allocate additional memory page to shared memory
+         if (db->htSizeBytes * (db->shared->htNum + 1) > db->htMappedSize)
+         {
+            result = resizeKdbShmem(db->htFd, &db->hashTables, db->htMappedSize, db->htMappedSize + db->htSizeBytes);
+            if (result == Kdb_false)
+            {
+               ret = KISSDB_ERROR_RESIZE_SHM;
+               break;
+            }
+            else
+            {
+               db->shared->htShmSize = db->htMappedSize + db->htSizeBytes;
+               db->htMappedSize = db->shared->htShmSize;
+            }
+         }
+         // copy the current hashtable read from file to (htadress + (htsize  * htcount)) in memory
+         memcpy(((uint8_t*) db->hashTables) + (db->htSizeBytes * db->shared->htNum), ptr, db->htSizeBytes);
+         ++db->shared->htNum;
+      }
+      free(items);
+      munmap(memory, statBuf.st_size);
+      if (ret != 0)
+      {
+         return ret;
+      }
+      if (linked == Kdb_false || (db->shared->htNum > 0 && link != 0))
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": Hashtables found in the file do not match their links"));
+         return -1; //start rebuild of hashtables
+      }
+
+      //check CRC of all found hashtables
+      if (db->shared->htNum > 0)
+      {
+         for (i = 0; i < db->shared->htNum; i++)
+         {
+            crc = getHashtableCrc(db, &db->hashTables[i]);
+            if (db->hashTables[i].crc != crc)
+            {
+               DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": Checksum of hashtable number: <"); DLT_INT(i); DLT_STRING("> is invalid"));
+#ifdef PFS_TEST
+               printf("VERIFY HASHTABLE: hashtable #%d: CHECKSUM INVALID! \n",i);
+#endif
+               return -1; //start rebuild of hashtables
+            }
+            else
+            {
+               DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": Checksum of hashtable number: <"); DLT_INT(i); DLT_STRING("> is OK"));
+
+#ifdef PFS_TEST
+               printf("VERIFY HASHTABLE: hashtable #%d: CHECKSUM OK! \n",i);
+#endif
+            }
+         }
+      }
+   }
+   return 0;
+}
+
+int rebuildHashtables(KISSDB* db)
+{
+   char* ptr;
+   DataBlock_s* data;
+   DataBlock_s* dataA;
+   DataBlock_s* dataB;
+   Kdb_scan_item_s* items = NULL;
+   int current = 0;
+   int ret = 0;
+   int64_t offset=0;
+   struct stat statBuf;
+   uint32_t blockSize = 0;
+   uint32_t count = 0;
+   uint32_t i = 0;
+   uint8_t flags = 0;
+   void* memory;
+
+   fstat(db->fd, &statBuf);
+   memory = (char*) mmap(NULL, statBuf.st_size, PROT_WRITE | PROT_READ, MAP_SHARED, db->fd, 0);
+   if (memory == MAP_FAILED)
+   {
+      return KISSDB_ERROR_IO;
+   }
+   ptr = (char*) memory;
+
+   //search the data blocks and hashtables behind the first hashtable, the checksums of the data blocks are verified by the scan
+   ret = scanDatabaseFile(db, ptr, statBuf.st_size, sizeof(Header_s) + sizeof(Hashtable_s), Kdb_true, &items, &count);
+   if (ret != 0)
+   {
+      munmap(memory, statBuf.st_size);
+      return ret;
+   }
+
+   //recover all hashtables of database
+   while (db->shared->htNum > 0) //htNum was determined in verifyhashtables() -> no reallocation is needed
+   {
+      current = 0;
+      memset(db->hashTables, 0, db->shared->htNum * sizeof(Hashtable_s));
+      db->shared->htUsedSlots = 0;
+      db->hashTables[0].delimStart = HASHTABLE_START_DELIMITER;
+      db->hashTables[0].delimEnd = HASHTABLE_END_DELIMITER;
+
+      //insert the data blocks in file order
+      for (i = 0; i < count; i++)
+      {
+         offset = items[i].offset;
+         blockSize = items[i].blockSize;
+         flags = items[i].flags;
+         data = (DataBlock_s*) (ptr + offset);
+         //the data block in front of a data block B is only invalidated with it if it stores the same key (an interrupted compaction can leave a data block B behind another key)
+         dataA = (offset - blockSize >= (int64_t) (sizeof(Header_s) + sizeof(Hashtable_s))) ? (DataBlock_s*) (ptr + offset - blockSize) : NULL;
+         dataA = (dataA != NULL && isSameKey(db, dataA, data) == Kdb_true) ? dataA : NULL;
+         dataB = (DataBlock_s*) (ptr + offset + blockSize);
+
+         if (items[i].type == KDB_SCAN_PAIR)
+         {
+            //use the block with the latest written data of the blocks with a valid checksum
+            if ((flags & KDB_SCAN_HAS_B) && (flags & KDB_SCAN_VALID_B)
+                  && (!(flags & KDB_SCAN_VALID_A) || isDataBlockBNewer(db, data, dataB) == Kdb_true))
+            {
+               rebuildWithBlockB(dataB, db, offset, offset + blockSize);
+            }
+            else if (flags & KDB_SCAN_VALID_A)
+            {
+               rebuildWithBlockA(data, db, offset, offset + blockSize);
+            }
+            else //checksum of block A and of Block B do not match (or block B was not found) ---> worst case scenario
+            {
+               invalidateBlocks(data, (flags & KDB_SCAN_HAS_B) ? dataB : NULL, blockSize, db);
+            }
+         }
+         else if (items[i].type == KDB_SCAN_BLOCK_B)
+         {
+            if (flags & KDB_SCAN_VALID_B)
+            {
+               rebuildWithBlockB(data, db, offset - blockSize, offset);
+            }
+            else
+            {
+               invalidateBlocks(dataA, data, blockSize, db);
+            }
+         }
+         else if (items[i].type == KDB_SCAN_DELETED_PAIR)
+         {
+            if (flags & KDB_SCAN_RELEASED) //released data blocks are not referenced by any hashtable
+            {
+               DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": Skipping released datablocks at offset: "); DLT_INT(offset));
+            }
+            else if (((flags & KDB_SCAN_HAS_B) && (flags & KDB_SCAN_VALID_B)) || (flags & KDB_SCAN_VALID_A))
+            {
+               invertBlockOffsets(data, db, offset, offset + blockSize);
+            }
+            else
+            {
+               invalidateBlocks(data, (flags & KDB_SCAN_HAS_B) ? dataB : NULL, blockSize, db);
+            }
+         }
+         else if (items[i].type == KDB_SCAN_DELETED_BLOCK_B)
+         {
+            if (flags & KDB_SCAN_RELEASED)
+            {
+               DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": Skipping released datablock at offset: "); DLT_INT(offset));
+            }
+            else if (flags & KDB_SCAN_VALID_B)
+            {
+               invertBlockOffsets(data, db, offset - blockSize, offset);
+            }
+            else
+            {
+               invalidateBlocks(dataA, data, blockSize, db);
+            }
+         }
+         else if (items[i].type == KDB_SCAN_HASHTABLE)
+         {
+            //next hashtable to use
+            db->hashTables[current].slots[db->htSize].offsetA = offset; //update link to next hashtable in current hashtable
+            current++;
+            if (current < db->shared->htNum)
+            {
+               db->hashTables[current].delimStart = HASHTABLE_START_DELIMITER;
+               db->hashTables[current].delimEnd   = HASHTABLE_END_DELIMITER;
+            }
+            else
+            {
+               free(items);
+               munmap(memory, statBuf.st_size);
+               return -1;
+            }
+         }
+      }
+      if (current + 1 >= db->shared->htNum)
+      {
+         break;
+      }
+      //verifyHashtableCS() counted a hashtable that is not found here (e.g. the old copy of a hashtable moved by an interrupted compaction)
+      //a hashtable without a link cannot be written back to the file -> rebuild the index with the found hashtables only
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": Found "); DLT_INT(current + 1); DLT_STRING(" of "); DLT_INT(db->shared->htNum); DLT_STRING(" hashtables -> rebuild again!"));
+      db->shared->htNum = current + 1;
+   }
+   free(items);
+   msync(memory, statBuf.st_size, MS_SYNC | MS_INVALIDATE);
+   munmap(memory, statBuf.st_size);
+   return 0;
+}
+
+
+//invalidate block content for A and B
+//this block can never be found / overwritten again
+//new insertions can reuse hashtable entry but block is added at EOF
+void invalidateBlocks(DataBlock_s* dataA, DataBlock_s* dataB, uint32_t blockSize, KISSDB* db)
+{
+   uint32_t valueAreaSize = blockSize - db->dataBlockHeaderSize - sizeof(int64_t);
+
+   if (dataA != NULL)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": Datablock recovery for key: <"); DLT_STRING(dataA->key); DLT_STRING("> impossible: both datablocks are invalid!"));
+
+      memset(dataA->key, 0, db->keyFieldSize);
+      memset(getDataBlockValue(db, dataA), 0, valueAreaSize);
+      dataA->crc=0;
+      getDataBlockInfo(db, dataA)->sequence = 0;
+      getDataBlockInfo(db, dataA)->valSize = 0;
+      getDataBlockInfo(db, dataA)->valFlags = 0;
+   }
+
+   if (dataB != NULL)
+   {
+      memset(dataB->key, 0, db->keyFieldSize);
+      memset(getDataBlockValue(db, dataB), 0, valueAreaSize);
+      dataB->crc=0;
+      getDataBlockInfo(db, dataB)->sequence = 0;
+      getDataBlockInfo(db, dataB)->valSize = 0;
+      getDataBlockInfo(db, dataB)->valFlags = 0;
+   }
+}
+
+
+/*
+ * inserts the slot entry for the key of a data block found during the rebuild of the hashtables
+ * if a compaction was interrupted, a key can be found twice: the copy with the latest value is used (the copy found first if both are the same)
+ */
+static void rebuildSlot(DataBlock_s* data, KISSDB* db, Hashtable_slot_s* entry)
+{
+   Hashtable_slot_s* slot;
+   DataBlock_s* found;
+   char* memory = (char*) data - ((entry->current & KISSDB_SLOT_CURRENT_B) ? entry->offsetB : entry->offsetA);
+   unsigned long klen = strnlen(data->key, db->keyFieldSize);
+   uint64_t hash = db->keyHash(data->key, klen);
+
+   setSlotKey(entry, hash, klen);
+   if (entry->offsetA > 0 && findHashtableSlot(db, data->key, klen, hash, &slot, NULL, Kdb_false) == 0)
+   {
+      found = (DataBlock_s*) (memory + getSlotCurrentOffset(db, slot));
+      if ((int32_t) (getDataBlockInfo(db, data)->sequence - getDataBlockInfo(db, found)->sequence) > 0) //sequence numbers may wrap around
+      {
+         slot->offsetA = entry->offsetA;
+         slot->offsetB = entry->offsetB;
+         slot->current = entry->current;
+      }
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": Found second copy of datablocks for key: <"); DLT_STRING(data->key); DLT_STRING(">"));
+      return;
+   }
+   if (insertHashtableSlot(db, hash, entry) != 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": Rebuild of hashtable slot for key: <"); DLT_STRING(data->key); DLT_STRING("> failed!"));
+   }
+}
+
+
+void invertBlockOffsets(DataBlock_s* data, KISSDB* db, int64_t offsetA, int64_t offsetB)
+{
+   Hashtable_slot_s entry;
+   //invert offsets for deleted block A
+   entry.offsetA = - offsetA;
+   //invert offsets for deleted block B
+   entry.offsetB = - offsetB;
+   //reset current flag
+   entry.current = 0x00;
+   rebuildSlot(data, db, &entry);
+}
+
+
+void rebuildWithBlockB(DataBlock_s* data, KISSDB* db, int64_t offsetA, int64_t offsetB)
+{
+   Hashtable_slot_s entry;
+   //write offsets for block A and block B
+   entry.offsetA = offsetA;
+   entry.offsetB = offsetB;
+   //set block B as current
+   entry.current = 0x01;
+   rebuildSlot(data, db, &entry);
+
+   /*
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": Rebuild of sequence <"); DLT_INT(getDataBlockInfo(db, data)->sequence);
+         DLT_STRING("> with Datablock B for key: <"); DLT_STRING(data->key); DLT_STRING("- hash: <"); DLT_INT(hash); DLT_STRING("> - OffsetA: <"); DLT_INT(offsetA);
+         DLT_STRING("> - OffsetB: <"); DLT_INT(offsetB));
+   */
+}
+
+
+void rebuildWithBlockA(DataBlock_s* data, KISSDB* db, int64_t offsetA, int64_t offsetB)
+{
+   Hashtable_slot_s entry;
+   //write offsets for block A and block B
+   entry.offsetA = offsetA;
+   entry.offsetB = offsetB;
+   //set block A as current
+   entry.current = 0x00;
+   rebuildSlot(data, db, &entry);
+
+   /*
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": Rebuild of sequence <"); DLT_INT(getDataBlockInfo(db, data)->sequence);
+         DLT_STRING("> with Datablock A for key: <"); DLT_STRING(data->key); DLT_STRING("- hash: <"); DLT_INT(hash); DLT_STRING("> - OffsetA: <"); DLT_INT(offsetA);
+         DLT_STRING("> - OffsetB: <"); DLT_INT(offsetB));
+   */
+}
+
+
+
+
+/* hashtables recovered by one thread */
+typedef struct
+{
+   KISSDB* db;
+   char* memory;
+   int64_t mappedSize;
+   uint32_t first;     /* hashtables first to last - 1 */
+   uint32_t last;
+} Kdb_recovery_range_s;
+
+/*
+ * writes a copy of the valid data block of a slot over its invalid data block A or B (given by the delimiters)
+ * the blocks of a slot are adjacent: an invalid block can be a partly moved copy of another size class left by an interrupted compaction
+ */
+static void repairDataBlock(KISSDB* db, char* ptr, int64_t mappedSize, DataBlock_s* valid, int64_t offset, int64_t delimStart, int64_t delimEnd)
+{
+   DataBlock_s* block = (DataBlock_s*) (ptr + offset);
+   uint32_t blockSize = getDataBlockInfo(db, valid)->blockSize;
+
+   if (offset < (int64_t) (KISSDB_HEADER_SIZE + sizeof(Hashtable_s)) || offset + (int64_t) blockSize > mappedSize)
+   {
+      return;
+   }
+   memcpy(block, valid, blockSize);
+   block->delimStart = delimStart;
+   *getDataBlockEndDelimiter(db, block) = delimEnd;
+}
+
+/* checks the data blocks referenced by a slot and sets the current flag to the latest valid data block */
+static void recoverSlotDataBlocks(KISSDB* db, char* ptr, int64_t mappedSize, uint32_t htNumber, uint32_t slotNumber)
+{
+   DataBlock_s* dataA;
+   DataBlock_s* dataB;
+   Hashtable_slot_s* slot = &db->hashTables[htNumber].slots[slotNumber];
+   Kdb_bool validA, validB;
+   uint8_t current = 0x00;
+
+   if (slot->offsetA <= 0) //ignore deleted or unused slots
+   {
+      return;
+   }
+   clearSlotInlineValue(db, slot); //the inline value can be older than the data blocks, it is set again when the database is opened
+   //check crc of both data blocks (a corrupt size class is treated like a wrong crc)
+   dataA = (DataBlock_s*) (ptr + slot->offsetA);
+   dataB = (DataBlock_s*) (ptr + slot->offsetB);
+   validA = isValidDataBlock(db, dataA, slot->offsetA, mappedSize, DATA_BLOCK_A_START_DELIMITER, DATA_BLOCK_A_END_DELIMITER);
+   validB = isValidDataBlock(db, dataB, slot->offsetB, mappedSize, DATA_BLOCK_B_START_DELIMITER, DATA_BLOCK_B_END_DELIMITER);
+   if (validA == Kdb_true && validB == Kdb_true && strncmp(dataA->key, dataB->key, db->keyFieldSize) != 0)
+   {
+      //blocks of different keys (an interrupted compaction moved only one of them): keep the current block of the slot
+      validA = (slot->current == 0x00) ? Kdb_true : Kdb_false;
+      validB = (slot->current == 0x00) ? Kdb_false : Kdb_true;
+   }
+   if (validA == Kdb_true && validB == Kdb_true)
+   {
+      //the current flag in the hashtable can be older than the last update: use the block with the higher sequence
+      current = (isDataBlockBNewer(db, dataA, dataB) == Kdb_true) ? 0x01 : 0x00;
+   }
+   else if (validA == Kdb_true || validB == Kdb_true)
+   {
+      current = (validB == Kdb_true) ? 0x01 : 0x00;
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": Invalid datablock found at file offset: "); DLT_INT((validB == Kdb_true) ? slot->offsetA : slot->offsetB));
+      if (validA == Kdb_true && slot->offsetB == slot->offsetA + (int64_t) getDataBlockInfo(db, dataA)->blockSize)
+      {
+         repairDataBlock(db, ptr, mappedSize, dataA, slot->offsetB, DATA_BLOCK_B_START_DELIMITER, DATA_BLOCK_B_END_DELIMITER);
+      }
+      else if (validB == Kdb_true && slot->offsetA == slot->offsetB - (int64_t) getDataBlockInfo(db, dataB)->blockSize)
+      {
+         repairDataBlock(db, ptr, mappedSize, dataB, slot->offsetA, DATA_BLOCK_A_START_DELIMITER, DATA_BLOCK_A_END_DELIMITER);
+      }
+#ifdef PFS_TEST
+      printf("DATABLOCK RECOVERY: INVALID CRC FOR DATABLOCK DETECTED! \n");
+#endif
+   }
+   else
+   {
+      //invalidate data blocks if recovery fails (the blocks are released when the free lists are rebuilt)
+      slot->offsetA = KISSDB_SLOT_DELETED;
+      slot->offsetB = KISSDB_SLOT_DELETED;
+      slot->current = 0x00;
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": Datablock recovery impossible: both datablocks are invalid in hashtable: "); DLT_INT(htNumber); DLT_STRING(" slot: "); DLT_INT(slotNumber));
+#ifdef PFS_TEST
+      printf("DATABLOCK RECOVERY: ERROR -> BOTH BLOCKS ARE INVALID! \n");
+#endif
+      return;
+   }
+   if (slot->current != current)
+   {
+      //switch current flag to the latest valid block
+      slot->current = current;
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": Latest datablock for key: <"); DLT_STRING(dataA->key); DLT_STRING("> successfully recovered!"));
+#ifdef PFS_TEST
+      printf("DATABLOCK RECOVERY: REPAIR OF INVALID DATA SUCCESSFUL! \n");
+#endif
+   }
+}
+
+/* worker recovering the data blocks of a range of hashtables (every slot only changes itself) */
+static void* recoverHashtableRange(void* arg)
+{
+   Kdb_recovery_range_s* range = (Kdb_recovery_range_s*) arg;
+   uint32_t i = 0;
+   uint32_t k = 0;
+
+   for (i = range->first; i < range->last; i++)
+   {
+      for (k = 0; k < HASHTABLE_SLOT_COUNT; k++)
+      {
+         recoverSlotDataBlocks(range->db, range->memory, range->mappedSize, i, k);
+      }
+   }
+   return NULL;
+}
+
+int recoverDataBlocks(KISSDB* db)
+{
+
+#ifdef PFS_TEST
+                  printf("DATABLOCK RECOVERY: START! \n");
+#endif
+
+   Kdb_recovery_range_s ranges[KISSDB_RECOVERY_MAX_THREADS];
+   uint32_t threads = 0;
+   uint32_t i = 0;
+   struct stat statBuf;
+   void* memory;
+
+   fstat(db->fd, &statBuf);
+   memory = (char*) mmap(NULL, statBuf.st_size, PROT_WRITE | PROT_READ, MAP_SHARED, db->fd, 0);
+   if (memory == MAP_FAILED)
+   {
+      return KISSDB_ERROR_IO;
+   }
+
+   //go through all hashtables and jump to data blocks for crc validation (the hashtables are divided into ranges checked by parallel threads)
+   threads = getRecoveryThreadCount(statBuf.st_size);
+   if (threads > db->shared->htNum)
+   {
+      threads = db->shared->htNum;
+   }
+   for (i = 0; i < threads; i++)
+   {
+      ranges[i].db = db;
+      ranges[i].memory = (char*) memory;
+      ranges[i].mappedSize = statBuf.st_size;
+      ranges[i].first = db->shared->htNum * i / threads;
+      ranges[i].last = db->shared->htNum * (i + 1) / threads;
+   }
+   if (threads > 0)
+   {
+      runRecoveryWorkers(recoverHashtableRange, ranges, sizeof(Kdb_recovery_range_s), threads);
+   }
+   msync(memory, statBuf.st_size, MS_SYNC | MS_INVALIDATE);
+   munmap(memory, statBuf.st_size);
+
+#ifdef PFS_TEST
+                  printf("DATABLOCK RECOVERY: END! \n");
+#endif
+
+   return 0;
+}
+
+/* data block pair written or released after the last checkpoint */
+typedef struct
+{
+   int64_t offset;    /* file offset of data block A */
+   uint32_t position; /* last position of the pair in the journal */
+} Kdb_journal_item_s;
+
+static int compareJournalOffsets(const void* a, const void* b)
+{
+   int64_t offsetA = ((const Kdb_journal_item_s*) a)->offset;
+   int64_t offsetB = ((const Kdb_journal_item_s*) b)->offset;
+   return (offsetA > offsetB) - (offsetA < offsetB);
+}
+
+static int compareJournalPositions(const void* a, const void* b)
+{
+   uint32_t positionA = ((const Kdb_journal_item_s*) a)->position;
+   uint32_t positionB = ((const Kdb_journal_item_s*) b)->position;
+   return (positionA > positionB) - (positionA < positionB);
+}
+
+/*
+ * replays a journaled data block pair: the key stored in the pair is inserted into the hashtables again
+ * released pairs and pairs without a valid data block are skipped
+ */
+static int replayDualDataBlock(KISSDB* db, int64_t offset)
+{
+   DataBlock_s* dataA = (DataBlock_s*) (db->mappedDb + offset);
+   DataBlock_s* dataB = NULL;
+   DataBlock_s* data;
+   Hashtable_slot_s* slot;
+   Hashtable_slot_s* freeSlot;
+   Hashtable_slot_s entry;
+   Kdb_bool validA, validB = Kdb_false;
+   uint32_t blockSize = 0;
+   uint64_t hash = 0;
+   unsigned long klen;
+   int ret = 0;
+
+   if (dataA->delimStart == DATA_BLOCK_A_DELETED_START_DELIMITER)
+   {
+      return 0; //released after it was written
+   }
+   validA = isValidDataBlock(db, dataA, offset, db->dbMappedSize, DATA_BLOCK_A_START_DELIMITER, DATA_BLOCK_A_END_DELIMITER);
+   //the size class of an interrupted write of block A is taken from block B
+   for (blockSize = db->minBlockSize; isValidDataBlockSize(db, blockSize) == Kdb_true && validB == Kdb_false; blockSize <<= 1)
+   {
+      if (validA == Kdb_false || blockSize == getDataBlockInfo(db, dataA)->blockSize)
+      {
+         dataB = (DataBlock_s*) (db->mappedDb + offset + blockSize);
+         validB = (getDataBlockInfo(db, dataB)->blockSize == blockSize) ? isValidDataBlock(db, dataB, offset + blockSize, db->dbMappedSize, DATA_BLOCK_B_START_DELIMITER, DATA_BLOCK_B_END_DELIMITER) : Kdb_false;
+      }
+   }
+   if (validA == Kdb_true && validB == Kdb_true && strncmp(dataA->key, dataB->key, db->keyFieldSize) != 0)
+   {
+      validB = Kdb_false; //block A is always written first
+   }
+   if (validA == Kdb_false && validB == Kdb_false)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": both datablocks are invalid at file offset: "); DLT_INT64(offset));
+      return 0;
+   }
+   entry.current = (validB == Kdb_true && (validA == Kdb_false || isDataBlockBNewer(db, dataA, dataB) == Kdb_true)) ? 0x01 : 0x00;
+   data = (entry.current == 0x00) ? dataA : dataB;
+   entry.offsetA = offset;
+   entry.offsetB = offset + getDataBlockInfo(db, data)->blockSize;
+   klen = strnlen(data->key, db->keyFieldSize);
+   hash = db->keyHash(data->key, klen);
+   setSlotKey(&entry, hash, klen);
+
+   ret = findHashtableSlot(db, data->key, klen, hash, &slot, &freeSlot, Kdb_false);
+   if (ret < 0)
+   {
+      return ret;
+   }
+   if (ret == 0) //the key was moved to this pair: the pair referenced so far is no longer used
+   {
+      if (slot->offsetA != offset)
+      {
+         releaseDualDataBlock(db, slot->offsetA);
+      }
+      *(slot) = entry;
+      setSlotDirty(db, slot);
+   }
+   else if (freeSlot != NULL)
+   {
+      if (freeSlot->offsetA == 0)
+      {
+         ++db->shared->htUsedSlots;
+      }
+      *(freeSlot) = entry;
+      setSlotDirty(db, freeSlot);
+   }
+   else
+   {
+      ret = insertHashtableSlot(db, hash, &entry);
+   }
+   return (ret < 0) ? ret : 0;
+}
+
+
+/*
+ * recovers the hashtables after a power loss from the last checkpoint in the file
+ * only the data block pairs journaled after the checkpoint are read: their slots are removed and inserted again with the latest valid data block
+ * returns -1 if there is no valid checkpoint (the hashtables must be rebuilt from the whole file)
+ */
+int recoverFromCheckpoint(KISSDB* db)
+{
+   Header_s* header = (Header_s*) db->mappedDb;
+   Kdb_journal_item_s* items;
+   Kdb_journal_item_s search;
+   Hashtable_slot_s* slot;
+   uint32_t count = 0;
+   uint32_t i = 0;
+   uint32_t k = 0;
+   int ret = 0;
+
+   if (header->checkpoint == 0 || header->journalCount > KISSDB_JOURNAL_SIZE
+         || (db->shared->htNum == 0 && header->journalCount > 0))
+   {
+      return -1;
+   }
+   //the hashtables loaded from the file must be the complete and unmodified hashtables of the checkpoint
+   for (i = 0; i < db->shared->htNum; i++)
+   {
+      if (db->hashTables[i].delimStart != HASHTABLE_START_DELIMITER || db->hashTables[i].delimEnd != HASHTABLE_END_DELIMITER
+            || db->hashTables[i].crc != getHashtableCrc(db, &db->hashTables[i]))
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": hashtable of checkpoint is invalid: "); DLT_INT(i));
+         return -1;
+      }
+   }
+   if (db->shared->htNum > 0 && db->hashTables[db->shared->htNum - 1].slots[db->htSize].offsetA != 0)
+   {
+      return -1;
+   }
+
+   items = (Kdb_journal_item_s*) malloc((header->journalCount + 1) * sizeof(Kdb_journal_item_s));
+   if (items == NULL)
+   {
+      return KISSDB_ERROR_MALLOC;
+   }
+   for (i = 0; i < header->journalCount; i++)
+   {
+      if (header->journal[i] < (int64_t) (KISSDB_HEADER_SIZE + sizeof(Hashtable_s))
+            || header->journal[i] + 2 * db->minBlockSize > db->dbMappedSize)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": invalid journal entry: "); DLT_INT64(header->journal[i]));
+         free(items);
+         return -1;
+      }
+      items[i].offset = header->journal[i];
+      items[i].position = i;
+   }
+   //a pair journaled more than once is replayed at its last position
+   qsort(items, header->journalCount, sizeof(Kdb_journal_item_s), compareJournalOffsets);
+   for (i = 0; i < header->journalCount; i++)
+   {
+      if (count > 0 && items[count - 1].offset == items[i].offset)
+      {
+         items[count - 1].position = items[i].position;
+      }
+      else
+      {
+         items[count++] = items[i];
+      }
+   }
+
+   //the free lists of the header include all pairs released before the power loss
+   memcpy(db->shared->freeList, header->freeList, sizeof(db->shared->freeList));
+   db->shared->htUsedSlots = countHashtableSlots(db);
+
+   //slots referencing a journaled pair are outdated
+   for (i = 0; i < db->shared->htNum; i++)
+   {
+      for (k = 0; k < db->htSize; k++)
+      {
+         slot = &db->hashTables[i].slots[k];
+         search.offset = slot->offsetA;
+         if (slot->offsetA > 0 && bsearch(&search, items, count, sizeof(Kdb_journal_item_s), compareJournalOffsets) != NULL)
+         {
+            slot->offsetA = KISSDB_SLOT_DELETED;
+            slot->offsetB = KISSDB_SLOT_DELETED;
+            slot->current = 0x00;
+            setHashtableDirty(db, i);
+         }
+      }
+   }
+
+   qsort(items, count, sizeof(Kdb_journal_item_s), compareJournalPositions);
+   for (i = 0; i < count && ret == 0; i++)
+   {
+      ret = replayDualDataBlock(db, items[i].offset);
+   }
+   free(items);
+   if (ret != 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": replay of journal failed: "); DLT_INT(ret));
+      return -1;
+   }
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO, DLT_STRING(__FUNCTION__); DLT_STRING(": checkpoint: "); DLT_INT64(header->checkpoint); DLT_STRING(" replayed journal entries: "); DLT_INT(count));
+   return 0;
+}
+
+
+int checkIsLink(const char* path, char* linkBuffer)
+{
+   char fileName[64] = { 0 };
+   char truncPath[128] = { 0 };
+   int isLink = 0;
+   int len = 0;
+   size_t strLen = 0;
+   struct stat statBuf;
+   uint16_t i = 0;
+
+   memset(&statBuf, 0, sizeof(statBuf));
+   strLen = strlen(path);
+   for (i = 0; i < strLen; i++)
+   {
+      if (path[i] == '/')
+      {
+         len = i; // remember the position of the last '/'
+      }
+   }
+   strncpy(truncPath, path, len);
+   truncPath[len + 1] = '\0'; // set end of string
+   strncpy(fileName, (const char*) path + len, 64);
 
-               //jump to next data block after hashtable
-               offset += sizeof(Hashtable_s);
-               ptr += sizeof(Hashtable_s);
+   if (lstat(truncPath, &statBuf) != -1)
+   {
+      if (S_ISLNK(statBuf.st_mode))
+      {
+         if (readlink(truncPath, linkBuffer, 256) != -1)
+         {
+            strncat(linkBuffer, fileName, 256);
+            isLink = 1;
          }
          else
          {
-            offset += ptrOffset;
-            ptr += ptrOffset;
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG,
+                    DLT_STRING(__FUNCTION__); DLT_STRING(": readlink failed: "); DLT_STRING(strerror(errno)));
+            isLink = -1;
          }
       }
-      munmap(memory, statBuf.st_size);
+      else
+      {
+         isLink = -1;
+      }
+   }
+   else
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
+              DLT_STRING(__FUNCTION__); DLT_STRING(": lstat failed: "); DLT_STRING(strerror(errno)));
+      isLink = -1;
+   }
+   return isLink;
+}
+
+
+
+void cleanKdbStruct(KISSDB* db)
+{
+   if (db->shared != NULL)
+   {
+      //Clean for every instance
+      if (db->mappedDb != NULL)
+      {
+         munmap(db->mappedDb, db->dbMappedSize);
+         db->mappedDb = NULL;
+      }
+      if (db->hashTables != NULL)
+      {
+         munmap(db->hashTables, db->htMappedSize);
+         db->hashTables = NULL;
+      }
+      if(db->cacheName != NULL)
+      {
+         free(db->cacheName);
+         db->cacheName = NULL;
+      }
+      if (db->fd)
+      {
+         close(db->fd);
+         db->fd = 0;
+      }
+      if(db->sharedCacheFd)
+      {
+         close(db->sharedCacheFd);
+         db->sharedCacheFd = -1;
+      }
+      db->alreadyOpen = Kdb_false;
+      db->htSize = 0;
+      //db->cacheReferenced = 0;
+      db->keySize = 0;
+      db->valSize = 0;
+      db->htSizeBytes = 0;
+      db->htMappedSize = 0;
+      db->dbMappedSize = 0;
+      db->shmCreator = 0;
+
+      Kdb_unlock(&db->shared->rwlock);
+
+      //Clean up for last instance referencing the database
+      if (db->shared->refCount == 0)
+      {
+         //close shared hashtable memory
+         if (db->htFd)
+         {
+            kdbShmemClose(db->htFd, db->htName);
+            db->htFd = 0;
+         }
+         if(db->htName != NULL)
+         {
+            free(db->htName);
+            db->htName = NULL;
+         }
+         //free rwlocks
+         pthread_rwlock_destroy(&db->shared->rwlock);
+         if (db->shared != NULL)
+         {
+            munmap(db->shared, sizeof(Shared_Data_s));
+            db->shared = NULL;
+         }
+         if (db->sharedFd)
+         {
+            kdbShmemClose(db->sharedFd, db->sharedName);
+            db->sharedFd = 0;
+         }
+         if(db->sharedName != NULL)
+         {
+            free(db->sharedName);
+            db->sharedName = NULL;
+         }
+
+         //destroy and unlock named semaphore only if ref counter is zero
+         if (-1 == sem_post(db->kdbSem)) //release semaphore
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_post() in cleanup failed: "),
+                  DLT_STRING(strerror(errno)));
+         }
+         if (-1 == sem_close(db->kdbSem))
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_close() in cleanup failed: "),
+                  DLT_STRING(strerror(errno)));
+         }
+         if (-1 == sem_unlink(db->semName))
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_unlink() in cleanup failed: "),
+                  DLT_STRING(strerror(errno)));
+         }
+         db->kdbSem = NULL;
+      }
+      else  //Clean up if other instances have reference to the database
+      {
+         if (db->sharedFd)
+         {
+            close(db->sharedFd);
+            db->sharedFd = 0;
+         }
+         if (db->htFd)
+         {
+            close(db->htFd);
+            db->htFd = 0;
+         }
+         if (db->shared != NULL)
+         {
+            munmap(db->shared, sizeof(Shared_Data_s));
+            db->shared = NULL;
+         }
+         if(db->htName != NULL)
+         {
+            free(db->htName);
+            db->htName = NULL;
+         }
+         if (-1 == sem_post(db->kdbSem))
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_post() in cleanup with refcounter > 0 failed: "),
+                  DLT_STRING(strerror(errno)));
+         }
+         if (-1 == sem_close(db->kdbSem))
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_close() in cleanup with refcounter > 0 failed: "),
+                    DLT_STRING(strerror(errno)));
+         }
+         db->kdbSem = NULL;
+      }
+   }
+}
+
+
+int writeDualDataBlock(KISSDB* db, int64_t offset, uint32_t blockSize, const void* key, unsigned long klen, const void* value, int valueSize, uint32_t valueFlags)
+{
+   DataBlock_s* backupBlock;
+   DataBlock_s* block;
+   uint64_t crc = 0x00;
+
+   block = (DataBlock_s*) (db->mappedDb + offset);
+   block->delimStart = DATA_BLOCK_A_START_DELIMITER;
+   memset(block->key, 0, db->keyFieldSize);
+   memcpy(block->key,key, klen);
+   getDataBlockInfo(db, block)->valSize = valueSize;
+   getDataBlockInfo(db, block)->valFlags = valueFlags;
+   getDataBlockInfo(db, block)->blockSize = blockSize;
+   memcpy(getDataBlockValue(db, block),value, getDataBlockInfo(db, block)->valSize);
+   getDataBlockInfo(db, block)->sequence = 0;
+   crc = getDataBlockCrc(db, block); //crc over key, datasize, blocksize, sequence and data
+   block->crc = crc;
+   *getDataBlockEndDelimiter(db, block) = DATA_BLOCK_A_END_DELIMITER;
+
+   // write same key and value again
+   backupBlock = (DataBlock_s*) ((char*) block + blockSize);
+   backupBlock->delimStart = DATA_BLOCK_B_START_DELIMITER;
+   backupBlock->crc = crc;
+   memset(backupBlock->key, 0, db->keyFieldSize);
+   memcpy(backupBlock->key,key, klen);
+   getDataBlockInfo(db, backupBlock)->valSize = valueSize;
+   getDataBlockInfo(db, backupBlock)->valFlags = valueFlags;
+   getDataBlockInfo(db, backupBlock)->blockSize = blockSize;
+   memcpy(getDataBlockValue(db, backupBlock),value, getDataBlockInfo(db, backupBlock)->valSize);
+   getDataBlockInfo(db, backupBlock)->sequence = 0;
+   *getDataBlockEndDelimiter(db, backupBlock) = DATA_BLOCK_B_END_DELIMITER;
+
+   return 0;
+}
+
+
+/*
+ * stores a slot entry in the hashtable selected by the hash (first empty slot of the probe sequence)
+ * returns Kdb_false if the hashtable has no empty slot
+ */
+static Kdb_bool placeHashtableSlot(KISSDB* db, uint64_t hash, const Hashtable_slot_s* entry)
+{
+   Hashtable_slot_s* hashTable = getHashtable(db, getHashtableNumber(db, hash))->slots;
+   uint32_t first = getHashtableSlot(db, hash);
+   uint32_t k = 0;
+
+   for (k = 0; k < db->htSize; k++)
+   {
+      if (hashTable[(first + k) % db->htSize].offsetA == 0)
+      {
+         hashTable[(first + k) % db->htSize] = *(entry);
+         setSlotDirty(db, &hashTable[(first + k) % db->htSize]);
+         return Kdb_true;
+      }
+   }
+   return Kdb_false;
+}
+
+
+int insertHashtableSlot(KISSDB* db, uint64_t hash, const Hashtable_slot_s* entry)
+{
+   int ret = 0;
 
-      //check CRC of all found hashtables
-      if (db->shared->htNum > 0)
+   if (db->shared->htNum == 0)
+   {
+      ret = addHashtable(db);
+      if (ret != 0)
       {
-         for (i = 0; i < db->shared->htNum; i++)
-         {
-            crc = 0;
-            crc = (uint64_t) pcoCrc32(crc, (unsigned char*) db->hashTables[i].slots, sizeof(db->hashTables[i].slots));
-            if (db->hashTables[i].crc != crc)
-            {
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": Checksum of hashtable number: <"); DLT_INT(i); DLT_STRING("> is invalid"));
-#ifdef PFS_TEST
-               printf("VERIFY HASHTABLE: hashtable #%d: CHECKSUM INVALID! \n",i);
-#endif
-               return -1; //start rebuild of hashtables
-            }
-            else
-            {
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": Checksum of hashtable number: <"); DLT_INT(i); DLT_STRING("> is OK"));
-
-#ifdef PFS_TEST
-               printf("VERIFY HASHTABLE: hashtable #%d: CHECKSUM OK! \n",i);
-#endif
-            }
-         }
+         return ret;
+      }
+   }
+   //a full hashtable is split until the entry fits (every split of a linear hashing round moves the split pointer towards it)
+   while (placeHashtableSlot(db, hash, entry) == Kdb_false)
+   {
+      ret = splitHashtable(db);
+      if (ret != 0)
+      {
+         return ret;
       }
    }
+   ++db->shared->htUsedSlots;
    return 0;
 }
 
-int rebuildHashtables(KISSDB* db)
+
+int addHashtable(KISSDB* db)
 {
-   char* ptr;
-   DataBlock_s* data;
-   DataBlock_s* dataA;
-   DataBlock_s* dataB;
    Hashtable_s* hashtable;
-   int current = 0;
-   int ptrOffset = 1;
-   int64_t offset=0;
-   int64_t offsetA = 0;
-   struct stat statBuf;
-   uint64_t crc = 0;
-   uint64_t calcCrcA, calcCrcB, readCrcA, readCrcB;
-   void* memory;
+   Kdb_bool temp = Kdb_false;
+   int64_t endoffset = 0;
+   int ret = 0;
 
-   fstat(db->fd, &statBuf);
-   memory = (char*) mmap(NULL, statBuf.st_size, PROT_WRITE | PROT_READ, MAP_SHARED, db->fd, 0);
-   if (memory == MAP_FAILED)
+   if (db->shared->htNum >= HASHTABLE_MAX_COUNT)
    {
-      return KISSDB_ERROR_IO;
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": maximum number of hashtables reached"));
+      return KISSDB_ERROR_HASHTABLE_FULL;
    }
-   ptr = (char*) memory;
 
-   //recover all hashtables of database
-   if (db->shared->htNum > 0) //htNum was determined in verifyhashtables() -> no reallocation is needed
+   //if new size would exceed old shared memory size for hashtables-> allocate additional memory to shared memory (+ db->htSizeBytes)
+   if( (db->htSizeBytes * (db->shared->htNum + 1)) > db->shared->htShmSize)
    {
-      ptr = (void*) memory;
-      memset(db->hashTables, 0, db->shared->htNum * sizeof(Hashtable_s));
-      db->hashTables[0].delimStart = HASHTABLE_START_DELIMITER;
-      db->hashTables[0].delimEnd = HASHTABLE_END_DELIMITER;
-
-      ptrOffset = greatestCommonFactor(sizeof(DataBlock_s), sizeof(Hashtable_s) );
-
-      //begin searching after first hashtable
-      offset = sizeof(Header_s) + sizeof(Hashtable_s);
-      ptr += offset;
-
-      //go through  database file until offset + Datablock size reaches end of file mapping
-      while (offset <= (statBuf.st_size - sizeof(DataBlock_s)))
+      if (db->htFd <= 0)
       {
-         data = (DataBlock_s*) ptr;
-
-         //if block A start or end delimiters were found
-         if (data->delimStart == DATA_BLOCK_A_START_DELIMITER
-               || data->delimEnd == DATA_BLOCK_A_END_DELIMITER)
+         db->htFd = kdbShmemOpen(db->htName,  db->htMappedSize, &temp);
+         if(db->htFd < 0)
          {
-            //calculate checksum of Block A
-            calcCrcA = 0;
-            calcCrcA = (uint64_t) pcoCrc32(calcCrcA, (unsigned char*) data->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t));
-            readCrcA = data->crc;
-
-            //search for block B start delimiter
-            offset += sizeof(DataBlock_s);
-            ptr += sizeof(DataBlock_s);
-            dataB = (DataBlock_s*) ptr;
-            if (dataB->delimStart == DATA_BLOCK_B_START_DELIMITER
-                  || dataB->delimEnd == DATA_BLOCK_B_END_DELIMITER)
-            {
-               //verify checksum of Block B
-               calcCrcB = 0;
-               calcCrcB = (uint64_t) pcoCrc32(calcCrcB, (unsigned char*) dataB->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t));
-               readCrcB = dataB->crc;
-               if (readCrcB == calcCrcB) //checksum of block B matches
-               {
-                  if (readCrcA == calcCrcA) //checksum of block A matches
-                  {
-                     if (1) //decide which datablock has latest written data - still statically using Block B for recovery because both blocks are written in kissdb_put
-                     {
-                        offsetA = offset - sizeof(DataBlock_s);
-                        rebuildWithBlockB(dataB, db, offsetA, offset);
-                     }
-                     else
-                     {
-                        // use block A for rebuild
-                        //write offsets for block a and block B
-                        offsetA = offset - sizeof(DataBlock_s);
-                        rebuildWithBlockA(data, db, offsetA, offset);
-                     }
-                  }
-                  else //checksum of block A does not match, but checksum of block B was valid
-                  {
-                     // use block B for rebuild
-                     offsetA = offset - sizeof(DataBlock_s);
-                     rebuildWithBlockB(dataB, db, offsetA, offset);
-                  }
-               }
-               else
-               {
-                  if (readCrcA == calcCrcA)
-                  {
-                     // use block A for rebuild
-                     //write offsets for block a and block B
-                     offsetA = offset - sizeof(DataBlock_s);
-                     rebuildWithBlockA(data, db, offsetA, offset);
-                  }
-                  else //checksum of block A and of Block B do not match ---> worst case scenario
-                  {
-                     invalidateBlocks(data, dataB, db);
-                  }
-               }
-            }
-            else
-            {
-               //if checksum A matches and block B was not found
-               if (readCrcA == calcCrcA)
-               {
-                  // use block A for rebuild
-                  //write offsets for block a and block B
-                  offsetA = offset - sizeof(DataBlock_s);
-                  rebuildWithBlockA(data, db, offsetA, offset);
-               }
-               else //checksum of block A does not match and block B was not found
-               {
-                  invalidateBlocks(data, dataB, db);
-               }
-            }
-            //jump behind datablock B
-            offset += sizeof(DataBlock_s);
-            ptr += sizeof(DataBlock_s);
-         }
-         //If a Bock B start or end delimiters were found: this only can happen if previous Block A was not found
-         else if (data->delimStart == DATA_BLOCK_B_START_DELIMITER
-                    || data->delimEnd == DATA_BLOCK_B_END_DELIMITER)
-         {
-            dataA = (DataBlock_s*) (ptr - sizeof(DataBlock_s)) ;
-            //verify checksum of Block B
-            crc = 0;
-            crc = (uint64_t) pcoCrc32(crc, (unsigned char*) data->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t));
-            if (data->crc == crc)
-            {
-               //use block B for rebuild
-               //write offsets for block A and block B
-               offsetA = offset - sizeof(DataBlock_s);
-               rebuildWithBlockB(data, db, offsetA, offset);
-            }
-            else
-            {
-               invalidateBlocks(dataA, data, db);
-            }
-            //jump behind datablock B
-            offset += sizeof(DataBlock_s);
-            ptr += sizeof(DataBlock_s);
+            return KISSDB_ERROR_OPEN_SHM;
          }
-         else if (data->delimStart == DATA_BLOCK_A_DELETED_START_DELIMITER
-                    || data->delimEnd == DATA_BLOCK_A_DELETED_END_DELIMITER)
-         {
-            //calculate checksum of Block A
-            calcCrcA = 0;
-            calcCrcA = (uint64_t) pcoCrc32(calcCrcA, (unsigned char*) data->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t));
-            readCrcA = data->crc;
-
-            //search for block B start delimiter
-            offset += sizeof(DataBlock_s);
-            ptr += sizeof(DataBlock_s);
-            dataB = (DataBlock_s*) ptr;
+      }
+      if (resizeKdbShmem(db->htFd, &db->hashTables, db->htMappedSize, db->htSizeBytes * (db->shared->htNum + 1)) == Kdb_false)
+      {
+         return KISSDB_ERROR_RESIZE_SHM;
+      }
+      db->shared->htShmSize = db->htSizeBytes * (db->shared->htNum + 1);
+      db->htMappedSize = db->shared->htShmSize;
+   }
 
-            if (dataB->delimStart == DATA_BLOCK_B_DELETED_START_DELIMITER
-                  || dataB->delimEnd == DATA_BLOCK_B_DELETED_END_DELIMITER)
-            {
-               //calculate checksum of Block B
-               calcCrcB = 0;
-               calcCrcB = (uint64_t) pcoCrc32(calcCrcB, (unsigned char*) dataB->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t));
-               readCrcB = dataB->crc;
-               if (readCrcB == calcCrcB) //checksum of block B matches
-               {
-                  offsetA = offset - sizeof(DataBlock_s);
-                  invertBlockOffsets(data, db, offsetA, offset);
-               }
-               else
-               {
-                  if (readCrcA == calcCrcA)
-                  {
-                     offsetA = offset - sizeof(DataBlock_s);
-                     invertBlockOffsets(data, db, offsetA, offset);
-                  }
-                  else
-                  {
-                     invalidateBlocks(data, dataB, db);
-                  }
-               }
-            }
-            else //NO BLOCK B Found
-            {
-               if (readCrcA == calcCrcA)
-               {
+   //prepare new hashtable in shared memory
+   hashtable = &(db->hashTables[db->shared->htNum]);
+   memset(hashtable, 0, db->htSizeBytes); //hashtable init
+   hashtable->delimStart = HASHTABLE_START_DELIMITER;
+   hashtable->delimEnd = HASHTABLE_END_DELIMITER;
+   hashtable->crc = 0x00;
+   setHashtableLoaded(db, db->shared->htNum);
 
-                  offsetA = offset - sizeof(DataBlock_s);
-                  invertBlockOffsets(data, db, offsetA, offset);
-               }
-               else
-               {
-                  invalidateBlocks(data, dataB, db);
-               }
-            }
-            //jump behind datablock B
-            offset += sizeof(DataBlock_s);
-            ptr += sizeof(DataBlock_s);
-         }
-         else if (data->delimStart == DATA_BLOCK_B_DELETED_START_DELIMITER
-                    || data->delimEnd == DATA_BLOCK_B_DELETED_END_DELIMITER)
-         {
-            crc = 0;
-            crc = (uint64_t) pcoCrc32(crc, (unsigned char*) data->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t));
-            if (crc == data->crc)
-            {
-               offsetA = offset - sizeof(DataBlock_s);
-               invertBlockOffsets(data, db, offsetA, offset);
-            }
-            else
-            {
-               dataA = (DataBlock_s*) (ptr - sizeof(DataBlock_s)) ;
-               invalidateBlocks(dataA, data, db);
-            }
-            //jump behind datablock B
-            offset += sizeof(DataBlock_s);
-            ptr += sizeof(DataBlock_s);
-         }
-         else if( offset <= (statBuf.st_size - sizeof(Hashtable_s)) ) //check if ptr range for hashtable is within mapping of file
-         {
-            hashtable = (Hashtable_s*) ptr;
+   //hashtables of read only databases are only kept in shared memory
+   if (db->shared->openMode != KISSDB_OPEN_MODE_RDONLY)
+   {
+      //append the new hashtable at the end of the data
+      endoffset = (int64_t) db->shared->dataEnd;
+      ret = growDatabaseFile(db, endoffset + db->htSizeBytes);
+      if (ret != 0)
+      {
+         return ret;
+      }
+      setDataEnd(db, endoffset + db->htSizeBytes);
 
-            if (hashtable->delimStart == HASHTABLE_START_DELIMITER
-                  || hashtable->delimEnd == HASHTABLE_END_DELIMITER)
-            {
-               //next hashtable to use
-               db->hashTables[current].slots[db->htSize].offsetA = offset; //update link to next hashtable in current hashtable
-               current++;
-               if (current < db->shared->htNum)
-               {
-                  db->hashTables[current].delimStart = HASHTABLE_START_DELIMITER;
-                  db->hashTables[current].delimEnd   = HASHTABLE_END_DELIMITER;
-               }
-               else
-               {
-                  return -1;
-               }
-               offset += sizeof(Hashtable_s);
-               ptr += sizeof(Hashtable_s);
-            }
-            else //if no hashtable is found
-            {
-               offset += ptrOffset;
-               ptr += ptrOffset;
-            }
-         }
-         else //if nothing is found for offsets in -> (filesize - hashtablesize)   area
-         {
-            DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": No Datablock or hashtable area found!"));
-            //increment pointer by greatest common factor of hashtable size and datablock size
-            offset += ptrOffset;
-            ptr += ptrOffset;
-         }
+      //copy hashtable in shared memory to mapped hashtable in file
+      memcpy(db->mappedDb + endoffset, hashtable, db->htSizeBytes);
+      //if a hashtable exists, update link to new hashtable in previous hashtable
+      if (db->shared->htNum)
+      {
+         getHashtable(db, db->shared->htNum - 1)->slots[db->htSize].offsetA = endoffset;
+         setHashtableDirty(db, db->shared->htNum - 1);
+      }
+      if (db->shared->htOffsetCount == db->shared->htNum)
+      {
+         db->shared->htOffset[db->shared->htOffsetCount++] = endoffset;
       }
    }
-   msync(memory, statBuf.st_size, MS_SYNC | MS_INVALIDATE);
-   munmap(memory, statBuf.st_size);
+   setHashtableDirty(db, db->shared->htNum);
+   ++db->shared->htNum;
+
    return 0;
 }
 
 
-//invalidate block content for A and B
-//this block can never be found / overwritten again
-//new insertions can reuse hashtable entry but block is added at EOF
-void invalidateBlocks(DataBlock_s* dataA, DataBlock_s* dataB, KISSDB* db)
+int splitHashtable(KISSDB* db)
 {
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": Datablock recovery for key: <"); DLT_STRING(dataA->key); DLT_STRING("> impossible: both datablocks are invalid!"));
+   Hashtable_slot_s entries[HASHTABLE_SLOT_COUNT];
+   Hashtable_slot_s* hashTable;
+   uint32_t level = 1;
+   uint32_t split = 0;
+   uint32_t count = 0;
+   uint32_t k = 0;
+   int ret = 0;
 
-   memset(dataA->key, 0, db->keySize);
-   memset(dataA->value, 0, db->valSize);
-   dataA->crc=0;
-   dataA->htNum = 0;
-   dataA->valSize = 0;
+   //the next hashtable to split is the split pointer of the current linear hashing round
+   while ((level << 1) <= db->shared->htNum)
+   {
+      level <<= 1;
+   }
+   split = db->shared->htNum - level;
 
-   memset(dataB->key, 0, db->keySize);
-   memset(dataB->value, 0, db->valSize);
-   dataB->crc=0;
-   dataB->htNum = 0;
-   dataB->valSize = 0;
-}
+   ret = addHashtable(db);
+   if (ret != 0)
+   {
+      return ret;
+   }
 
+   //remove all used slots from the split hashtable and distribute them between the split and the new hashtable
+   //slots of deleted keys are dropped: the reinserted slots get new probe sequences
+   hashTable = getHashtable(db, split)->slots;
+   for (k = 0; k < db->htSize; k++)
+   {
+      if (hashTable[k].offsetA > 0)
+      {
+         entries[count++] = hashTable[k];
+      }
+      else if (hashTable[k].offsetA < 0)
+      {
+         --db->shared->htUsedSlots;
+      }
+   }
+   memset(hashTable, 0, db->htSize * sizeof(Hashtable_slot_s));
+   setHashtableDirty(db, split);
 
-void invertBlockOffsets(DataBlock_s* data, KISSDB* db, int64_t offsetA, int64_t offsetB)
-{
-   uint64_t hash = 0;
-   hash = KISSDB_hash(data->key, strlen(data->key)) % (uint64_t) db->htSize;
-   //invert offsets for deleted block A
-   db->hashTables[data->htNum].slots[hash].offsetA = - offsetA;
-   //invert offsets for deleted block B
-   db->hashTables[data->htNum].slots[hash].offsetB = - offsetB;
-   //reset current flag
-   db->hashTables[data->htNum].slots[hash].current = 0x00;
+   for (k = 0; k < count; k++)
+   {
+      if (entries[k].offsetA < KISSDB_HEADER_SIZE || entries[k].offsetA > db->dbMappedSize)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": dropping hashtable slot with invalid offset: "); DLT_INT64(entries[k].offsetA));
+         --db->shared->htUsedSlots;
+      }
+      else if (placeHashtableSlot(db, getSlotHash(&entries[k]), &entries[k]) == Kdb_false)
+      {
+         return KISSDB_ERROR_CORRUPT_DBFILE; //cannot happen: both hashtables have at least as many empty slots as the split hashtable had entries
+      }
+   }
+   return 0;
 }
 
 
-void rebuildWithBlockB(DataBlock_s* data, KISSDB* db, int64_t offsetA, int64_t offsetB)
+/*
+ * removes the slots of deleted keys from the hashtables
+ * the remaining slots of every hashtable are inserted again, so their probe sequences no longer pass deleted slots
+ */
+void removeDeletedHashtableSlots(KISSDB* db)
 {
-   uint64_t hash = KISSDB_hash(data->key, strlen(data->key)) % (uint64_t) db->htSize;
-   //write offsets for block A and block B
-   db->hashTables[data->htNum].slots[hash].offsetA = offsetA;
-   db->hashTables[data->htNum].slots[hash].offsetB = offsetB;
-   //set block B as current
-   db->hashTables[data->htNum].slots[hash].current = 0x01;
-
-   /*
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": Rebuild in hashtable No. <"); DLT_INT(data->htNum);
-         DLT_STRING("> with Datablock B for key: <"); DLT_STRING(data->key); DLT_STRING("- hash: <"); DLT_INT(hash); DLT_STRING("> - OffsetA: <"); DLT_INT(offsetA);
-         DLT_STRING("> - OffsetB: <"); DLT_INT(offsetB));
-   */
+   Hashtable_slot_s entries[HASHTABLE_SLOT_COUNT];
+   uint32_t count = 0;
+   uint32_t i = 0;
+   uint32_t k = 0;
+
+   loadAllHashtables(db);
+   db->shared->htUsedSlots = 0;
+   for (i = 0; i < db->shared->htNum; i++)
+   {
+      count = 0;
+      for (k = 0; k < db->htSize; k++)
+      {
+         if (db->hashTables[i].slots[k].offsetA > 0)
+         {
+            entries[count++] = db->hashTables[i].slots[k];
+         }
+      }
+      memset(db->hashTables[i].slots, 0, db->htSize * sizeof(Hashtable_slot_s));
+      setHashtableDirty(db, i);
+      for (k = 0; k < count; k++)
+      {
+         placeHashtableSlot(db, getSlotHash(&entries[k]), &entries[k]); //the slots stay in their hashtable, so they always fit
+      }
+      db->shared->htUsedSlots += count;
+   }
 }
 
 
-void rebuildWithBlockA(DataBlock_s* data, KISSDB* db, int64_t offsetA, int64_t offsetB)
+/* data block of a valid slot or hashtable (except the first one) stored in the database file */
+typedef struct
 {
-   uint64_t hash = KISSDB_hash(data->key, strlen(data->key)) % (uint64_t) db->htSize;
-   //write offsets for block A and block B
-   db->hashTables[data->htNum].slots[hash].offsetA = offsetA;
-   db->hashTables[data->htNum].slots[hash].offsetB = offsetB;
-   //set block B as current
-   db->hashTables[data->htNum].slots[hash].current = 0x00;
+   int64_t offset;  /* file offset (before the compaction) */
+   uint32_t size;
+   int64_t* ref;    /* hashtable slot offset or hashtable link referencing the object (NULL for data block B of an inline slot) */
+} Kdb_file_item_s;
 
-   /*
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": Rebuild in hashtable No. <"); DLT_INT(data->htNum);
-         DLT_STRING("> with Datablock A for key: <"); DLT_STRING(data->key); DLT_STRING("- hash: <"); DLT_INT(hash); DLT_STRING("> - OffsetA: <"); DLT_INT(offsetA);
-         DLT_STRING("> - OffsetB: <"); DLT_INT(offsetB));
-   */
+static int compareFileItems(const void* a, const void* b)
+{
+   int64_t offsetA = ((const Kdb_file_item_s*) a)->offset;
+   int64_t offsetB = ((const Kdb_file_item_s*) b)->offset;
+   return (offsetA > offsetB) - (offsetA < offsetB);
 }
 
-
-
-
-int recoverDataBlocks(KISSDB* db)
+/*
+ * adds the data block at offset to the items, returns Kdb_false if the data block is invalid
+ * ref is the slot offset updated when the data block is moved (NULL for data block B of an inline slot: it always follows data block A)
+ */
+static Kdb_bool addFileDataBlock(KISSDB* db, Kdb_file_item_s* items, uint32_t* count, int64_t offset, int64_t* ref)
 {
+   DataBlock_s* block;
 
-#ifdef PFS_TEST
-                  printf("DATABLOCK RECOVERY: START! \n");
-#endif
+   if (offset < (int64_t) (KISSDB_HEADER_SIZE + sizeof(Hashtable_s)) || offset + db->minBlockSize > db->dbMappedSize)
+   {
+      return Kdb_false;
+   }
+   block = (DataBlock_s*) (db->mappedDb + offset);
+   if (isValidDataBlockSize(db, getDataBlockInfo(db, block)->blockSize) == Kdb_false || offset + getDataBlockInfo(db, block)->blockSize > db->dbMappedSize)
+   {
+      return Kdb_false;
+   }
+   items[*(count)].offset = offset;
+   items[*(count)].size = getDataBlockInfo(db, block)->blockSize;
+   items[*(count)].ref = ref;
+   ++*(count);
+   return Kdb_true;
+}
 
-   char* ptr;
-   DataBlock_s* data;
-   int i = 0;
-   int k = 0;
-   int64_t offset = 0;
-   struct stat statBuf;
-   uint64_t crc = 0;
-   void* memory;
 
-   fstat(db->fd, &statBuf);
-   memory = (char*) mmap(NULL, statBuf.st_size, PROT_WRITE | PROT_READ, MAP_SHARED, db->fd, 0);
-   if (memory == MAP_FAILED)
+/*
+ * collects the data blocks of all valid slots and all hashtables except the first one sorted by their file offset
+ * returns KISSDB_ERROR_CORRUPT_DBFILE if a data block is invalid or two items overlap
+ */
+static int collectFileItems(KISSDB* db, Kdb_file_item_s** items, uint32_t* count)
+{
+   int64_t end = KISSDB_HEADER_SIZE + sizeof(Hashtable_s);
+   Hashtable_slot_s* slot;
+   uint32_t i = 0;
+   uint32_t k = 0;
+
+   *(count) = 0;
+   *(items) = (Kdb_file_item_s*) malloc(((size_t) countHashtableSlots(db) * 2 + db->shared->htNum) * sizeof(Kdb_file_item_s));
+   if (*(items) == NULL)
    {
-      return KISSDB_ERROR_IO;
+      return KISSDB_ERROR_MALLOC;
    }
-   ptr = (char*) memory;
-
-   //go through all hashtables and jump to data blocks for crc validation
-   if (db->shared->htNum > 0)
+   for (i = 0; i < db->shared->htNum; i++)
    {
-      ptr = (void*) memory;
-      for (i = 0; i < db->shared->htNum; i++)
+      for (k = 0; k < db->htSize; k++)
       {
-         for (k = 0; k < HASHTABLE_SLOT_COUNT; k++)
-         {
-            if (db->hashTables[i].slots[k].offsetA > 0) //ignore deleted or unused slots
-            {
-               ptr = (void*) memory;  //reset pointer
-               //current valid data is offset A or offset B?
-               offset = (db->hashTables[i].slots[k].current == 0x00) ? db->hashTables[i].slots[k].offsetA : db->hashTables[i].slots[k].offsetB;
-               ptr += offset; //set pointer to current valid datablock
-               data = (DataBlock_s*) ptr;
-               //check crc of data block marked as current in hashtable
-               crc = 0;
-               crc = (uint64_t) pcoCrc32(crc, (unsigned char*) data->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t));
-               if (data->crc != crc)
-               {
-                  DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": Invalid datablock found at file offset: "); DLT_INT(offset));
-#ifdef PFS_TEST
-                  printf("DATABLOCK RECOVERY: INVALID CRC FOR CURRENT DATABLOCK DETECTED! \n");
-#endif
-                  ptr = (void*) memory;
-                  //get offset to other data block and check crc
-                  offset = (db->hashTables[i].slots[k].current == 0x00) ? db->hashTables[i].slots[k].offsetB : db->hashTables[i].slots[k].offsetA;
-                  ptr += offset;
-                  data = (DataBlock_s*) ptr;
-                  crc = 0;
-                  crc = (uint64_t) pcoCrc32(crc, (unsigned char*) data->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t));
-                  if (data->crc == crc)
-                  {
-                     //switch current flag if valid backup is available
-                     db->hashTables[i].slots[k].current = (db->hashTables[i].slots[k].current == 0x00) ? 0x01 : 0x00;
-#ifdef PFS_TEST
-                     printf("DATABLOCK RECOVERY: REPAIR OF INVALID DATA SUCCESSFUL! \n");
-#endif
-                     DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": Invalid datablock for key: <"); DLT_STRING(data->key); DLT_STRING("> successfully recovered!"));
-                  }
-                  else
-                  {
-                     //invalidate data blocks if recovery fails
-                     db->hashTables[i].slots[k].offsetA = - db->hashTables[i].slots[k].offsetA;
-                     db->hashTables[i].slots[k].offsetB = - db->hashTables[i].slots[k].offsetB;
-                     db->hashTables[i].slots[k].current = 0x00;
-                     DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": Datablock recovery for key: <"); DLT_STRING(data->key); DLT_STRING("> impossible: both datablocks are invalid!"));
-#ifdef PFS_TEST
-                     printf("DATABLOCK RECOVERY: ERROR -> BOTH BLOCKS ARE INVALID! \n");
-#endif
-                  }
-               }
+         if (db->hashTables[i].slots[k].offsetA > 0)
+         {
+            slot = &db->hashTables[i].slots[k];
+            if (addFileDataBlock(db, *(items), count, slot->offsetA, &slot->offsetA) == Kdb_false
+                  || addFileDataBlock(db, *(items), count, getSlotOffsetB(db, slot), (isSlotInline(slot) == Kdb_true) ? NULL : &slot->offsetB) == Kdb_false)
+            {
+               DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": invalid data block in hashtable: "); DLT_INT(i); DLT_STRING(" slot: "); DLT_INT(k));
+               free(*(items));
+               return KISSDB_ERROR_CORRUPT_DBFILE;
             }
          }
       }
+      if (i > 0)
+      {
+         (*(items))[*(count)].offset = db->hashTables[i - 1].slots[db->htSize].offsetA;
+         (*(items))[*(count)].size = sizeof(Hashtable_s);
+         (*(items))[*(count)].ref = &db->hashTables[i - 1].slots[db->htSize].offsetA;
+         ++*(count);
+      }
    }
-   msync(memory, statBuf.st_size, MS_SYNC | MS_INVALIDATE);
-   munmap(memory, statBuf.st_size);
-
-#ifdef PFS_TEST
-                  printf("DATABLOCK RECOVERY: END! \n");
-#endif
 
+   qsort(*(items), *(count), sizeof(Kdb_file_item_s), compareFileItems);
+   for (i = 0; i < *(count); i++)
+   {
+      if ((*(items))[i].offset < end || (*(items))[i].offset + (*(items))[i].size > db->dbMappedSize)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": overlapping data at file offset: "); DLT_INT64((*(items))[i].offset));
+         free(*(items));
+         return KISSDB_ERROR_CORRUPT_DBFILE;
+      }
+      end = (*(items))[i].offset + (*(items))[i].size;
+   }
    return 0;
 }
 
 
-int checkIsLink(const char* path, char* linkBuffer)
+/*
+ * releases the unused file area between offset and end as pairs of data blocks
+ * data blocks found in the area keep their size class, other parts are divided into the largest size classes that fit
+ */
+static void releaseFileArea(KISSDB* db, int64_t offset, int64_t end)
 {
-   char fileName[64] = { 0 };
-   char truncPath[128] = { 0 };
-   int isLink = 0;
-   int len = 0;
-   size_t strLen = 0;
-   struct stat statBuf;
-   uint16_t i = 0;
+   DataBlock_s* block;
+   uint32_t blockSize = 0;
 
-   memset(&statBuf, 0, sizeof(statBuf));
-   strLen = strlen(path);
-   for (i = 0; i < strLen; i++)
+   while (offset + 2 * db->minBlockSize <= end)
    {
-      if (path[i] == '/')
+      block = (DataBlock_s*) (db->mappedDb + offset);
+      blockSize = getDataBlockSizeAt(db, block, offset, end);
+      if (blockSize == 0 || offset + 2 * (int64_t) blockSize > end)
       {
-         len = i; // remember the position of the last '/'
+         blockSize = getDataBlockSize(db, db->valSize);
+         while (offset + 2 * (int64_t) blockSize > end)
+         {
+            blockSize >>= 1;
+         }
       }
+      getDataBlockInfo(db, block)->blockSize = blockSize;
+      getDataBlockInfo(db, (DataBlock_s*) (db->mappedDb + offset + blockSize))->blockSize = blockSize;
+      releaseDualDataBlock(db, offset);
+      offset += 2 * blockSize;
    }
-   strncpy(truncPath, path, len);
-   truncPath[len + 1] = '\0'; // set end of string
-   strncpy(fileName, (const char*) path + len, 64);
+}
 
-   if (lstat(truncPath, &statBuf) != -1)
+
+/*
+ * rebuilds the free lists from all areas of the database file which are not used by a valid slot or a hashtable
+ * (used after a power loss)
+ * the data blocks of deleted slots are released as well, deleted slots no longer reference data blocks
+ */
+int rebuildFreeLists(KISSDB* db)
+{
+   Kdb_file_item_s* items;
+   int64_t offset = KISSDB_HEADER_SIZE + sizeof(Hashtable_s);
+   uint32_t count = 0;
+   uint32_t i = 0;
+   uint32_t k = 0;
+   int ret = 0;
+
+   clearFreeLists(db);
+   if (db->shared->htNum == 0)
    {
-      if (S_ISLNK(statBuf.st_mode))
+      return 0; //nothing stored
+   }
+   ret = collectFileItems(db, &items, &count);
+   if (ret != 0)
+   {
+      return ret;
+   }
+   for (i = 0; i < count; i++)
+   {
+      releaseFileArea(db, offset, items[i].offset);
+      offset = items[i].offset + items[i].size;
+   }
+   //data blocks recovered behind the end of the data in the header are kept
+   if ((uint64_t) offset > db->shared->dataEnd)
+   {
+      setDataEnd(db, (uint64_t) offset);
+   }
+   releaseFileArea(db, offset, db->shared->dataEnd);
+   free(items);
+
+   for (i = 0; i < db->shared->htNum; i++)
+   {
+      for (k = 0; k < db->htSize; k++)
       {
-         if (readlink(truncPath, linkBuffer, 256) != -1)
-         {
-            strncat(linkBuffer, fileName, 256);
-            isLink = 1;
-         }
-         else
+         if (db->hashTables[i].slots[k].offsetA < 0)
          {
-            DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG,
-                    DLT_STRING(__FUNCTION__); DLT_STRING(": readlink failed: "); DLT_STRING(strerror(errno)));
-            isLink = -1;
+            db->hashTables[i].slots[k].offsetA = KISSDB_SLOT_DELETED;
+            db->hashTables[i].slots[k].offsetB = KISSDB_SLOT_DELETED;
+            db->hashTables[i].slots[k].current = 0x00;
          }
       }
-      else
-      {
-         isLink = -1;
-      }
    }
-   else
+   return 0;
+}
+
+
+/* syncs the pages of the mapped database file between the offsets start and end */
+static void syncFileArea(KISSDB* db, int64_t start, int64_t end)
+{
+   int64_t pageStart = start & ~((int64_t) sysconf(_SC_PAGESIZE) - 1);
+
+   if (end > start)
    {
-      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
-              DLT_STRING(__FUNCTION__); DLT_STRING(": lstat failed: "); DLT_STRING(strerror(errno)));
-      isLink = -1;
+      msync(db->mappedDb + pageStart, end - pageStart, MS_SYNC);
    }
-   return isLink;
 }
 
 
-
-void cleanKdbStruct(KISSDB* db)
+int KISSDB_compact(KISSDB* db, int64_t* bytesReclaimed)
 {
-   if (db->shared != NULL)
+   Hashtable_s* htptr;
+   Kdb_file_item_s* items;
+   int64_t cursor = KISSDB_HEADER_SIZE + sizeof(Hashtable_s); //the first hashtable is never moved
+   int64_t unsynced = cursor;
+   int64_t pending = INT64_MAX;
+   uint32_t count = 0;
+   uint32_t i = 0;
+   int ret = 0;
+
+   *(bytesReclaimed) = 0;
+   if (db->shared->openMode == KISSDB_OPEN_MODE_RDONLY)
    {
-      //Clean for every instance
-      if (db->mappedDb != NULL)
-      {
-         munmap(db->mappedDb, db->dbMappedSize);
-         db->mappedDb = NULL;
-      }
-      if (db->hashTables != NULL)
-      {
-         munmap(db->hashTables, db->htMappedSize);
-         db->hashTables = NULL;
-      }
-      if(db->cacheName != NULL)
+      return KISSDB_ERROR_ACCESS_VIOLATION;
+   }
+   reclaimViewPins(db);
+   if (db->shared->viewPins > 0) //pinned values must not be moved
+   {
+      return KISSDB_ERROR_VIEW_PINNED;
+   }
+
+   if(db->htMappedSize < db->shared->htShmSize)
+   {
+      if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
       {
-         free(db->cacheName);
-         db->cacheName = NULL;
+         return KISSDB_ERROR_RESIZE_SHM;
       }
-      if (db->fd)
+      else
       {
-         close(db->fd);
-         db->fd = 0;
+         db->htMappedSize = db->shared->htShmSize;
       }
-      if(db->sharedCacheFd)
+   }
+
+   //remap database file if in the meanwhile another process modified the size of the file
+   if (db->dbMappedSize != db->shared->mappedDbSize)
+   {
+      ret = remapDatabaseFile(db, db->shared->mappedDbSize);
+      if (ret != 0)
       {
-         close(db->sharedCacheFd);
-         db->sharedCacheFd = -1;
+         return ret;
       }
-      db->alreadyOpen = Kdb_false;
-      db->htSize = 0;
-      //db->cacheReferenced = 0;
-      db->keySize = 0;
-      db->valSize = 0;
-      db->htSizeBytes = 0;
-      db->htMappedSize = 0;
-      db->dbMappedSize = 0;
-      db->shmCreator = 0;
+   }
 
-      Kdb_unlock(&db->shared->rwlock);
+   if (db->shared->htNum == 0)
+   {
+      return 0; //nothing stored
+   }
 
-      //Clean up for last instance referencing the database
-      if (db->shared->refCount == 0)
-      {
-         //close shared hashtable memory
-         if (db->htFd)
-         {
-            kdbShmemClose(db->htFd, db->htName);
-            db->htFd = 0;
-         }
-         if(db->htName != NULL)
-         {
-            free(db->htName);
-            db->htName = NULL;
-         }
-         //free rwlocks
-         pthread_rwlock_destroy(&db->shared->rwlock);
-         if (db->shared != NULL)
-         {
-            munmap(db->shared, sizeof(Shared_Data_s));
-            db->shared = NULL;
-         }
-         if (db->sharedFd)
-         {
-            kdbShmemClose(db->sharedFd, db->sharedName);
-            db->sharedFd = 0;
-         }
-         if(db->sharedName != NULL)
-         {
-            free(db->sharedName);
-            db->sharedName = NULL;
-         }
+   ret = collectFileItems(db, &items, &count);
+   if (ret != 0)
+   {
+      return ret;
+   }
 
-         //destroy and unlock named semaphore only if ref counter is zero
-         if (-1 == sem_post(db->kdbSem)) //release semaphore
-         {
-            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_post() in cleanup failed: "),
-                  DLT_STRING(strerror(errno)));
-         }
-         if (-1 == sem_close(db->kdbSem))
-         {
-            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_close() in cleanup failed: "),
-                  DLT_STRING(strerror(errno)));
-         }
-         if (-1 == sem_unlink(db->semName))
-         {
-            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_unlink() in cleanup failed: "),
-                  DLT_STRING(strerror(errno)));
-         }
-         db->kdbSem = NULL;
+   //invalidate the checksum of the first hashtable in the file: if the compaction is interrupted, the hashtables are rebuilt when the database is opened
+   //the checkpoint is no longer valid either: the journaled data blocks are moved
+   htptr = (Hashtable_s*) (db->mappedDb + KISSDB_HEADER_SIZE);
+   htptr->crc = getHashtableCrc(db, htptr) ^ 0x01;
+   ((Header_s*) db->mappedDb)->checkpoint = 0;
+   msync(db->mappedDb, KISSDB_HEADER_SIZE + sizeof(Hashtable_s), MS_SYNC);
+
+   //an item is only moved into an area in front of it which does not overlap its old place
+   //and the old place of a moved item is only overwritten after its new place is synced:
+   //if the compaction is interrupted, a complete copy of every item is still in the file
+   for (i = 0; i < count; i++)
+   {
+      if (items[i].offset != cursor && cursor + (int64_t) items[i].size > items[i].offset)
+      {
+         cursor = items[i].offset; //the gap in front of the item is too small, it is released to the free lists
       }
-      else  //Clean up if other instances have reference to the database
+      if (items[i].offset != cursor)
       {
-         if (db->sharedFd)
+         if (cursor + (int64_t) items[i].size > pending)
          {
-            close(db->sharedFd);
-            db->sharedFd = 0;
-         }
-         if (db->htFd)
-         {
-            close(db->htFd);
-            db->htFd = 0;
+            syncFileArea(db, unsynced, cursor);
+            unsynced = cursor;
+            pending = INT64_MAX;
          }
-         if (db->shared != NULL)
+         memmove(db->mappedDb + cursor, db->mappedDb + items[i].offset, items[i].size);
+         if (items[i].ref != NULL)
          {
-            munmap(db->shared, sizeof(Shared_Data_s));
-            db->shared = NULL;
+            *(items[i].ref) = cursor;
          }
-         if(db->htName != NULL)
+         if (pending == INT64_MAX)
          {
-            free(db->htName);
-            db->htName = NULL;
+            pending = items[i].offset; //lowest old place of the items moved since the last sync
          }
-         if (-1 == sem_post(db->kdbSem))
+      }
+      cursor += items[i].size;
+   }
+   free(items);
+   db->shared->htOffsetCount = 0; //the offsets of the moved hashtables are looked up again along their links
+
+   //released data blocks were overwritten or are cut off, the gaps left in front of items which were not moved are released again
+   db->shared->deferredCount = 0;
+   removeDeletedHashtableSlots(db);
+   msync(db->mappedDb, cursor, MS_SYNC);
+   setDataEnd(db, cursor);
+   ret = rebuildFreeLists(db);
+   if (ret != 0)
+   {
+      return ret;
+   }
+   //all hashtables are written with valid checksums and a new checkpoint
+   //the checksum of the first hashtable only gets valid when all other hashtables are on disk: hashtables with old offsets are never used
+   setAllHashtablesDirty(db);
+   writeHashtables(db, Kdb_false);
+   htptr->crc ^= 0x01;
+   msync(db->mappedDb, cursor, MS_SYNC);
+   htptr->crc ^= 0x01;
+   checkpointHashtables(db);
+
+   if (cursor < db->dbMappedSize)
+   {
+      if (ftruncate(db->fd, cursor) < 0)
+      {
+         return KISSDB_ERROR_IO;
+      }
+      *(bytesReclaimed) = db->dbMappedSize - cursor;
+      ret = remapDatabaseFile(db, cursor);
+      if (ret != 0)
+      {
+         return ret;
+      }
+      db->shared->mappedDbSize = cursor;
+   }
+   setDataEnd(db, cursor);
+   return 0;
+}
+
+
+/*
+ * writes the hashtables modified since the last checkpoint with their checksums to the file
+ * sync: only the pages of the written hashtables are synced (unmodified hashtables are neither checksummed nor written)
+ * the number of hashtables and used slots in the header allow the next open to load the hashtables on their first access
+ */
+void writeHashtables(KISSDB* db, Kdb_bool sync)
+{
+   Header_s* header = (Header_s*) db->mappedDb;
+   Hashtable_s* htptr = NULL;
+   int64_t offset = 0;
+   int64_t pageOffset = 0;
+   int64_t pageMask = ~((int64_t) sysconf(_SC_PAGESIZE) - 1);
+   int i = 0;
+
+   for (i = 0; i < db->shared->htNum; i++)
+   {
+      //a hashtable not loaded yet is unchanged in the file
+      if (isHashtableDirty(db, i) == Kdb_true && isHashtableLoaded(db, i) == Kdb_true)
+      {
+         offset = getHashtableFileOffset(db, i);
+         if (offset < 0)
          {
-            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_post() in cleanup with refcounter > 0 failed: "),
-                  DLT_STRING(strerror(errno)));
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": no link to hashtable: "); DLT_INT(i));
+            break;
          }
-         if (-1 == sem_close(db->kdbSem))
+         db->hashTables[i].crc = getHashtableCrc(db, &db->hashTables[i]);
+         htptr = (Hashtable_s*) (db->mappedDb +  offset);
+         //copy hashtable and generated crc from shared memory to mapped hashtable in file
+         memcpy(htptr, &db->hashTables[i], db->htSizeBytes);
+         if (sync == Kdb_true)
          {
-            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_close() in cleanup with refcounter > 0 failed: "),
-                    DLT_STRING(strerror(errno)));
+            pageOffset = offset & pageMask; //hashtables are only aligned to the smallest data block size
+            msync(db->mappedDb + pageOffset, offset + db->htSizeBytes - pageOffset, MS_SYNC);
          }
-         db->kdbSem = NULL;
       }
    }
+   memset(db->shared->htDirty, 0, sizeof(db->shared->htDirty));
+   header->htCount = db->shared->htNum;
+   header->htUsedSlots = db->shared->htUsedSlots;
 }
 
 
-int writeDualDataBlock(KISSDB* db, int64_t offset, int htNumber, const void* key, unsigned long klen, const void* value, int valueSize)
+/*
+ * writes the hashtables modified since the last checkpoint with their checksums to the file and starts a new checkpoint
+ * the marker in the header is cleared while the hashtables are written: an interrupted checkpoint leads to a full recovery
+ */
+void checkpointHashtables(KISSDB* db)
 {
-   DataBlock_s* backupBlock;
-   DataBlock_s* block;
-   uint64_t crc = 0x00;
+   Header_s* header = (Header_s*) db->mappedDb;
+   uint64_t checkpoint = header->checkpoint;
 
-   block = (DataBlock_s*) (db->mappedDb + offset);
-   block->delimStart = DATA_BLOCK_A_START_DELIMITER;
-   memset(block->key, 0, db->keySize);
-   memcpy(block->key,key, klen);
-   block->valSize = valueSize;
-   memcpy(block->value,value, block->valSize);
-   block->htNum = htNumber;
-   crc = 0x00;
-   crc = (uint32_t) pcoCrc32(crc, (unsigned char*)block->key, db->keySize + sizeof(uint32_t) + db->valSize + sizeof(uint64_t)); //crc over key, datasize, data and htnum
-   block->crc = crc;
-   block->delimEnd = DATA_BLOCK_A_END_DELIMITER;
+   header->checkpoint = 0;
+   msync(db->mappedDb, KISSDB_HEADER_SIZE, MS_SYNC);
 
-   // write same key and value again
-   backupBlock = (DataBlock_s*) ((char*) block + sizeof(DataBlock_s));
-   backupBlock->delimStart = DATA_BLOCK_B_START_DELIMITER;
-   backupBlock->crc = crc;
-   memset(backupBlock->key, 0, db->keySize);
-   memcpy(backupBlock->key,key, klen);
-   backupBlock->valSize = valueSize;
-   memcpy(backupBlock->value,value, backupBlock->valSize);
-   backupBlock->htNum = htNumber;
-   backupBlock->delimEnd = DATA_BLOCK_B_END_DELIMITER;
+   writeHashtables(db, Kdb_false);
+   //the data blocks journaled so far must be on disk before the journal is cleared
+   msync(db->mappedDb, db->dbMappedSize, MS_SYNC);
 
-   return 0;
+   header->checkpoint = checkpoint + 1;
+   header->journalCount = 0;
+   msync(db->mappedDb, KISSDB_HEADER_SIZE, MS_SYNC);
+}
+
+
+uint32_t countHashtableSlots(KISSDB* db)
+{
+   uint32_t count = 0;
+   uint32_t i = 0;
+   uint32_t k = 0;
+
+   loadAllHashtables(db);
+   for (i = 0; i < db->shared->htNum; i++)
+   {
+      for (k = 0; k < db->htSize; k++)
+      {
+         if (db->hashTables[i].slots[k].offsetA != 0)
+         {
+            count++;
+         }
+      }
+   }
+   return count;
 }
 
 
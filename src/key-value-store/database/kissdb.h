@@ -23,10 +23,13 @@
 #define ___KISSDB_H
 
 #include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include "../hashtable/qlibc.h"
+#include "../crc32.h"
+#include "../keyhash.h"
 #include "../inc/protected/persComDbAccess.h"
 
 #ifdef __cplusplus
@@ -52,6 +55,110 @@ extern "C" {
 
 #define HASHTABLE_SLOT_COUNT 510
 
+/**
+ * The hashtables form a linear hashing index: every hashtable is a bucket with HASHTABLE_SLOT_COUNT slots
+ * (linear probing inside the bucket). If more than HASHTABLE_MAX_LOAD_PERCENT of all slots are used,
+ * the next bucket is split into itself and a new hashtable appended to the database file.
+ */
+#define HASHTABLE_MAX_LOAD_PERCENT 40
+
+/**
+ * Maximum number of hashtables of a database (limited by Shared_Data_s.htNum and Hashtable_slot_s.bucketHash)
+ */
+#define HASHTABLE_MAX_COUNT 0xFFFF
+
+/**
+ * Default smallest data block size class in bytes.
+ * Data blocks are allocated in size classes starting with the smallest size class of the database
+ * and doubling for every next class. Databases with small records use their record size instead (see KISSDB.minBlockSize).
+ */
+#define KISSDB_MIN_DATA_BLOCK_SIZE 256
+
+/**
+ * Alignment of all data blocks and hashtables in the database file, the smallest size class of a database is a multiple of it
+ */
+#define KISSDB_DATA_BLOCK_ALIGNMENT 64
+
+/**
+ * Number of free lists: one list of released data block pairs for every size class
+ * (KISSDB_MIN_DATA_BLOCK_SIZE << 15 is the size class of the largest value, see KISSDB_MAX_VALUE_SIZE)
+ */
+#define KISSDB_FREE_LIST_COUNT 16
+
+/**
+ * Offsets stored in a hashtable slot of a deleted key: its data blocks were released to the free lists,
+ * the slot stays used to keep the probe sequence of other keys intact
+ */
+#define KISSDB_SLOT_DELETED -1
+
+/**
+ * Largest value stored inline in a hashtable slot (in the first half of offsetB, the second half holds the checksum of the key).
+ * KISSDB_get returns an inline value without reading a data block, the data blocks of the key still hold the value for recovery,
+ * so every write of an inline value still writes one data block.
+ * An inline value is returned without comparing the key itself: the slot must match the key length,
+ * the 48 bit key hash and the 32 bit checksum of the key (checksum algorithm of the file).
+ * 16 byte values do not fit into the 24 byte slot, a wider slot would reduce the number of slots per hashtable.
+ */
+#define KISSDB_INLINE_VALUE_SIZE 4
+
+/**
+ * Value flags stored with a value in its data blocks (DataBlockInfo_s.valFlags), they are passed to KISSDB_put and returned by KISSDB_get.
+ * The value of a key with flags is never stored inline.
+ */
+#define KISSDB_VALUE_COMPRESSED 0x01 /* the value was compressed by the caller (see compress.h) */
+
+/**
+ * Flags in Hashtable_slot_s.current: offsetB points to the current data block,
+ * offsetB stores the value of the key (the size of the value is stored in the upper four bits)
+ */
+#define KISSDB_SLOT_CURRENT_B 0x01
+#define KISSDB_SLOT_INLINE    0x02
+
+/**
+ * Number of data block pairs which can be written between two checkpoints of the hashtables.
+ * The file offsets of the written pairs are journaled in the header, a full journal triggers the next checkpoint.
+ */
+#define KISSDB_JOURNAL_SIZE 448
+
+/**
+ * The database file is scanned by up to KISSDB_RECOVERY_MAX_THREADS threads when the hashtables or data blocks are recovered
+ * after a power loss, every thread scans a range of at least KISSDB_RECOVERY_MIN_RANGE_SIZE bytes
+ */
+#define KISSDB_RECOVERY_MAX_THREADS    8
+#define KISSDB_RECOVERY_MIN_RANGE_SIZE (1024 * 1024)
+
+/**
+ * The database file grows by half of its size, but at least by KISSDB_MIN_FILE_GROWTH and at most by KISSDB_MAX_FILE_GROWTH bytes.
+ * New data blocks and hashtables are appended at the end of the data inside of the preallocated area,
+ * the area behind the end of the data is cut off when the database is closed
+ */
+#define KISSDB_MIN_FILE_GROWTH (64 * 1024)
+#define KISSDB_MAX_FILE_GROWTH (4 * 1024 * 1024)
+
+/**
+ * Number of data block pairs which can be pinned by views (see KISSDB_getView) of all processes at the same time.
+ * Every pin records the pid of the process holding the views, the pins of a process which ended without releasing
+ * its views are reclaimed. While all pins are used, values are returned as copies instead of views.
+ */
+#define KISSDB_VIEW_PIN_COUNT 64
+
+/**
+ * Number of pinned data block pairs whose release is deferred until they are no longer pinned (one for every pin)
+ */
+#define KISSDB_DEFERRED_RELEASE_COUNT KISSDB_VIEW_PIN_COUNT
+
+/**
+ * Checksum algorithm (PERS_COM_CHECKSUM_*) used for newly created database files (see KISSDB_setAlgorithms).
+ * Existing files keep the algorithm recorded in their header.
+ */
+#define KISSDB_CHECKSUM_ALGORITHM PERS_COM_CHECKSUM_CRC32C
+
+/**
+ * Key hash algorithm (PERS_COM_KEY_HASH_*) used for newly created database files (see KISSDB_setAlgorithms).
+ * Existing files keep the algorithm recorded in their header.
+ */
+#define KISSDB_KEY_HASH_ALGORITHM PERS_COM_KEY_HASH_WYHASH
+
 #ifdef __showTimeMeasurements
 #define SECONDS2NANO 1000000000L
 #define NANO2MIL        1000000L
@@ -66,18 +173,48 @@ extern "C" {
 #define PIDFILE_TEMPLATE PIDFILEDIR "/" PIDFILE_PREFIX"%d.pid"   // PIDFILEDIR is defined via configure switch -pidfiledir (default is /var/run if not set)
 
 /**
- * Version: 2.3
+ * Version: 3.0
  *
  * This is the file format identifier, and changes any time the file
- * format changes.
+ * format changes. Files with another version are not opened,
+ * the keys of files of version 2.x are read by KISSDB_readVersion2 to convert them.
+ * 3.0: variable-length data blocks allocated from power of two size classes,
+ *      checksum algorithm stored in the header, data block checksums only cover the used value bytes,
+ *      hashtables are buckets of a linear hashing index,
+ *      hashtable slots store the key length and the key hash,
+ *      key hash algorithm stored in the header,
+ *      released data blocks are linked in free lists, the first free data block of every size class is stored in the header,
+ *      an update only writes the older data block of a key, the valid data block with the higher sequence number is current,
+ *      checkpoints of the hashtables while the database is open, the data blocks written after the last checkpoint are journaled in the header,
+ *      size of the key field and smallest size class of the data blocks stored in the header,
+ *      values of up to KISSDB_INLINE_VALUE_SIZE bytes are stored inline in the hashtable slots as well,
+ *      value flags stored in the data blocks (compressed values),
+ *      number of hashtables and used slots stored in the header,
+ *      end of the data in front of the preallocated area of the file stored in the header
+ */
+#define KISSDB_MAJOR_VERSION 3
+#define KISSDB_MINOR_VERSION 0
+
+/**
+ * Major version of the files with data blocks of fixed size (DataBlock2_s in kissdb.c)
  */
-#define KISSDB_MAJOR_VERSION 2
-#define KISSDB_MINOR_VERSION 3
+#define KISSDB_MAJOR_VERSION_2 2
 
 typedef int16_t Kdb_bool;
 static const int16_t Kdb_true  = -1;
 static const int16_t Kdb_false =  0;
 
+/**
+ * Data block pair pinned by the views of a process
+ */
+typedef struct
+{
+   int32_t pid; /* process holding the views, 0 if the pin is unused */
+   uint32_t count; /* number of views of the process */
+   int64_t pair; /* offset of data block A of the pinned pair */
+   int64_t value; /* offset of the viewed value */
+} Kdb_view_pin_s;
+
 typedef struct
 {
       uint64_t htShmSize; /* shared info about current size of hashtable shared memory */
@@ -85,13 +222,27 @@ typedef struct
       /*uint16_t cacheCount;*/
       uint16_t htNum;
       uint16_t refCount;
+      uint32_t htUsedSlots; /* number of used (valid or deleted) slots in all hashtables */
       uint16_t openMode;
       uint16_t writeMode;
       Kdb_bool cacheCreated; /* flag to indicate if the shared cache was created */
       pthread_rwlock_t rwlock;
       pthread_mutex_t mutex;
       Kdb_bool mutexInit;
-      uint64_t mappedDbSize; /* shared information about current mapped size of database file */
+      uint64_t mappedDbSize; /* shared information about current mapped size of database file (high-water mark including the preallocated area) */
+      uint64_t dataEnd; /* end of the data in the database file, new data blocks and hashtables are appended here */
+      int64_t freeList[KISSDB_FREE_LIST_COUNT]; /* offset of the first released data block pair of every size class (0 if the list is empty) */
+      uint8_t htDirty[(HASHTABLE_MAX_COUNT + 7) / 8]; /* bitmap of the hashtables modified since they were last written to the file */
+      uint8_t htLoaded[(HASHTABLE_MAX_COUNT + 7) / 8]; /* bitmap of the hashtables copied from the file into the shared memory */
+      uint32_t htOffsetCount; /* number of hashtables with a known offset in htOffset */
+      int64_t htOffset[HASHTABLE_MAX_COUNT]; /* offsets of the first htOffsetCount hashtables in the database file */
+      uint32_t viewPins; /* number of views of all processes (sum of the counts of viewPin) */
+      Kdb_view_pin_s viewPin[KISSDB_VIEW_PIN_COUNT]; /* data block pairs pinned by views, the data blocks of a pinned pair are never overwritten */
+      uint32_t deferredCount; /* number of released data block pairs in deferred */
+      int64_t deferred[KISSDB_DEFERRED_RELEASE_COUNT]; /* pinned data block pairs released by a write or delete, added to the free lists when they are no longer pinned */
+      Kdb_bool keyListValid; /* keyCount and keyListSize are set (by the first listing) and updated by every write and delete */
+      uint32_t keyCount; /* number of listed keys: the keys in cache not marked as deleted and the keys only in the file */
+      uint64_t keyListSize; /* size of the list of these keys (separated by '\0') */
 } Shared_Data_s;
 
 
@@ -108,29 +259,71 @@ typedef struct
       uint64_t keySize;
       uint64_t valSize;
       char delimiter[8];
-      char padding[4032]; /* TODO remove padding*/
+      uint64_t checksumAlgorithm; /* PERS_COM_CHECKSUM_* used for hashtables and data blocks */
+      uint64_t keyHashAlgorithm; /* PERS_COM_KEY_HASH_* used for the hashtable index */
+      int64_t freeList[KISSDB_FREE_LIST_COUNT]; /* copy of Shared_Data_s.freeList, updated with every released or reused data block pair */
+      uint64_t checkpoint; /* number of the last checkpoint of the hashtables in this lifecycle (0: database closed or no valid checkpoint) */
+      uint64_t journalCount; /* number of entries in journal */
+      int64_t journal[KISSDB_JOURNAL_SIZE]; /* offsets of the data block pairs written after the last checkpoint */
+      uint64_t keyFieldSize; /* size of the key field of the data blocks */
+      uint64_t minBlockSize; /* smallest size class of the data blocks */
+      uint64_t htCount; /* number of hashtables, written with the hashtables */
+      uint64_t htUsedSlots; /* number of used (valid or deleted) slots in all hashtables, written with the hashtables */
+      uint64_t dataEnd; /* copy of Shared_Data_s.dataEnd, the preallocated area behind it is reused after a power loss */
+      char padding[248]; /* TODO remove padding*/
 } Header_s;
 
+/**
+ * Start of a data block: the key field (KISSDB.keyFieldSize bytes) is followed by DataBlockInfo_s,
+ * the value area and the end delimiter.
+ * The size of a block (blockSize) is the smallest size class that can hold the value,
+ * the largest size class of a database is given by its maximum value size (valSize in the header):
+ * a block with the largest value of the default maximum (PERS_DB_MAX_SIZE_KEY_DATA = 8028) still fits into 8192 bytes
+ */
 typedef struct
 {
    int64_t  delimStart;
    uint64_t crc;
-   char     key[PERS_DB_MAX_LENGTH_KEY_NAME];
-   uint32_t valSize;
-   char     value[PERS_DB_MAX_SIZE_KEY_DATA]; /* 8028, 12124, 16220 -- > PERS_DB_MAX_SIZE_KEY_DATA = (pagesize * n) - (PERS_DB_MAX_LENGTH_KEY_NAME + 36) */
-   uint64_t htNum; /*index which hashtable stores the offset for this data block */
-   int64_t  delimEnd;
+   char     key[]; /* key field, the size is given by the key size of the database rounded up to 8 bytes */
 } DataBlock_s;
 
+/**
+ * Fields of a data block stored behind the key field, followed by the value area
+ */
+typedef struct
+{
+   uint32_t valSize : 24; /* KISSDB_MAX_VALUE_SIZE fits into 24 bits */
+   uint32_t valFlags : 8; /* KISSDB_VALUE_* flags of the value */
+   uint32_t blockSize; /* size class of this data block: header + value area + end delimiter */
+   uint32_t sequence; /* incremented by every update of the key, the valid block of A and B with the higher sequence holds the latest value */
+} DataBlockInfo_s;
+
+/**
+ * Size of the largest data block header (key field of PERS_DB_MAX_LENGTH_KEY_NAME bytes),
+ * the data block header of a database is stored in KISSDB.dataBlockHeaderSize
+ */
+#define KISSDB_MAX_DATA_BLOCK_HEADER_SIZE (sizeof(DataBlock_s) + PERS_DB_MAX_LENGTH_KEY_NAME + sizeof(DataBlockInfo_s))
+
+/**
+ * Largest maximum value size of a database: the value fills a data block of the largest size class with a free list
+ */
+#define KISSDB_MAX_VALUE_SIZE ((KISSDB_MIN_DATA_BLOCK_SIZE << (KISSDB_FREE_LIST_COUNT - 1)) - KISSDB_MAX_DATA_BLOCK_HEADER_SIZE - sizeof(int64_t))
+
 
 /**
  * Hashtable slot entry -for usage with mmap -> 24 byte --> use 510 + 1 slots
+ * keyLength and the two parts of the key hash allow to reject most non matching slots without reading the data block
+ * a slot with an inline value stores the value in offsetB: its data block B follows data block A of the smallest size class,
+ * and the checksum of its key, which is compared in place of the key in the data block when the value is read
  */
 typedef struct
 {
       int64_t offsetA;
       int64_t offsetB;
-      uint64_t current; //flag which offset points to the current data -> (if 0x00 offsetA points to current data, if 0x01 offsetB)
+      uint8_t current; //flag which offset points to the current data -> (if KISSDB_SLOT_CURRENT_B is not set offsetA points to current data, else offsetB), KISSDB_SLOT_INLINE
+      uint8_t keyLength; //length of the key stored in the data blocks
+      uint16_t bucketHash; //low 16 bits of the key hash (selects the hashtable)
+      uint32_t fingerprint; //high 32 bits of the key hash (selects the first slot of the probe sequence)
 } Hashtable_slot_s;
 
 
@@ -145,6 +338,15 @@ typedef struct
 
 
 
+/**
+ * Mapping of the database file which was replaced by a larger mapping while values were pinned by views of the process
+ */
+typedef struct
+{
+   char* map;
+   uint64_t size;
+} Kdb_mapping_s;
+
 /**
  * KISSDB database
  *
@@ -155,6 +357,9 @@ typedef struct {
         //uint16_t cacheReferenced;
         uint64_t keySize;
         uint64_t valSize;
+        uint32_t keyFieldSize; //size of the key field of the data blocks (from header)
+        uint32_t dataBlockHeaderSize; //offset of the value area in a data block
+        uint32_t minBlockSize; //smallest size class of the data blocks (from header)
         uint64_t htSizeBytes;
         uint64_t htMappedSize; //local info about currently mapped hashtable size for this process
         uint64_t dbMappedSize; //local info about currently mapped database  size for this process
@@ -174,6 +379,13 @@ typedef struct {
         qhasharr_t *tbl[1];   //reference to cache
         sem_t* kdbSem;
         int fd; //local fd
+        uint32_t checksumAlgorithm; //checksum algorithm of the database file (from header)
+        pcoChecksumFunc checksum; //local: checksum function for checksumAlgorithm
+        uint32_t keyHashAlgorithm; //key hash algorithm of the database file (from header)
+        pcoKeyHashFunc keyHash; //local: key hash function for keyHashAlgorithm
+        uint32_t viewPins; //local: number of values pinned by views of this process, the mapping of the database file is not moved while a value is pinned
+        uint32_t retiredCount; //local: number of mappings in retiredMappings
+        Kdb_mapping_s* retiredMappings; //local: mappings replaced while values were pinned, unmapped when the last view of this process is released
 } KISSDB;
 
 /**
@@ -256,6 +468,16 @@ typedef struct {
  * don't increment ref counter, possible application detected
  */
 #define KISSDB_ERROR_APPCRASH -14
+
+/**
+ * the maximum number of hashtables (HASHTABLE_MAX_COUNT) is reached
+ */
+#define KISSDB_ERROR_HASHTABLE_FULL -15
+
+/**
+ * the operation is not possible while values are pinned by views (KISSDB_getView)
+ */
+#define KISSDB_ERROR_VIEW_PINNED -16
    
 
 /**
@@ -325,15 +547,100 @@ extern int KISSDB_open(
  */
 extern int KISSDB_close(KISSDB *db);
 
+/**
+ * Get the hash of a key
+ *
+ * The hash is calculated once per operation with the key hash algorithm of the database file
+ * and passed to KISSDB_get, KISSDB_put, KISSDB_delete and to the cache.
+ *
+ * @param db Database struct
+ * @param key Key (null terminated)
+ * @return 64 bit hash of the key
+ */
+extern uint64_t KISSDB_getKeyHash(KISSDB *db,const void *key);
+
 /**
  * Get an entry
  *
+ * A value stored inline in the hashtable slot is matched without comparing the key (see KISSDB_INLINE_VALUE_SIZE).
+ *
  * @param db Database struct
  * @param key Key (key_size bytes)
+ * @param hash Hash of the key (KISSDB_getKeyHash)
  * @param vbuf Value buffer (value_size bytes capacity)
+ * @param vflags Returns the KISSDB_VALUE_* flags of the value (can be NULL)
+ * @return negative on error (see kissdb.h for error codes), 0 on success, 1 if key not found
+ */
+extern int KISSDB_get(KISSDB *db,const void *key,uint64_t hash,void *vbuf, uint32_t bufsize, uint32_t* vsize, uint32_t* vflags);
+
+/**
+ * Lookup of a key by KISSDB_getBatch
+ */
+typedef struct
+{
+   const char* key; /* null terminated */
+   uint64_t hash; /* hash of the key (KISSDB_getKeyHash) */
+   void* vbuf; /* value buffer */
+   uint32_t bufsize; /* size of vbuf, the value is only copied if it fits */
+   uint32_t vsize; /* returns the size of the value */
+   uint32_t vflags; /* returns the KISSDB_VALUE_* flags of the value */
+   int result; /* returns negative on error, 0 on success, 1 if key not found */
+   int64_t offset; /* file offset of the value, used to sort the reads */
+} KISSDB_Read_s;
+
+/**
+ * Get several entries
+ *
+ * All keys are looked up before the values are copied in the order of their data blocks in the file,
+ * so the pages of the file are read sequentially. The result of every key is returned in its KISSDB_Read_s.
+ * The caller must hold the write lock of the database.
+ *
+ * @param db Database struct
+ * @param reads Keys to read
+ * @param count Number of keys
+ * @return negative on error (see kissdb.h for error codes), 0 on success
+ */
+extern int KISSDB_getBatch(KISSDB *db, KISSDB_Read_s* reads, uint32_t count);
+
+/**
+ * Get the address of a value in the mapping of the database file (view)
+ *
+ * The value is pinned until it is released with KISSDB_releaseView: while a value is pinned,
+ * updates of its key are written to new data blocks, its data blocks are reused only after its last view
+ * of all processes is released, the mapping of this process is not moved and the file is not compacted.
+ * The views of a process which ended without releasing them are released by the next open, compaction or view
+ * that finds all pins (KISSDB_VIEW_PIN_COUNT) used.
+ * Inline and compressed values and values read while all pins are used by running processes have no view:
+ * value returns NULL, they are read with KISSDB_get.
+ * The caller must hold the write lock of the database.
+ *
+ * @param db Database struct
+ * @param key Key (null terminated)
+ * @param hash Hash of the key (KISSDB_getKeyHash)
+ * @param value Returns the address of the value or NULL
+ * @param vsize Returns the size of the value
+ * @param vflags Returns the KISSDB_VALUE_* flags of the value (can be NULL)
  * @return negative on error (see kissdb.h for error codes), 0 on success, 1 if key not found
  */
-extern int KISSDB_get(KISSDB *db,const void *key,void *vbuf, uint32_t bufsize, uint32_t* vsize);
+extern int KISSDB_getView(KISSDB *db, const void *key, uint64_t hash, const void** value, uint32_t* vsize, uint32_t* vflags);
+
+/**
+ * Checks if an address lies in a mapping of the database file of this process, i.e. if it is a view returned by KISSDB_getView
+ *
+ * @param db Database struct
+ * @param value Address
+ */
+extern Kdb_bool KISSDB_isView(KISSDB *db, const void* value);
+
+/**
+ * Release a view returned by KISSDB_getView
+ *
+ * The caller must hold the write lock of the database.
+ *
+ * @param db Database struct
+ * @param value Address returned by KISSDB_getView
+ */
+extern void KISSDB_releaseView(KISSDB *db, const void* value);
 
 
 
@@ -342,9 +649,10 @@ extern int KISSDB_get(KISSDB *db,const void *key,void *vbuf, uint32_t bufsize, u
  *
  * @param db Database struct
  * @param key Key (key_size bytes)
+ * @param hash Hash of the key (KISSDB_getKeyHash)
  * @return negative on error (see kissdb.h for error codes), 0 on success, 1 if key not found
  */
-extern int KISSDB_delete(KISSDB *db,const void *key, int32_t* bytesDeleted);
+extern int KISSDB_delete(KISSDB *db,const void *key,uint64_t hash, int32_t* bytesDeleted);
 
 /**
  * Put an entry (overwriting it if it already exists)
@@ -354,10 +662,89 @@ extern int KISSDB_delete(KISSDB *db,const void *key, int32_t* bytesDeleted);
  *
  * @param db Database struct
  * @param key Key (key_size bytes)
+ * @param hash Hash of the key (KISSDB_getKeyHash)
  * @param value Value (value_size bytes)
+ * @param valueFlags KISSDB_VALUE_* flags stored with the value
  * @return negative on error (see kissdb.h for error codes) error, 0 on success
  */
-extern int KISSDB_put(KISSDB *db,const void *key,const void *value, int valueSize, int32_t* bytesWritten);
+extern int KISSDB_put(KISSDB *db,const void *key,uint64_t hash,const void *value, int valueSize, uint32_t valueFlags, int32_t* bytesWritten);
+
+/**
+ * Reserve space for new values
+ *
+ * The database file grows once, so that the data blocks of count values with the given sizes can be appended
+ * without further growth and remaps of the file (the space of keys which are overwritten in place or reuse
+ * released data blocks stays preallocated).
+ * The caller must hold the write lock of the database.
+ *
+ * @param db Database struct
+ * @param valueSizes Sizes of the values
+ * @param count Number of values
+ * @return negative on error (see kissdb.h for error codes), 0 on success
+ */
+extern int KISSDB_reserve(KISSDB *db, const int* valueSizes, uint32_t count);
+
+/**
+ * Compact the database file
+ *
+ * Moves the data blocks of all valid keys and the hashtables towards the start of the file,
+ * removes the slots of deleted keys from the hashtables and truncates the file.
+ * The caller must hold the write lock of the database, other processes remap the file on their next access.
+ * The file is not compacted while values are pinned by views (KISSDB_ERROR_VIEW_PINNED).
+ *
+ * @param db Database struct
+ * @param bytesReclaimed Returns the number of bytes the file was truncated by
+ * @return negative on error (see kissdb.h for error codes), 0 on success
+ */
+extern int KISSDB_compact(KISSDB *db, int64_t* bytesReclaimed);
+
+/**
+ * Sets the number of threads used to recover a database after a power loss (see KISSDB_RECOVERY_MAX_THREADS)
+ *
+ * @param threads Number of threads, 0 (default) for one thread per online CPU
+ */
+extern void KISSDB_setRecoveryThreads(uint32_t threads);
+
+/**
+ * Sets the checksum and the key hash algorithm of the database files created afterwards by this process
+ * (default: KISSDB_CHECKSUM_ALGORITHM and KISSDB_KEY_HASH_ALGORITHM).
+ * Existing files are always opened with the algorithms recorded in their header.
+ *
+ * @param checksumAlgorithm PERS_COM_CHECKSUM_* of the hashtables and data blocks
+ * @param keyHashAlgorithm PERS_COM_KEY_HASH_* of the hashtable index
+ * @return KISSDB_ERROR_INVALID_PARAMETERS if an algorithm is unknown, 0 on success
+ */
+extern int KISSDB_setAlgorithms(uint32_t checksumAlgorithm, uint32_t keyHashAlgorithm);
+
+/**
+ * Returns the major version of a database file
+ *
+ * @param path Path to file
+ * @return major version (KISSDB_MAJOR_VERSION for files opened by KISSDB_open),
+ *         KISSDB_ERROR_IO if the file can not be read, KISSDB_ERROR_CORRUPT_DBFILE if it is no database file
+ */
+extern int KISSDB_getFileVersion(const char* path);
+
+/**
+ * Called by KISSDB_readVersion2 for every key, a nonzero return value stops the reading
+ */
+typedef int (*KISSDB_Version2Item_f)(void* arg, const char* key, const void* value, uint32_t valueSize);
+
+/**
+ * Read all keys of a database file of version 2.x (KISSDB_MAJOR_VERSION_2)
+ *
+ * The file is only read. The keys are found along the hashtables of the file, a key gets the value of its current
+ * data block, or of its other data block if the checksum of the current one is wrong (the file was not closed correctly).
+ * Keys without a valid data block are skipped. The value passed to item is only valid during the call.
+ *
+ * @param path Path to file
+ * @param valueSize Returns the maximum value size of the file (can be NULL)
+ * @param item Called for every key (can be NULL to count the keys)
+ * @param arg Passed to item
+ * @return number of keys, the nonzero return value of item, KISSDB_ERROR_WRONG_DATABASE_VERSION if the file
+ *         is not of version 2.x, other negative values on error (see kissdb.h for error codes)
+ */
+extern int KISSDB_readVersion2(const char* path, uint64_t* valueSize, KISSDB_Version2Item_f item, void* arg);
 
 /**
  * Cursor used for iterating over all entries in database
@@ -366,6 +753,10 @@ typedef struct {
 	KISSDB *db;
 	unsigned long h_no;
 	unsigned long h_idx;
+	uint64_t hash; /* key hash stored in the slot of the last returned entry (bits of the hashtable number and the fingerprint) */
+	uint32_t htNum; /* number of hashtables at KISSDB_Iterator_init, gives the order of KISSDB_Iterator_nextStable */
+	Kdb_bool found; /* KISSDB_Iterator_nextStable: hash and key are the last returned entry of hashtable number h_no */
+	char key[PERS_DB_MAX_LENGTH_KEY_NAME]; /* KISSDB_Iterator_nextStable: key of the last returned entry */
 } KISSDB_Iterator;
 
 /**
@@ -388,6 +779,20 @@ extern void KISSDB_Iterator_init(KISSDB *db,KISSDB_Iterator *dbi);
  * @return 0 if there are no more entries, negative on error, positive if kbuf/vbuf have been filled
  */
 extern int KISSDB_Iterator_next(KISSDB_Iterator *dbi,void *kbuf,void *vbuf);
+
+/**
+ * Get the next entry, also if entries are written during the iteration
+ *
+ * Every key is returned at most once, and the keys which are not deleted during the iteration
+ * are returned, even if the hashtables are split. New keys may or may not be returned.
+ * Every call scans the hashtables, use KISSDB_Iterator_next if the database is not modified.
+ *
+ * @param Database iterator
+ * @param kbuf Buffer to fill with next key (key_size bytes)
+ * @param vbuf Buffer to fill with next value (value_size bytes)
+ * @return 0 if there are no more entries, negative on error, positive if kbuf/vbuf have been filled
+ */
+extern int KISSDB_Iterator_nextStable(KISSDB_Iterator *dbi,void *kbuf,void *vbuf);
 extern Kdb_bool freeKdbShmemPtr(void * shmem_ptr, size_t length);
 extern void * getKdbShmemPtr(int shmem, size_t length);
 extern Kdb_bool kdbShmemClose(int shmem, const char * shmName);
@@ -398,12 +803,21 @@ extern void Kdb_rdlock(pthread_rwlock_t * rdlock);
 extern void Kdb_unlock(pthread_rwlock_t * lock);
 extern int readHeader(KISSDB* db, uint16_t* htSize, uint64_t* keySize, uint64_t* valSize);
 extern int writeHeader(KISSDB* db, uint16_t* htSize, uint64_t* keySize, uint64_t* valSize);
-extern int writeDualDataBlock(KISSDB* db, int64_t offset, int htNumber, const void* key, unsigned long klen, const void* value, int valueSize);
+extern int writeDualDataBlock(KISSDB* db, int64_t offset, uint32_t blockSize, const void* key, unsigned long klen, const void* value, int valueSize, uint32_t valueFlags);
 extern int checkErrorFlags(KISSDB* db);
 extern int verifyHashtableCS(KISSDB* db);
 extern int rebuildHashtables(KISSDB* db);
+extern int addHashtable(KISSDB* db);
+extern int splitHashtable(KISSDB* db);
+extern void removeDeletedHashtableSlots(KISSDB* db);
+extern int insertHashtableSlot(KISSDB* db, uint64_t hash, const Hashtable_slot_s* entry);
+extern int rebuildFreeLists(KISSDB* db);
+extern void writeHashtables(KISSDB* db, Kdb_bool sync);
+extern void checkpointHashtables(KISSDB* db);
+extern int recoverFromCheckpoint(KISSDB* db);
+extern uint32_t countHashtableSlots(KISSDB* db);
 extern int greatestCommonFactor(int x, int y);
-extern void invalidateBlocks(DataBlock_s* dataA, DataBlock_s* dataB, KISSDB* db);
+extern void invalidateBlocks(DataBlock_s* dataA, DataBlock_s* dataB, uint32_t blockSize, KISSDB* db);
 extern void invertBlockOffsets(DataBlock_s* data, KISSDB* db, int64_t offsetA, int64_t offsetB);
 extern void rebuildWithBlockB(DataBlock_s* data, KISSDB* db, int64_t offsetA, int64_t offsetB);
 extern void rebuildWithBlockA(DataBlock_s* data, KISSDB* db, int64_t offsetA, int64_t offsetB);
@@ -31,23 +31,24 @@
  *
  * qhasharr implements a hash-table which maps keys to values and stores into
  * fixed size static memory like shared-memory and memory-mapped file.
- * The creator qhasharr() initializes static memory to makes small slots in it.
- * The default slot size factors are defined in _Q_HASHARR_KEYSIZE and
- * _Q_HASHARR_VALUESIZE. And they are applied at compile time.
- *
- * The value part of an element will be stored across several slots if it's size
- * exceeds the slot size. But the key part of an element will be truncated if
- * the size exceeds and it's length and more complex MD5 hash value will be
- * stored with the key. So to look up a particular key, first we find an element
- * which has same hash value. If the key was not truncated, we just do key
- * comparison. But if the key was truncated because it's length exceeds, we do
- * both md5 and key comparison(only stored size) to verify that the key is same.
- * So please be aware of that, theoretically there is a possibility we pick
- * wrong element in case a key exceeds the limit, has same length and MD5 hash
- * with lookup key. But this possibility is extreamly low and almost never
- * happen in practice. If you happpen to want to make sure everything,
- * you set _Q_HASHARR_KEYSIZE big enough at compile time to make sure all keys
- * fits in it.
+ * The creator qhasharr() divides the static memory into an index of slots and
+ * an arena which holds the elements. The division is given by the average
+ * element size _Q_HASHARR_ELEMSIZE which is applied at compile time.
+ *
+ * The index is an open addressing table with linear probing. A slot holds the
+ * key hash calculated by the caller and the arena offset of the element, so a
+ * lookup compares hashes in the index and the key only once for the element
+ * with the same hash. At most 3/4 of the slots are used, a removed slot is
+ * refilled by shifting the following slots of the probe sequence back, so
+ * there are no tombstones.
+ *
+ * An element is stored in one chunk of the arena: element header, key and
+ * value are contiguous. Chunks are allocated by size classes (multiples of 8
+ * bytes up to 64 bytes, then 8 classes per power of two, so less than 1/8 of a
+ * chunk is unused). A chunk is taken from the free list of its class or carved
+ * from the unused end of the arena. If the arena is used up, a free chunk of a
+ * larger class is taken. Freed chunks are put on the free list of their class.
+ * A value which still fits into its chunk is overwritten in place.
  *
  * qhasharr hash-table does not support thread-safe. So users should handle
  * race conditions on application side by raising user lock before calling
@@ -57,42 +58,10 @@
  *  [Data Structure Diagram]
  *
  *  +--[Static Flat Memory Area]-----------------------------------------------+
- *  | +-[Header]---------+ +-[Slot 0]---+ +-[Slot 1]---+        +-[Slot N]---+ |
- *  | |Private table data| |KEY A|DATA A| |KEY B|DATA B|  ....  |KEY N|DATA N| |
- *  | +------------------+ +------------+ +------------+        +------------+ |
+ *  | +-[Header]---------+ +-[Index]-----------------+ +-[Arena]-------------+ |
+ *  | |Private table data| |HASH|OFS|HASH|OFS|  ...  | |KEY A|DATA A|KEY B|.. | |
+ *  | +------------------+ +-------------------------+ +---------------------+ |
  *  +--------------------------------------------------------------------------+
- *
- *  Below diagram shows how a big value is stored.
- *  +--[Static Flat Memory Area------------------------------------------------+
- *  | +--------+ +-[Slot 0]---+ +-[Slot 1]---+ +-[Slot 2]---+ +-[Slot 3]-----+ |
- *  | |TBL INFO| |KEY A|DATA A| |DATA A cont.| |KEY B|DATA B| |DATA A cont.  | |
- *  | +--------+ +------------+ +------------+ +------------+ +--------------+ |
- *  |                      ^~~link~~^     ^~~~~~~~~~link~~~~~~~~~^             |
- *  +--------------------------------------------------------------------------+
- * @endcode
- *
- * @code
- *  // initialize hash-table.
- *  char memory[1000 * 10];
- *  qhasharr_t *tbl = qhasharr(memory, sizeof(memory));
- *  if(tbl == NULL) return;
- *
- *  // insert elements (key duplication does not allowed)
- *  tbl->putstr(tbl, "e1", "a");
- *  tbl->putstr(tbl, "e2", "b");
- *  tbl->putstr(tbl, "e3", "c");
- *
- *  // debug print out
- *  tbl->//DEBUG(tbl, stdout);
- *
- *  char *e2 = tbl->getstr(tbl, "e2");
- *  if(e2 != NULL) {
- *     printf("getstr('e2') : %s\n", e2);
- *     free(e2);
- *  }
- *
- *  // Release reference object.
- *  tbl->free(tbl);
  * @endcode
  *
  * An example for using hash table over shared memory.
@@ -153,14 +122,22 @@
 
 #ifndef _DOXYGEN_SKIP
 
-static bool put(qhasharr_t *tbl, const char *key, const void *value,
-                size_t size);
+static bool put(qhasharr_t *tbl, const char *key, uint32_t keyhash,
+                const void *value, size_t size);
 
-static void *get(qhasharr_t *tbl, const char *key, size_t *size);
+static void *get(qhasharr_t *tbl, const char *key, uint32_t keyhash, size_t *size);
 
 static bool getnext(qhasharr_t *tbl, qnobj_t *obj, int *idx);
 
-static bool remove_(qhasharr_t *tbl, const char *key);
+static bool getnextkey(qhasharr_t *tbl, char *key, size_t keysize,
+                       void *head, size_t headsize, int *idx);
+
+static bool exists(qhasharr_t *tbl, const char *key, uint32_t keyhash);
+
+static bool gethead(qhasharr_t *tbl, const char *key, uint32_t keyhash,
+                    void *head, size_t headsize);
+
+static bool remove_(qhasharr_t *tbl, const char *key, uint32_t keyhash);
 
 static int size(qhasharr_t *tbl, int *maxslots, int *usedslots);
 
@@ -169,31 +146,43 @@ static void free_(qhasharr_t *tbl);
 
 
 // internal usages
-static int _find_empty(qhasharr_t *tbl, int startidx);
-static int _get_idx(qhasharr_t *tbl, const char *key, unsigned int hash);
-static void *_get_data(qhasharr_t *tbl, int idx, size_t *size);
-static bool _put_data(qhasharr_t *tbl, int idx, unsigned int hash,
-                      const char *key, const void *value, size_t size,
-                      int count);
-static bool _copy_slot(qhasharr_t *tbl, int idx1, int idx2);
-static bool _remove_slot(qhasharr_t *tbl, int idx);
-static bool _remove_data(qhasharr_t *tbl, int idx);
+#define _ELEM(data, offset) ((qhasharr_elem_t *) ((data)->arena + (offset)))
+#define _ELEM_KEY(elem) ((char *) (elem) + sizeof(qhasharr_elem_t))
+#define _ELEM_VALUE(elem) (_ELEM_KEY(elem) + (elem)->keylen + 1)
+#define _ELEM_SIZE(elem) (sizeof(qhasharr_elem_t) + (elem)->keylen + 1 + (elem)->size)
+
+// index slot and arena offset of an element, used to move the elements in arena order
+typedef struct {
+    uint32_t offset;
+    int idx;
+} qhasharr_move_t;
+
+static int _get_class(size_t size);
+static size_t _class_size(int sizeclass);
+static uint32_t _alloc_chunk(qhasharr_data_t *data, int sizeclass);
+static void _free_chunk(qhasharr_data_t *data, uint32_t offset);
+static int _compare_moves(const void *a, const void *b);
+static bool _compact_arena(qhasharr_data_t *data, size_t chunksize);
+static int _get_idx(qhasharr_t *tbl, const char *key, uint32_t keyhash);
+static bool _is_full(qhasharr_data_t *data);
+static void _put_elem(qhasharr_data_t *data, uint32_t offset, const char *key,
+                      size_t keylen, const void *value, size_t size);
+static void _remove_slot(qhasharr_t *tbl, int idx);
 
 #endif
 
 /**
- * Get how much memory is needed for N slots.
+ * Get how much memory is needed for N elements of the average element size
+ * _Q_HASHARR_ELEMSIZE.
  *
- * @param max       a number of maximum internal slots
+ * @param max       a number of maximum elements
  *
  * @return memory size needed
- *
- * @note
- *  This can be used for calculating minimum memory size for N slots.
  */
 size_t qhasharr_calculate_memsize(int max) {
     size_t memsize = sizeof(qhasharr_data_t)
-            + (sizeof(qhasharr_slot_t) * (max));
+            + ((sizeof(qhasharr_slot_t) * 4 / 3 + _Q_HASHARR_ELEMSIZE) * (max))
+            + sizeof(qhasharr_slot_t);
     return memsize;
 }
 
@@ -206,15 +195,16 @@ size_t qhasharr_calculate_memsize(int max) {
  * @return qhasharr_t container pointer, otherwise returns NULL.
  * @retval errno  will be set in error condition.
  *  - EINVAL : Assigned memory is too small. It must bigger enough to allocate
- *  at least 1 slot.
+ *  at least 1 element.
  *
- * @code
- *  // initialize hash-table with 100 slots.
- *  // A single element can take several slots.
- *  char memory[112 * 100];
+ * @note
+ *  The memory is not cleared, a new shared memory object is filled with zeros
+ *  which marks all index slots as empty. Only the touched parts of the memory
+ *  are allocated by the system.
  *
+ * @code
  *  // Initialize new table.
- *  qhasharr_t *tbl = qhasharr(memory, sizeof(memory));
+ *  qhasharr_t *tbl = qhasharr(memory, memsize);
  *
  *  // Use existing table.
  *  qhasharr_t *tbl2 = qhasharr(memory, 0);
@@ -225,26 +215,39 @@ qhasharr_t *qhasharr(void *memory, size_t memsize)
 // Structure memory.
    qhasharr_data_t *data = (qhasharr_data_t *) memory;
 
-   //printf("qhasharr memory pointer: %p \n", memory);
 // Initialize data if memsize is set or use existing data.
    if (memsize > 0)
    {
-// calculate max
-      int maxslots = (memsize - sizeof(qhasharr_data_t)) / sizeof(qhasharr_slot_t);
-      if (maxslots < 1 || memsize <= sizeof(qhasharr_t))
+// calculate max, at most 3/4 of the index slots are used
+      size_t maxelems = 0;
+      size_t arenasize = 0;
+      if (memsize > sizeof(qhasharr_data_t))
+      {
+         maxelems = (memsize - sizeof(qhasharr_data_t))
+                  / (sizeof(qhasharr_slot_t) * 4 / 3 + _Q_HASHARR_ELEMSIZE);
+      }
+      size_t maxslots = maxelems + maxelems / 3 + 1;
+      if (maxelems < 1 || maxslots > INT32_MAX)
       {
          errno = EINVAL;
          return NULL;
       }
+      arenasize = (memsize - sizeof(qhasharr_data_t) - maxslots * sizeof(qhasharr_slot_t)) & ~(size_t) 7;
+      if (arenasize > (UINT32_MAX & ~(uint32_t) 7))
+      {
+         arenasize = UINT32_MAX & ~(uint32_t) 7;
+      }
 // Set memory.
       //memset((void *) data, 0, memsize);   // remove memset in order to get all the memory NOT preallocated
-      data->maxslots = maxslots;
+      data->maxslots = (int) maxslots;
       data->usedslots = 0;
       data->num = 0;
+      data->arenasize = (uint32_t) arenasize;
+      data->arenaused = 8;  // offset 0 marks empty slots and the end of free lists
+      memset((void *) data->freechunks, 0, sizeof(data->freechunks));
    }
-   //printf("Memory address: %p, sizeof(qhasharr_data_t): %d \n", memory, sizeof(qhasharr_data_t));
 // Set data address. Shared memory returns virtul address.
-   data->slots = (qhasharr_slot_t *) (memory + sizeof(qhasharr_data_t));
+   setMemoryAddress(memory, NULL);
 
 // Create the table object.
    qhasharr_t *tbl = (qhasharr_t *) malloc(sizeof(qhasharr_t));
@@ -258,6 +261,9 @@ qhasharr_t *qhasharr(void *memory, size_t memsize)
    tbl->put = put;
    tbl->get = get;
    tbl->getnext = getnext;
+   tbl->getnextkey = getnextkey;
+   tbl->exists = exists;
+   tbl->gethead = gethead;
    tbl->remove = remove_;
    tbl->size = size;
    tbl->free = free_;
@@ -271,13 +277,18 @@ qhasharr_t *qhasharr(void *memory, size_t memsize)
  * setMemoryAddress(): resets the mapped shared memory pointer.
  *
  * @param memory    pointer to shared memory.
- * @param tbl       qhasharr_t container pointer
+ * @param tbl       qhasharr_t container pointer, NULL to set the pointers of
+ *                  the memory only
  */
 void setMemoryAddress(void* memory, qhasharr_t *tbl )
 {
    qhasharr_data_t *data = (qhasharr_data_t *) memory;
    data->slots = (qhasharr_slot_t *) (memory + sizeof(qhasharr_data_t));
-   tbl->data = data;
+   data->arena = (unsigned char *) (data->slots + data->maxslots);
+   if (tbl != NULL)
+   {
+      tbl->data = data;
+   }
 }
 
 
@@ -286,6 +297,7 @@ void setMemoryAddress(void* memory, qhasharr_t *tbl )
  *
  * @param tbl       qhasharr_t container pointer.
  * @param key       key string
+ * @param keyhash   hash of the key (calculated by the caller)
  * @param value     value object data
  * @param size      size of value
  *
@@ -293,95 +305,78 @@ void setMemoryAddress(void* memory, qhasharr_t *tbl )
  * @retval errno will be set in error condition.
  *  - ENOBUFS   : Table doesn't have enough space to store the object.
  *  - EINVAL    : Invalid argument.
- *  - EFAULT    : Unexpected error. Data structure is not constant.
+ *
+ * @note
+ *  If the object can not be stored, the previous value of the key is kept.
  */
-static bool put(qhasharr_t *tbl, const char *key, const void *value,
-                size_t size) {
+static bool put(qhasharr_t *tbl, const char *key, uint32_t keyhash,
+                const void *value, size_t size) {
     if (tbl == NULL || key == NULL || value == NULL) {
         errno = EINVAL;
         return false;
     }
 
     qhasharr_data_t *data = tbl->data;
-    //printf("put data-> ptr= %p ---- MAXSLOTS = %d \n", data, data->maxslots);
-    // check full
-    if (data->usedslots >= data->maxslots || ((data->usedslots + (size / 32)) >= data->maxslots))  {
-        //DEBUG("hasharr: put %s - FULL", key);
+    size_t keylen = strlen(key);
+    if (keylen > UINT16_MAX || size > UINT32_MAX) {
+        errno = EINVAL;
+        return false;
+    }
+    int sizeclass = _get_class(sizeof(qhasharr_elem_t) + keylen + 1 + size);
+    if (sizeclass < 0) {
         errno = ENOBUFS;
-        //printf("CACHE TOO SMALL \n");
         return false;
     }
 
-
-    // get hash integer
-    unsigned int hash = qhashmurmur3_32(key, strlen(key)) % data->maxslots;
-
-    // check, is slot empty
-    if (data->slots[hash].count == 0) {  // empty slot
-        // put data
-        if (_put_data(tbl, hash, hash, key, value, size, 1) == false) {
-            //DEBUG("hasharr: FAILED put(new) %s", key);
-            return false;
-        } //DEBUG("hasharr: put(new) %s (idx=%d,hash=%u,tot=%d)",
-          //      key, hash, hash, data->usedslots);
-    } else if (data->slots[hash].count > 0) {  // same key or hash collision
-        // check same key;
-        int idx = _get_idx(tbl, key, hash);
-        if (idx >= 0) {  // same key
-            // remove and recall
-            remove_(tbl, key);
-            return put(tbl, key, value, size);
-        } else {  // no same key, just hash collision
-            // find empty slot
-            int idx = _find_empty(tbl, hash);
-            if (idx < 0) {
-                errno = ENOBUFS;
-                return false;
-            }
-
-            // put data. -1 is used for collision resolution (idx != hash);
-            if (_put_data(tbl, idx, hash, key, value, size, -1) == false) {
-                //DEBUG("hasharr: FAILED put(col) %s", key);
-                return false;
-            }
-
-            // increase counter from leading slot
-            data->slots[hash].count++;
-
-            //DEBUG("hasharr: put(col) %s (idx=%d,hash=%u,tot=%d)",
-            //        key, idx, hash, data->usedslots);
+    int idx = _get_idx(tbl, key, keyhash);
+    if (idx >= 0) {  // same key
+        uint32_t offset = data->slots[idx].offset;
+        qhasharr_elem_t *elem = _ELEM(data, offset);
+        size_t chunksize = _class_size(elem->sizeclass);
+        size_t elemsize = sizeof(qhasharr_elem_t) + keylen + 1 + size;
+
+        // overwrite in place if the value fits and uses more than half of the chunk
+        if (elemsize <= chunksize && elemsize > chunksize / 2) {
+            elem->size = (uint32_t) size;
+            memcpy(_ELEM_VALUE(elem), value, size);
+            return true;
         }
-    } else {
-        // in case of -1 or -2, move it. -1 used for collision resolution,
-        // -2 used for oversized value data.
-        // find empty slot
-        int idx = _find_empty(tbl, hash + 1);
-        if (idx < 0) {
+
+        uint32_t newoffset = _alloc_chunk(data, sizeclass);
+        if (newoffset == 0) {
             errno = ENOBUFS;
             return false;
         }
+        _put_elem(data, newoffset, key, keylen, value, size);
+        offset = data->slots[idx].offset;  // moved if the allocation compacted the arena
+        data->slots[idx].offset = newoffset;
+        _free_chunk(data, offset);
+        return true;
+    }
 
-        // move dup slot to empty
-        _copy_slot(tbl, idx, hash);
-        _remove_slot(tbl, hash);
-
-        // in case of -2, adjust link of mother
-        if (data->slots[idx].count == -2) {
-            data->slots[data->slots[idx].hash].link = idx;
-            if (data->slots[idx].link != -1) {
-                data->slots[data->slots[idx].link].hash = idx;
-            }
-        }
-
-        // store data
-        if (_put_data(tbl, hash, hash, key, value, size, 1) == false) {
-            //DEBUG("hasharr: FAILED put(swp) %s", key);
-            return false;
-        }
+    // check full
+    if (_is_full(data)) {
+        errno = ENOBUFS;
+        return false;
+    }
+    uint32_t offset = _alloc_chunk(data, sizeclass);
+    if (offset == 0) {
+        errno = ENOBUFS;
+        return false;
+    }
+    _put_elem(data, offset, key, keylen, value, size);
 
-        //DEBUG("hasharr: put(swp) %s (idx=%u,hash=%u,tot=%d)",
-        //        key, hash, hash, data->usedslots);
+    // first empty slot of the probe sequence
+    idx = (int) (keyhash % (uint32_t) data->maxslots);
+    while (data->slots[idx].offset != 0) {
+        idx++;
+        if (idx >= data->maxslots)
+            idx = 0;
     }
+    data->slots[idx].hash = keyhash;
+    data->slots[idx].offset = offset;
+    data->usedslots++;
+    data->num++;
     return true;
 }
 
@@ -393,6 +388,7 @@ static bool put(qhasharr_t *tbl, const char *key, const void *value,
  *
  * @param tbl       qhasharr_t container pointer.
  * @param key       key string
+ * @param keyhash   hash of the key (calculated by the caller)
  * @param size      if not NULL, oject size will be stored
  *
  * @return malloced object pointer if successful, otherwise(not found)
@@ -405,20 +401,29 @@ static bool put(qhasharr_t *tbl, const char *key, const void *value,
  * @note
  * returned object must be freed after done using.
  */
-static void *get(qhasharr_t *tbl, const char *key, size_t *size) {
+static void *get(qhasharr_t *tbl, const char *key, uint32_t keyhash, size_t *size) {
     if (tbl == NULL || key == NULL) {
         //errno = EINVAL;
         return NULL;
     }
-    qhasharr_data_t *data = tbl->data;
-    // get hash integer
-    unsigned int hash = qhashmurmur3_32(key, strlen(key)) % data->maxslots;
-    int idx = _get_idx(tbl, key, hash);
+    int idx = _get_idx(tbl, key, keyhash);
     if (idx < 0) {
         //errno = ENOENT;
         return NULL;
     }
-    return _get_data(tbl, idx, size);
+
+    qhasharr_elem_t *elem = _ELEM(tbl->data, tbl->data->slots[idx].offset);
+    void *value = malloc(elem->size > 0 ? elem->size : 1);
+    if (value == NULL) {
+        //errno = ENOMEM;
+        return NULL;
+    }
+    memcpy(value, _ELEM_VALUE(elem), elem->size);
+    if (size != NULL)
+    {
+       *size = elem->size;
+    }
+    return value;
 }
 
 /**
@@ -443,11 +448,6 @@ static void *get(qhasharr_t *tbl, const char *key, size_t *size) {
  *    free(obj.data);
  *  }
  * @endcode
- *
- * @note
- *  Please be aware a key name will be returned with truncated length
- *  because key name is truncated when it put into the table if it's length is
- *  longer than _Q_HASHARR_KEYSIZE.
  */
 static bool getnext(qhasharr_t *tbl, qnobj_t *obj, int *idx) {
     if (tbl == NULL || obj == NULL || idx == NULL) {
@@ -457,27 +457,26 @@ static bool getnext(qhasharr_t *tbl, qnobj_t *obj, int *idx) {
 
     qhasharr_data_t *data = tbl->data;
     for (; *idx < data->maxslots; (*idx)++) {
-        if (data->slots[*idx].count == 0 || data->slots[*idx].count == -2) {
+        if (data->slots[*idx].offset == 0) {
             continue;
         }
-        size_t keylen = data->slots[*idx].data.pair.keylen;
-        if (keylen > _Q_HASHARR_KEYSIZE)
-            keylen = _Q_HASHARR_KEYSIZE;
+        qhasharr_elem_t *elem = _ELEM(data, data->slots[*idx].offset);
 
-        obj->name = (char *) malloc(keylen + 1);
+        obj->name = (char *) malloc(elem->keylen + 1);
         if (obj->name == NULL) {
             //errno = ENOMEM;
             return false;
         }
-        memcpy(obj->name, data->slots[*idx].data.pair.key, keylen);
-        obj->name[keylen] = '\0';
+        memcpy(obj->name, _ELEM_KEY(elem), elem->keylen + 1);
 
-        obj->data = _get_data(tbl, *idx, &obj->size);
+        obj->data = malloc(elem->size > 0 ? elem->size : 1);
         if (obj->data == NULL) {
             free(obj->name);
             //errno = ENOMEM;
             return false;
         }
+        memcpy(obj->data, _ELEM_VALUE(elem), elem->size);
+        obj->size = elem->size;
 
         *idx += 1;
         return true;
@@ -487,86 +486,130 @@ static bool getnext(qhasharr_t *tbl, qnobj_t *obj, int *idx) {
     return false;
 }
 
+/**
+ * qhasharr->getnextkey(): Get the key of the next element without allocating
+ * memory.
+ *
+ * @param tbl       qhasharr_t container pointer.
+ * @param key       buffer for the key string (null terminated, cut to keysize - 1)
+ * @param keysize   size of the key buffer
+ * @param head      buffer for the first bytes of the value or NULL
+ * @param headsize  number of bytes copied to head, at most the value size
+ * @param idx       index pointer
+ *
+ * @return true if successful, otherwise(end of table) returns false
+ *
+ * @code
+ *  int idx = 0;
+ *  char key[128];
+ *  while(tbl->getnextkey(tbl, key, sizeof(key), NULL, 0, &idx) == true) {
+ *    printf("NAME=%s\n", key);
+ *  }
+ * @endcode
+ */
+static bool getnextkey(qhasharr_t *tbl, char *key, size_t keysize,
+                       void *head, size_t headsize, int *idx) {
+    if (tbl == NULL || key == NULL || keysize == 0 || idx == NULL) {
+        return false;
+    }
+
+    qhasharr_data_t *data = tbl->data;
+    for (; *idx < data->maxslots; (*idx)++) {
+        if (data->slots[*idx].offset == 0) {
+            continue;
+        }
+        qhasharr_elem_t *elem = _ELEM(data, data->slots[*idx].offset);
+        size_t keylen = elem->keylen;
+        if (keylen > keysize - 1)
+            keylen = keysize - 1;
+        memcpy(key, _ELEM_KEY(elem), keylen);
+        key[keylen] = '\0';
+
+        if (head != NULL) {
+            if (headsize > elem->size)
+                headsize = elem->size;
+            memcpy(head, _ELEM_VALUE(elem), headsize);
+        }
+
+        *idx += 1;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * qhasharr->exists(): Check if a key is in this table.
+ *
+ * @param tbl       qhasharr_t container pointer.
+ * @param key       key string
+ * @param keyhash   hash of the key (calculated by the caller)
+ *
+ * @return true if the key was found, otherwise returns false
+ */
+static bool exists(qhasharr_t *tbl, const char *key, uint32_t keyhash) {
+    if (tbl == NULL || key == NULL) {
+        return false;
+    }
+    return _get_idx(tbl, key, keyhash) >= 0;
+}
+
+/**
+ * qhasharr->gethead(): Get the first bytes of the value of a key without
+ * allocating memory.
+ *
+ * @param tbl       qhasharr_t container pointer.
+ * @param key       key string
+ * @param keyhash   hash of the key (calculated by the caller)
+ * @param head      buffer for the first bytes of the value
+ * @param headsize  number of bytes copied to head, at most the value size
+ *
+ * @return true if the key was found, otherwise returns false
+ */
+static bool gethead(qhasharr_t *tbl, const char *key, uint32_t keyhash,
+                    void *head, size_t headsize) {
+    if (tbl == NULL || key == NULL || head == NULL) {
+        return false;
+    }
+    int idx = _get_idx(tbl, key, keyhash);
+    if (idx < 0) {
+        return false;
+    }
+    qhasharr_elem_t *elem = _ELEM(tbl->data, tbl->data->slots[idx].offset);
+    if (headsize > elem->size)
+        headsize = elem->size;
+    memcpy(head, _ELEM_VALUE(elem), headsize);
+    return true;
+}
+
 /**
  * qhasharr->remove(): Remove an object from this table.
  *
  * @param tbl       qhasharr_t container pointer.
  * @param key       key string
+ * @param keyhash   hash of the key (calculated by the caller)
  *
  * @return true if successful, otherwise(not found) returns false
  * @retval errno will be set in error condition.
  *  - ENOENT    : No such key found.
  *  - EINVAL    : Invald argument.
- *  - EFAULT        : Unexpected error. Data structure is not constant.
  */
-static bool remove_(qhasharr_t *tbl, const char *key) {
+static bool remove_(qhasharr_t *tbl, const char *key, uint32_t keyhash) {
     if (tbl == NULL || key == NULL) {
         //errno = EINVAL;
         return false;
     }
 
-    qhasharr_data_t *data = tbl->data;
-
-    // get hash integer
-    unsigned int hash = qhashmurmur3_32(key, strlen(key)) % data->maxslots;
-
-    int idx = _get_idx(tbl, key, hash);
+    int idx = _get_idx(tbl, key, keyhash);
     if (idx < 0) {
         //DEBUG("not found %s", key);
         //errno = ENOENT;
         return false;
     }
 
-    if (data->slots[idx].count == 1) {
-        // just remove
-        _remove_data(tbl, idx);
-        //DEBUG("hasharr: rem %s (idx=%d,tot=%d)", key, idx, data->usedslots);
-    } else if (data->slots[idx].count > 1) {  // leading slot and has dup
-        // find dup
-        int idx2;
-        for (idx2 = idx + 1;; idx2++)
-        {
-            if (idx2 >= data->maxslots)
-                idx2 = 0;
-            if (idx2 == idx) {
-                //DEBUG("hasharr: [BUG] failed to remove dup key %s.", key);
-                //errno = EFAULT;
-                return false;
-            }
-            if (data->slots[idx2].count == -1 && data->slots[idx2].hash == hash)
-            {
-                break;
-            }
-        }
-
-        // move to leading slot
-        int backupcount = data->slots[idx].count;
-        _remove_data(tbl, idx);  // remove leading data
-        _copy_slot(tbl, idx, idx2);  // copy slot
-        _remove_slot(tbl, idx2);  // remove moved slot
-
-        data->slots[idx].count = backupcount - 1;  // adjust collision counter
-        if (data->slots[idx].link != -1) {
-            data->slots[data->slots[idx].link].hash = idx;
-        }
-
-        //DEBUG("hasharr: rem(lead) %s (idx=%d,tot=%d)",
-        //        key, idx, data->usedslots);
-    } else {  // in case of -1. used for collision resolution
-        // decrease counter from leading slot
-        if (data->slots[data->slots[idx].hash].count <= 1) {
-            //DEBUG("hasharr: [BUG] failed to remove  %s. "
-            //        "counter of leading slot mismatch.", key);
-            //errno = EFAULT;
-            return false;
-        }
-        data->slots[data->slots[idx].hash].count--;
-
-        // remove data
-        _remove_data(tbl, idx);
-        //DEBUG("hasharr: rem(dup) %s (idx=%d,tot=%d)", key, idx, data->usedslots);
-    }
-
+    _free_chunk(tbl->data, tbl->data->slots[idx].offset);
+    _remove_slot(tbl, idx);
+    tbl->data->num--;
     return true;
 }
 
@@ -611,254 +654,185 @@ void free_(qhasharr_t *tbl) {
 
 #ifndef _DOXYGEN_SKIP
 
-// find empty slot : return empty slow number, otherwise returns -1.
-static int _find_empty(qhasharr_t *tbl, int startidx) {
-    qhasharr_data_t *data = tbl->data;
-
-    if (startidx >= data->maxslots)
-        startidx = 0;
-
-    int idx = startidx;
-    while (true) {
-        if (data->slots[idx].count == 0)
-            return idx;
-
-        idx++;
-        if (idx >= data->maxslots)
-            idx = 0;
-        if (idx == startidx)
-            break;
+// size class of a chunk for size bytes, -1 if there is no class big enough
+static int _get_class(size_t size) {
+    if (size <= 64) {
+        return (size > 0) ? (int) ((size - 1) >> 3) : 0;
     }
 
-    return -1;
+    // 2^exp <= size - 1 < 2^(exp + 1), 8 classes of 2^(exp - 3) bytes each
+    int exp = 6;
+    while (exp < 63 && ((size - 1) >> (exp + 1)) != 0) {
+        exp++;
+    }
+    int sizeclass = 8 + (exp - 6) * 8 + (int) (((size - 1) >> (exp - 3)) & 7);
+    return (sizeclass < _Q_HASHARR_CLASSES) ? sizeclass : -1;
 }
 
-static int _get_idx(qhasharr_t *tbl, const char *key, unsigned int hash) {
-    qhasharr_data_t *data = tbl->data;
-
-    if (data->slots[hash].count > 0) {
-        int count, idx;
-        for (count = 0, idx = hash; count < data->slots[hash].count;) {
-            if (data->slots[idx].hash == hash
-                    && (data->slots[idx].count > 0
-                            || data->slots[idx].count == -1)) {
-                // same hash
-                count++;
-
-                // is same key?
-                size_t keylen = strlen(key);
-                // first check key length
-                if (keylen == data->slots[idx].data.pair.keylen) {
-                    if (keylen <= _Q_HASHARR_KEYSIZE) {
-                        // original key is stored
-                        if (!memcmp(key, data->slots[idx].data.pair.key, keylen))
-                        {
-                            return idx;
-                        }
-                    }
-                }
-            }
+// chunk size of a size class
+static size_t _class_size(int sizeclass) {
+    if (sizeclass < 8) {
+        return ((size_t) sizeclass + 1) << 3;
+    }
+    int exp = 6 + (sizeclass - 8) / 8;
+    return ((size_t) 8 + ((sizeclass - 8) % 8) + 1) << (exp - 3);
+}
 
-            // increase idx
-            idx++;
-            if (idx >= data->maxslots)
-                idx = 0;
+// allocate a chunk : return arena offset, otherwise returns 0.
+static uint32_t _alloc_chunk(qhasharr_data_t *data, int sizeclass) {
+    size_t chunksize = _class_size(sizeclass);
+    uint32_t offset = data->freechunks[sizeclass];
 
-            // check loop
-            if (idx == hash)
+    if (offset != 0) {
+        data->freechunks[sizeclass] = _ELEM(data, offset)->size;
+    } else if (chunksize <= (size_t) (data->arenasize - data->arenaused)) {
+        offset = data->arenaused;
+        data->arenaused += (uint32_t) chunksize;
+    } else {
+        // arena used up, take a free chunk of a larger class
+        for (sizeclass++; sizeclass < _Q_HASHARR_CLASSES; sizeclass++) {
+            offset = data->freechunks[sizeclass];
+            if (offset != 0) {
+                data->freechunks[sizeclass] = _ELEM(data, offset)->size;
                 break;
-
-            continue;
+            }
+        }
+        if (offset == 0) {
+            // the free chunks are too small: merge them at the end of the arena
+            if (_compact_arena(data, chunksize) == false) {
+                return 0;
+            }
+            offset = data->arenaused;
+            data->arenaused += (uint32_t) chunksize;
+            sizeclass = _get_class(chunksize);
         }
     }
-    return -1;
+    _ELEM(data, offset)->sizeclass = (uint8_t) sizeclass;
+    return offset;
 }
 
-static void *_get_data(qhasharr_t *tbl, int idx, size_t *size) {
-    if (idx < 0) {
-        //errno = ENOENT;
-        return NULL;
-    }
-    qhasharr_data_t *data = tbl->data;
-
-    int newidx;
-    size_t valsize;
-    for (newidx = idx, valsize = 0;; newidx = data->slots[newidx].link)
-    {
-        valsize += data->slots[newidx].size;
-        if (data->slots[newidx].link == -1)
-            break;
-    }
+// put a chunk on the free list of its size class
+static void _free_chunk(qhasharr_data_t *data, uint32_t offset) {
+    qhasharr_elem_t *elem = _ELEM(data, offset);
+    elem->size = data->freechunks[elem->sizeclass];
+    data->freechunks[elem->sizeclass] = offset;
+}
 
-    void *value, *vp;
-    value = malloc(valsize);
-    if (value == NULL) {
-        //errno = ENOMEM;
-        return NULL;
-    }
+static int _compare_moves(const void *a, const void *b) {
+    uint32_t offseta = ((const qhasharr_move_t *) a)->offset;
+    uint32_t offsetb = ((const qhasharr_move_t *) b)->offset;
+    return (offseta > offsetb) - (offseta < offsetb);
+}
 
-    for (newidx = idx, vp = value;; newidx = data->slots[newidx].link) {
-        if (data->slots[newidx].count == -2) {
-            // extended data block
-            memcpy(vp, (void *) data->slots[newidx].data.ext.value,
-                   data->slots[newidx].size);
-        } else {
-            // key/value pair data block
-            memcpy(vp, (void *) data->slots[newidx].data.pair.value,
-                   data->slots[newidx].size);
+// move all elements to the front of the arena in arena order, every element
+// gets the smallest chunk that holds it and the free lists are emptied.
+// returns false without moving anything if a chunk of chunksize bytes still
+// would not fit behind the elements.
+static bool _compact_arena(qhasharr_data_t *data, size_t chunksize) {
+    size_t used = 8;
+    int count = 0;
+    int i;
+
+    for (i = 0; i < data->maxslots; i++) {
+        if (data->slots[i].offset != 0) {
+            used += _class_size(_get_class(_ELEM_SIZE(_ELEM(data, data->slots[i].offset))));
+            count++;
         }
-
-        vp += data->slots[newidx].size;
-        if (data->slots[newidx].link == -1)
-            break;
     }
-
-    if (size != NULL)
-    {
-       *size = valsize;
+    if (chunksize > data->arenasize - used) {
+        return false;
     }
-    return value;
-}
-
-static bool _put_data(qhasharr_t *tbl, int idx, unsigned int hash,
-                      const char *key, const void *value, size_t size,
-                      int count) {
-    qhasharr_data_t *data = tbl->data;
 
-    // check if used
-    if (data->slots[idx].count != 0) {
-        //DEBUG("hasharr: BUG found.");
-        //errno = EFAULT;
+    qhasharr_move_t *moves = (qhasharr_move_t *) malloc(((size_t) count + 1) * sizeof(qhasharr_move_t));
+    if (moves == NULL) {
         return false;
     }
-
-    size_t keylen = strlen(key);
-
-    // store key
-    data->slots[idx].count = count;
-    data->slots[idx].hash = hash;
-    strncpy(data->slots[idx].data.pair.key, key, _Q_HASHARR_KEYSIZE);
-    data->slots[idx].data.pair.keylen = keylen;
-    data->slots[idx].link = -1;
-
-    // store value
-    int newidx;
-    size_t savesize;
-    for (newidx = idx, savesize = 0; savesize < size;) {
-        if (savesize > 0) {  // find next empty slot
-            int tmpidx = _find_empty(tbl, newidx + 1);
-            if (tmpidx < 0) {
-                //DEBUG("hasharr: Can't expand slot for key %s.", key);
-                _remove_data(tbl, idx);
-                errno = ENOBUFS;
-                return false;
-            }
-
-            // clear & set
-            memset((void *) (&data->slots[tmpidx]), '\0',
-                   sizeof(qhasharr_slot_t));
-
-            data->slots[tmpidx].count = -2;      // extended data block
-            data->slots[tmpidx].hash = newidx;   // prev link
-            data->slots[tmpidx].link = -1;       // end block mark
-            data->slots[tmpidx].size = 0;
-
-            data->slots[newidx].link = tmpidx;   // link chain
-
-            //DEBUG("hasharr: slot %d is linked to slot %d for key %s.",
-            //        tmpidx, newidx, key);
-            newidx = tmpidx;
+    count = 0;
+    for (i = 0; i < data->maxslots; i++) {
+        if (data->slots[i].offset != 0) {
+            moves[count].offset = data->slots[i].offset;
+            moves[count].idx = i;
+            count++;
         }
-
-        // copy data
-        size_t copysize = size - savesize;
-
-        if (data->slots[newidx].count == -2) {
-            // extended value
-            if (copysize > sizeof(struct _Q_HASHARR_SLOT_EXT)) {
-                copysize = sizeof(struct _Q_HASHARR_SLOT_EXT);
-            }
-            memcpy(data->slots[newidx].data.ext.value, value + savesize,
-                   copysize);
-        } else {
-            // first slot
-            if (copysize > _Q_HASHARR_VALUESIZE) {
-                copysize = _Q_HASHARR_VALUESIZE;
-            }
-            memcpy(data->slots[newidx].data.pair.value, value + savesize,
-                   copysize);
-
-            // increase stored key counter
-            data->num++;
-        }
-        data->slots[newidx].size = copysize;
-        savesize += copysize;
-
-        // increase used slot counter
-        data->usedslots++;
     }
-
-    return true;
-}
-
-static bool _copy_slot(qhasharr_t *tbl, int idx1, int idx2) {
-    qhasharr_data_t *data = tbl->data;
-
-    if (data->slots[idx1].count != 0 || data->slots[idx2].count == 0) {
-        //DEBUG("hasharr: BUG found.");
-        //errno = EFAULT;
-        return false;
+    qsort(moves, (size_t) count, sizeof(qhasharr_move_t), _compare_moves);
+
+    uint32_t cursor = 8;
+    for (i = 0; i < count; i++) {
+        qhasharr_elem_t *elem = _ELEM(data, moves[i].offset);
+        size_t elemsize = _ELEM_SIZE(elem);
+        int sizeclass = _get_class(elemsize);
+        memmove(data->arena + cursor, elem, elemsize);  // the elements only move towards the front
+        _ELEM(data, cursor)->sizeclass = (uint8_t) sizeclass;
+        data->slots[moves[i].idx].offset = cursor;
+        cursor += (uint32_t) _class_size(sizeclass);
     }
-
-    memcpy((void *) (&data->slots[idx1]), (void *) (&data->slots[idx2]),
-           sizeof(qhasharr_slot_t));
-
-    // increase used slot counter
-    data->usedslots++;
+    free(moves);
+    data->arenaused = cursor;
+    memset((void *) data->freechunks, 0, sizeof(data->freechunks));
     return true;
 }
 
-static bool _remove_slot(qhasharr_t *tbl, int idx)
-{
+static int _get_idx(qhasharr_t *tbl, const char *key, uint32_t keyhash) {
     qhasharr_data_t *data = tbl->data;
-
-    if (data->slots[idx].count == 0)
-    {
-        //DEBUG("hasharr: BUG found.");
-        //errno = EFAULT;
-        return false;
+    size_t keylen = strlen(key);
+    int idx = (int) (keyhash % (uint32_t) data->maxslots);
+    int count;
+
+    for (count = 0; count < data->maxslots && data->slots[idx].offset != 0; count++) {
+        if (data->slots[idx].hash == keyhash) {
+            qhasharr_elem_t *elem = _ELEM(data, data->slots[idx].offset);
+            if (elem->keylen == keylen && !memcmp(key, _ELEM_KEY(elem), keylen)) {
+                return idx;
+            }
+        }
+        idx++;
+        if (idx >= data->maxslots)
+            idx = 0;
     }
+    return -1;
+}
 
-    data->slots[idx].count = 0;
+// at most 3/4 of the index slots are used to keep the probe sequences short
+static bool _is_full(qhasharr_data_t *data) {
+    return data->usedslots >= data->maxslots - data->maxslots / 4;
+}
 
-    // decrease used slot counter
-    data->usedslots--;
-    return true;
+static void _put_elem(qhasharr_data_t *data, uint32_t offset, const char *key,
+                      size_t keylen, const void *value, size_t size) {
+    qhasharr_elem_t *elem = _ELEM(data, offset);
+    elem->size = (uint32_t) size;
+    elem->keylen = (uint16_t) keylen;
+    elem->reserved = 0;
+    memcpy(_ELEM_KEY(elem), key, keylen + 1);
+    memcpy(_ELEM_VALUE(elem), value, size);
 }
 
-static bool _remove_data(qhasharr_t *tbl, int idx) {
+// empty a slot and shift the following slots of the probe sequence back
+static void _remove_slot(qhasharr_t *tbl, int idx) {
     qhasharr_data_t *data = tbl->data;
-
-    if (data->slots[idx].count == 0) {
-        //DEBUG("hasharr: BUG found.");
-        //errno = EFAULT;
-        return false;
-    }
+    int next = idx;
 
     while (true) {
-        int link = data->slots[idx].link;
-        _remove_slot(tbl, idx);
-
-        if (link == -1)
+        next++;
+        if (next >= data->maxslots)
+            next = 0;
+        if (data->slots[next].offset == 0)
             break;
 
-        idx = link;
+        // the slot can move to idx unless its home slot is in (idx, next]
+        int home = (int) (data->slots[next].hash % (uint32_t) data->maxslots);
+        bool inrange = (idx <= next) ? (idx < home && home <= next)
+                                     : (idx < home || home <= next);
+        if (inrange == false) {
+            data->slots[idx] = data->slots[next];
+            idx = next;
+        }
     }
 
-    // decrease stored key counter
-    data->num--;
-
-    return true;
+    data->slots[idx].hash = 0;
+    data->slots[idx].offset = 0;
+    data->usedslots--;
 }
 
 #endif /* _DOXYGEN_SKIP */
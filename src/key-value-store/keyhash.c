@@ -0,0 +1,172 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * Copyright
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           keyhash.c
+ * @ingroup        Persistence key value store
+ * @brief          Key hash functions used by the database index and the cache
+ * @see
+ */
+
+/*
+ * The wyhash part of this file is derived from wyhash (final version 4) by Wang Yi,
+ * which is released into the public domain (The Unlicense).
+ */
+
+#include "keyhash.h"
+#include <string.h>
+
+
+/* default secret of wyhash */
+static const uint64_t wyp[4] = { 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL };
+
+
+uint64_t pcoKeyHashDjb2(const void *key, size_t len)
+{
+   size_t i;
+   uint64_t hash = 5381;
+
+   for (i = 0; i < len; ++i)
+   {
+      hash = ((hash << 5) + hash) + (uint64_t) (((const uint8_t*) key)[i]);
+   }
+   //murmur3 64 bit finalizer
+   hash ^= hash >> 33;
+   hash *= 0xff51afd7ed558ccdULL;
+   hash ^= hash >> 33;
+   hash *= 0xc4ceb9fe1a85ec53ULL;
+   hash ^= hash >> 33;
+   return hash;
+}
+
+
+/* 64x64->128 bit multiplication: A returns the low and B the high 64 bits of the product */
+static void wymum(uint64_t *A, uint64_t *B)
+{
+#if defined(__SIZEOF_INT128__)
+   __uint128_t r = *A;
+   r *= *B;
+   *A = (uint64_t) r;
+   *B = (uint64_t) (r >> 64);
+#else
+   //32 bit targets: multiply the 32 bit halves
+   uint64_t ha = *A >> 32, hb = *B >> 32, la = (uint32_t) *A, lb = (uint32_t) *B, hi, lo;
+   uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+   lo = t + (rm1 << 32);
+   c += lo < t;
+   hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+   *A = lo;
+   *B = hi;
+#endif
+}
+
+static uint64_t wymix(uint64_t A, uint64_t B)
+{
+   wymum(&A, &B);
+   return A ^ B;
+}
+
+/* little endian reads, so that the hash does not depend on the byte order of the CPU */
+static uint64_t wyr8(const uint8_t *p)
+{
+   uint64_t v;
+   memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+   v = __builtin_bswap64(v);
+#endif
+   return v;
+}
+
+static uint64_t wyr4(const uint8_t *p)
+{
+   uint32_t v;
+   memcpy(&v, p, 4);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+   v = __builtin_bswap32(v);
+#endif
+   return v;
+}
+
+static uint64_t wyr3(const uint8_t *p, size_t k)
+{
+   return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) | p[k - 1];
+}
+
+
+uint64_t pcoKeyHashWyhash(const void *key, size_t len)
+{
+   const uint8_t *p = (const uint8_t*) key;
+   uint64_t seed = 0;
+   uint64_t a, b;
+   size_t i = len;
+
+   seed ^= wymix(seed ^ wyp[0], wyp[1]);
+   if (len <= 16)
+   {
+      if (len >= 4)
+      {
+         a = (wyr4(p) << 32) | wyr4(p + ((len >> 3) << 2));
+         b = (wyr4(p + len - 4) << 32) | wyr4(p + len - 4 - ((len >> 3) << 2));
+      }
+      else if (len > 0)
+      {
+         a = wyr3(p, len);
+         b = 0;
+      }
+      else
+      {
+         a = b = 0;
+      }
+   }
+   else
+   {
+      if (i > 48)
+      {
+         uint64_t see1 = seed, see2 = seed;
+         do
+         {
+            seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+            see1 = wymix(wyr8(p + 16) ^ wyp[2], wyr8(p + 24) ^ see1);
+            see2 = wymix(wyr8(p + 32) ^ wyp[3], wyr8(p + 40) ^ see2);
+            p += 48;
+            i -= 48;
+         } while (i > 48);
+         seed ^= see1 ^ see2;
+      }
+      while (i > 16)
+      {
+         seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+         i -= 16;
+         p += 16;
+      }
+      a = wyr8(p + i - 16);
+      b = wyr8(p + i - 8);
+   }
+   a ^= wyp[1];
+   b ^= seed;
+   wymum(&a, &b);
+   return wymix(a ^ wyp[0] ^ len, b ^ wyp[1]);
+}
+
+
+pcoKeyHashFunc pcoGetKeyHashFunc(unsigned int algorithm)
+{
+   switch (algorithm)
+   {
+      case PERS_COM_KEY_HASH_DJB2:
+         return pcoKeyHashDjb2;
+      case PERS_COM_KEY_HASH_WYHASH:
+         return pcoKeyHashWyhash;
+      default:
+         return NULL;
+   }
+}
@@ -0,0 +1,67 @@
+#ifndef KEYHASH_H
+#define KEYHASH_H
+
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * Copyright
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           keyhash.h
+ * @ingroup        Persistence key value store
+ * @brief          Header of the key hash functions used by the database index and the cache
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define PERS_COM_KEYHASH_INTERFACE_VERSION  (0x01000000U)
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Key hash algorithm identifiers.
+ * These values are stored in database files and must never be changed.
+ */
+#define PERS_COM_KEY_HASH_DJB2     0  /* djb2 mixed with the murmur3 64 bit finalizer as calculated by pcoKeyHashDjb2 */
+#define PERS_COM_KEY_HASH_WYHASH   1  /* hash derived from wyhash (final version 4) as calculated by pcoKeyHashWyhash */
+
+/**
+ * Key hash function: returns the 64 bit hash of the first len bytes of key
+ */
+typedef uint64_t (*pcoKeyHashFunc)(const void *key, size_t len);
+
+/**
+ * djb2 hash of the key, mixed with the murmur3 finalizer so that the low and the high bits are independent.
+ * Keys with long common prefixes are clustered by djb2, new database files use wyhash (KISSDB_KEY_HASH_ALGORITHM).
+ */
+uint64_t pcoKeyHashDjb2(const void *key, size_t len);
+
+/**
+ * wyhash of the key: reads the key in 8 byte words and mixes every word with a 64x64->128 bit multiplication
+ */
+uint64_t pcoKeyHashWyhash(const void *key, size_t len);
+
+/**
+ * Returns the key hash function for one of the PERS_COM_KEY_HASH_* algorithm identifiers
+ * or NULL if the algorithm is unknown
+ */
+pcoKeyHashFunc pcoGetKeyHashFunc(unsigned int algorithm);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYHASH_H */
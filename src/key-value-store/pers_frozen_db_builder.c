@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * Copyright
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           pers_frozen_db_builder.c
+ * @ingroup        Persistence key value store
+ * @brief          Offline tool which converts a database into a frozen image (see frozendb.h)
+ * @see
+ */
+
+/*
+ * The keys and values of the source database are read with the database access API and written as frozen image.
+ * persComDbOpen opens the frozen image instead of a database, so the source file can be replaced by the image
+ * for read-only data like the factory and configurable default data.
+ * Database files of version 2.x (like baseline .itz files) are read with the reader of version 2.x instead,
+ * as opening them would convert them to the current version.
+ *
+ * usage: pers_frozen_db_builder <source database> <frozen image>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dlt.h>
+#include "persComDbAccess.h"
+#include "persComErrors.h"
+#include "./database/frozendb.h"
+#include "./database/kissdb.h"
+
+
+/* reads all keys and values of the database, returns the number of items or a negative value in case of error */
+static int readItems(int handle, char** keyList, FrozenDB_Item_s** items)
+{
+   char* key;
+   char* value;
+   int listSize = persComDbGetSizeKeysList(handle);
+   int count = 0;
+   int size;
+
+   *keyList = NULL;
+   *items = NULL;
+   if (listSize <= 0)
+   {
+      return listSize;
+   }
+   *keyList = (char*) malloc((size_t) listSize);
+   if (*keyList == NULL || persComDbGetKeysList(handle, *keyList, listSize) != listSize)
+   {
+      return PERS_COM_FAILURE;
+   }
+   for (key = *keyList; key < *keyList + listSize; key += strlen(key) + 1)
+   {
+      count++;
+   }
+   *items = (FrozenDB_Item_s*) calloc((size_t) count, sizeof(FrozenDB_Item_s));
+   if (*items == NULL)
+   {
+      return PERS_COM_ERR_MALLOC;
+   }
+
+   count = 0;
+   for (key = *keyList; key < *keyList + listSize; key += strlen(key) + 1)
+   {
+      size = persComDbGetKeySize(handle, key);
+      value = (size > 0) ? (char*) malloc((size_t) size) : NULL;
+      if (size < 0 || (size > 0 && (value == NULL || persComDbReadKey(handle, key, value, size) != size)))
+      {
+         printf("failed to read key <%s>\n", key);
+         free(value);
+         return PERS_COM_FAILURE;
+      }
+      (*items)[count].key = key;
+      (*items)[count].value = value;
+      (*items)[count].valueSize = (uint32_t) size;
+      count++;
+   }
+   return count;
+}
+
+
+int main(int argc, char* argv[])
+{
+   FrozenDB_Item_s* items = NULL;
+   char* keyList = NULL;
+   int handle;
+   int count;
+   int maxValueSize;
+   int ret = EXIT_FAILURE;
+   int i;
+
+   if (argc != 3)
+   {
+      printf("usage: %s <source database> <frozen image>\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   DLT_REGISTER_APP("PCOf", "frozen image builder of the persistence common object library");
+
+   if (KISSDB_getFileVersion(argv[1]) == KISSDB_MAJOR_VERSION_2)
+   {
+      count = FROZENDB_buildFromVersion2(argv[2], argv[1]);
+      if (count < 0)
+      {
+         printf("failed to convert database <%s> of version 2.x: %d\n", argv[1], count);
+      }
+      else
+      {
+         printf("%d keys of version 2.x written to frozen image <%s>\n", count, argv[2]);
+         ret = EXIT_SUCCESS;
+      }
+      DLT_UNREGISTER_APP();
+      return ret;
+   }
+
+   handle = persComDbOpen(argv[1], 0x4); //read only
+   if (handle < 0)
+   {
+      printf("failed to open database <%s>: %d\n", argv[1], handle);
+   }
+   else
+   {
+      maxValueSize = persComDbGetMaxValueSize(handle);
+      count = readItems(handle, &keyList, &items);
+      if (count < 0 || maxValueSize < 0)
+      {
+         printf("failed to read database <%s>: %d\n", argv[1], count);
+      }
+      else if (FROZENDB_build(argv[2], items, (uint32_t) count, (uint32_t) maxValueSize) != 0)
+      {
+         printf("failed to write frozen image <%s>\n", argv[2]);
+      }
+      else
+      {
+         printf("%d keys written to frozen image <%s>\n", count, argv[2]);
+         ret = EXIT_SUCCESS;
+      }
+      for (i = 0; items != NULL && i < count; i++)
+      {
+         free((void*) items[i].value);
+      }
+      free(items);
+      free(keyList);
+      (void) persComDbClose(handle);
+   }
+
+   DLT_UNREGISTER_APP();
+   return ret;
+}
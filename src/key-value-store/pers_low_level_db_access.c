@@ -24,7 +24,9 @@
 #include <sys/mman.h>
 #include <unistd.h>
 #include "./database/kissdb.h"
+#include "./database/frozendb.h"
 #include "./hashtable/qlibc.h"
+#include "./compress.h"
 #include <inttypes.h>
 #include "persComTypes.h"
 #include "persComErrors.h"
@@ -36,6 +38,9 @@
 #include <errno.h>
 #include <sys/time.h>
 #include <sys/shm.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 
 
 /* #define PFS_TEST */
@@ -54,17 +59,16 @@ DLT_DECLARE_CONTEXT   (persComLldbDLTCtx)
 
 #define SEM_TIMEDWAIT_TIMEOUT                      5        // wait for seconds until sem_timedwait fails
 
+#define PERS_LLDB_COMPRESS_MIN_SIZE               64        /* smaller data is never compressed */
+
+#define PERS_LLDB_VERSION2_IMAGE_DIR      "/dev/shm"        /* frozen images of read only files of version 2.x are built here */
 
-typedef struct
-{
-   char m_data[PERS_DB_MAX_SIZE_KEY_DATA];
-   uint32_t m_dataSize;
-} Data_LocalDB_s;
 
 typedef enum pers_lldb_cache_flag_e
 {
    CachedDataDelete = 0, /* Resource-Configuration-Table */
-   CachedDataWrite /* Local/Shared DB */
+   CachedDataWrite, /* Local/Shared DB */
+   CachedDataWriteCompressed /* Local/Shared DB: the cached data is a compressed value (see compress.h) */
 } pers_lldb_cache_flag_e;
 
 typedef struct
@@ -81,12 +85,28 @@ typedef struct
    char m_data[sizeof(PersistenceConfigurationKey_s)];
 } Data_Cached_RCT_s;
 
+/* position of the key cursor of a handle: the keys in cache are returned first, then the keys in the database file */
+typedef struct
+{
+   bool_t bOpen;
+   bool_t bInFile; /* all keys in cache were returned */
+   int cacheIdx; /* next slot of the cache */
+   KISSDB_Iterator fileIter; /* last key returned from the database file */
+   uint32_t frozenIdx; /* next entry of a frozen image */
+   size_t prefixLen;
+   str_t prefix[PERS_DB_MAX_LENGTH_KEY_NAME];
+} lldb_cursor_s;
+
 typedef struct
 {
    bool_t bIsAssigned;
    sint_t dbHandler;
    pers_lldb_purpose_e ePurpose;
+   bool_t bCompressValues; /* values are written compressed if this saves space (open option 0x08) */
+   bool_t bFrozen; /* the file is a frozen image (see frozendb.h): read only, kissDb is not used */
    KISSDB kissDb;
+   FROZENDB frozenDb;
+   lldb_cursor_s cursor; /* see pers_lldb_iter_open */
    str_t dbPathname[PERS_ORG_MAX_LENGTH_PATH_FILENAME];
 } lldb_handler_s;
 
@@ -116,20 +136,46 @@ static struct timespec gSemWaitTimeout;
 /* ---------------------- local functions  --------------------------------- */
 static sint_t DeleteDataFromKissDB(sint_t dbHandler, pconststr_t key);
 //static sint_t DeleteDataFromKissRCT(sint_t dbHandler, pconststr_t key);
+static sint_t CompactKissDB(sint_t dbHandler);
 static sint_t GetAllKeysFromKissLocalDB(sint_t dbHandler, pstr_t buffer, sint_t size);
 static sint_t GetAllKeysFromKissRCT(sint_t dbHandler, pstr_t buffer, sint_t size);
 static sint_t GetKeySizeFromKissLocalDB(sint_t dbHandler, pconststr_t key);
+static sint_t OpenKissKeyCursor(sint_t dbHandler, pers_lldb_purpose_e ePurpose, pconststr_t prefix);
+static sint_t GetNextKeyFromKissCursor(sint_t dbHandler, pers_lldb_purpose_e ePurpose, pstr_t buffer_out, sint_t bufSize);
+static sint_t CloseKissKeyCursor(sint_t dbHandler, pers_lldb_purpose_e ePurpose);
 static sint_t GetDataFromKissLocalDB(sint_t dbHandler, pconststr_t key, pstr_t buffer_out, sint_t bufSize);
+static sint_t GetDataFromKissLocalDBBatch(sint_t dbHandler, pconststr_t const* keys, pstr_t const* buffers_out, sint_t const* bufSizes, sint_t* results_out, sint_t count);
 static sint_t GetDataFromKissRCT(sint_t dbHandler, pconststr_t key, PersistenceConfigurationKey_s* pConfig);
+static sint_t GetViewFromKissLocalDB(sint_t dbHandler, pconststr_t key, void const** data_out);
+static sint_t ReleaseViewFromKissLocalDB(sint_t dbHandler, void const* data);
 static sint_t SetDataInKissLocalDB(sint_t dbHandler, pconststr_t key, pconststr_t data, sint_t dataSize);
+static sint_t SetDataInKissLocalDBBatch(sint_t dbHandler, pconststr_t const* keys, pconststr_t const* data, sint_t const* dataSizes, sint_t count);
 static sint_t SetDataInKissRCT(sint_t dbHandler, pconststr_t key, PersistenceConfigurationKey_s const* pConfig);
 static sint_t writeBackKissDB(KISSDB* db, lldb_handler_s* pLldbHandler);
 static sint_t writeBackKissRCT(KISSDB* db, lldb_handler_s* pLldbHandler);
-static sint_t getListandSize(KISSDB* db, pstr_t buffer, sint_t size, bool_t bOnlySizeNeeded, pers_lldb_purpose_e purpose);
-static sint_t putToCache(KISSDB* db, sint_t dataSize, char* metaKey, void* cachedData);
-static sint_t deleteFromCache(KISSDB* db, char* metaKey);
-static sint_t getFromCache(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize, bool_t sizeOnly);
-static sint_t getFromDatabaseFile(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize);
+static sint_t getListandSize(KISSDB* db, pstr_t buffer, sint_t size, bool_t bOnlySizeNeeded);
+static sint_t appendKeyToList(const char* key, size_t keyLen, pstr_t* buffer, sint_t* availableSize, bool_t bOnlySizeNeeded);
+static sint_t openFrozenDb(lldb_handler_s* pLldbHandler, pers_lldb_purpose_e ePurpose, str_t const* path, int frozenState);
+static sint_t writeVersion2Items(sint_t handlerDB, pers_lldb_purpose_e ePurpose, const FrozenDB_Item_s* items, uint32_t count);
+static sint_t convertVersion2Db(str_t const* dbPathname, pers_lldb_purpose_e ePurpose);
+static sint_t openVersion2Db(lldb_handler_s* pLldbHandler, pers_lldb_purpose_e ePurpose, str_t const* path);
+static sint_t getFromFrozenDb(FROZENDB* db, pconststr_t key, void* readBuffer, sint_t bufsize);
+static sint_t getFrozenListandSize(FROZENDB* db, pstr_t buffer, sint_t size, bool_t bOnlySizeNeeded);
+static sint_t getNextCursorKey(KISSDB* db, lldb_cursor_s* cursor, str_t* key);
+static sint_t getNextFrozenCursorKey(FROZENDB* db, lldb_cursor_s* cursor, str_t* key);
+static sint_t getCopyView(KISSDB* db, pconststr_t key, uint64_t hash, bool_t bCached, sint_t size, void const** data_out);
+static sint_t putToCache(KISSDB* db, sint_t dataSize, char* metaKey, uint64_t hash, void* cachedData);
+static sint_t deleteFromCache(KISSDB* db, char* metaKey, uint64_t hash);
+static sint_t getFromCache(KISSDB* db, void* metaKey, uint64_t hash, void* readBuffer, sint_t bufsize, bool_t sizeOnly);
+static sint_t getFromDatabaseFile(KISSDB* db, void* metaKey, uint64_t hash, void* readBuffer, sint_t bufsize);
+static sint_t getCompressedFromDatabaseFile(KISSDB* db, void* metaKey, uint64_t hash, uint32_t size, void* readBuffer, sint_t bufsize);
+static sint_t getFromDatabaseFileBatch(KISSDB* db, pconststr_t const* keys, pstr_t const* buffers_out, sint_t const* bufSizes, sint_t* results_out, sint_t count);
+static sint_t putToDatabaseFile(KISSDB* db, char* metaKey, uint64_t hash, pconststr_t data, sint_t dataSize, uint32_t valueFlags);
+static sint_t compressValue(lldb_handler_s* pLldbHandler, pconststr_t data, sint_t dataSize, char** compressed, uint32_t* valueFlags);
+static sint_t putToKissLocalDB(lldb_handler_s* pLldbHandler, pconststr_t key, uint64_t hash, pconststr_t storedData, sint_t storedSize, uint32_t valueFlags);
+static bool_t isKeyListed(KISSDB* db, pconststr_t key, uint64_t hash);
+static void updateKeyList(KISSDB* db, pconststr_t key, bool_t bListedBefore, bool_t bListedAfter);
+static uint32_t getCacheHash(uint64_t hash);
 
 /* access to resources shared by the threads within a process */
 static bool_t lldb_handles_InitLock(pthread_mutex_t *mutex);
@@ -177,6 +223,24 @@ static void pco_library_destroy()
  * \return >=0 for success, negative value otherway (see pers_error_codes.h)
  */
 sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, bool_t bForceCreationIfNotPresent)
+{
+   sint_t maxValueSize = (PersLldbPurpose_RCT == ePurpose) ? (sint_t) sizeof(PersistenceConfigurationKey_s) : PERS_DB_MAX_SIZE_KEY_DATA;
+
+   return pers_lldb_open_with_max_value_size(dbPathname, ePurpose, bForceCreationIfNotPresent, maxValueSize);
+}
+
+/**
+ * \open or create a key-value database with a maximum value size
+ * \note : the maximum value size is stored when the DB is created, an existing DB keeps its maximum value size
+ *
+ * \param dbPathname                    [in] absolute path to DB
+ * \param ePurpose                      [in] see pers_lldb_purpose_e
+ * \param bForceCreationIfNotPresent    [in] if true, the DB is created if it does not exist
+ * \param maxValueSize                  [in] maximum size of a key's data in a created DB
+ *
+ * \return >=0 for success, negative value otherway (see pers_error_codes.h)
+ */
+sint_t pers_lldb_open_with_max_value_size(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, bool_t bForceCreationIfNotPresent, sint_t maxValueSize)
 {
    bool_t bCanContinue = true;
    bool_t bLocked = false;
@@ -184,9 +248,11 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
    const char* path;
    int error = 0;
    int kdbState = 0;
+   int frozenState = 0;
    int openMode  = KISSDB_OPEN_MODE_RDWR; //default is open existing in RDWR
    int writeMode = KISSDB_WRITE_MODE_WC;  //default is write cached
    int incRefCounter = 1;  // default increment counter
+   bool_t bCompressValues = false; //default is uncompressed values
    lldb_handler_s* pLldbHandler = NIL;
    sint_t returnValue = PERS_COM_FAILURE;
 
@@ -196,6 +262,12 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
            DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING("Begin opening:"); DLT_STRING("<"); DLT_STRING(dbPathname); DLT_STRING(">, ");
            ((PersLldbPurpose_RCT == ePurpose) ? DLT_STRING("RCT, ") : DLT_STRING("DB, ")); ((true == bForceCreationIfNotPresent) ? DLT_STRING("forced, ") : DLT_STRING("unforced, ")));
 
+   //a file of version 2.x is converted by its first writable open, before the handle of the converted file is taken
+   if (!(bForceCreationIfNotPresent & (1 << 2)) && convertVersion2Db(dbPathname, ePurpose) < 0)
+   {
+      return PERS_COM_FAILURE;
+   }
+
    pLldbHandler = lldb_handles_FindAvailableHandle();
    if (NIL == pLldbHandler)
    {
@@ -205,7 +277,7 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
    if (bCanContinue)
    {
       size_t datasize = (PersLldbPurpose_RCT == ePurpose) ? sizeof(PersistenceConfigurationKey_s) :
-                        PERS_DB_MAX_SIZE_KEY_DATA;
+                        (size_t) maxValueSize;
       size_t keysize = (PersLldbPurpose_RCT == ePurpose) ? PERS_RCT_MAX_LENGTH_RESOURCE_ID :
                        PERS_DB_MAX_LENGTH_KEY_NAME;
 
@@ -226,6 +298,12 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
          DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO, DLT_STRING(LT_HDR), DLT_STRING(__FUNCTION__), DLT_STRING("Opening in read only mode:"), DLT_STRING("<"),
                  DLT_STRING(dbPathname), DLT_STRING(">, "));
       }
+      if ((PersLldbPurpose_DB == ePurpose) && (bForceCreationIfNotPresent & (1 << 3))) //check bit 3
+      {
+         bCompressValues = true; //bit 3 is set 0x8
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO, DLT_STRING(LT_HDR), DLT_STRING(__FUNCTION__), DLT_STRING("Opening with value compression:"), DLT_STRING("<"),
+                 DLT_STRING(dbPathname), DLT_STRING(">, "));
+      }
 
 
       if (1 == checkIsLink(dbPathname, linkBuffer))
@@ -237,6 +315,18 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
          path = dbPathname;
       }
 
+      frozenState = FROZENDB_open(&pLldbHandler->frozenDb, path);
+      if (frozenState != FROZENDB_ERROR_NOT_FROZEN)
+      {
+         //frozen image of default data: no semaphore, shared memory or locks are needed
+         return openFrozenDb(pLldbHandler, ePurpose, path, frozenState);
+      }
+      if (KISSDB_OPEN_MODE_RDONLY == openMode && KISSDB_getFileVersion(path) == KISSDB_MAJOR_VERSION_2)
+      {
+         //the file is not converted, its keys are served from a frozen image
+         return openVersion2Db(pLldbHandler, ePurpose, path);
+      }
+
       //printKdb(&pLldbHandler->kissDb);
 
       if (pLldbHandler->kissDb.alreadyOpen == Kdb_false) //check if this instance has already opened the db before
@@ -364,6 +454,8 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
    if (bCanContinue)
    {
       lldb_handles_InitHandle(pLldbHandler, ePurpose, path);
+      pLldbHandler->bCompressValues = bCompressValues;
+      pLldbHandler->bFrozen = false;
       returnValue = pLldbHandler->dbHandler;
    }
    else
@@ -436,7 +528,16 @@ sint_t pers_lldb_close(sint_t handlerDB)
       returnValue = PERS_COM_ERR_INVALID_PARAM;
    }
 
-   if (PERS_COM_SUCCESS == returnValue)
+   if ((PERS_COM_SUCCESS == returnValue) && pLldbHandler->bFrozen)
+   {
+      FROZENDB_close(&pLldbHandler->frozenDb);
+      pLldbHandler->bFrozen = false;
+      if (!lldb_handles_DeinitHandle(pLldbHandler->dbHandler))
+      {
+         returnValue = PERS_COM_FAILURE;
+      }
+   }
+   else if (PERS_COM_SUCCESS == returnValue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
       if (lldb_handles_Lock(&db->shared->mutex))
@@ -615,6 +716,7 @@ static sint_t writeBackKissRCT(KISSDB* db, lldb_handler_s* pLldbHandler)
    pers_lldb_cache_flag_e eFlag;
    qnobj_t obj;
    sint_t returnValue = PERS_COM_SUCCESS;
+   uint64_t hash = 0;
 
    DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO, DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("START writeback for RCT: "),
            DLT_STRING(pLldbHandler->dbPathname));
@@ -627,13 +729,14 @@ static sint_t writeBackKissRCT(KISSDB* db, lldb_handler_s* pLldbHandler)
       eFlag = (pers_lldb_cache_flag_e) *(int*) ptr;
       ptr += 2 * (sizeof(int));
       metaKey = obj.name;
+      hash = KISSDB_getKeyHash(&pLldbHandler->kissDb, metaKey);
 
       //check how data should be persisted
       switch (eFlag)
       {
          case CachedDataDelete:  //data must be deleted from file
          {
-            kdbState = KISSDB_delete(&pLldbHandler->kissDb, metaKey, &bytesDeleted);
+            kdbState = KISSDB_delete(&pLldbHandler->kissDb, metaKey, hash, &bytesDeleted);
             if (kdbState != 0)
             {
                if (kdbState == 1)
@@ -652,7 +755,7 @@ static sint_t writeBackKissRCT(KISSDB* db, lldb_handler_s* pLldbHandler)
          }
          case CachedDataWrite:   //data must be written to file
          {
-            kdbState = KISSDB_put(&pLldbHandler->kissDb, metaKey, ptr, sizeof(PersistenceConfigurationKey_s), &bytesWritten);
+            kdbState = KISSDB_put(&pLldbHandler->kissDb, metaKey, hash, ptr, sizeof(PersistenceConfigurationKey_s), 0, &bytesWritten);
             if (kdbState != 0)
             {
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
@@ -686,7 +789,6 @@ static sint_t writeBackKissDB(KISSDB* db, lldb_handler_s* pLldbHandler)
 {
    char* metaKey;
    char* ptr;
-   Data_LocalDB_s insert = {{0},0};
    int datasize = 0;
    int idx = 0;
    int kdbState = 0;
@@ -695,6 +797,7 @@ static sint_t writeBackKissDB(KISSDB* db, lldb_handler_s* pLldbHandler)
    pers_lldb_cache_flag_e eFlag;
    qnobj_t obj;
    sint_t returnValue = PERS_COM_SUCCESS;
+   uint64_t hash = 0;
 
    DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO, DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("START writeback for DB: "),
            DLT_STRING(pLldbHandler->dbPathname));
@@ -710,6 +813,7 @@ static sint_t writeBackKissDB(KISSDB* db, lldb_handler_s* pLldbHandler)
       datasize = *(int*) ptr; //pointer in obj.data to datasize
       ptr += sizeof(int);     //pointer in obj.data to data
       metaKey = obj.name;
+      hash = KISSDB_getKeyHash(&pLldbHandler->kissDb, metaKey);
 
       //check how data should be persisted
       switch (eFlag)
@@ -717,7 +821,7 @@ static sint_t writeBackKissDB(KISSDB* db, lldb_handler_s* pLldbHandler)
          case CachedDataDelete:  //data must be deleted from file
          {
             //delete key-value pair from database file
-            kdbState = KISSDB_delete(&pLldbHandler->kissDb, metaKey, &bytesDeleted);
+            kdbState = KISSDB_delete(&pLldbHandler->kissDb, metaKey, hash, &bytesDeleted);
             if (kdbState != 0)
             {
                if (kdbState == 1)
@@ -736,10 +840,10 @@ static sint_t writeBackKissDB(KISSDB* db, lldb_handler_s* pLldbHandler)
             break;
          }
          case CachedDataWrite:  //data must be written to file
+         case CachedDataWriteCompressed:
          {
-            (void) memcpy(insert.m_data, ptr, datasize);
-            insert.m_dataSize = datasize;
-            kdbState = KISSDB_put(&pLldbHandler->kissDb, metaKey, &insert, insert.m_dataSize, &bytesWritten); //store data followed by datasize
+            kdbState = KISSDB_put(&pLldbHandler->kissDb, metaKey, hash, ptr, datasize,
+                                  (eFlag == CachedDataWriteCompressed) ? KISSDB_VALUE_COMPRESSED : 0, &bytesWritten);
             if (kdbState != 0)
             {
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
@@ -798,6 +902,39 @@ sint_t pers_lldb_write_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
    return eErrorCode;
 }
 
+/**
+ * \brief write several key-value pairs into database with one lock of the database
+ * \note : in write through mode the database file is synced once for all keys
+ *
+ * \param handlerDB     [in] handler obtained with pers_lldb_open
+ * \param ePurpose      [in] see pers_lldb_purpose_e
+ * \param keys          [in] keys' names
+ * \param data          [in] buffers with keys' data
+ * \param dataSizes     [in] sizes of keys' data
+ * \param count         [in] number of keys
+ *
+ * \return number of written keys, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_write_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* const* keys, str_t const* const* data, sint_t const* dataSizes, sint_t count)
+{
+   sint_t eErrorCode = PERS_COM_SUCCESS;
+
+   switch (ePurpose)
+   {
+      case PersLldbPurpose_DB:
+      {
+         eErrorCode = SetDataInKissLocalDBBatch(handlerDB, keys, data, dataSizes, count);
+         break;
+      }
+      default:
+      {
+         eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+         break;
+      }
+   }
+   return eErrorCode;
+}
+
 /**
  * \brief read a key's value from database
  * \note : DB type is identified from dbPathname (based on extension)
@@ -835,6 +972,101 @@ sint_t pers_lldb_read_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
    return eErrorCode;
 }
 
+/**
+ * \brief read the values of several keys from database with one lock of the database
+ * \note : a key which is not found or does not fit into its buffer does not fail the other keys
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param keys              [in] keys' names
+ * \param dataBuffers_out   [out]buffers where to return the read data
+ * \param bufSizes          [in] sizes of dataBuffers_out
+ * \param results_out       [out]read size, or negative value (see pers_error_codes.h) of every key
+ * \param count             [in] number of keys
+ *
+ * \return number of keys read, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* const* keys, pstr_t const* dataBuffers_out, sint_t const* bufSizes,
+                           sint_t* results_out, sint_t count)
+{
+   sint_t eErrorCode = PERS_COM_SUCCESS;
+
+   switch (ePurpose)
+   {
+      case PersLldbPurpose_DB:
+      {
+         eErrorCode = GetDataFromKissLocalDBBatch(handlerDB, keys, dataBuffers_out, bufSizes, results_out, count);
+         break;
+      }
+      default:
+      {
+         eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+         break;
+      }
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief returns a read-only view of a key's value instead of copying it
+ * \note : the view stays valid until it is released with pers_lldb_release_view
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param key               [in] key's name
+ * \param data_out          [out]returns the address of the value
+ *
+ * \return size of the value, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_key_view(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* key, void const** data_out)
+{
+   sint_t eErrorCode = PERS_COM_SUCCESS;
+
+   switch (ePurpose)
+   {
+      case PersLldbPurpose_DB:
+      {
+         eErrorCode = GetViewFromKissLocalDB(handlerDB, key, data_out);
+         break;
+      }
+      default:
+      {
+         eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+         break;
+      }
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief releases a view returned by pers_lldb_read_key_view
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param data              [in] address returned by pers_lldb_read_key_view
+ *
+ * \return 0 for success, negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_release_view(sint_t handlerDB, pers_lldb_purpose_e ePurpose, void const* data)
+{
+   sint_t eErrorCode = PERS_COM_SUCCESS;
+
+   switch (ePurpose)
+   {
+      case PersLldbPurpose_DB:
+      {
+         eErrorCode = ReleaseViewFromKissLocalDB(handlerDB, data);
+         break;
+      }
+      default:
+      {
+         eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+         break;
+      }
+   }
+   return eErrorCode;
+}
+
 /**
  * \brief reads the size of a value that corresponds to a key
  * \note : DB type is identified from dbPathname (based on extension)
@@ -967,9 +1199,160 @@ sint_t pers_lldb_get_keys_list(sint_t handlerDB, pers_lldb_purpose_e ePurpose, p
    return eErrorCode;
 }
 
+/**
+ * \brief Open the key cursor of a handle
+ * \note : every handle has one cursor, opening it again restarts the listing
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param prefix            [in] only keys starting with prefix are returned, NIL for all keys
+ *
+ * \return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_iter_open(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* prefix)
+{
+   sint_t eErrorCode = PERS_COM_SUCCESS;
+
+   switch (ePurpose)
+   {
+      case PersLldbPurpose_DB:
+      case PersLldbPurpose_RCT:
+      {
+         eErrorCode = OpenKissKeyCursor(handlerDB, ePurpose, prefix);
+         break;
+      }
+      default:
+      {
+         eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+         break;
+      }
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief Return the next key of the cursor opened with pers_lldb_iter_open
+ * \note : keys written or deleted while the cursor is open may or may not be returned
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param keyBuffer_out     [out]buffer where to return the key (null terminated)
+ * \param bufSize           [in] size of keyBuffer_out
+ *
+ * \return length of the key, 0 if all keys were returned, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_iter_next(sint_t handlerDB, pers_lldb_purpose_e ePurpose, pstr_t keyBuffer_out, sint_t bufSize)
+{
+   sint_t eErrorCode = PERS_COM_SUCCESS;
+
+   switch (ePurpose)
+   {
+      case PersLldbPurpose_DB:
+      case PersLldbPurpose_RCT:
+      {
+         eErrorCode = GetNextKeyFromKissCursor(handlerDB, ePurpose, keyBuffer_out, bufSize);
+         break;
+      }
+      default:
+      {
+         eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+         break;
+      }
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief Close the key cursor of a handle
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ *
+ * \return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_iter_close(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+   sint_t eErrorCode = PERS_COM_SUCCESS;
+
+   switch (ePurpose)
+   {
+      case PersLldbPurpose_DB:
+      case PersLldbPurpose_RCT:
+      {
+         eErrorCode = CloseKissKeyCursor(handlerDB, ePurpose);
+         break;
+      }
+      default:
+      {
+         eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+         break;
+      }
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief Compact the database file: the data of all keys is moved to the start of the file and the file is truncated
+ * \note : can be called while the database is opened by other processes
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ *
+ * \return number of bytes the file was reduced by, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_compact(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+   sint_t eErrorCode = PERS_COM_SUCCESS;
+
+   switch (ePurpose)
+   {
+      case PersLldbPurpose_DB:
+      case PersLldbPurpose_RCT:
+      {
+         eErrorCode = CompactKissDB(handlerDB);
+         break;
+      }
+      default:
+      {
+         eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+         break;
+      }
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief Get the maximum size of a key's data in the database
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ *
+ * \return maximum size, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_get_max_value_size(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+   lldb_handler_s* pLldbHandler = NIL;
+
+   if ((handlerDB < 0) || (ePurpose >= PersLldbPurpose_LastEntry))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   pLldbHandler = lldb_handles_FindInUseHandle(handlerDB);
+   if ((NIL == pLldbHandler) || (ePurpose != pLldbHandler->ePurpose))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   if (pLldbHandler->bFrozen)
+   {
+      return (sint_t) pLldbHandler->frozenDb.header->maxValueSize;
+   }
+   return (sint_t) pLldbHandler->kissDb.valSize; //read from the header when the database was opened
+}
+
 static sint_t DeleteDataFromKissDB(sint_t dbHandler, pconststr_t key)
 {
    bool_t bCanContinue = true;
+   bool_t bListed = false;
    bool_t bLocked = false;
    int kdbState = 0;
    lldb_handler_s* pLldbHandler = NIL;
@@ -985,6 +1368,11 @@ static sint_t DeleteDataFromKissDB(sint_t dbHandler, pconststr_t key)
       {
          bCanContinue = false;
       }
+      else if (pLldbHandler->bFrozen)
+      {
+         bCanContinue = false;
+         bytesDeleted = PERS_COM_ERR_READONLY;
+      }
    }
    else
    {
@@ -994,20 +1382,22 @@ static sint_t DeleteDataFromKissDB(sint_t dbHandler, pconststr_t key)
    if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
+      uint64_t hash = KISSDB_getKeyHash(db, key);
       if (lldb_handles_Lock(&db->shared->mutex))
       {
          bLocked = true;
       }
 
       Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
+      bListed = isKeyListed(db, key, hash);
       if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
       {
-         bytesDeleted = deleteFromCache(&pLldbHandler->kissDb, (char*) key);
+         bytesDeleted = deleteFromCache(&pLldbHandler->kissDb, (char*) key, hash);
       }
       else //write through
       {
 
-         kdbState = KISSDB_delete(&pLldbHandler->kissDb, key, &bytesDeleted);
+         kdbState = KISSDB_delete(&pLldbHandler->kissDb, key, hash, &bytesDeleted);
          if (kdbState != 0)
          {
             if (kdbState == 1)
@@ -1031,6 +1421,8 @@ static sint_t DeleteDataFromKissDB(sint_t dbHandler, pconststr_t key)
          fdatasync(pLldbHandler->kissDb.fd);
 #endif
       }
+      //a deleted key is not listed anymore, a failed delete leaves the key as it was
+      updateKeyList(db, key, bListed, bListed && !((kdbState == 0) && (bytesDeleted >= 0)));
       Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
    }
 
@@ -1066,7 +1458,12 @@ static sint_t DeleteDataFromKissRCT(sint_t dbHandler, pconststr_t key)
       {
          bCanContinue = false;
       }
-   }
+      else if (pLldbHandler->bFrozen)
+      {
+         bCanContinue = false;
+         bytesDeleted = PERS_COM_ERR_READONLY;
+      }
+   }
    else
    {
       bCanContinue = false;
@@ -1127,6 +1524,196 @@ static sint_t DeleteDataFromKissRCT(sint_t dbHandler, pconststr_t key)
 }
 #endif
 
+static sint_t CompactKissDB(sint_t dbHandler)
+{
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   int kdbState = 0;
+   int64_t bytesReclaimed = 0;
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t result = PERS_COM_SUCCESS;
+
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("handlerDB="); DLT_INT(dbHandler));
+
+   if (dbHandler >= 0)
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
+      {
+         bCanContinue = false;
+         result = PERS_COM_ERR_INVALID_PARAM;
+      }
+      else if (pLldbHandler->bFrozen)
+      {
+         bCanContinue = false;
+         result = PERS_COM_ERR_READONLY;
+      }
+   }
+   else
+   {
+      bCanContinue = false;
+      result = PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      if (lldb_handles_Lock(&db->shared->mutex))
+      {
+         bLocked = true;
+      }
+
+      Kdb_wrlock(&db->shared->rwlock);
+      if (KISSDB_OPEN_MODE_RDONLY == db->shared->openMode)
+      {
+         result = PERS_COM_ERR_READONLY;
+      }
+      else
+      {
+         kdbState = KISSDB_compact(db, &bytesReclaimed);
+         if (kdbState != 0)
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                    DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_compact: Error with retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
+            result = PERS_COM_FAILURE;
+         }
+         else
+         {
+            result = (sint_t) bytesReclaimed;
+         }
+#if USE_FSYNC
+         fsync(db->fd);
+#else
+         fdatasync(db->fd);
+#endif
+      }
+      Kdb_unlock(&db->shared->rwlock);
+   }
+
+   if (bLocked)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex);
+   }
+
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("handlerDB="); DLT_INT(dbHandler); DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
+   return result;
+}
+
+static sint_t OpenKissKeyCursor(sint_t dbHandler, pers_lldb_purpose_e ePurpose, pconststr_t prefix)
+{
+   lldb_handler_s* pLldbHandler = NIL;
+   lldb_cursor_s* cursor = NIL;
+
+   if ((dbHandler < 0) || ((NIL != prefix) && (strlen(prefix) >= PERS_DB_MAX_LENGTH_KEY_NAME)))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+   if (NIL == pLldbHandler)
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   if (ePurpose != pLldbHandler->ePurpose)
+   {
+      return PERS_COM_FAILURE;
+   }
+
+   cursor = &pLldbHandler->cursor;
+   cursor->bOpen = true;
+   cursor->bInFile = false;
+   cursor->cacheIdx = 0;
+   cursor->frozenIdx = 0;
+   cursor->prefixLen = (NIL != prefix) ? strlen(prefix) : 0;
+   (void) memcpy(cursor->prefix, (NIL != prefix) ? prefix : "", cursor->prefixLen + 1);
+   if (!pLldbHandler->bFrozen)
+   {
+      KISSDB_Iterator_init(&pLldbHandler->kissDb, &cursor->fileIter);
+   }
+   return PERS_COM_SUCCESS;
+}
+
+/*
+ * every call locks the database once, the key is copied from the cache or the database file without allocating memory
+ */
+static sint_t GetNextKeyFromKissCursor(sint_t dbHandler, pers_lldb_purpose_e ePurpose, pstr_t buffer_out, sint_t bufSize)
+{
+   bool_t bLocked = false;
+   lldb_handler_s* pLldbHandler = NIL;
+   lldb_cursor_s position;
+   sint_t result = PERS_COM_FAILURE;
+   str_t key[PERS_DB_MAX_LENGTH_KEY_NAME];
+
+   if ((dbHandler < 0) || (NIL == buffer_out) || (bufSize <= 0))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+   if ((NIL == pLldbHandler) || !pLldbHandler->cursor.bOpen)
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   if (ePurpose != pLldbHandler->ePurpose)
+   {
+      return PERS_COM_FAILURE;
+   }
+
+   position = pLldbHandler->cursor;
+   if (pLldbHandler->bFrozen)
+   {
+      result = getNextFrozenCursorKey(&pLldbHandler->frozenDb, &pLldbHandler->cursor, key);
+   }
+   else
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      if (lldb_handles_Lock(&db->shared->mutex))
+      {
+         bLocked = true;
+      }
+      Kdb_wrlock(&db->shared->rwlock);
+      result = getNextCursorKey(db, &pLldbHandler->cursor, key);
+      Kdb_unlock(&db->shared->rwlock);
+      if (bLocked)
+      {
+         (void) lldb_handles_Unlock(&db->shared->mutex);
+      }
+   }
+
+   if (result >= bufSize) //the cursor stays at the key, so it can be read with a larger buffer
+   {
+      pLldbHandler->cursor = position;
+      result = PERS_COM_ERR_BUFFER_TOO_SMALL;
+   }
+   else if (result > 0)
+   {
+      (void) memcpy(buffer_out, key, (size_t) result + 1);
+   }
+   return result;
+}
+
+static sint_t CloseKissKeyCursor(sint_t dbHandler, pers_lldb_purpose_e ePurpose)
+{
+   lldb_handler_s* pLldbHandler = NIL;
+
+   if (dbHandler < 0)
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+   if ((NIL == pLldbHandler) || !pLldbHandler->cursor.bOpen)
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   if (ePurpose != pLldbHandler->ePurpose)
+   {
+      return PERS_COM_FAILURE;
+   }
+   pLldbHandler->cursor.bOpen = false;
+   return PERS_COM_SUCCESS;
+}
+
 static sint_t GetAllKeysFromKissLocalDB(sint_t dbHandler, pstr_t buffer, sint_t size)
 {
    bool_t bCanContinue = true;
@@ -1134,6 +1721,7 @@ static sint_t GetAllKeysFromKissLocalDB(sint_t dbHandler, pstr_t buffer, sint_t
    bool_t bOnlySizeNeeded = (NIL == buffer);
    lldb_handler_s* pLldbHandler = NIL;
    sint_t result = 0;
+   sint_t keyCount = 0;
 
    DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
    DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("buffer="); DLT_UINT((uint_t)buffer); DLT_STRING("size="); DLT_INT(size));
@@ -1163,7 +1751,15 @@ static sint_t GetAllKeysFromKissLocalDB(sint_t dbHandler, pstr_t buffer, sint_t
       result = PERS_COM_ERR_INVALID_PARAM;
    }
 
-   if (bCanContinue)
+   if (bCanContinue && pLldbHandler->bFrozen)
+   {
+      if ((buffer != NIL) && (size > 0))
+      {
+         (void) memset(buffer, 0, (size_t) size);
+      }
+      result = getFrozenListandSize(&pLldbHandler->frozenDb, buffer, size, bOnlySizeNeeded);
+   }
+   else if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
       if (lldb_handles_Lock(&db->shared->mutex))
@@ -1177,7 +1773,8 @@ static sint_t GetAllKeysFromKissLocalDB(sint_t dbHandler, pstr_t buffer, sint_t
       }
 
       Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
-      result = getListandSize(&pLldbHandler->kissDb, buffer, size, bOnlySizeNeeded, PersLldbPurpose_DB);
+      result = getListandSize(&pLldbHandler->kissDb, buffer, size, bOnlySizeNeeded);
+      keyCount = (sint_t) pLldbHandler->kissDb.shared->keyCount;
       Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
       if (result < 0)
       {
@@ -1191,7 +1788,8 @@ static sint_t GetAllKeysFromKissLocalDB(sint_t dbHandler, pstr_t buffer, sint_t
    }
 
    DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("keys=<"); DLT_INT(keyCount); DLT_STRING(">, ");
+   DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
    return result;
 }
 
@@ -1231,7 +1829,15 @@ static sint_t GetAllKeysFromKissRCT(sint_t dbHandler, pstr_t buffer, sint_t size
       result = PERS_COM_ERR_INVALID_PARAM;
    }
 
-   if (bCanContinue)
+   if (bCanContinue && pLldbHandler->bFrozen)
+   {
+      if ((buffer != NIL) && (size > 0))
+      {
+         (void) memset(buffer, 0, (size_t) size);
+      }
+      result = getFrozenListandSize(&pLldbHandler->frozenDb, buffer, size, bOnlySizeNeeded);
+   }
+   else if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
       if (lldb_handles_Lock(&db->shared->mutex))
@@ -1244,7 +1850,7 @@ static sint_t GetAllKeysFromKissRCT(sint_t dbHandler, pstr_t buffer, sint_t size
          (void) memset(buffer, 0, (size_t) size);
       }
       Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
-      result = getListandSize(&pLldbHandler->kissDb, buffer, size, bOnlySizeNeeded, PersLldbPurpose_RCT);
+      result = getListandSize(&pLldbHandler->kissDb, buffer, size, bOnlySizeNeeded);
       Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
       if (result < 0)
       {
@@ -1267,10 +1873,12 @@ static sint_t SetDataInKissLocalDB(sint_t dbHandler, pconststr_t key, pconststr_
 {
    bool_t bCanContinue = true;
    bool_t bLocked = false;
-   Data_Cached_s dataCached = { 0 };
-   int kdbState = 0;
    lldb_handler_s* pLldbHandler = NIL;
    sint_t bytesWritten = PERS_COM_FAILURE;
+   char* compressed = NIL;
+   pconststr_t storedData = data;
+   sint_t storedSize = dataSize;
+   uint32_t valueFlags = 0;
 
 
    DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
@@ -1293,6 +1901,16 @@ static sint_t SetDataInKissLocalDB(sint_t dbHandler, pconststr_t key, pconststr_
             bCanContinue = false;
             bytesWritten = PERS_COM_FAILURE;
          }
+         else if (pLldbHandler->bFrozen)
+         {
+            bCanContinue = false;
+            bytesWritten = PERS_COM_ERR_READONLY;
+         }
+         else if ((uint64_t) dataSize > pLldbHandler->kissDb.valSize) //maximum value size of the database
+         {
+            bCanContinue = false;
+            bytesWritten = PERS_COM_ERR_INVALID_PARAM;
+         }
       }
    }
    else
@@ -1304,40 +1922,33 @@ static sint_t SetDataInKissLocalDB(sint_t dbHandler, pconststr_t key, pconststr_
    if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
+      uint64_t hash = KISSDB_getKeyHash(db, key);
       if (lldb_handles_Lock(&db->shared->mutex))
       {
          bLocked = true;
       }
 
-      char* metaKey = (char*) key;
-      dataCached.eFlag = CachedDataWrite;
-      dataCached.m_dataSize = dataSize;
-      (void) memcpy(dataCached.m_data, data, (size_t) dataSize);
+      //the compressed value is stored in the cache and in the file if it is smaller than the data
+      storedSize = compressValue(pLldbHandler, data, dataSize, &compressed, &valueFlags);
+      storedData = (NIL != compressed) ? compressed : data;
 
-      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
-      if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
+      Kdb_wrlock(&db->shared->rwlock);
+      bytesWritten = putToKissLocalDB(pLldbHandler, key, hash, storedData, storedSize, valueFlags);
+      if (KISSDB_WRITE_MODE_WT == db->shared->writeMode && KISSDB_OPEN_MODE_RDONLY != db->shared->openMode)
       {
-         bytesWritten = putToCache(&pLldbHandler->kissDb, dataSize, (char*) metaKey, &dataCached);
-      }
-      else
-      {
-         if (KISSDB_OPEN_MODE_RDONLY != pLldbHandler->kissDb.shared->openMode)
-         {
-            kdbState = KISSDB_put(&pLldbHandler->kissDb, metaKey, dataCached.m_data, dataCached.m_dataSize, &bytesWritten);
-            if (kdbState != 0)
-            {
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
-                     DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_put: key=<"); DLT_STRING(metaKey); DLT_STRING(">, "); DLT_STRING("WriteThrough to file failed with retval=<"); DLT_INT(bytesWritten); DLT_STRING(">"));
-            }
-
 #if USE_FSYNC
-            fsync(pLldbHandler->kissDb.fd);
+         fsync(db->fd);
 #else
-            fdatasync(pLldbHandler->kissDb.fd);
+         fdatasync(db->fd);
 #endif
-         }
       }
-      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
+      Kdb_unlock(&db->shared->rwlock);
+
+      if (valueFlags != 0 && bytesWritten == storedSize)
+      {
+         bytesWritten = dataSize; //the size of the data is returned, not the size of the compressed value
+      }
+      free(compressed);
    }
 
    if (bLocked)
@@ -1353,9 +1964,124 @@ static sint_t SetDataInKissLocalDB(sint_t dbHandler, pconststr_t key, pconststr_
    return bytesWritten;
 }
 
+/*
+ * the keys are written with one lock of the database: the file is grown once for all values written to it
+ * and in write through mode the file is synced once after the last key
+ */
+static sint_t SetDataInKissLocalDBBatch(sint_t dbHandler, pconststr_t const* keys, pconststr_t const* data, sint_t const* dataSizes, sint_t count)
+{
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t result = PERS_COM_SUCCESS;
+   sint_t bytesWritten = 0;
+   sint_t storedSize = 0;
+   char* compressed = NIL;
+   uint32_t valueFlags = 0;
+   sint_t written = 0;
+   sint_t i = 0;
+
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("count=<"); DLT_INT(count); DLT_STRING(">"));
+
+   if ((dbHandler >= 0) && (NIL != keys) && (NIL != data) && (NIL != dataSizes) && (count > 0))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
+      {
+         bCanContinue = false;
+         result = PERS_COM_ERR_INVALID_PARAM;
+      }
+      else if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
+      {
+         bCanContinue = false;
+         result = PERS_COM_FAILURE;
+      }
+      else if (pLldbHandler->bFrozen)
+      {
+         bCanContinue = false;
+         result = PERS_COM_ERR_READONLY;
+      }
+      //no key is written if one of the keys is invalid
+      for (i = 0; bCanContinue && i < count; i++)
+      {
+         if ((NIL == keys[i]) || (NIL == data[i]) || (dataSizes[i] <= 0) || ((uint64_t) dataSizes[i] > pLldbHandler->kissDb.valSize))
+         {
+            bCanContinue = false;
+            result = PERS_COM_ERR_INVALID_PARAM;
+         }
+      }
+   }
+   else
+   {
+      bCanContinue = false;
+      result = PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      if (lldb_handles_Lock(&db->shared->mutex))
+      {
+         bLocked = true;
+      }
+
+      Kdb_wrlock(&db->shared->rwlock);
+      if (KISSDB_OPEN_MODE_RDONLY == db->shared->openMode)
+      {
+         result = PERS_COM_ERR_READONLY;
+      }
+      else if (KISSDB_WRITE_MODE_WT == db->shared->writeMode && KISSDB_reserve(db, (const int*) dataSizes, (uint32_t) count) != 0)
+      {
+         result = PERS_COM_FAILURE;
+      }
+      for (i = 0; PERS_COM_SUCCESS == result && i < count; i++)
+      {
+         storedSize = compressValue(pLldbHandler, data[i], dataSizes[i], &compressed, &valueFlags);
+         bytesWritten = putToKissLocalDB(pLldbHandler, keys[i], KISSDB_getKeyHash(db, keys[i]), (NIL != compressed) ? compressed : data[i],
+                                         storedSize, valueFlags);
+         if (bytesWritten != storedSize)
+         {
+            result = (bytesWritten < 0) ? bytesWritten : PERS_COM_FAILURE;
+         }
+         else
+         {
+            written++;
+         }
+         free(compressed);
+      }
+      if (KISSDB_WRITE_MODE_WT == db->shared->writeMode && KISSDB_OPEN_MODE_RDONLY != db->shared->openMode)
+      {
+#if USE_FSYNC
+         fsync(db->fd);
+#else
+         fdatasync(db->fd);
+#endif
+      }
+      Kdb_unlock(&db->shared->rwlock);
+
+      if ((PERS_COM_SUCCESS == result) || (written > 0))
+      {
+         result = written; //keys[written] failed if less than count keys were written
+      }
+   }
+
+   if (bLocked)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex);
+   }
+
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("count=<"); DLT_INT(count); DLT_STRING(">, ");
+           DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
+   return result;
+}
+
 static sint_t SetDataInKissRCT(sint_t dbHandler, pconststr_t key, PersistenceConfigurationKey_s const* pConfig)
 {
    bool_t bCanContinue = true;
+   bool_t bListed = false;
    bool_t bLocked = false;
    Data_Cached_RCT_s dataCached = { 0 };
    int kdbState = 0;
@@ -1381,6 +2107,11 @@ static sint_t SetDataInKissRCT(sint_t dbHandler, pconststr_t key, PersistenceCon
             bCanContinue = false;
             bytesWritten = PERS_COM_FAILURE;
          }
+         else if (pLldbHandler->bFrozen)
+         {
+            bCanContinue = false;
+            bytesWritten = PERS_COM_ERR_READONLY;
+         }
          /* to not use DLT while mutex locked */
       }
    }
@@ -1392,6 +2123,7 @@ static sint_t SetDataInKissRCT(sint_t dbHandler, pconststr_t key, PersistenceCon
    if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
+      uint64_t hash = KISSDB_getKeyHash(db, key);
       if (lldb_handles_Lock(&db->shared->mutex))
       {
          bLocked = true;
@@ -1405,16 +2137,17 @@ static sint_t SetDataInKissRCT(sint_t dbHandler, pconststr_t key, PersistenceCon
 
 
       Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
+      bListed = isKeyListed(db, key, hash);
       if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
       {
-         bytesWritten = putToCache(&pLldbHandler->kissDb, dataSize, (char*) metaKey, &dataCached);
+         bytesWritten = putToCache(&pLldbHandler->kissDb, dataSize, (char*) metaKey, hash, &dataCached);
       }
       else
       {
 
          if (KISSDB_OPEN_MODE_RDONLY != pLldbHandler->kissDb.shared->openMode)
          {
-            kdbState = KISSDB_put(&pLldbHandler->kissDb, metaKey, dataCached.m_data, dataCached.m_dataSize, &bytesWritten);
+            kdbState = KISSDB_put(&pLldbHandler->kissDb, metaKey, hash, dataCached.m_data, dataCached.m_dataSize, 0, &bytesWritten);
             if (kdbState != 0)
             {
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
@@ -1428,6 +2161,8 @@ static sint_t SetDataInKissRCT(sint_t dbHandler, pconststr_t key, PersistenceCon
 #endif
          }
       }
+      //a written key is listed, a failed write leaves the key as it was
+      updateKeyList(db, key, bListed, bListed || ((kdbState == 0) && (bytesWritten >= 0)));
       Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
 
    }
@@ -1456,7 +2191,6 @@ static sint_t GetKeySizeFromKissLocalDB(sint_t dbHandler, pconststr_t key)
 
    if ((dbHandler >= 0) && (NIL != key))
    {
-      bLocked = true;
       pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
       if (NIL == pLldbHandler)
       {
@@ -1478,9 +2212,14 @@ static sint_t GetKeySizeFromKissLocalDB(sint_t dbHandler, pconststr_t key)
       bCanContinue = false;
       bytesRead = PERS_COM_ERR_INVALID_PARAM;
    }
-   if (bCanContinue)
+   if (bCanContinue && pLldbHandler->bFrozen)
+   {
+      bytesRead = getFromFrozenDb(&pLldbHandler->frozenDb, key, NULL, 0);
+   }
+   else if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
+      uint64_t hash = KISSDB_getKeyHash(db, key);
       if (lldb_handles_Lock(&db->shared->mutex))
       {
          bLocked = true;
@@ -1489,15 +2228,15 @@ static sint_t GetKeySizeFromKissLocalDB(sint_t dbHandler, pconststr_t key)
       Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
       if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
       {
-         bytesRead = getFromCache(&pLldbHandler->kissDb, (char*) key, NULL, 0, true);
+         bytesRead = getFromCache(&pLldbHandler->kissDb, (char*) key, hash, NULL, 0, true);
          if (bytesRead == PERS_STATUS_KEY_NOT_IN_CACHE)
          {
-            bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, NULL, 0);
+            bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, hash, NULL, 0);
          }
       }
       else
       {
-         bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, NULL, 0);
+         bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, hash, NULL, 0);
       }
       Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
    }
@@ -1550,9 +2289,14 @@ static sint_t GetDataFromKissLocalDB(sint_t dbHandler, pconststr_t key, pstr_t b
       bytesRead = PERS_COM_ERR_INVALID_PARAM;
    }
 
-   if (bCanContinue)
+   if (bCanContinue && pLldbHandler->bFrozen)
+   {
+      bytesRead = getFromFrozenDb(&pLldbHandler->frozenDb, key, buffer_out, bufSize);
+   }
+   else if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
+      uint64_t hash = KISSDB_getKeyHash(db, key);
       if (lldb_handles_Lock(&db->shared->mutex))
       {
          bLocked = true;
@@ -1561,16 +2305,16 @@ static sint_t GetDataFromKissLocalDB(sint_t dbHandler, pconststr_t key, pstr_t b
       Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
       if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
       {
-         bytesRead = getFromCache(&pLldbHandler->kissDb, (char*) key, buffer_out, bufSize, false);
+         bytesRead = getFromCache(&pLldbHandler->kissDb, (char*) key, hash, buffer_out, bufSize, false);
          //if key is not already in cache
          if (bytesRead == PERS_STATUS_KEY_NOT_IN_CACHE)
          {
-            bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, buffer_out, bufSize);
+            bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, hash, buffer_out, bufSize);
          }
       }
       else //write through mode -> only read from file
       {
-         bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, buffer_out, bufSize);
+         bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, hash, buffer_out, bufSize);
       }
       Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
    }
@@ -1586,6 +2330,248 @@ static sint_t GetDataFromKissLocalDB(sint_t dbHandler, pconststr_t key, pstr_t b
    return bytesRead;
 }
 
+/*
+ * the keys are read with one lock of the database: in write cached mode the cache is searched first,
+ * the other keys are looked up in the database file at once and their values are copied in file order
+ */
+static sint_t GetDataFromKissLocalDBBatch(sint_t dbHandler, pconststr_t const* keys, pstr_t const* buffers_out, sint_t const* bufSizes, sint_t* results_out, sint_t count)
+{
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t result = PERS_COM_FAILURE;
+   sint_t i = 0;
+
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("count=<"); DLT_INT(count); DLT_STRING(">"));
+
+   if ((dbHandler >= 0) && (NIL != keys) && (NIL != buffers_out) && (NIL != bufSizes) && (NIL != results_out) && (count > 0))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
+      {
+         bCanContinue = false;
+         result = PERS_COM_ERR_INVALID_PARAM;
+      }
+      else if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
+      {
+         bCanContinue = false;
+         result = PERS_COM_FAILURE;
+      }
+      for (i = 0; bCanContinue && i < count; i++)
+      {
+         if ((NIL == keys[i]) || (NIL == buffers_out[i]) || (bufSizes[i] <= 0))
+         {
+            bCanContinue = false;
+            result = PERS_COM_ERR_INVALID_PARAM;
+         }
+      }
+   }
+   else
+   {
+      bCanContinue = false;
+      result = PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   if (bCanContinue && pLldbHandler->bFrozen)
+   {
+      for (i = 0; i < count; i++)
+      {
+         results_out[i] = getFromFrozenDb(&pLldbHandler->frozenDb, keys[i], buffers_out[i], bufSizes[i]);
+      }
+      result = PERS_COM_SUCCESS;
+   }
+   else if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      if (lldb_handles_Lock(&db->shared->mutex))
+      {
+         bLocked = true;
+      }
+
+      Kdb_wrlock(&db->shared->rwlock);
+      result = getFromDatabaseFileBatch(db, keys, buffers_out, bufSizes, results_out, count);
+      Kdb_unlock(&db->shared->rwlock);
+   }
+   if (bLocked)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex);
+   }
+
+   if (PERS_COM_SUCCESS == result)
+   {
+      for (i = 0; i < count; i++)
+      {
+         if (results_out[i] > bufSizes[i])
+         {
+            results_out[i] = PERS_COM_ERR_BUFFER_TOO_SMALL;
+         }
+         if (results_out[i] >= 0)
+         {
+            result++;
+         }
+      }
+   }
+
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("count=<"); DLT_INT(count); DLT_STRING(">, ");
+           DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
+   return result;
+}
+
+/*
+ * values stored uncompressed in a data block of the database file or in a frozen image are returned without a copy,
+ * cached, inline and compressed values are copied into an allocated buffer
+ */
+static sint_t GetViewFromKissLocalDB(sint_t dbHandler, pconststr_t key, void const** data_out)
+{
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t bytesRead = PERS_COM_FAILURE;
+   const void* value = NIL;
+   uint32_t valueSize = 0;
+   int kdbState = 0;
+
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">"));
+
+   if ((dbHandler >= 0) && (NIL != key) && (NIL != data_out))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
+      {
+         bCanContinue = false;
+         bytesRead = PERS_COM_ERR_INVALID_PARAM;
+      }
+      else if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
+      {
+         bCanContinue = false;
+         bytesRead = PERS_COM_FAILURE;
+      }
+   }
+   else
+   {
+      bCanContinue = false;
+      bytesRead = PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   if (bCanContinue && pLldbHandler->bFrozen)
+   {
+      if (FROZENDB_get(&pLldbHandler->frozenDb, key, &value, &valueSize) != 0)
+      {
+         bytesRead = PERS_COM_ERR_NOT_FOUND;
+      }
+      else
+      {
+         *data_out = value;
+         bytesRead = (sint_t) valueSize;
+      }
+   }
+   else if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      uint64_t hash = KISSDB_getKeyHash(db, key);
+      if (lldb_handles_Lock(&db->shared->mutex))
+      {
+         bLocked = true;
+      }
+
+      Kdb_wrlock(&db->shared->rwlock);
+      bytesRead = PERS_STATUS_KEY_NOT_IN_CACHE;
+      if (KISSDB_WRITE_MODE_WC == db->shared->writeMode)
+      {
+         bytesRead = getFromCache(db, (char*) key, hash, NIL, 0, true);
+         if (bytesRead >= 0)
+         {
+            bytesRead = getCopyView(db, key, hash, true, bytesRead, data_out);
+         }
+      }
+      if (bytesRead == PERS_STATUS_KEY_NOT_IN_CACHE)
+      {
+         kdbState = KISSDB_getView(db, key, hash, &value, &valueSize, NIL);
+         if (kdbState != 0)
+         {
+            bytesRead = PERS_COM_ERR_NOT_FOUND;
+         }
+         else if (value != NIL)
+         {
+            *data_out = value;
+            bytesRead = (sint_t) valueSize;
+         }
+         else
+         {
+            bytesRead = getFromDatabaseFile(db, (char*) key, hash, NIL, 0);
+            if (bytesRead >= 0)
+            {
+               bytesRead = getCopyView(db, key, hash, false, bytesRead, data_out);
+            }
+         }
+      }
+      Kdb_unlock(&db->shared->rwlock);
+   }
+   if (bLocked)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex);
+   }
+
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">, ");
+           DLT_STRING("retval=<"); DLT_INT(bytesRead); DLT_STRING(">"));
+   return bytesRead;
+}
+
+static sint_t ReleaseViewFromKissLocalDB(sint_t dbHandler, void const* data)
+{
+   bool_t bLocked = false;
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t result = PERS_COM_SUCCESS;
+
+   if ((dbHandler < 0) || (NIL == data))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+   if ((NIL == pLldbHandler) || (PersLldbPurpose_DB != pLldbHandler->ePurpose))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   if (pLldbHandler->bFrozen)
+   {
+      //the image stays mapped until it is closed
+      if ((const char*) data < pLldbHandler->frozenDb.map || (const char*) data > pLldbHandler->frozenDb.map + pLldbHandler->frozenDb.mapSize)
+      {
+         result = PERS_COM_ERR_INVALID_PARAM;
+      }
+   }
+   else
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      if (lldb_handles_Lock(&db->shared->mutex))
+      {
+         bLocked = true;
+      }
+      Kdb_wrlock(&db->shared->rwlock);
+      if (KISSDB_isView(db, data) == Kdb_true)
+      {
+         KISSDB_releaseView(db, data);
+      }
+      else
+      {
+         free((void*) data); //copy of a cached, inline or compressed value
+      }
+      Kdb_unlock(&db->shared->rwlock);
+      if (bLocked)
+      {
+         (void) lldb_handles_Unlock(&db->shared->mutex);
+      }
+   }
+   return result;
+}
+
 static sint_t GetDataFromKissRCT(sint_t dbHandler, pconststr_t key, PersistenceConfigurationKey_s* pConfig)
 {
    bool_t bCanContinue = true;
@@ -1622,9 +2608,14 @@ static sint_t GetDataFromKissRCT(sint_t dbHandler, pconststr_t key, PersistenceC
    }
 
    //read RCT
-   if (bCanContinue)
+   if (bCanContinue && pLldbHandler->bFrozen)
+   {
+      bytesRead = getFromFrozenDb(&pLldbHandler->frozenDb, key, pConfig, sizeof(PersistenceConfigurationKey_s));
+   }
+   else if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
+      uint64_t hash = KISSDB_getKeyHash(db, key);
       if (lldb_handles_Lock(&db->shared->mutex))
       {
          bLocked = true;
@@ -1633,15 +2624,15 @@ static sint_t GetDataFromKissRCT(sint_t dbHandler, pconststr_t key, PersistenceC
       Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
       if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
       {
-         bytesRead = getFromCache(&pLldbHandler->kissDb, (char*) key, pConfig, sizeof(PersistenceConfigurationKey_s), false);
+         bytesRead = getFromCache(&pLldbHandler->kissDb, (char*) key, hash, pConfig, sizeof(PersistenceConfigurationKey_s), false);
          if (bytesRead == PERS_STATUS_KEY_NOT_IN_CACHE)
          {
-            bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, pConfig, sizeof(PersistenceConfigurationKey_s));
+            bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, hash, pConfig, sizeof(PersistenceConfigurationKey_s));
          }
       }
       else
       {
-         bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, pConfig, sizeof(PersistenceConfigurationKey_s));
+         bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, hash, pConfig, sizeof(PersistenceConfigurationKey_s));
       }
       Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
    }
@@ -1866,6 +2857,7 @@ static void lldb_handles_InitHandle(lldb_handler_s* psHandle_inout, pers_lldb_pu
 {
    psHandle_inout->bIsAssigned = true;
    psHandle_inout->ePurpose = ePurpose;
+   psHandle_inout->cursor.bOpen = false;
    (void) strncpy(psHandle_inout->dbPathname, dbPathname, sizeof(psHandle_inout->dbPathname));
 }
 
@@ -1934,7 +2926,16 @@ static bool_t lldb_handles_DeinitHandle(sint_t dbHandler)
    return bEverythingOK;
 }
 
-sint_t getFromCache(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize, bool_t sizeOnly)
+/*
+ * returns the hash used by the cache for a key hash (KISSDB_getKeyHash)
+ * the high 32 bits are also stored in the hashtable slots, so the hash of keys listed from the database file can be used for the cache
+ */
+uint32_t getCacheHash(uint64_t hash)
+{
+   return (uint32_t) (hash >> 32);
+}
+
+sint_t getFromCache(KISSDB* db, void* metaKey, uint64_t hash, void* readBuffer, sint_t bufsize, bool_t sizeOnly)
 {
    char* ptr;
    int datasize = 0;
@@ -1956,7 +2957,7 @@ sint_t getFromCache(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize,
 
       setMemoryAddress(db->sharedCache, db->tbl[0]);
 
-      val = db->tbl[0]->get(db->tbl[0], metaKey, &size);
+      val = db->tbl[0]->get(db->tbl[0], metaKey, getCacheHash(hash), &size);
       if (val == NULL)
       {
          bytesRead = PERS_COM_ERR_NOT_FOUND;
@@ -1968,7 +2969,29 @@ sint_t getFromCache(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize,
          eFlag = (pers_lldb_cache_flag_e) *(int*) ptr;
 
          //check if this key has already been marked as deleted
-         if (eFlag != CachedDataDelete)
+         if (eFlag == CachedDataWriteCompressed)
+         {
+            ptr = ptr + sizeof(pers_lldb_cache_flag_e);
+            datasize = *(int*) ptr; //size of the compressed value
+            ptr = ptr + sizeof(int);
+            bytesRead = (sint_t) pcoGetDecompressedSize(ptr, (uint32_t) datasize);
+
+            //decompress data if needed
+            if (!sizeOnly)
+            {
+               if (bufsize < bytesRead)
+               {
+                  bytesRead = PERS_COM_FAILURE;
+               }
+               else if (pcoDecompress(ptr, (uint32_t) datasize, readBuffer, (uint32_t) bufsize) < 0)
+               {
+                  DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                          DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("Failed to decompress cached data for key=<"); DLT_STRING(metaKey); DLT_STRING(">"));
+                  bytesRead = PERS_COM_FAILURE;
+               }
+            }
+         }
+         else if (eFlag != CachedDataDelete)
          {
             //get datasize
             ptr = ptr + sizeof(pers_lldb_cache_flag_e);
@@ -2013,14 +3036,19 @@ sint_t getFromCache(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize,
    }
 }
 
-sint_t getFromDatabaseFile(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize)
+sint_t getFromDatabaseFile(KISSDB* db, void* metaKey, uint64_t hash, void* readBuffer, sint_t bufsize)
 {
    int kdbState = 0;
    sint_t bytesRead = 0;
    uint32_t size = 0;
+   uint32_t flags = 0;
 
-   kdbState  = KISSDB_get(db, metaKey, readBuffer, bufsize, &size);
-   if (kdbState == 0)
+   kdbState  = KISSDB_get(db, metaKey, hash, readBuffer, bufsize, &size, &flags);
+   if (kdbState == 0 && (flags & KISSDB_VALUE_COMPRESSED))
+   {
+      bytesRead = getCompressedFromDatabaseFile(db, metaKey, hash, size, readBuffer, bufsize);
+   }
+   else if (kdbState == 0)
    {
       bytesRead = size;
    }
@@ -2028,7 +3056,8 @@ sint_t getFromDatabaseFile(KISSDB* db, void* metaKey, void* readBuffer, sint_t b
    {
       if (kdbState == 1)
       {
-         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
+         //lookups of keys which were never written are expected (defaults are read from other databases): no warning
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG,
                  DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_get: key=<"); DLT_STRING(metaKey); DLT_STRING(">, "); DLT_STRING("not found, retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
          bytesRead = PERS_COM_ERR_NOT_FOUND;
       }
@@ -2042,67 +3071,277 @@ sint_t getFromDatabaseFile(KISSDB* db, void* metaKey, void* readBuffer, sint_t b
    return bytesRead;
 }
 
-sint_t putToCache(KISSDB* db, sint_t dataSize, char* metaKey, void* cachedData)
+/*
+ * reads a compressed value of size bytes from the database file and decompresses it into readBuffer
+ * like for uncompressed values, only the size of the data is returned if readBuffer is too small
+ */
+sint_t getCompressedFromDatabaseFile(KISSDB* db, void* metaKey, uint64_t hash, uint32_t size, void* readBuffer, sint_t bufsize)
 {
-   sint_t bytesWritten = 0;
-
-   //DO NOT ALLOW WRITING TO CACHE IF DATABASE IS OPENED IN READONLY MODE
-   if(KISSDB_OPEN_MODE_RDONLY == db->shared->openMode )
-   {
-      return PERS_COM_ERR_READONLY;
-   }
+   char* compressed = (char*) malloc(size);
+   sint_t bytesRead = PERS_COM_ERR_OUT_OF_MEMORY;
 
-   //if cache not already created
-   if (db->shared->cacheCreated == Kdb_false)
+   if (compressed != NULL)
    {
-      if (createCache(db) != 0)
+      if (KISSDB_get(db, metaKey, hash, compressed, size, &size, NULL) != 0)
       {
-         return PERS_COM_FAILURE;
+         bytesRead = PERS_COM_FAILURE;
       }
-   }
-   else //open cache
-   {
-      if (openCache(db) != 0)
+      else
       {
-         return PERS_COM_FAILURE;
+         bytesRead = (sint_t) pcoGetDecompressedSize(compressed, size);
+         if (readBuffer != NULL && bufsize >= bytesRead && pcoDecompress(compressed, size, readBuffer, (uint32_t) bufsize) < 0)
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                    DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("Failed to decompress data for key=<"); DLT_STRING(metaKey); DLT_STRING(">"));
+            bytesRead = PERS_COM_FAILURE;
+         }
       }
+      free(compressed);
    }
-   // update db->sharedCache pointer (process adress range mapping can be different after remap) (use
-   //printf("setMemoryAddress(db->sharedCache, db->tbl[0] = %p \n", db->sharedCache );
-   setMemoryAddress(db->sharedCache, db->tbl[0]); //address to first hashtable
-   //put in cache
-   if (db->tbl[0]->put(db->tbl[0], metaKey, cachedData, sizeof(pers_lldb_cache_flag_e) + sizeof(int) + (size_t) dataSize) ==
-         false) //store flag , datasize and data as value in cache
-   {
-      bytesWritten = PERS_COM_FAILURE;
-      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("Failed to put data into cache: "); DLT_STRING(strerror(errno)));
+   return bytesRead;
+}
 
-#if 0
-      int k = 0;
-      //if additional caches were created by another process -> get referemnce to them and init the local tbl struct
-      if(db->cacheReferenced < db->shared->cacheCount)
+/*
+ * reads several keys, the caller holds the write lock of the database
+ * results_out returns the size of every value (the value is only copied if it fits into its buffer) or a negative value
+ */
+sint_t getFromDatabaseFileBatch(KISSDB* db, pconststr_t const* keys, pstr_t const* buffers_out, sint_t const* bufSizes, sint_t* results_out, sint_t count)
+{
+   KISSDB_Read_s* reads = (KISSDB_Read_s*) calloc((size_t) count, sizeof(KISSDB_Read_s));
+   sint_t cached = PERS_STATUS_KEY_NOT_IN_CACHE;
+   uint32_t readCount = 0;
+   sint_t* readIndex = (sint_t*) malloc((size_t) count * sizeof(sint_t));
+   int kdbState = 0;
+   sint_t i = 0;
+
+   if (reads == NIL || readIndex == NIL)
+   {
+      free(reads);
+      free(readIndex);
+      return PERS_COM_ERR_OUT_OF_MEMORY;
+   }
+   for (i = 0; i < count; i++)
+   {
+      uint64_t hash = KISSDB_getKeyHash(db, keys[i]);
+      if (KISSDB_WRITE_MODE_WC == db->shared->writeMode)
       {
-         printf("additional caches found! \n");
-         //init local tbl2 array (internally a malloc occurs)
-         for(k=1; k < db->shared->cacheCount; k++ )
+         cached = getFromCache(db, (char*) keys[i], hash, buffers_out[i], bufSizes[i], false);
+         if (cached == PERS_COM_FAILURE) //value does not fit into the buffer
          {
-            printf("qhasharr init cache no.= %d with zero \n",k);
-            db->tbl[k] = qhasharr(db->sharedCache + (k * PERS_CACHE_MEMSIZE) , 0);
-            db->cacheReferenced++;
+            cached = getFromCache(db, (char*) keys[i], hash, NIL, 0, true);
          }
       }
-
-      //reset addresses for all caches mapped to this process space
-      for(k=0; k <  db->shared->cacheCount; k++ )
+      if (cached != PERS_STATUS_KEY_NOT_IN_CACHE)
       {
-         printf("setMemoryAddress  k= %d --  putToCache ptr: %p \n", k, db->sharedCache + (k * PERS_CACHE_MEMSIZE));
-         setMemoryAddress(db->sharedCache + (k * PERS_CACHE_MEMSIZE ), db->tbl[k]);
+         results_out[i] = cached;
       }
-
-      int putOk = 0;
-      k=0;
-      //try to insert data until empty slot or same key is found in all of the caches
-      while (k < db->shared->cacheCount) //store flag , datasize and data as value in cache
+      else
+      {
+         reads[readCount].key = keys[i];
+         reads[readCount].hash = hash;
+         reads[readCount].vbuf = buffers_out[i];
+         reads[readCount].bufsize = (uint32_t) bufSizes[i];
+         readIndex[readCount] = i;
+         readCount++;
+      }
+   }
+
+   if (readCount > 0)
+   {
+      kdbState = KISSDB_getBatch(db, reads, readCount);
+   }
+   for (i = 0; i < (sint_t) readCount; i++)
+   {
+      if (kdbState != 0 || reads[i].result < 0)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                 DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_getBatch: key=<"); DLT_STRING(reads[i].key); DLT_STRING(">, "); DLT_STRING("Error with retval=<");
+                 DLT_INT((kdbState != 0) ? kdbState : reads[i].result); DLT_STRING(">"));
+         results_out[readIndex[i]] = PERS_COM_FAILURE;
+      }
+      else if (reads[i].result == 1)
+      {
+         results_out[readIndex[i]] = PERS_COM_ERR_NOT_FOUND;
+      }
+      else if (reads[i].vflags & KISSDB_VALUE_COMPRESSED)
+      {
+         results_out[readIndex[i]] = getCompressedFromDatabaseFile(db, (char*) reads[i].key, reads[i].hash, reads[i].vsize, reads[i].vbuf, (sint_t) reads[i].bufsize);
+      }
+      else
+      {
+         results_out[readIndex[i]] = (sint_t) reads[i].vsize;
+      }
+   }
+   free(reads);
+   free(readIndex);
+   return PERS_COM_SUCCESS;
+}
+
+/*
+ * compresses data if values of the database are compressed and the compressed value is smaller than the data
+ * returns the size of the stored value, compressed returns the compressed value (NIL if the data is stored uncompressed)
+ */
+sint_t compressValue(lldb_handler_s* pLldbHandler, pconststr_t data, sint_t dataSize, char** compressed, uint32_t* valueFlags)
+{
+   sint_t storedSize = dataSize;
+
+   *compressed = NIL;
+   *valueFlags = 0;
+   if (pLldbHandler->bCompressValues && dataSize >= PERS_LLDB_COMPRESS_MIN_SIZE)
+   {
+      *compressed = (char*) malloc((size_t) dataSize);
+      if (NIL != *compressed)
+      {
+         storedSize = (sint_t) pcoCompress(data, (uint32_t) dataSize, *compressed, (uint32_t) dataSize - 1);
+         if (storedSize > 0)
+         {
+            *valueFlags = KISSDB_VALUE_COMPRESSED;
+         }
+         else
+         {
+            free(*compressed);
+            *compressed = NIL;
+            storedSize = dataSize;
+         }
+      }
+   }
+   return storedSize;
+}
+
+/*
+ * writes a value to the cache (write cached mode) or to the database file, the caller holds the write lock of the database
+ * the file is not synced, returns the number of bytes written
+ */
+sint_t putToKissLocalDB(lldb_handler_s* pLldbHandler, pconststr_t key, uint64_t hash, pconststr_t storedData, sint_t storedSize, uint32_t valueFlags)
+{
+   Data_Cached_s dataCached = { 0 };
+   KISSDB* db = &pLldbHandler->kissDb;
+   sint_t bytesWritten = PERS_COM_FAILURE;
+   int kdbState = 0;
+   bool_t bListed = isKeyListed(db, key, hash);
+
+   if (KISSDB_WRITE_MODE_WC == db->shared->writeMode && storedSize <= PERS_DB_MAX_SIZE_KEY_DATA)
+   {
+      dataCached.eFlag = (valueFlags & KISSDB_VALUE_COMPRESSED) ? CachedDataWriteCompressed : CachedDataWrite;
+      dataCached.m_dataSize = storedSize;
+      (void) memcpy(dataCached.m_data, storedData, (size_t) storedSize);
+      bytesWritten = putToCache(db, storedSize, (char*) key, hash, &dataCached);
+   }
+   else if (KISSDB_WRITE_MODE_WC == db->shared->writeMode)
+   {
+      //larger values are not cached (the shared cache has a fixed size): they are written to the file directly
+      bytesWritten = putToDatabaseFile(db, (char*) key, hash, storedData, storedSize, valueFlags);
+   }
+   else if (KISSDB_OPEN_MODE_RDONLY != db->shared->openMode)
+   {
+      kdbState = KISSDB_put(db, key, hash, storedData, storedSize, valueFlags, &bytesWritten);
+      if (kdbState != 0)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                 DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_put: key=<"); DLT_STRING(key); DLT_STRING(">, "); DLT_STRING("WriteThrough to file failed with retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
+      }
+   }
+   //a written key is listed, a failed write leaves the key as it was
+   updateKeyList(db, key, bListed, bListed || ((kdbState == 0) && (bytesWritten >= 0)));
+   return bytesWritten;
+}
+
+/*
+ * writes a value which is too large for the cache directly to the database file
+ * a cached value or deletion of the key is removed from the cache, it is older than the written value
+ */
+sint_t putToDatabaseFile(KISSDB* db, char* metaKey, uint64_t hash, pconststr_t data, sint_t dataSize, uint32_t valueFlags)
+{
+   int kdbState = 0;
+   int32_t bytesWritten = 0;
+
+   //DO NOT ALLOW WRITING IF DATABASE IS OPENED IN READONLY MODE
+   if (KISSDB_OPEN_MODE_RDONLY == db->shared->openMode)
+   {
+      return PERS_COM_ERR_READONLY;
+   }
+
+   if (db->shared->cacheCreated == Kdb_true)
+   {
+      if (openCache(db) != 0)
+      {
+         return PERS_COM_FAILURE;
+      }
+      setMemoryAddress(db->sharedCache, db->tbl[0]);
+      (void) db->tbl[0]->remove(db->tbl[0], metaKey, getCacheHash(hash));
+   }
+
+   kdbState = KISSDB_put(db, metaKey, hash, data, dataSize, valueFlags, &bytesWritten);
+   if (kdbState != 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+              DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_put: key=<"); DLT_STRING(metaKey); DLT_STRING(">, "); DLT_STRING("Writing to file failed with retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
+      return PERS_COM_FAILURE;
+   }
+   return (sint_t) bytesWritten;
+}
+
+sint_t putToCache(KISSDB* db, sint_t dataSize, char* metaKey, uint64_t hash, void* cachedData)
+{
+   sint_t bytesWritten = 0;
+
+   //DO NOT ALLOW WRITING TO CACHE IF DATABASE IS OPENED IN READONLY MODE
+   if(KISSDB_OPEN_MODE_RDONLY == db->shared->openMode )
+   {
+      return PERS_COM_ERR_READONLY;
+   }
+
+   //if cache not already created
+   if (db->shared->cacheCreated == Kdb_false)
+   {
+      if (createCache(db) != 0)
+      {
+         return PERS_COM_FAILURE;
+      }
+   }
+   else //open cache
+   {
+      if (openCache(db) != 0)
+      {
+         return PERS_COM_FAILURE;
+      }
+   }
+   // update db->sharedCache pointer (process adress range mapping can be different after remap) (use
+   //printf("setMemoryAddress(db->sharedCache, db->tbl[0] = %p \n", db->sharedCache );
+   setMemoryAddress(db->sharedCache, db->tbl[0]); //address to first hashtable
+   //put in cache
+   if (db->tbl[0]->put(db->tbl[0], metaKey, getCacheHash(hash), cachedData, sizeof(pers_lldb_cache_flag_e) + sizeof(int) + (size_t) dataSize) ==
+         false) //store flag , datasize and data as value in cache
+   {
+      bytesWritten = PERS_COM_FAILURE;
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("Failed to put data into cache: "); DLT_STRING(strerror(errno)));
+
+#if 0
+      int k = 0;
+      //if additional caches were created by another process -> get referemnce to them and init the local tbl struct
+      if(db->cacheReferenced < db->shared->cacheCount)
+      {
+         printf("additional caches found! \n");
+         //init local tbl2 array (internally a malloc occurs)
+         for(k=1; k < db->shared->cacheCount; k++ )
+         {
+            printf("qhasharr init cache no.= %d with zero \n",k);
+            db->tbl[k] = qhasharr(db->sharedCache + (k * PERS_CACHE_MEMSIZE) , 0);
+            db->cacheReferenced++;
+         }
+      }
+
+      //reset addresses for all caches mapped to this process space
+      for(k=0; k <  db->shared->cacheCount; k++ )
+      {
+         printf("setMemoryAddress  k= %d --  putToCache ptr: %p \n", k, db->sharedCache + (k * PERS_CACHE_MEMSIZE));
+         setMemoryAddress(db->sharedCache + (k * PERS_CACHE_MEMSIZE ), db->tbl[k]);
+      }
+
+      int putOk = 0;
+      k=0;
+      //try to insert data until empty slot or same key is found in all of the caches
+      while (k < db->shared->cacheCount) //store flag , datasize and data as value in cache
       {
          printf("start while k = %d, cacheCount= %d\n", k, db->shared->cacheCount);
          if( db->tbl[k]->put(db->tbl[k], metaKey, cachedData, sizeof(pers_lldb_cache_flag_e) + sizeof(int) + (size_t) dataSize) == true)
@@ -2158,7 +3397,7 @@ sint_t putToCache(KISSDB* db, sint_t dataSize, char* metaKey, void* cachedData)
 
 
 
-sint_t deleteFromCache(KISSDB* db, char* metaKey)
+sint_t deleteFromCache(KISSDB* db, char* metaKey, uint64_t hash)
 {
    char* ptr;
    Data_Cached_s dataCached = { 0 };
@@ -2194,7 +3433,7 @@ sint_t deleteFromCache(KISSDB* db, char* metaKey)
 
       setMemoryAddress(db->sharedCache, db->tbl[0]);
 
-      val = db->tbl[0]->get(db->tbl[0], metaKey, &size);
+      val = db->tbl[0]->get(db->tbl[0], metaKey, getCacheHash(hash), &size);
       if (NULL != val) //check if key to be deleted is in Cache
       {
          ptr = val;
@@ -2205,7 +3444,7 @@ sint_t deleteFromCache(KISSDB* db, char* metaKey)
          //Mark data in cache as deleted
          if (eFlag != CachedDataDelete)
          {
-            if (db->tbl[0]->put(db->tbl[0], metaKey, &dataCached, sizeof(pers_lldb_cache_flag_e) + sizeof(int)) == false) //do not store any data
+            if (db->tbl[0]->put(db->tbl[0], metaKey, getCacheHash(hash), &dataCached, sizeof(pers_lldb_cache_flag_e) + sizeof(int)) == false) //do not store any data
             {
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
                      DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("Failed to mark data in cache as deleted"));
@@ -2222,10 +3461,10 @@ sint_t deleteFromCache(KISSDB* db, char* metaKey)
       {
          //get dataSize
          uint32_t size;
-         status = KISSDB_get(db, metaKey, NULL, 0, &size);
+         status = KISSDB_get(db, metaKey, hash, NULL, 0, &size, NULL);
          if (status == 0)
          {
-            if (db->tbl[0]->put(db->tbl[0], metaKey, &dataCached, sizeof(pers_lldb_cache_flag_e) + sizeof(int)) == false)
+            if (db->tbl[0]->put(db->tbl[0], metaKey, getCacheHash(hash), &dataCached, sizeof(pers_lldb_cache_flag_e) + sizeof(int)) == false)
             {
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
                      DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("Failed to mark existing data as deleted"));
@@ -2266,211 +3505,443 @@ sint_t deleteFromCache(KISSDB* db, char* metaKey)
 
 
 
-sint_t getListandSize(KISSDB* db, pstr_t buffer, sint_t size, bool_t bOnlySizeNeeded, pers_lldb_purpose_e purpose)
+/*
+ * appends a key to the list of keys (if it fits into the remaining buffer) and returns the size needed for the key in the list
+ */
+sint_t appendKeyToList(const char* key, size_t keyLen, pstr_t* buffer, sint_t* availableSize, bool_t bOnlySizeNeeded)
 {
-   char* memory = NULL;
-   char* ptr;
-   char* ptr2;
-   char** tmplist = NULL;
-   char** tmp_deleted_list = NULL;
-   int keyCountFile = 0, keyCountCache = 0, deletedKeysInCacheCount = 0, result = 0, x = 0, idx = 0, max = 0, used = 0, objCount = 0;
+   if ((!bOnlySizeNeeded) && ((sint_t) keyLen < *(availableSize)))
+   {
+      (void) strncpy(*(buffer), key, keyLen);
+      *(*(buffer) + keyLen) = ListItemsSeparator;
+      *(buffer) += (keyLen + sizeof(ListItemsSeparator));
+      *(availableSize) -= (sint_t) (keyLen + sizeof(ListItemsSeparator));
+   }
+   return (sint_t) (keyLen + sizeof(ListItemsSeparator));
+}
+
+
+
+sint_t getListandSize(KISSDB* db, pstr_t buffer, sint_t size, bool_t bOnlySizeNeeded)
+{
+   Kdb_bool cacheOpened = Kdb_false;
+   int idx = 0;
+   int iter_ret_val;
    KISSDB_Iterator dbi;
-   pers_lldb_cache_flag_e eFlag;
-   qhasharr_t* tbl;
-   qnobj_t obj;
+   pers_lldb_cache_flag_e eFlag = CachedDataDelete;
    sint_t availableSize = size;
-   void* pt;
-   int iter_ret_val;
-
-   int keylength = (purpose == PersLldbPurpose_RCT) ? PERS_RCT_MAX_LENGTH_RESOURCE_ID : PERS_DB_MAX_LENGTH_KEY_NAME;
+   sint_t result = 0;
+   size_t keyLen = 0;
+   uint32_t keyCount = 0;
    char kbuf[PERS_DB_MAX_LENGTH_KEY_NAME];
 
-   //open existing cache if present and look for keys
+   //the size of the list is updated by every write and delete after the keys were listed once
+   if (bOnlySizeNeeded && db->shared->keyListValid == Kdb_true)
+   {
+      return (sint_t) db->shared->keyListSize;
+   }
+
+   //list the keys in cache which are not marked as deleted
    if (db->shared->cacheCreated == Kdb_true)
    {
       if (openCache(db) != 0)
       {
          return PERS_COM_FAILURE;
       }
-      else
-      {
-         setMemoryAddress(db->sharedCache, db->tbl[0]);
+      setMemoryAddress(db->sharedCache, db->tbl[0]);
+      cacheOpened = Kdb_true;
 
-         objCount = db->tbl[0]->size(db->tbl[0], &max, &used);
-         if (objCount > 0)
+      while (db->tbl[0]->getnextkey(db->tbl[0], kbuf, sizeof(kbuf), &eFlag, sizeof(eFlag), &idx) == true)
+      {
+         keyLen = strlen(kbuf);
+         if (eFlag != CachedDataDelete && keyLen > 0)
          {
-            tmplist          = malloc(sizeof(char*) * objCount);
-            if (tmplist != NULL)
-            {
-               tmp_deleted_list = malloc(sizeof(char*) * objCount);
-               if(tmp_deleted_list != NULL)
-               {
-                  while (db->tbl[0]->getnext(db->tbl[0], &obj, &idx) == true)
-                  {
-                     size_t keyLen = strlen(obj.name);
-                     pt = obj.data;
-                     eFlag = (pers_lldb_cache_flag_e) *(int*) pt;
-                     if (eFlag != CachedDataDelete)
-                     {
-                        tmplist[keyCountCache] = (char*) malloc(keyLen + 1);
-                        (void) strncpy(tmplist[keyCountCache], obj.name, keyLen);
-                        ptr = tmplist[keyCountCache];
-                        ptr[keyLen] = '\0';
-                        keyCountCache++;
-                     } else { //get all keys marked as deleted in cache
-                       tmp_deleted_list[deletedKeysInCacheCount] = (char*) malloc(keyLen + 1);
-                       (void) strncpy(tmp_deleted_list[deletedKeysInCacheCount], obj.name, keyLen);
-                       ptr2 = tmp_deleted_list[deletedKeysInCacheCount];
-                       ptr2[keyLen] = '\0';
-                       deletedKeysInCacheCount++;
-                     }
-                  }
-               }
-               else
-               {
-                  free(tmp_deleted_list);
-                  return PERS_COM_ERR_MALLOC;
-               }
-            }
-            else
-            {
-               free(tmplist);
-               return PERS_COM_ERR_MALLOC;
-            }
+            result += appendKeyToList(kbuf, keyLen, &buffer, &availableSize, bOnlySizeNeeded);
+            keyCount++;
          }
       }
    }
 
-   //look for keys in database file
-   //Initialise database iterator
+   //list the keys in database file which are not in cache (already listed or marked as deleted and not yet updated to file)
+   //the cache is the hash set of these keys: the key hash stored in the hashtable slot is used for the lookup,
+   //so the keys are not hashed again and no memory is allocated
    KISSDB_Iterator_init(db, &dbi);
-   //get number of keys, stored in database file    
    while ( (iter_ret_val = KISSDB_Iterator_next(&dbi, &kbuf, NULL)) > 0)
    {
       if (iter_ret_val == KISSDB_ITERATOR_NEXT_ITEM_FOUND)
-      {      
-          bool found_deleted = false;
-          for (x = 0; x < deletedKeysInCacheCount; x++)
-          {
-             if (strncmp(kbuf, tmp_deleted_list[x], strnlen(kbuf, sizeof(kbuf))) == 0)
-             {
-               found_deleted = true;
-             }
-          }
-          // Do not count key in file which is already marked as deleted in cache and not yet updated to file.
-          if(!found_deleted )
-          {
-            keyCountFile++;
-          }
-      }
-   }
-
-   if ((keyCountCache + keyCountFile) > 0)
-   {
-      int memsize = qhasharr_calculate_memsize(keyCountCache + keyCountFile);
-      //create hashtable that stores the list of keys without duplicates
-      memory = malloc(memsize);
-      if (memory != NULL)
-      {
-         memset(memory, 0, memsize);
-         tbl = qhasharr(memory, memsize);
-         if (tbl == NULL)
-         {
-            free(tmp_deleted_list);
-            free(tmplist);
-            return PERS_COM_ERR_MALLOC;
-         }
-         //put keys in cache to a hashtable
-         for (x = 0; x < keyCountCache; x++)
-         {
-           if( tmplist != NULL)
-           {
-             if (tbl->put(tbl, tmplist[x], "0", 1) == true)
-             {
-                if (tmplist[x] != NULL)
-                {
-                   free(tmplist[x]);
-                }
-             }
-           }
-         }
-         if( tmplist != NULL)
-           free(tmplist);
-
-         //put keys in database file to hashtable (existing key gets overwritten -> no duplicate keys)
-         KISSDB_Iterator_init(db, &dbi);
-         memset(kbuf, 0, keylength);
-         while ( (iter_ret_val = KISSDB_Iterator_next(&dbi, &kbuf, NULL)) > 0)
-         {
-            if (iter_ret_val == KISSDB_ITERATOR_NEXT_ITEM_FOUND)
-            {
-               size_t keyLen = strnlen(kbuf, sizeof(kbuf));
-               if (keyLen > 0)
-               {
-                   //only add keys from file to temporary hashtable if they are not already marked as deleted in cache
-                  bool found_deleted = false;
-                  for (x = 0; x < deletedKeysInCacheCount; x++)
-                  {
-                    if (strncmp(kbuf, tmp_deleted_list[x], keyLen) == 0)
-                    {
-                      found_deleted = true;
-                    }
-                  }
-                  if(!found_deleted )
-                  {
-                    tbl->put(tbl, kbuf, "0", 1);
-                  }
-               }
-            }
+      {
+         keyLen = strnlen(kbuf, sizeof(kbuf));
+         if (keyLen > 0 && (cacheOpened == Kdb_false || db->tbl[0]->exists(db->tbl[0], kbuf, getCacheHash(dbi.hash)) == false))
+         {
+            result += appendKeyToList(kbuf, keyLen, &buffer, &availableSize, bOnlySizeNeeded);
+            keyCount++;
          }
-         // free temporary list which holds the deleted keys that are not yet updated with file
-         if( tmp_deleted_list != NULL) {
-            for (x = 0; x < deletedKeysInCacheCount; x++)
-            {
-               if (tmp_deleted_list[x] != NULL)
-               {
-                 free(tmp_deleted_list[x]);
-               }
-            }
-            free(tmp_deleted_list);
+      }
+   }
+   if (iter_ret_val == 0)
+   {
+      db->shared->keyCount = keyCount;
+      db->shared->keyListSize = (uint64_t) result;
+      db->shared->keyListValid = Kdb_true;
+   }
+   return result;
+}
+
+
+
+/*
+ * returns true if the key is in the list of keys: it is in cache and not marked as deleted or it is only in the database file
+ * the key is only looked up if the size of the key list is known, the caller holds the write lock of the database
+ */
+bool_t isKeyListed(KISSDB* db, pconststr_t key, uint64_t hash)
+{
+   pers_lldb_cache_flag_e eFlag = CachedDataDelete;
+   uint32_t size = 0;
+
+   if (db->shared->keyListValid != Kdb_true)
+   {
+      return false;
+   }
+   if (db->shared->cacheCreated == Kdb_true && openCache(db) == 0)
+   {
+      setMemoryAddress(db->sharedCache, db->tbl[0]);
+      if (db->tbl[0]->gethead(db->tbl[0], key, getCacheHash(hash), &eFlag, sizeof(eFlag)) == true)
+      {
+         return (eFlag != CachedDataDelete);
+      }
+   }
+   return (KISSDB_get(db, key, hash, NIL, 0, &size, NIL) == 0);
+}
+
+
+
+/*
+ * updates the number of keys and the size of the key list after the key was written or deleted,
+ * bListedBefore is the result of isKeyListed before the key was written or deleted, bListedAfter follows from the result
+ * of the write or delete, so the key is looked up only once
+ */
+void updateKeyList(KISSDB* db, pconststr_t key, bool_t bListedBefore, bool_t bListedAfter)
+{
+   if (db->shared->keyListValid != Kdb_true)
+   {
+      return;
+   }
+   if (bListedAfter && !bListedBefore)
+   {
+      db->shared->keyCount++;
+      db->shared->keyListSize += strlen(key) + sizeof(ListItemsSeparator);
+   }
+   else if (bListedBefore && !bListedAfter)
+   {
+      db->shared->keyCount--;
+      db->shared->keyListSize -= strlen(key) + sizeof(ListItemsSeparator);
+   }
+}
+
+
+
+/*
+ * returns the length of the next key of the cursor starting with the prefix of the cursor, 0 if all keys were returned
+ * the keys in cache which are not marked as deleted are returned first, then the keys in the database file which are not in cache
+ */
+sint_t getNextCursorKey(KISSDB* db, lldb_cursor_s* cursor, str_t* key)
+{
+   Kdb_bool cacheOpened = Kdb_false;
+   int iter_ret_val;
+   pers_lldb_cache_flag_e eFlag = CachedDataDelete;
+   size_t keyLen = 0;
+
+   if (db->shared->cacheCreated == Kdb_true)
+   {
+      if (openCache(db) != 0)
+      {
+         return PERS_COM_FAILURE;
+      }
+      setMemoryAddress(db->sharedCache, db->tbl[0]);
+      cacheOpened = Kdb_true;
+
+      while (!cursor->bInFile)
+      {
+         if (db->tbl[0]->getnextkey(db->tbl[0], key, PERS_DB_MAX_LENGTH_KEY_NAME, &eFlag, sizeof(eFlag), &cursor->cacheIdx) == false)
+         {
+            cursor->bInFile = true;
+            break;
          }
-         //count needed size for buffer / copy keys to buffer
-         idx = 0;
-         while (tbl->getnext(tbl, &obj, &idx) == true)
+         keyLen = strlen(key);
+         if (eFlag != CachedDataDelete && keyLen > 0 && strncmp(key, cursor->prefix, cursor->prefixLen) == 0)
          {
-            size_t keyLen = strlen(obj.name);
-            if (keyLen > 0)
-            {
-               if ((!bOnlySizeNeeded) && ((sint_t) keyLen < availableSize))
-               {
-                  (void) strncpy(buffer, obj.name, keyLen);
-                  *(buffer + keyLen) = ListItemsSeparator;
-                  buffer += (keyLen + sizeof(ListItemsSeparator));
-                  availableSize -= (sint_t) (keyLen + sizeof(ListItemsSeparator));
-               }
-            }
-            result += (sint_t) (keyLen + sizeof(ListItemsSeparator));
+            return (sint_t) keyLen;
          }
-         //release hashtable and allocated memory
-         tbl->free(tbl);
-         free(memory);
       }
-      else
+   }
+   cursor->bInFile = true;
+
+   //the key hash stored in the hashtable slot is used for the cache lookup, so the keys are not hashed again
+   while ((iter_ret_val = KISSDB_Iterator_nextStable(&cursor->fileIter, key, NULL)) > 0)
+   {
+      if (iter_ret_val == KISSDB_ITERATOR_NEXT_ITEM_FOUND)
       {
-         // free temporary list which holds the deleted keys that are not yet updated with file
-         if( tmp_deleted_list != NULL) {
-            for (x = 0; x < deletedKeysInCacheCount; x++)
-            {
-               if (tmp_deleted_list[x] != NULL)
-               {
-                 free(tmp_deleted_list[x]);
-               }
-            }
-            free(tmp_deleted_list);
-            free(tmplist);
+         keyLen = strnlen(key, PERS_DB_MAX_LENGTH_KEY_NAME);
+         if (keyLen > 0 && keyLen < PERS_DB_MAX_LENGTH_KEY_NAME && strncmp(key, cursor->prefix, cursor->prefixLen) == 0
+             && (cacheOpened == Kdb_false || db->tbl[0]->exists(db->tbl[0], key, getCacheHash(cursor->fileIter.hash)) == false))
+         {
+            return (sint_t) keyLen;
+         }
+      }
+   }
+   return (iter_ret_val < 0) ? PERS_COM_FAILURE : 0;
+}
+
+
+
+/*
+ * returns the length of the next key of a frozen image starting with the prefix of the cursor, 0 if all keys were returned
+ */
+sint_t getNextFrozenCursorKey(FROZENDB* db, lldb_cursor_s* cursor, str_t* key)
+{
+   const char* entryKey;
+   uint32_t keyLen = 0;
+
+   while (cursor->frozenIdx < db->header->keyCount)
+   {
+      entryKey = FROZENDB_getKey(db, cursor->frozenIdx, &keyLen);
+      if (entryKey == NIL || keyLen >= PERS_DB_MAX_LENGTH_KEY_NAME)
+      {
+         return PERS_COM_FAILURE;
+      }
+      cursor->frozenIdx++;
+      if (keyLen >= cursor->prefixLen && memcmp(entryKey, cursor->prefix, cursor->prefixLen) == 0)
+      {
+         (void) memcpy(key, entryKey, keyLen);
+         key[keyLen] = '\0';
+         return (sint_t) keyLen;
+      }
+   }
+   return 0;
+}
+
+
+
+/*
+ * completes the open of a frozen image, frozenState is the result of FROZENDB_open
+ */
+sint_t openFrozenDb(lldb_handler_s* pLldbHandler, pers_lldb_purpose_e ePurpose, str_t const* path, int frozenState)
+{
+   if (frozenState != 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+              DLT_STRING("FROZENDB_open: "); DLT_STRING("<"); DLT_STRING(path); DLT_STRING(">, "); DLT_STRING("retval=<"); DLT_INT(frozenState); DLT_STRING(">"));
+      (void) lldb_handles_DeinitHandle(pLldbHandler->dbHandler);
+      return PERS_COM_FAILURE;
+   }
+   lldb_handles_InitHandle(pLldbHandler, ePurpose, path);
+   pLldbHandler->bCompressValues = false;
+   pLldbHandler->bFrozen = true;
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO, DLT_STRING(LT_HDR), DLT_STRING(__FUNCTION__), DLT_STRING("Opened frozen image:"), DLT_STRING("<"),
+           DLT_STRING(path), DLT_STRING(">, "), DLT_STRING("keys=<"), DLT_INT((int) pLldbHandler->frozenDb.header->keyCount), DLT_STRING(">"));
+   return pLldbHandler->dbHandler;
+}
+
+
+
+/*
+ * writes the keys read from a file of version 2.x to the opened database, the keys of a local database are written as one batch
+ */
+sint_t writeVersion2Items(sint_t handlerDB, pers_lldb_purpose_e ePurpose, const FrozenDB_Item_s* items, uint32_t count)
+{
+   pconststr_t* keys;
+   pconststr_t* data;
+   sint_t* dataSizes;
+   sint_t result = 0;
+   uint32_t i;
+
+   if (PersLldbPurpose_DB != ePurpose || count == 0)
+   {
+      for (i = 0; i < count && result >= 0; i++)
+      {
+         result = pers_lldb_write_key(handlerDB, ePurpose, items[i].key, (str_t const*) items[i].value, (sint_t) items[i].valueSize);
+      }
+      return (result < 0) ? result : 0;
+   }
+
+   keys = (pconststr_t*) malloc(count * sizeof(pconststr_t));
+   data = (pconststr_t*) malloc(count * sizeof(pconststr_t));
+   dataSizes = (sint_t*) malloc(count * sizeof(sint_t));
+   if (keys == NIL || data == NIL || dataSizes == NIL)
+   {
+      result = PERS_COM_ERR_MALLOC;
+   }
+   else
+   {
+      for (i = 0; i < count; i++)
+      {
+         keys[i] = items[i].key;
+         data[i] = (pconststr_t) items[i].value;
+         dataSizes[i] = (sint_t) items[i].valueSize;
+      }
+      result = pers_lldb_write_keys(handlerDB, ePurpose, keys, data, dataSizes, (sint_t) count);
+      result = (result == (sint_t) count) ? 0 : PERS_COM_FAILURE;
+   }
+   free(keys);
+   free(data);
+   free(dataSizes);
+   return result;
+}
+
+
+
+/*
+ * converts a database file of version 2.x to the current version: its keys are written to a new database file,
+ * which then replaces it. Processes opening the file at the same time wait for the conversion by a lock of the file.
+ * Returns 0 if the file was converted or is not of version 2.x, negative value in case of error.
+ */
+sint_t convertVersion2Db(str_t const* dbPathname, pers_lldb_purpose_e ePurpose)
+{
+   char linkBuffer[256] = { 0 };
+   char tmpPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME + sizeof(".convert")];
+   FrozenDB_Item_s* items = NIL;
+   uint32_t count = 0;
+   const char* path = (1 == checkIsLink(dbPathname, linkBuffer)) ? linkBuffer : dbPathname;
+   uint32_t maxValueSize = 0;
+   struct stat sb;
+   sint_t result = 0;
+   sint_t handle = 0;
+   int fd;
+
+   if (KISSDB_getFileVersion(path) != KISSDB_MAJOR_VERSION_2)
+   {
+      return 0;
+   }
+   fd = open(path, O_RDONLY);
+   if (fd == -1 || flock(fd, LOCK_EX) != 0 || fstat(fd, &sb) != 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(": lock of <"); DLT_STRING(path); DLT_STRING("> failed: "); DLT_STRING(strerror(errno)));
+      if (fd != -1)
+      {
+         close(fd);
+      }
+      return PERS_COM_FAILURE;
+   }
+
+   //another process converted the file while this one waited for the lock
+   if (KISSDB_getFileVersion(path) == KISSDB_MAJOR_VERSION_2)
+   {
+      (void) snprintf(tmpPath, sizeof(tmpPath), "%s.convert", path);
+      (void) remove(tmpPath); //left by an interrupted conversion
+      result = (FROZENDB_readVersion2(path, &items, &count, &maxValueSize) == 0) ? 0 : PERS_COM_FAILURE;
+      if (result >= 0)
+      {
+         handle = pers_lldb_open_with_max_value_size(tmpPath, ePurpose, 0x3, (sint_t) maxValueSize); //create, write through
+         result = (handle < 0) ? handle : writeVersion2Items(handle, ePurpose, items, count);
+         if (handle >= 0 && pers_lldb_close(handle) != 0)
+         {
+            result = PERS_COM_FAILURE;
          }
-         return PERS_COM_ERR_MALLOC;
       }
+      if (result >= 0 && (chmod(tmpPath, sb.st_mode & 07777) != 0 || rename(tmpPath, path) != 0))
+      {
+         result = PERS_COM_FAILURE;
+      }
+      if (result < 0)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(": conversion of <"); DLT_STRING(path); DLT_STRING("> failed: "); DLT_INT(result));
+         (void) remove(tmpPath);
+      }
+      else
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(": converted <"); DLT_STRING(path); DLT_STRING("> of version 2.x, keys: "); DLT_INT((int) count));
+      }
+      FROZENDB_freeItems(items, count);
+   }
+   (void) flock(fd, LOCK_UN);
+   close(fd);
+   return result;
+}
+
+
+
+/*
+ * opens a read only database file of version 2.x: a frozen image of its keys is built and mapped,
+ * the image file is removed right away (the file itself can be replaced by an image of pers_frozen_db_builder)
+ */
+sint_t openVersion2Db(lldb_handler_s* pLldbHandler, pers_lldb_purpose_e ePurpose, str_t const* path)
+{
+   char imagePath[sizeof(PERS_LLDB_VERSION2_IMAGE_DIR) + 64];
+   int frozenState = FROZENDB_ERROR_IO;
+
+   (void) snprintf(imagePath, sizeof(imagePath), PERS_LLDB_VERSION2_IMAGE_DIR "/pers_version2_%d_%d.frz", (int) getpid(), (int) pLldbHandler->dbHandler);
+   if (FROZENDB_buildFromVersion2(imagePath, path) >= 0)
+   {
+      frozenState = FROZENDB_open(&pLldbHandler->frozenDb, imagePath);
+      (void) remove(imagePath); //the mapping keeps the image
+   }
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(": read only file <"); DLT_STRING(path);
+           DLT_STRING("> of version 2.x opened from a frozen image, retval=<"); DLT_INT(frozenState); DLT_STRING(">"));
+   return openFrozenDb(pLldbHandler, ePurpose, path, frozenState);
+}
+
+
+
+/*
+ * reads a cached (bCached) or an inline or compressed value of size bytes into an allocated buffer, freed by ReleaseViewFromKissLocalDB
+ */
+sint_t getCopyView(KISSDB* db, pconststr_t key, uint64_t hash, bool_t bCached, sint_t size, void const** data_out)
+{
+   sint_t bytesRead = PERS_COM_ERR_MALLOC;
+   char* buffer = (char*) malloc((size_t) size + 1); //the view of an empty value is not NULL
+
+   if (buffer != NIL)
+   {
+      bytesRead = bCached ? getFromCache(db, (char*) key, hash, buffer, size, false) : getFromDatabaseFile(db, (char*) key, hash, buffer, size);
+      if (bytesRead < 0)
+      {
+         free(buffer);
+      }
+      else
+      {
+         *data_out = buffer;
+      }
+   }
+   return bytesRead;
+}
+
+/*
+ * reads a value from a frozen image, like for the database file only the size of the value is returned if readBuffer is too small
+ */
+sint_t getFromFrozenDb(FROZENDB* db, pconststr_t key, void* readBuffer, sint_t bufsize)
+{
+   const void* value = NIL;
+   uint32_t valueSize = 0;
+
+   if (FROZENDB_get(db, key, &value, &valueSize) != 0)
+   {
+      return PERS_COM_ERR_NOT_FOUND;
+   }
+   if (readBuffer != NIL && bufsize >= (sint_t) valueSize)
+   {
+      (void) memcpy(readBuffer, value, valueSize);
+   }
+   return (sint_t) valueSize;
+}
+
+
+
+sint_t getFrozenListandSize(FROZENDB* db, pstr_t buffer, sint_t size, bool_t bOnlySizeNeeded)
+{
+   const char* key;
+   sint_t availableSize = size;
+   sint_t result = 0;
+   uint32_t keyLen = 0;
+   uint32_t i;
+
+   for (i = 0; i < db->header->keyCount; i++)
+   {
+      key = FROZENDB_getKey(db, i, &keyLen);
+      if (key == NIL)
+      {
+         return PERS_COM_FAILURE;
+      }
+      result += appendKeyToList(key, keyLen, &buffer, &availableSize, bOnlySizeNeeded);
    }
    return result;
 }
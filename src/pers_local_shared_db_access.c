@@ -47,7 +47,7 @@ int persComDbgetMaxKeyValueSize(void)
  * \note : DB is created if it does not exist and (bForceCreationIfNotPresent != 0)
  *
  * \param dbPathname    [in] absolute path to database (length limited to \ref PERS_ORG_MAX_LENGTH_PATH_FILENAME)
- * \param bOption       [in] bitfield option: 0x01: create if not exists, 0x02: write through, 0x04: read only
+ * \param bOption       [in] bitfield option: 0x01: create if not exists, 0x02: write through, 0x04: read only, 0x08: compress values
  * \Remarks the support of the option depends from backend database realisation
  * \return >= 0 for valid handler, negative value for error (\ref PERS_COM_ERROR_CODES_DEFINES)
  */
@@ -75,6 +75,66 @@ signed int persComDbOpen(char const * dbPathname, unsigned char bOption)
     return iErrCode ;
 }
 
+/**
+ * \brief Obtain a handler to DB indicated by dbPathname, a created DB supports keys with a data size up to maxValueSize
+ * \note : the max. size is stored in the DB when it is created, an existing DB keeps the max. size it was created with
+ *
+ * \param dbPathname    [in] absolute path to database (length limited to \ref PERS_ORG_MAX_LENGTH_PATH_FILENAME)
+ * \param bOption       [in] bitfield option: 0x01: create if not exists, 0x02: write through, 0x04: read only, 0x08: compress values
+ * \param maxValueSize  [in] max. size of key's data in a created DB (limited to \ref PERS_DB_MAX_SIZE_KEY_DATA_LIMIT)
+ * \return >= 0 for valid handler, negative value for error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbOpenWithMaxValueSize(char const * dbPathname, unsigned char bOption, signed int maxValueSize)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (NIL == dbPathname)
+        ||  (maxValueSize <= 0)
+        ||  (maxValueSize > PERS_DB_MAX_SIZE_KEY_DATA_LIMIT)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    else
+    {
+        if(strlen(dbPathname) >= PERS_ORG_MAX_LENGTH_PATH_FILENAME)
+        {
+            iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+        }
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_open_with_max_value_size(dbPathname, PersLldbPurpose_DB, bOption, maxValueSize);
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief returns the max key data size supported by an opened database
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ *
+ * \return max size in byte, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbGetMaxValueSize(signed int handlerDB)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(handlerDB < 0)
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_get_max_value_size(handlerDB, PersLldbPurpose_DB) ;
+    }
+
+    return iErrCode ;
+}
+
 /**
  * \brief Close handler to DB
  *
@@ -105,7 +165,7 @@ signed int persComDbClose(signed int handlerDB)
  * \param handlerDB     [in] handler obtained with persComDbOpen
  * \param key           [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
  * \param data          [in] buffer with key's data
- * \param dataSize      [in] size of key's data (max allowed \ref PERS_DB_MAX_SIZE_KEY_DATA)
+ * \param dataSize      [in] size of key's data (max allowed \ref persComDbGetMaxValueSize)
  *
  * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
  */
@@ -117,7 +177,7 @@ signed int persComDbWriteKey(signed int handlerDB, char const * key, char const
         ||  (NIL == key)
         ||  (NIL == data)
         ||  (dataSize <= 0)
-        ||  (dataSize > PERS_DB_MAX_SIZE_KEY_DATA)
+        ||  (dataSize > PERS_DB_MAX_SIZE_KEY_DATA_LIMIT) /* the max. size of the DB is checked when the data is written */
     )
     {
         iErrCode = PERS_COM_ERR_INVALID_PARAM ;
@@ -139,6 +199,53 @@ signed int persComDbWriteKey(signed int handlerDB, char const * key, char const
 }
 
 
+/**
+ * \brief write several key-value pairs into local/shared database at once
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param keys          [in] keys' names (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param data          [in] buffers with keys' data
+ * \param dataSizes     [in] sizes of keys' data (max allowed \ref persComDbGetMaxValueSize)
+ * \param count         [in] number of keys
+ *
+ * \return number of written keys, or negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbWriteKeys(signed int handlerDB, char const * const * keys, char const * const * data, signed int const * dataSizes, signed int count)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+    sint_t i = 0 ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == keys)
+        ||  (NIL == data)
+        ||  (NIL == dataSizes)
+        ||  (count <= 0)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    for(i = 0; (PERS_COM_SUCCESS == iErrCode) && (i < count); i++)
+    {
+        if(     (NIL == keys[i])
+            ||  (NIL == data[i])
+            ||  (dataSizes[i] <= 0)
+            ||  (dataSizes[i] > PERS_DB_MAX_SIZE_KEY_DATA_LIMIT) /* the max. size of the DB is checked when the data is written */
+            ||  (strlen(keys[i]) >= PERS_DB_MAX_LENGTH_KEY_NAME)
+        )
+        {
+            iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+        }
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_write_keys(handlerDB, PersLldbPurpose_DB, keys, data, dataSizes, count) ;
+    }
+
+    return iErrCode ;
+}
+
+
 /**
  * \brief read a key's value from local/shared database
  *
@@ -177,6 +284,116 @@ signed int persComDbReadKey(signed int handlerDB, char const * key, char* dataBu
     return iErrCode ;
 }
 
+/**
+ * \brief read the values of several keys from local/shared database at once
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param keys              [in] keys' names (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param dataBuffers_out   [out]buffers where to return the read data
+ * \param bufferSizes       [in] sizes of dataBuffers_out
+ * \param results_out       [out]read size or negative value (\ref PERS_COM_ERROR_CODES_DEFINES) of every key
+ * \param count             [in] number of keys
+ *
+ * \return number of keys read, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReadKeys(signed int handlerDB, char const * const * keys, char * const * dataBuffers_out, signed int const * bufferSizes,
+                             signed int * results_out, signed int count)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+    sint_t i = 0 ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == keys)
+        ||  (NIL == dataBuffers_out)
+        ||  (NIL == bufferSizes)
+        ||  (NIL == results_out)
+        ||  (count <= 0)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    for(i = 0; (PERS_COM_SUCCESS == iErrCode) && (i < count); i++)
+    {
+        if(     (NIL == keys[i])
+            ||  (NIL == dataBuffers_out[i])
+            ||  (bufferSizes[i] <= 0)
+            ||  (strlen(keys[i]) >= PERS_DB_MAX_LENGTH_KEY_NAME)
+        )
+        {
+            iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+        }
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_read_keys(handlerDB, PersLldbPurpose_DB, keys, dataBuffers_out, bufferSizes, results_out, count) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief return a read-only view of a key's value in local/shared database without copying it
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param key               [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param data_out          [out]returns the address of the value
+ *
+ * \return size of the value, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReadKeyView(signed int handlerDB, char const * key, void const ** data_out)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == key)
+        ||  (NIL == data_out)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    else
+    {
+        if(strlen(key) >= PERS_DB_MAX_LENGTH_KEY_NAME)
+        {
+            iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+        }
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_read_key_view(handlerDB, PersLldbPurpose_DB, key, data_out) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief release a view returned by persComDbReadKeyView
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param data              [in] address returned by persComDbReadKeyView
+ *
+ * \return 0 for success, negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReleaseView(signed int handlerDB, void const * data)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == data)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    else
+    {
+        iErrCode = pers_lldb_release_view(handlerDB, PersLldbPurpose_DB, data) ;
+    }
+
+    return iErrCode ;
+}
+
 /**
  * \brief read a key's value from local/shared database
  *
@@ -300,3 +517,114 @@ signed int persComDbGetKeysList(signed int handlerDB, char* listBuffer_out, sign
     return iErrCode ;
 }
 
+
+
+/**
+ * \brief Open a cursor which returns the keys' names in local/shared database one by one
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param prefix        [in] only keys starting with prefix are returned, NULL for all keys
+ *
+ * \return 0 for success, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbIterOpen(signed int handlerDB, char const * prefix)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  ((NIL != prefix) && (strlen(prefix) >= PERS_DB_MAX_LENGTH_KEY_NAME))
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_iter_open(handlerDB, PersLldbPurpose_DB, prefix) ;
+    }
+
+    return iErrCode ;
+}
+
+
+/**
+ * \brief Obtain the next key's name of the cursor opened with persComDbIterOpen
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param keyBuffer_out     [out]buffer where to return the key's name (null terminated)
+ * \param keyBufferSize     [in] size of keyBuffer_out
+ *
+ * \return length of the key's name, 0 if all keys were returned, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbIterNext(signed int handlerDB, char* keyBuffer_out, signed int keyBufferSize)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == keyBuffer_out)
+        ||  (keyBufferSize <= 0)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_iter_next(handlerDB, PersLldbPurpose_DB, keyBuffer_out, keyBufferSize) ;
+    }
+
+    return iErrCode ;
+}
+
+
+/**
+ * \brief Close the cursor opened with persComDbIterOpen
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ *
+ * \return 0 for success, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbIterClose(signed int handlerDB)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(handlerDB < 0)
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_iter_close(handlerDB, PersLldbPurpose_DB) ;
+    }
+
+    return iErrCode ;
+}
+
+
+
+/**
+ * \brief Compact a local/shared database
+ * \note : the space of deleted and overwritten keys is released and the database file is truncated,
+ *          the database can stay opened by other processes during the compaction
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ *
+ * \return >=0 for the number of bytes reclaimed, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbCompact(signed int handlerDB)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(handlerDB < 0)
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_compact(handlerDB, PersLldbPurpose_DB) ;
+    }
+
+    return iErrCode ;
+}
@@ -70,6 +70,9 @@ typedef struct
    // SQLite satetments to find modified and deleted items in cached table
    sqlite3_stmt *stmtSelectModCache;
    sqlite3_stmt *stmtSelectDelCache;
+   // SQLite statement of the key cursor (pers_lldb_iter_open), NULL if the cursor is closed
+   sqlite3_stmt *stmtIter;
+   str_t iterPrefix[PERS_DB_MAX_LENGTH_KEY_NAME];
 
    str_t dbPathname[PERS_ORG_MAX_LENGTH_PATH_FILENAME];
 } lldb_handler_s;
@@ -279,6 +282,15 @@ sint_t pers_lldb_open(str_t const * dbPathname, pers_lldb_purpose_e ePurpose, bo
 
 
 
+/* the values are stored as BLOBs without a fixed size, so the maximum value size is not needed */
+sint_t pers_lldb_open_with_max_value_size(str_t const * dbPathname, pers_lldb_purpose_e ePurpose, bool_t bForceCreationIfNotPresent, sint_t maxValueSize)
+{
+   (void) maxValueSize;
+   return pers_lldb_open(dbPathname, ePurpose, bForceCreationIfNotPresent);
+}
+
+
+
 sint_t pers_lldb_close(sint_t handlerDB)
 {
    sint_t rval = PERS_COM_SUCCESS;
@@ -417,6 +429,49 @@ sint_t pers_lldb_write_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
 
 
 
+/* the keys are written in one transaction, so the database file is synced once */
+sint_t pers_lldb_write_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, str_t const * const * data, sint_t const * dataSizes, sint_t count)
+{
+   sint_t rval = PERS_COM_SUCCESS;
+   sint_t i = 0;
+   char* errMsg = NULL;
+   lldb_handler_s* pLldbHandler = NIL;
+
+   if((handlerDB >= 0) && (NIL != keys) && (NIL != data) && (NIL != dataSizes) && (count > 0))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(handlerDB);
+   }
+   if (NIL == pLldbHandler)
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   if(sqlite3_exec(pLldbHandler->sqlDb, "BEGIN TRANSACTION;", NULL, 0, &errMsg) != SQLITE_OK)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING("pers_lldb_write_keys - SQL -" ), DLT_STRING(errMsg));
+      sqlite3_free(errMsg);
+      return PERS_COM_FAILURE;
+   }
+   for(i = 0; (i < count) && (rval >= 0); i++)
+   {
+      rval = pers_lldb_write_key(handlerDB, ePurpose, keys[i], data[i], dataSizes[i]);
+   }
+   //the keys written before a failed key are committed, keys[i - 1] failed
+   if(sqlite3_exec(pLldbHandler->sqlDb, "COMMIT TRANSACTION;", NULL, 0, &errMsg) != SQLITE_OK)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING("pers_lldb_write_keys - SQL -" ), DLT_STRING(errMsg));
+      sqlite3_free(errMsg);
+      return PERS_COM_FAILURE;
+   }
+   if (rval >= 0)
+   {
+      return count;
+   }
+   return (i > 1) ? (i - 1) : rval;
+}
+
+
+
 sint_t pers_lldb_read_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * key, pstr_t dataBuffer_out, sint_t bufSize)
 {
    sint_t rval = PERS_COM_FAILURE;
@@ -527,6 +582,96 @@ sint_t pers_lldb_read_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
 
 
 
+/* the keys are read in one transaction, so all values are read from the same state of the database */
+sint_t pers_lldb_read_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, pstr_t const * dataBuffers_out, sint_t const * bufSizes,
+                           sint_t * results_out, sint_t count)
+{
+   sint_t rval = 0;
+   sint_t i = 0;
+   char* errMsg = NULL;
+   lldb_handler_s* pLldbHandler = NIL;
+
+   if((handlerDB >= 0) && (NIL != keys) && (NIL != dataBuffers_out) && (NIL != bufSizes) && (NIL != results_out) && (count > 0))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(handlerDB);
+   }
+   if (NIL == pLldbHandler)
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   if(sqlite3_exec(pLldbHandler->sqlDb, "BEGIN TRANSACTION;", NULL, 0, &errMsg) != SQLITE_OK)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING("pers_lldb_read_keys - SQL -" ), DLT_STRING(errMsg));
+      sqlite3_free(errMsg);
+      return PERS_COM_FAILURE;
+   }
+   for(i = 0; i < count; i++)
+   {
+      results_out[i] = pers_lldb_read_key(handlerDB, ePurpose, keys[i], dataBuffers_out[i], bufSizes[i]);
+      if(results_out[i] > bufSizes[i])
+      {
+         results_out[i] = PERS_COM_ERR_BUFFER_TOO_SMALL;
+      }
+      if(results_out[i] >= 0)
+      {
+         rval++;
+      }
+   }
+   if(sqlite3_exec(pLldbHandler->sqlDb, "COMMIT TRANSACTION;", NULL, 0, &errMsg) != SQLITE_OK)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING("pers_lldb_read_keys - SQL -" ), DLT_STRING(errMsg));
+      sqlite3_free(errMsg);
+   }
+   return rval;
+}
+
+
+
+/* the values are not mapped: a view is a copy of the value, freed by pers_lldb_release_view */
+sint_t pers_lldb_read_key_view(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * key, void const ** data_out)
+{
+   sint_t rval = PERS_COM_ERR_INVALID_PARAM;
+   pstr_t copy = NIL;
+
+   if ((PersLldbPurpose_DB == ePurpose) && (NIL != key) && (NIL != data_out))
+   {
+      rval = pers_lldb_get_key_size(handlerDB, ePurpose, key);
+   }
+   if (rval >= 0)
+   {
+      copy = (pstr_t) malloc((rval > 0) ? (size_t) rval : 1);
+      if (NIL == copy)
+      {
+         return PERS_COM_ERR_MALLOC;
+      }
+      rval = pers_lldb_read_key(handlerDB, ePurpose, key, copy, rval);
+      if (rval >= 0)
+      {
+         *data_out = copy;
+      }
+      else
+      {
+         free(copy);
+      }
+   }
+   return rval;
+}
+
+
+
+sint_t pers_lldb_release_view(sint_t handlerDB, pers_lldb_purpose_e ePurpose, void const * data)
+{
+   if ((PersLldbPurpose_DB != ePurpose) || (NIL == data) || (handlerDB < 0) || (NIL == lldb_handles_FindInUseHandle(handlerDB)))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   free((void*) data);
+   return PERS_COM_SUCCESS;
+}
+
+
+
 sint_t pers_lldb_get_key_size(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * key)
 {
    sint_t rval = PERS_COM_ERR_INVALID_PARAM;
@@ -842,6 +987,124 @@ sint_t pers_lldb_get_keys_list(sint_t handlerDB, pers_lldb_purpose_e ePurpose, p
 
 
 
+/* the cursor has its own statement, so listing the keys while the cursor is open does not reset it */
+sint_t pers_lldb_iter_open(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * prefix)
+{
+   const char* sql = NULL;
+   lldb_handler_s* pLldbHandler = NIL;
+
+   (void) ePurpose;
+   if ((handlerDB >= 0) && ((NIL == prefix) || (strlen(prefix) < PERS_DB_MAX_LENGTH_KEY_NAME)))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(handlerDB);
+   }
+   if (NIL == pLldbHandler)
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   sqlite3_finalize(pLldbHandler->stmtIter);
+   pLldbHandler->stmtIter = NULL;
+   sql = (pLldbHandler->bIsCached == true) ? gSqlSelectCacheWt : gSqlSelectAll;
+   if(sqlite3_prepare_v2(pLldbHandler->sqlDb, sql, (int)strlen(sql), &pLldbHandler->stmtIter, 0) != SQLITE_OK)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING("pers_lldb_iter_open - SQL - failed to compile statement" ));
+      return PERS_COM_FAILURE;
+   }
+   (void) strncpy(pLldbHandler->iterPrefix, (NIL != prefix) ? prefix : "", sizeof(pLldbHandler->iterPrefix));
+   return PERS_COM_SUCCESS;
+}
+
+
+
+sint_t pers_lldb_iter_next(sint_t handlerDB, pers_lldb_purpose_e ePurpose, pstr_t keyBuffer_out, sint_t bufSize)
+{
+   sint_t rval = 0;
+   int rc = -1;
+   int keyLen = 0;
+   const char* key = NULL;
+   lldb_handler_s* pLldbHandler = NIL;
+
+   (void) ePurpose;
+   if ((handlerDB >= 0) && (NIL != keyBuffer_out) && (bufSize > 0))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(handlerDB);
+   }
+   if ((NIL == pLldbHandler) || (NULL == pLldbHandler->stmtIter))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   while ((rval == 0) && ((rc = sqlite3_step(pLldbHandler->stmtIter)) == SQLITE_ROW))
+   {
+      key = (const char*)sqlite3_column_text(pLldbHandler->stmtIter, 0);
+      keyLen = sqlite3_column_bytes(pLldbHandler->stmtIter, 0);
+      if (((pLldbHandler->bIsCached == true) && (sqlite3_column_int(pLldbHandler->stmtIter, 2) == 1))  // deleted in cache
+          || (strncmp(key, pLldbHandler->iterPrefix, strlen(pLldbHandler->iterPrefix)) != 0))
+      {
+         continue;
+      }
+      if (keyLen >= bufSize)
+      {
+         //the row can not be read again, so the key is skipped
+         rval = PERS_COM_ERR_BUFFER_TOO_SMALL;
+      }
+      else
+      {
+         (void) memcpy(keyBuffer_out, key, (size_t)keyLen + 1);
+         rval = keyLen;
+      }
+   }
+   if ((rc != SQLITE_ROW) && (rc != SQLITE_DONE))
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING("pers_lldb_iter_next - SQL - step failed" ));
+      rval = PERS_COM_FAILURE;
+   }
+   return rval;
+}
+
+
+
+sint_t pers_lldb_iter_close(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+   lldb_handler_s* pLldbHandler = NIL;
+
+   (void) ePurpose;
+   if (handlerDB >= 0)
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(handlerDB);
+   }
+   if ((NIL == pLldbHandler) || (NULL == pLldbHandler->stmtIter))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   sqlite3_finalize(pLldbHandler->stmtIter);
+   pLldbHandler->stmtIter = NULL;
+   return PERS_COM_SUCCESS;
+}
+
+
+
+sint_t pers_lldb_compact(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+   (void) handlerDB;
+   (void) ePurpose;
+   return PERS_COM_ERR_OPERATION_NOT_SUPPORTED;
+}
+
+
+
+sint_t pers_lldb_get_max_value_size(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+   if ((handlerDB < 0) || (NIL == lldb_handles_FindInUseHandle(handlerDB)))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   return (PersLldbPurpose_RCT == ePurpose) ? (sint_t) sizeof(PersistenceConfigurationKey_s) : PERS_DB_MAX_SIZE_KEY_DATA;
+}
+
+
+
 static lldb_handler_s* lldb_handles_FindAvailableHandle(void)
 {
     bool_t bCanContinue = true;
@@ -956,6 +1219,7 @@ static void lldb_handles_InitHandle(lldb_handler_s* psHandle_inout, pers_lldb_pu
 {
    psHandle_inout->bIsAssigned = true;
    psHandle_inout->ePurpose = ePurpose;
+   psHandle_inout->stmtIter = NULL;
    (void) strncpy(psHandle_inout->dbPathname, dbPathname, sizeof(psHandle_inout->dbPathname));
 }
 
@@ -1331,6 +1595,9 @@ void dbHelper_finalizeSQLiteStmt(lldb_handler_s* dbHandler)
       sqlite3_finalize(dbHandler->stmtSelectAll);
 
       sqlite3_finalize(dbHandler->stmtDelete);
+
+      sqlite3_finalize(dbHandler->stmtIter);
+      dbHandler->stmtIter = NULL;
    }
 }
 
@@ -0,0 +1,160 @@
+/******************************************************************************
+ * Project         persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+/**
+* @file           benchmark_kvs_lookup.c
+* @ingroup        persistency
+* @brief          benchmark of the page faults of key lookups in a key value store database on a cold page cache
+* @see
+*/
+
+/*
+ * For every database size, the database file is dropped from the page cache and reopened:
+ * the page faults per lookup are reported for keys that exist and for keys that are not in the database.
+ * Key length and key hash stored in the hashtable slots reject non matching slots without reading a data block,
+ * so lookups of missing keys cause much fewer page faults than lookups of existing keys.
+ * The hashtables are loaded by lookups of other missing keys before the page faults are counted.
+ *
+ * usage: benchmark_kvs_lookup [number of keys of the largest database]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include <dlt/dlt.h>
+#include <../inc/protected/persComDbAccess.h>
+#include <../inc/protected/persComErrors.h>
+
+
+#define BENCHMARK_DB_PATH        "/tmp/benchmark-lookup.db"
+#define BENCHMARK_MAX_VALUE_SIZE 1024
+
+
+/* returns the number of page faults (minor and major) of this process */
+static long getPageFaults(void)
+{
+   struct rusage usage;
+
+   getrusage(RUSAGE_SELF, &usage);
+   return usage.ru_minflt + usage.ru_majflt;
+}
+
+
+static int createDatabase(int keys)
+{
+   char key[64] = { 0 };
+   char value[BENCHMARK_MAX_VALUE_SIZE] = { 0 };
+   int handle = 0;
+   int ret = 0;
+   int i = 0;
+
+   remove(BENCHMARK_DB_PATH);
+   handle = persComDbOpen(BENCHMARK_DB_PATH, 0x3); //create, write through
+   if (handle < 0)
+   {
+      return handle;
+   }
+   for (i = 0; i < keys && ret >= 0; i++)
+   {
+      snprintf(key, sizeof(key), "benchmark/key_%d", i);
+      snprintf(value, sizeof(value), "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, value, strlen(value));
+   }
+   persComDbClose(handle);
+   return (ret < 0) ? ret : 0;
+}
+
+
+/* drops the database file from the page cache */
+static int dropDatabase(void)
+{
+   int fd = open(BENCHMARK_DB_PATH, O_RDONLY);
+
+   if (fd == -1)
+   {
+      return -1;
+   }
+   posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+   close(fd);
+   return 0;
+}
+
+
+/* returns the page faults of the lookups of the keys with the given prefix, -1 if a lookup has an unexpected result */
+static long lookupKeys(int handle, const char* prefix, int keys, int exist)
+{
+   char key[64] = { 0 };
+   char value[BENCHMARK_MAX_VALUE_SIZE] = { 0 };
+   long faults = getPageFaults();
+   int ret = 0;
+   int i = 0;
+
+   for (i = 0; i < keys; i++)
+   {
+      snprintf(key, sizeof(key), "%s%d", prefix, i);
+      ret = persComDbReadKey(handle, key, value, sizeof(value));
+      if ((exist != 0 && ret <= 0) || (exist == 0 && ret != PERS_COM_ERR_NOT_FOUND))
+      {
+         return -1;
+      }
+   }
+   return getPageFaults() - faults;
+}
+
+
+int main(int argc, char* argv[])
+{
+   int maxKeys = (argc > 1) ? atoi(argv[1]) : 100000;
+   int keys = 0;
+   int handle = 0;
+   long hitFaults = 0;
+   long missFaults = 0;
+
+   DLT_REGISTER_APP("PCOb", "benchmark of the persistence common object library");
+
+   printf("%10s %22s %22s\n", "keys", "faults/existing key", "faults/missing key");
+   for (keys = 1000; keys <= maxKeys; keys *= 10)
+   {
+      if (createDatabase(keys) != 0 || dropDatabase() != 0)
+      {
+         printf("failed to create database with %d keys\n", keys);
+         return EXIT_FAILURE;
+      }
+      handle = persComDbOpen(BENCHMARK_DB_PATH, 0x2); //write through
+      if (handle < 0)
+      {
+         printf("failed to reopen database: %d\n", handle);
+         return EXIT_FAILURE;
+      }
+      if (lookupKeys(handle, "benchmark/warmup_", keys, 0) < 0)
+      {
+         printf("missing key found\n");
+         return EXIT_FAILURE;
+      }
+      missFaults = lookupKeys(handle, "benchmark/missing_", keys, 0);
+      hitFaults = lookupKeys(handle, "benchmark/key_", keys, 1);
+      persComDbClose(handle);
+      if (missFaults < 0 || hitFaults < 0)
+      {
+         printf("wrong lookup result\n");
+         return EXIT_FAILURE;
+      }
+      printf("%10d %22.4f %22.4f\n", keys, (double) hitFaults / keys, (double) missFaults / keys);
+   }
+   remove(BENCHMARK_DB_PATH);
+
+   DLT_UNREGISTER_APP();
+   return EXIT_SUCCESS;
+}
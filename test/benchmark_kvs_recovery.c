@@ -0,0 +1,174 @@
+/******************************************************************************
+ * Project         persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+/**
+* @file           benchmark_kvs_recovery.c
+* @ingroup        persistency
+* @brief          benchmark of the recovery of a key value store database after a power loss
+* @see
+*/
+
+/*
+ * For every database size, the hashtables of the database file are made corrupt and the database is reopened:
+ * the hashtables are rebuilt by a scan of the whole file and the data blocks of all keys are checked.
+ * The recovery time is reported for every number of recovery threads (the database file is in the page cache),
+ * a database file smaller than KISSDB_RECOVERY_MIN_RANGE_SIZE bytes per thread is recovered by less threads.
+ *
+ * usage: benchmark_kvs_recovery [number of keys of the largest database]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <dlt/dlt.h>
+#include <../inc/protected/persComDbAccess.h>
+#include <../inc/protected/persComErrors.h>
+#include <../src/key-value-store/database/kissdb.h>
+
+
+#define BENCHMARK_DB_PATH             "/tmp/benchmark-recovery.db"
+#define BENCHMARK_HEADER_SIZE         4096   /* size of the database header */
+#define BENCHMARK_CLOSE_FAILED_OFFSET 16     /* offset of the close failed flag in the header */
+#define BENCHMARK_MAX_VALUE_SIZE      1024
+
+
+static long long getDurationUs(struct timespec* start, struct timespec* end)
+{
+   return (end->tv_sec - start->tv_sec) * 1000000LL + (end->tv_nsec - start->tv_nsec) / 1000;
+}
+
+
+/* size of the value of key number i: 16 to 1000 bytes */
+static int getValueSize(int i)
+{
+   return 16 + (i * 7919) % 985;
+}
+
+
+static int createDatabase(int keys)
+{
+   char key[64] = { 0 };
+   char value[BENCHMARK_MAX_VALUE_SIZE] = { 0 };
+   int handle = 0;
+   int ret = 0;
+   int i = 0;
+
+   remove(BENCHMARK_DB_PATH);
+   handle = persComDbOpen(BENCHMARK_DB_PATH, 0x3); //create, write through
+   if (handle < 0)
+   {
+      return handle;
+   }
+   for (i = 0; i < keys && ret >= 0; i++)
+   {
+      snprintf(key, sizeof(key), "benchmark/key_%d", i);
+      memset(value, 'a' + i % 26, sizeof(value));
+      ret = persComDbWriteKey(handle, key, value, getValueSize(i));
+   }
+   persComDbClose(handle);
+   return (ret < 0) ? ret : 0;
+}
+
+
+/* sets the close failed flag and makes the first hashtable corrupt: the next open rebuilds the hashtables */
+static int breakDatabase(void)
+{
+   uint64_t flag = 0x01;
+   char corrupt = 'x';
+   int fd = open(BENCHMARK_DB_PATH, O_RDWR);
+
+   if (fd == -1)
+   {
+      return -1;
+   }
+   if (pwrite(fd, &flag, sizeof(flag), BENCHMARK_CLOSE_FAILED_OFFSET) != sizeof(flag)
+         || pwrite(fd, &corrupt, sizeof(corrupt), BENCHMARK_HEADER_SIZE + 100) != sizeof(corrupt))
+   {
+      close(fd);
+      return -1;
+   }
+   close(fd);
+   return 0;
+}
+
+
+/* returns the number of keys which cannot be read after the recovery */
+static int verifyDatabase(int handle, int keys)
+{
+   char key[64] = { 0 };
+   char value[BENCHMARK_MAX_VALUE_SIZE] = { 0 };
+   int errors = 0;
+   int i = 0;
+
+   for (i = 0; i < keys; i++)
+   {
+      snprintf(key, sizeof(key), "benchmark/key_%d", i);
+      if (persComDbReadKey(handle, key, value, sizeof(value)) != getValueSize(i))
+      {
+         errors++;
+      }
+   }
+   return errors;
+}
+
+
+int main(int argc, char* argv[])
+{
+   struct timespec start, end;
+   struct stat sb;
+   int threads[] = { 1, 2, 4, KISSDB_RECOVERY_MAX_THREADS };
+   int maxKeys = (argc > 1) ? atoi(argv[1]) : 100000;
+   int keys = 0;
+   int handle = 0;
+   int errors = 0;
+   unsigned int t = 0;
+
+   DLT_REGISTER_APP("PCOb", "benchmark of the persistence common object library");
+
+   printf("%10s %12s %8s %14s\n", "keys", "file size", "threads", "recovery");
+   for (keys = 1000; keys <= maxKeys; keys *= 10)
+   {
+      if (createDatabase(keys) != 0 || stat(BENCHMARK_DB_PATH, &sb) != 0)
+      {
+         printf("failed to create database with %d keys\n", keys);
+         return EXIT_FAILURE;
+      }
+      for (t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+      {
+         if (breakDatabase() != 0)
+         {
+            printf("failed to make database corrupt\n");
+            return EXIT_FAILURE;
+         }
+         KISSDB_setRecoveryThreads(threads[t]);
+         clock_gettime(CLOCK_MONOTONIC, &start);
+         handle = persComDbOpen(BENCHMARK_DB_PATH, 0x0);
+         clock_gettime(CLOCK_MONOTONIC, &end);
+         if (handle < 0)
+         {
+            printf("failed to reopen database: %d\n", handle);
+            return EXIT_FAILURE;
+         }
+         errors = verifyDatabase(handle, keys);
+         persComDbClose(handle);
+         printf("%10d %9.1f MB %8d %11.1f ms%s\n", keys, sb.st_size / (1024.0 * 1024.0), threads[t],
+                getDurationUs(&start, &end) / 1000.0, (errors != 0) ? " (keys lost)" : "");
+      }
+   }
+   remove(BENCHMARK_DB_PATH);
+
+   DLT_UNREGISTER_APP();
+   return EXIT_SUCCESS;
+}
@@ -19,17 +19,22 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <errno.h>
 #include <unistd.h>     /* exit */
 #include <time.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
 
 #include <dlt/dlt.h>
 #include <dlt/dlt_common.h>
 #include <../inc/protected/persComRct.h>
 #include <../inc/protected/persComDbAccess.h>
 #include <../inc/protected/persComErrors.h>
+#include <../src/key-value-store/database/kissdb.h>
+#include <../src/key-value-store/database/frozendb.h>
 //#include <../test/pers_com_test_base.h>
 //#include <../test/pers_com_check.h>
 #include <check.h>
@@ -83,6 +88,93 @@ static void createPidFile(pid_t pid)
 }
 
 
+/*
+ * Layout of a key-value-store database file, used by the tests that make a database file corrupt
+ * IF DATABASE HEADER STRUCTURES OR KEY VALUE PAIR STORAGE CHANGES, these values must be updated
+ */
+#define KVS_HEADER_SIZE               4096        /* size of the database header */
+#define KVS_HEADER_CHECKSUM_ALGORITHM_OFFSET 64   /* offset of the checksum algorithm in the header */
+#define KVS_HEADER_KEY_HASH_ALGORITHM_OFFSET 72   /* offset of the key hash algorithm in the header */
+#define KVS_HEADER_CHECKPOINT_OFFSET  208         /* offset of the checkpoint number in the header */
+#define KVS_HASHTABLE_SIZE            12288       /* size of a hashtable */
+#define KVS_HASHTABLE_START_DELIMITER 0x33333333
+#define KVS_DATA_BLOCK_ALIGNMENT      256         /* data blocks and hashtables are aligned to the smallest data block size */
+#define KVS_DATA_BLOCK_KEY_OFFSET     16          /* offset of the key in a data block */
+#define KVS_DATA_BLOCK_VALUE_OFFSET   156         /* offset of the value in a data block */
+
+
+/* returns the file offset of data block A (blockNumber 0) or block B (blockNumber 1) of a key or -1 if not found */
+static off_t findDataBlock(const char* path, const char* key, int blockNumber)
+{
+   off_t offset = -1;
+   off_t i = 0;
+   struct stat sb;
+   char* memory = NULL;
+   int fd = open(path, O_RDONLY);
+
+   if(fd != -1)
+   {
+      if(fstat(fd, &sb) == 0)
+      {
+         memory = (char*) mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+         if(memory != MAP_FAILED)
+         {
+            for(i = KVS_HEADER_SIZE + KVS_HASHTABLE_SIZE; i + KVS_DATA_BLOCK_ALIGNMENT <= sb.st_size; i += KVS_DATA_BLOCK_ALIGNMENT)
+            {
+               if(strncmp(memory + i + KVS_DATA_BLOCK_KEY_OFFSET, key, KVS_DATA_BLOCK_ALIGNMENT - KVS_DATA_BLOCK_KEY_OFFSET) == 0)
+               {
+                  if(blockNumber-- == 0)
+                  {
+                     offset = i;
+                     break;
+                  }
+               }
+            }
+            munmap(memory, sb.st_size);
+         }
+      }
+      close(fd);
+   }
+   return offset;
+}
+
+
+/* returns the file offset of the n-th hashtable in the file (0 is the hashtable behind the header) or -1 if not found */
+static off_t findHashtable(const char* path, int number)
+{
+   off_t offset = -1;
+   off_t i = 0;
+   struct stat sb;
+   char* memory = NULL;
+   int fd = open(path, O_RDONLY);
+
+   if(fd != -1)
+   {
+      if(fstat(fd, &sb) == 0)
+      {
+         memory = (char*) mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+         if(memory != MAP_FAILED)
+         {
+            for(i = KVS_HEADER_SIZE; i + KVS_HASHTABLE_SIZE <= sb.st_size; i += KVS_DATA_BLOCK_ALIGNMENT)
+            {
+               if(*(int64_t*)(memory + i) == KVS_HASHTABLE_START_DELIMITER)
+               {
+                  if(number-- == 0)
+                  {
+                     offset = i;
+                     break;
+                  }
+               }
+            }
+            munmap(memory, sb.st_size);
+         }
+      }
+      close(fd);
+   }
+   return offset;
+}
+
+
 void data_setup(void)
 {
    //ssd
@@ -2238,12 +2330,12 @@ START_TEST(test_CacheSize)
    unsigned char buffer2[PERS_DB_MAX_SIZE_KEY_DATA] = { 1 };
    int handle = 0;
    int i, k, ret = 0;
-   int maxKeys = 2169;
+   int maxKeys = 2207;
    char dataBufer[PERS_DB_MAX_SIZE_KEY_DATA] = { 1 };
    char key[128] = { 0 };
    char path[128] = { 0 };
    int handles[100] = { 0 };
-   int writings = 2173;
+   int writings = 2211;
    int databases = 1;
 
    for (k = 0; k < databases; k++)
@@ -2574,43 +2666,38 @@ START_TEST(test_RebuildHashtables)
    fputc('x',f); //make data corrupt
 
    //destroy delimiters of a hashtable
-   // destroy start delimiter of a hashtable - 655352
-   fseeko(f,655352, SEEK_SET);
+   // destroy start delimiter of the second hashtable
+   fseeko(f, findHashtable("/tmp/rebuild-hashtables.db", 1), SEEK_SET);
    fputc('x',f);
 
-
-
-
-
-
    //just make block B data corrupt- -> block A must be used for recovery
-   fseeko(f,4841626, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/rebuild-hashtables.db", "Key_in_loop_200_40000", 1) + KVS_DATA_BLOCK_VALUE_OFFSET + 10, SEEK_SET);
    fputc('x',f);
 
    //destroy one  delimiter of datablock A --> Key_in_loop_222_49284 --> block A can be used for recovery if data is valid
-   fseeko(f,1024002, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/rebuild-hashtables.db", "Key_in_loop_222_49284", 0) + 2, SEEK_SET);
    fputc('x',f);
 
    //Destroy data of block A --> Key_in_loop_153_23409  --> block B must be used for recovery
-   fseeko(f,16407, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/rebuild-hashtables.db", "Key_in_loop_153_23409", 0) + KVS_DATA_BLOCK_KEY_OFFSET + 7, SEEK_SET);
    fputc('x',f); //just make block A data corrupt
 
-   //destroy both delimiters of datablock A --> Key_in_loop_101_10201 --> block B must be used for recovery
-   fseeko(f,827394, SEEK_SET);
+   //destroy both delimiters of datablock A (the end delimiter is stored in front of block B) --> Key_in_loop_101_10201 --> block B must be used for recovery
+   fseeko(f, findDataBlock("/tmp/rebuild-hashtables.db", "Key_in_loop_101_10201", 0) + 2, SEEK_SET);
    fputc('x',f);
-   fseeko(f,835577, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/rebuild-hashtables.db", "Key_in_loop_101_10201", 1) - 7, SEEK_SET);
    fputc('x',f);
 
-   //also destroy both delimiters of last datablock A in file --> Key_in_loop_4_16  --> block B must be used for recovery
-   fseeko(f,4964353, SEEK_SET);
+   //also destroy both delimiters of datablock A --> Key_in_loop_4_16  --> block B must be used for recovery
+   fseeko(f, findDataBlock("/tmp/rebuild-hashtables.db", "Key_in_loop_4_16", 0) + 1, SEEK_SET);
    fputc('x',f);
-   fseeko(f,4972537, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/rebuild-hashtables.db", "Key_in_loop_4_16", 1) - 7, SEEK_SET);
    fputc('x',f);
 
    //make block A and block B data corrupt --> Key_in_loop_31_961 --> recovery not possible
-   fseeko(f,3834005, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/rebuild-hashtables.db", "Key_in_loop_31_961", 0) + KVS_DATA_BLOCK_VALUE_OFFSET + 21, SEEK_SET);
    fputc('x',f);
-   fseeko(f,3842201, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/rebuild-hashtables.db", "Key_in_loop_31_961", 1) + KVS_DATA_BLOCK_VALUE_OFFSET + 29, SEEK_SET);
    fputc('x',f);
 
    //test with start AND end delimiter of hashtable destroyed --> recovery not possible
@@ -2734,25 +2821,25 @@ START_TEST(test_RecoverDatablocks)
    fwrite(&flag,sizeof(uint64_t),1, f);
 
    //seek to data block A of key  Key_in_loop_153_23409
-   fseeko(f,16407, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/recover-datablocks.db", "Key_in_loop_153_23409", 0) + KVS_DATA_BLOCK_KEY_OFFSET + 7, SEEK_SET);
    fputc('x',f); //make key corrupt
 
    //seek to data block B of key: Key_in_loop_285_81225
-   fseeko(f,356559, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/recover-datablocks.db", "Key_in_loop_285_81225", 1) + KVS_DATA_BLOCK_VALUE_OFFSET + 15, SEEK_SET);
    fputc('x',f); //make data corrupt
 
    //seek to data block B of key: Key_in_loop_125_15625
-   fseeko(f,1212614, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/recover-datablocks.db", "Key_in_loop_125_15625", 1) + KVS_DATA_BLOCK_VALUE_OFFSET + 38, SEEK_SET);
    fputc('x',f); //make data corrupt
 
    //make both blocks corrupt of key: Key_in_loop_48_2304 --> DLT_LOG must show -> datablock recovery impossible -> both datablocks are invalid!
 
    //block A Key_in_loop_48_2304
-   fseeko(f,51066, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/recover-datablocks.db", "Key_in_loop_48_2304", 0) + KVS_DATA_BLOCK_VALUE_OFFSET + 26, SEEK_SET);
    fputc('x',f); //make data corrupt
 
    //block B Key_in_loop_48_2304
-   fseeko(f,61009, SEEK_SET);
+   fseeko(f, findDataBlock("/tmp/recover-datablocks.db", "Key_in_loop_48_2304", 1) + KVS_DATA_BLOCK_VALUE_OFFSET + 81, SEEK_SET);
    fputc('x',f); //make data corrupt
 
    fclose(f);
@@ -2797,83 +2884,56 @@ END_TEST
 
 
 /*
- * In this test, the access to databases through symlinks is tested
- * the symlink named "/tmp/symlink" points to the folder "/tmp"
- * The database file gets created under the path: "/tmp/symlink/symlink-localdb.db"
- * Keys get written and must also be readable again if the database under the symlink is reopened.
+ * Data block checksums only cover the used part of the value area:
+ * modifying unused bytes behind a value must not make the data block invalid during recovery
  */
-START_TEST(test_LinkedDatabase)
+START_TEST(test_ChecksumUnusedValueArea)
 {
    int ret = 0;
    int handle = 0;
-   unsigned char readBuffer[READ_SIZE] = { 0 };
-   char write2[READ_SIZE] = { 0 };
-   char key[128] = { 0 };
-   int i = 0;
+   char read[READ_SIZE] = { 0 };
+   const char* value = "short value";
 
    //Cleaning up testdata folder
-   remove("/tmp/symlink-localdb.db");
-   remove("/tmp/symlink");
+   remove("/tmp/checksum-unused-value-area.db");
 
-   ret = symlink("/tmp","/tmp/symlink");
-   fail_unless(ret == 0, "Failed to create symlink /tmp/symlink: [%s]", strerror(errno));
+   handle = persComDbOpen("/tmp/checksum-unused-value-area.db", 0x1); //create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
 
-   handle = persComDbOpen("/tmp/symlink/symlink-localdb.db", 0x1); //create test.db if not present
-   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", ret);
+   ret = persComDbWriteKey(handle, "Key_short_value", (char*) value, strlen(value));
+   fail_unless(ret == strlen(value), "Wrong write size");
 
-   //write keys to cache
-   for(i=0; i< 50; i++)
-   {
-      snprintf(key, 128, "Key_in_loop_%d_%d",i,i*i);
-      memset(write2, 0, sizeof(write2));
-      snprintf(write2, 128, "DATA-%d-%d",i,i*i );
-      ret = persComDbWriteKey(handle, key, (char*) write2, strlen(write2));
-      fail_unless(ret == strlen(write2), "Wrong write size");
-   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
 
-   //Read keys from cache
-   for(i=0; i< 50; i++)
-   {
-      snprintf(key, 128, "Key_in_loop_%d_%d",i,i*i);
-      memset(write2, 0, sizeof(write2));
-      snprintf(write2, sizeof(write2), "DATA-%d-%d",i,i*i );
-      memset(readBuffer, 0, sizeof(readBuffer));
-      ret = persComDbReadKey(handle, key, (char*) readBuffer, sizeof(readBuffer));
-      fail_unless(ret == strlen(write2), "Wrong read size");
-      fail_unless(memcmp(readBuffer, write2, sizeof(readBuffer)) == 0, "Reading Data from Cache failed: Buffer not correctly read");
-   }
+   // IF DATABASE HEADER STRUCTURES OR KEY VALUE PAIR STORAGE CHANGES, the seek to offset part must be updated
+   int fd;
+   FILE* f;
+   fd = open("/tmp/checksum-unused-value-area.db", O_RDWR , S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH  ); //gets closed when f is closed
+   f = fdopen(fd, "w+b");
+   uint64_t flag = 0x01;
 
-   //persist changed data for this lifecycle
-   ret = persComDbClose(handle);
-   if (ret != 0)
-   {
-      printf("persComDbClose() failed: Cached Data was not written back: [%d] \n", ret);
-   }
-   fail_unless(ret == 0, "Failed to close cached database: retval: [%d]", ret);
+   //seek to close failed flag and set it to 1 -> data blocks get verified at next open
+   fseeko(f,16, SEEK_SET);
+   fwrite(&flag,sizeof(uint64_t),1, f);
 
-   //open database again
-   handle = persComDbOpen("/tmp/symlink/symlink-localdb.db", 0x1); //create test.db if not present
-   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", ret);
+   //modify unused bytes behind the value in block A and block B
+   fseeko(f, findDataBlock("/tmp/checksum-unused-value-area.db", "Key_short_value", 0) + KVS_DATA_BLOCK_VALUE_OFFSET + 50, SEEK_SET);
+   fputc('x',f);
+   fseeko(f, findDataBlock("/tmp/checksum-unused-value-area.db", "Key_short_value", 1) + KVS_DATA_BLOCK_VALUE_OFFSET + 50, SEEK_SET);
+   fputc('x',f);
 
-   //Read keys from database file
-   for(i=0; i< 50; i++)
-   {
-      snprintf(key, 128, "Key_in_loop_%d_%d",i,i*i);
-      memset(write2, 0, sizeof(write2));
-      snprintf(write2, sizeof(write2), "DATA-%d-%d",i,i*i );
-      memset(readBuffer, 0, sizeof(readBuffer));
-      ret = persComDbReadKey(handle, key, (char*) readBuffer, sizeof(readBuffer));
-      fail_unless(ret == strlen(write2), "Wrong read size");
-      fail_unless(memcmp(readBuffer, write2, sizeof(readBuffer)) == 0, "Reading Data from File failed: Buffer not correctly read");
-   }
+   fclose(f);
+
+   handle = persComDbOpen("/tmp/checksum-unused-value-area.db", 0x1);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+
+   ret = persComDbReadKey(handle, "Key_short_value", (char*) read, sizeof(read));
+   fail_unless(ret == strlen(value), "Wrong read size: [%d]", ret);
+   fail_unless(memcmp(read, value, strlen(value)) == 0, "Buffer not correctly read");
 
    ret = persComDbClose(handle);
-   if (ret != 0)
-   {
-      printf("persComDbClose() failed: [%d] \n", ret);
-   }
    fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
-
 }
 END_TEST
 
@@ -2881,112 +2941,2967 @@ END_TEST
 
 
 /*
- * Write a key value pair into the cache multiple times with same key but different data
- * Then close the database in order to persist the data.
- * After reopening the database, the last data written to cache must be returned for the key
+ * The checksum algorithm of a database file is taken from its header:
+ * a file created with pcoCrc32 is recovered after a power loss by a process using CRC-32C for new files,
+ * the corrupt current data block of a key is detected and the previous value is read from the other data block.
  */
-START_TEST(test_MultipleWrites)
+START_TEST(test_ChecksumAlgorithmOfFile)
 {
    int ret = 0;
    int handle = 0;
-   char write1[READ_SIZE] = { 0 };
-   char write2[READ_SIZE] = { 0 };
+   int fd = 0;
+   int i = 0;
+   uint64_t algorithm = 0;
+   uint64_t flag = 0x01;
+   off_t current = -1;
    char read[READ_SIZE] = { 0 };
-   char key[128] = { 0 };
-   int i =0;
+   char value[32] = { 0 };
+   const char* previous = "previous value";
+   const char* latest = "latest value";
 
    //Cleaning up testdata folder
-   remove("/tmp/multiple-writes.db");
+   remove("/tmp/checksum-algorithm.db");
 
-#if 1
+   ret = KISSDB_setAlgorithms(PERS_COM_CHECKSUM_CRC32, KISSDB_KEY_HASH_ALGORITHM);
+   fail_unless(ret == 0, "Failed to select pcoCrc32: retval: [%d]", ret);
+   handle = persComDbOpen("/tmp/checksum-algorithm.db", 0x3); //write through and create test.db if not present
+   KISSDB_setAlgorithms(KISSDB_CHECKSUM_ALGORITHM, KISSDB_KEY_HASH_ALGORITHM);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   ret = persComDbWriteKey(handle, "Key_checksum", (char*) previous, strlen(previous));
+   fail_unless(ret == strlen(previous), "Wrong write size");
+   ret = persComDbWriteKey(handle, "Key_checksum", (char*) latest, strlen(latest));
+   fail_unless(ret == strlen(latest), "Wrong write size");
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
 
-   handle = persComDbOpen("/tmp/multiple-writes.db", 0x1); //create test.db if not present
-   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", ret);
+   fd = open("/tmp/checksum-algorithm.db", O_RDWR);
+   fail_unless(pread(fd, &algorithm, sizeof(algorithm), KVS_HEADER_CHECKSUM_ALGORITHM_OFFSET) == sizeof(algorithm), "Failed to read the header");
+   fail_unless(algorithm == PERS_COM_CHECKSUM_CRC32, "Wrong checksum algorithm in the header: [%llu]", (unsigned long long) algorithm);
 
-   //use same key for all writes and reads
-   snprintf(key, 128, "Key_in_loop_%d_%d",i,i*i);
-   snprintf(write1, 128, "%s", "1234567890");
-   snprintf(write2, 128, "%s", "12345");
+   //set the close failed flag and corrupt the data block holding the latest value
+   for (i = 0; i < 2 && current < 0; i++)
+   {
+      fail_unless(pread(fd, value, strlen(latest), findDataBlock("/tmp/checksum-algorithm.db", "Key_checksum", i) + KVS_DATA_BLOCK_VALUE_OFFSET) == strlen(latest), "Failed to read the data block");
+      if (memcmp(value, latest, strlen(latest)) == 0)
+      {
+         current = findDataBlock("/tmp/checksum-algorithm.db", "Key_checksum", i);
+      }
+   }
+   fail_unless(current >= 0, "Data block of the latest value not found");
+   fail_unless(pwrite(fd, &flag, sizeof(flag), 16) == sizeof(flag), "Failed to set the close failed flag");
+   fail_unless(pwrite(fd, "x", 1, current + KVS_DATA_BLOCK_VALUE_OFFSET) == 1, "Failed to corrupt the data block");
+   close(fd);
+
+   handle = persComDbOpen("/tmp/checksum-algorithm.db", 0x0);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   ret = persComDbReadKey(handle, "Key_checksum", (char*) read, sizeof(read));
+   fail_unless(ret == strlen(previous), "Wrong read size: [%d]", ret);
+   fail_unless(memcmp(read, previous, strlen(previous)) == 0, "Buffer not correctly read");
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
 
-   //write 10 bytes to cache
-   ret = persComDbWriteKey(handle, key, (char*) write1, strlen(write1));
-   fail_unless(ret == strlen(write1) , "Wrong write size while inserting in cache");
-   //write 5 bytes to cache
-   ret = persComDbWriteKey(handle, key, (char*) write2, strlen(write2));
-   fail_unless(ret == strlen(write2) , "Wrong write size while inserting in cache");
+   //a file written with an unknown checksum algorithm
+   algorithm = 99;
+   fd = open("/tmp/checksum-algorithm.db", O_RDWR);
+   fail_unless(pwrite(fd, &algorithm, sizeof(algorithm), KVS_HEADER_CHECKSUM_ALGORITHM_OFFSET) == sizeof(algorithm), "Failed to write the header");
+   close(fd);
+   handle = persComDbOpen("/tmp/checksum-algorithm.db", 0x0);
+   fail_unless(handle < 0, "Database with unknown checksum algorithm opened: retval: [%d]", handle);
+}
+END_TEST
 
-   //read must return 5 bytes from cache
-   ret = persComDbReadKey(handle, key, (char*) read, READ_SIZE);
-   //printf("Read from cache write 2: %s \n", read);
-   fail_unless(ret == strlen(write2), "Wrong read size while reading from cache!");
-   fail_unless(memcmp(read, write2, sizeof(write2)) == 0, "Reading Data from Cache failed: Buffer not correctly read!");
 
-   //write 10 bytes to cache
-   ret = persComDbWriteKey(handle, key, (char*) write1, strlen(write1));
-   fail_unless(ret == strlen(write1) , "Wrong write size while inserting in cache");
 
-   //read must return 10 bytes from cache
-   ret = persComDbReadKey(handle, key, (char*) read, READ_SIZE);
-   //printf("Read from cache write 1: %s \n", read);
-   fail_unless(ret == strlen(write1), "Wrong read size while reading from cache!");
-   fail_unless(memcmp(read, write1, sizeof(write1)) == 0, "Reading Data from Cache failed: Buffer not correctly read!");
 
+/*
+ * An update only writes the older data block of a key:
+ * the block with the higher sequence number must be used after a power loss, even if the hashtable in the file
+ * still marks the other block as current, and the previous value must be used if the update was interrupted
+ */
+START_TEST(test_UpdateSingleDataBlock)
+{
+   int ret = 0;
+   int handle = 0;
+   int copyFd = 0;
+   char read[READ_SIZE] = { 0 };
+   char blockA[16] = { 0 };
+   char blockB[16] = { 0 };
+   char buffer[4096];
+   off_t offset = 0;
+   ssize_t size = 0;
+
+   //Cleaning up testdata folder
+   remove("/tmp/update-single-block.db");
+   remove("/tmp/update-single-block-copy.db");
 
-   //persist data in cache to file
+   handle = persComDbOpen("/tmp/update-single-block.db", 0x1); //create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   ret = persComDbWriteKey(handle, "Key_update", "value-1", strlen("value-1"));
+   fail_unless(ret == strlen("value-1"), "Wrong write size");
    ret = persComDbClose(handle);
-   if (ret != 0)
-   {
-      printf("persComDbClose() failed: [%d] \n", ret);
-   }
-   fail_unless(ret == 0, "Failed to close cached database: retval: [%d]", ret);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
 
+   handle = persComDbOpen("/tmp/update-single-block.db", 0x3); //write through
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   ret = persComDbWriteKey(handle, "Key_update", "value-2", strlen("value-2"));
+   fail_unless(ret == strlen("value-2"), "Wrong write size");
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
 
-   handle = persComDbOpen("/tmp/multiple-writes.db", 0x1); //create test.db if not present
-   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", ret);
-   //printf("open ok \n");
+   // IF DATABASE HEADER STRUCTURES OR KEY VALUE PAIR STORAGE CHANGES, the seek to offset part must be updated
+   int fd;
+   FILE* f;
+   fd = open("/tmp/update-single-block.db", O_RDONLY);
+   fail_unless(fd != -1, "Failed to open database file");
+   pread(fd, blockA, 7, findDataBlock("/tmp/update-single-block.db", "Key_update", 0) + KVS_DATA_BLOCK_VALUE_OFFSET);
+   pread(fd, blockB, 7, findDataBlock("/tmp/update-single-block.db", "Key_update", 1) + KVS_DATA_BLOCK_VALUE_OFFSET);
+   close(fd);
+   fail_unless(strcmp(blockA, "value-1") == 0 && strcmp(blockB, "value-2") == 0, "Update did not keep the previous value: [%s] [%s]", blockA, blockB);
+
+   //the hashtables of a copy of an open database file are outdated like after a power loss
+   handle = persComDbOpen("/tmp/update-single-block.db", 0x3);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   ret = persComDbWriteKey(handle, "Key_update", "value-3", strlen("value-3"));
+   fail_unless(ret == strlen("value-3"), "Wrong write size");
+   fd = open("/tmp/update-single-block.db", O_RDONLY);
+   copyFd = open("/tmp/update-single-block-copy.db", O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
+   fail_unless(fd != -1 && copyFd != -1, "Failed to copy database file");
+   while ((size = pread(fd, buffer, sizeof(buffer), offset)) > 0)
+   {
+      fail_unless(pwrite(copyFd, buffer, size, offset) == size, "Failed to copy database file");
+      offset += size;
+   }
+   close(copyFd);
+   close(fd);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
 
-   //read from database file
-   memset(read, 0, 1024);
-   ret = persComDbReadKey(handle, key, (char*) read, strlen(write1));
-   //printf("read: %d returns: %s \n", i, read);
-   fail_unless(ret == strlen(write1), "Wrong read size");
-   fail_unless(memcmp(read, write1, sizeof(write1)) == 0, "Reading Data from File failed: Buffer not correctly read");
+   handle = persComDbOpen("/tmp/update-single-block-copy.db", 0x1);
+   fail_unless(handle >= 0, "Failed to open copy of lDB: retval: [%d]", handle);
+   memset(read, 0, sizeof(read));
+   ret = persComDbReadKey(handle, "Key_update", (char*) read, sizeof(read));
+   fail_unless(ret == strlen("value-3") && strcmp(read, "value-3") == 0, "Latest value not recovered: [%d] [%s]", ret, read);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
 
+   //power loss while value-3 was written into block A
+   offset = findDataBlock("/tmp/update-single-block-copy.db", "Key_update", 0);
+   fd = open("/tmp/update-single-block-copy.db", O_RDWR , S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH  ); //gets closed when f is closed
+   f = fdopen(fd, "w+b");
+   uint64_t flag = 0x01;
 
+   //seek to close failed flag and set it to 1 -> data blocks get verified at next open
+   fseeko(f,16, SEEK_SET);
+   fwrite(&flag,sizeof(uint64_t),1, f);
+   fseeko(f, offset + KVS_DATA_BLOCK_VALUE_OFFSET + 6, SEEK_SET);
+   fputc('x',f); //make data corrupt
+   fclose(f);
 
+   handle = persComDbOpen("/tmp/update-single-block-copy.db", 0x1);
+   fail_unless(handle >= 0, "Failed to reopen copy of lDB: retval: [%d]", handle);
+   memset(read, 0, sizeof(read));
+   ret = persComDbReadKey(handle, "Key_update", (char*) read, sizeof(read));
+   fail_unless(ret == strlen("value-2") && strcmp(read, "value-2") == 0, "Previous value not recovered: [%d] [%s]", ret, read);
    ret = persComDbClose(handle);
-   if (ret != 0)
-   {
-      printf("persComDbClose() failed: [%d] \n", ret);
-   }
-   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
-
-#endif
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
 }
 END_TEST
 
 
 
-START_TEST(test_WriteThrough)
+
+/*
+ * After a power loss the hashtables must be recovered from the last checkpoint:
+ * a copy of a database file taken while keys get written through must contain all updated, deleted and added keys
+ */
+START_TEST(test_RecoverFromCheckpoint)
 {
-   int pid;
+   int ret = 0;
+   int handle = 0;
+   int fd = 0;
+   int copyFd = 0;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   char buffer[4096];
+   uint64_t checkpoint = 0;
+   off_t offset = 0;
+   ssize_t size = 0;
+   int i = 0;
+   int numKeys = 300;
 
-      //Cleaning up testdata folder
-      remove("/tmp/writethrough-concurrent.db");
+   //Cleaning up testdata folder
+   remove("/tmp/recover-checkpoint.db");
+   remove("/tmp/recover-checkpoint-copy.db");
 
-      pid = fork();
-      if (pid == 0)
-      {
-         DLT_REGISTER_APP("PCOt", "tests the persistence common object library");
+   handle = persComDbOpen("/tmp/recover-checkpoint.db", 0x1); //create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_checkpoint_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
 
-         /*child*/
-         //printf("Started child process with PID: [%d] \n", pid);
-         int handle = 0;
-         int ret = 0;
-         char childSysTimeBuffer[256] = { 0 };
-         char key[128] = { 0 };
-         char write2[READ_SIZE] = { 0 };
-         int i =0;
+   //update all keys (every tenth value moves to a larger data block), delete every fifth key and add new keys:
+   //the journal gets full and the hashtables are split while the database is open
+   handle = persComDbOpen("/tmp/recover-checkpoint.db", 0x3); //write through
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_checkpoint_%d", i);
+      snprintf(write, READ_SIZE, (i % 10 == 0) ? "UPDATED-DATA-%d-%0200d" : "UPDATED-%d", i, 0);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   for (i = 0; i < numKeys; i += 5)
+   {
+      snprintf(key, 128, "Key_checkpoint_%d", i);
+      ret = persComDbDeleteKey(handle, key);
+      fail_unless(ret >= 0, "Failed to delete key [%s]: [%d]", key, ret);
+   }
+   for (i = numKeys; i < 3 * numKeys; i++)
+   {
+      snprintf(key, 128, "Key_checkpoint_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+
+   //the copy of the open database file has the hashtables of the last checkpoint
+   fd = open("/tmp/recover-checkpoint.db", O_RDONLY);
+   copyFd = open("/tmp/recover-checkpoint-copy.db", O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
+   fail_unless(fd != -1 && copyFd != -1, "Failed to copy database file");
+   while ((size = pread(fd, buffer, sizeof(buffer), offset)) > 0)
+   {
+      fail_unless(pwrite(copyFd, buffer, size, offset) == size, "Failed to copy database file");
+      offset += size;
+   }
+   close(copyFd);
+   close(fd);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   // IF DATABASE HEADER STRUCTURES CHANGE, the offset of the checkpoint must be updated
+   fd = open("/tmp/recover-checkpoint-copy.db", O_RDONLY);
+   fail_unless(fd != -1, "Failed to open database file");
+   pread(fd, &checkpoint, sizeof(checkpoint), KVS_HEADER_CHECKPOINT_OFFSET);
+   close(fd);
+   fail_unless(checkpoint != 0, "No checkpoint in copy of open database");
+   fd = open("/tmp/recover-checkpoint.db", O_RDONLY);
+   fail_unless(fd != -1, "Failed to open database file");
+   pread(fd, &checkpoint, sizeof(checkpoint), KVS_HEADER_CHECKPOINT_OFFSET);
+   close(fd);
+   fail_unless(checkpoint == 0, "Checkpoint not cleared at close: [%llu]", (unsigned long long) checkpoint);
+
+   handle = persComDbOpen("/tmp/recover-checkpoint-copy.db", 0x1);
+   fail_unless(handle >= 0, "Failed to open copy of lDB: retval: [%d]", handle);
+   for (i = 0; i < 3 * numKeys; i++)
+   {
+      snprintf(key, 128, "Key_checkpoint_%d", i);
+      if (i >= numKeys)
+      {
+         snprintf(write, READ_SIZE, "DATA-%d", i);
+      }
+      else
+      {
+         snprintf(write, READ_SIZE, (i % 10 == 0) ? "UPDATED-DATA-%d-%0200d" : "UPDATED-%d", i, 0);
+      }
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      if (i < numKeys && i % 5 == 0)
+      {
+         fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key [%s] recovered: [%d]", key, ret);
+      }
+      else
+      {
+         fail_unless(ret == strlen(write) && strncmp(read, write, strlen(write)) == 0, "Wrong value recovered for key [%s]: [%d] [%s]", key, ret, read);
+      }
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+/*
+ * Values larger than the default maximum size can be stored in a database created with a larger maximum value size:
+ * they are written with write cache and write through, the maximum value size is kept in the database file
+ */
+START_TEST(test_LargeValues)
+{
+   int ret = 0;
+   int handle = 0;
+   int size = 100 * 1024;
+   int maxValueSize = 256 * 1024;
+   char* write = NULL;
+   char* read = NULL;
+
+   //Cleaning up testdata folder
+   remove("/tmp/large-values.db");
+   remove("/tmp/large-values-default.db");
+
+   write = (char*) malloc(maxValueSize + 1);
+   read = (char*) malloc(maxValueSize + 1);
+   fail_unless(write != NULL && read != NULL, "Failed to allocate buffers");
+   memset(write, 'L', maxValueSize + 1);
+   memset(write + size / 2, 'M', size / 2);
+
+   ret = persComDbOpenWithMaxValueSize("/tmp/large-values.db", 0x1, PERS_DB_MAX_SIZE_KEY_DATA_LIMIT + 1);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Open with too large max. value size succeeded: retval: [%d]", ret);
+
+   handle = persComDbOpenWithMaxValueSize("/tmp/large-values.db", 0x1, maxValueSize); //write cache
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   ret = persComDbGetMaxValueSize(handle);
+   fail_unless(ret == maxValueSize, "Wrong max. value size: [%d]", ret);
+
+   ret = persComDbWriteKey(handle, "Key_small_value", "small", 5);
+   fail_unless(ret == 5, "Wrong write size: [%d]", ret);
+   ret = persComDbWriteKey(handle, "Key_large_value_cached", write, size);
+   fail_unless(ret == size, "Wrong write size: [%d]", ret);
+   ret = persComDbWriteKey(handle, "Key_max_value", write, maxValueSize);
+   fail_unless(ret == maxValueSize, "Wrong write size: [%d]", ret);
+   ret = persComDbWriteKey(handle, "Key_too_large_value", write, maxValueSize + 1);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Write of too large value succeeded: [%d]", ret);
+
+   ret = persComDbGetKeySize(handle, "Key_large_value_cached");
+   fail_unless(ret == size, "Wrong key size: [%d]", ret);
+   memset(read, 0, maxValueSize + 1);
+   ret = persComDbReadKey(handle, "Key_large_value_cached", read, maxValueSize);
+   fail_unless(ret == size && memcmp(read, write, size) == 0, "Wrong value read: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/large-values.db", 0x2); //write through
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   ret = persComDbGetMaxValueSize(handle);
+   fail_unless(ret == maxValueSize, "Wrong max. value size after reopen: [%d]", ret);
+   memset(read, 0, maxValueSize + 1);
+   ret = persComDbReadKey(handle, "Key_max_value", read, maxValueSize);
+   fail_unless(ret == maxValueSize && memcmp(read, write, maxValueSize) == 0, "Wrong value read: [%d]", ret);
+   ret = persComDbWriteKey(handle, "Key_large_value_write_through", write + 1, size);
+   fail_unless(ret == size, "Wrong write size: [%d]", ret);
+   ret = persComDbWriteKey(handle, "Key_max_value", "replaced", 8);
+   fail_unless(ret == 8, "Wrong write size: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/large-values.db", 0x0);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   memset(read, 0, maxValueSize + 1);
+   ret = persComDbReadKey(handle, "Key_large_value_cached", read, maxValueSize);
+   fail_unless(ret == size && memcmp(read, write, size) == 0, "Wrong value read: [%d]", ret);
+   memset(read, 0, maxValueSize + 1);
+   ret = persComDbReadKey(handle, "Key_large_value_write_through", read, maxValueSize);
+   fail_unless(ret == size && memcmp(read, write + 1, size) == 0, "Wrong value read: [%d]", ret);
+   memset(read, 0, maxValueSize + 1);
+   ret = persComDbReadKey(handle, "Key_max_value", read, maxValueSize);
+   fail_unless(ret == 8 && memcmp(read, "replaced", 8) == 0, "Wrong value read: [%d]", ret);
+   memset(read, 0, maxValueSize + 1);
+   ret = persComDbReadKey(handle, "Key_small_value", read, maxValueSize);
+   fail_unless(ret == 5 && memcmp(read, "small", 5) == 0, "Wrong value read: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //a database created with the default maximum value size rejects larger values
+   handle = persComDbOpen("/tmp/large-values-default.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   ret = persComDbGetMaxValueSize(handle);
+   fail_unless(ret == PERS_DB_MAX_SIZE_KEY_DATA, "Wrong default max. value size: [%d]", ret);
+   ret = persComDbWriteKey(handle, "Key_too_large_value", write, PERS_DB_MAX_SIZE_KEY_DATA + 1);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Write of too large value succeeded: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   free(write);
+   free(read);
+}
+END_TEST
+
+
+/*
+ * The data blocks of a RCT use the key size and the configuration size of the RCT:
+ * every resource needs a pair of small data blocks instead of the blocks of a database with large keys
+ */
+START_TEST(test_CompactRctDataBlocks)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int numResources = 1000;
+   char key[PERS_RCT_MAX_LENGTH_RESOURCE_ID] = { 0 };
+   PersistenceConfigurationKey_s psConfig;
+   struct stat sb;
+
+   //Cleaning up testdata folder
+   remove("/tmp/compact-rct.db");
+
+   handle = persComRctOpen("/tmp/compact-rct.db", 0x1); //create rct.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent RCT: retval: [%d]", handle);
+   for (i = 0; i < numResources; i++)
+   {
+      memset(&psConfig, 0, sizeof(psConfig));
+      snprintf(key, sizeof(key), "/resource/compact/%d", i);
+      snprintf(psConfig.custom_name, sizeof(psConfig.custom_name), "custom_%d", i);
+      psConfig.max_size = i;
+      ret = persComRctWrite(handle, key, &psConfig);
+      fail_unless(ret == sizeof(psConfig), "Wrong write size for resource [%s]: [%d]", key, ret);
+   }
+   ret = persComRctClose(handle);
+   fail_unless(ret == 0, "Failed to close RCT: retval: [%d]", ret);
+
+   //a pair of data blocks with a key field of PERS_DB_MAX_LENGTH_KEY_NAME bytes needs 1024 bytes for every resource
+   fail_unless(stat("/tmp/compact-rct.db", &sb) == 0, "Failed to get size of RCT file");
+   fail_unless(sb.st_size < numResources * 2 * 384 + KVS_HEADER_SIZE + 16 * KVS_HASHTABLE_SIZE, "RCT file too large: [%lld]", (long long) sb.st_size);
+
+   handle = persComRctOpen("/tmp/compact-rct.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open existing RCT: retval: [%d]", handle);
+   for (i = 0; i < numResources; i++)
+   {
+      memset(&psConfig, 0, sizeof(psConfig));
+      snprintf(key, sizeof(key), "/resource/compact/%d", i);
+      ret = persComRctRead(handle, key, &psConfig);
+      fail_unless(ret == sizeof(psConfig), "Wrong read size for resource [%s]: [%d]", key, ret);
+      snprintf(key, sizeof(key), "custom_%d", i);
+      fail_unless(strcmp(psConfig.custom_name, key) == 0 && psConfig.max_size == i, "Wrong configuration read for resource: [%d]", i);
+   }
+   ret = persComRctClose(handle);
+   fail_unless(ret == 0, "Failed to close RCT: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+/*
+ * The hash index must grow by splitting buckets while keys get written:
+ * many keys are written through, deleted partially and must be found again after the database is reopened
+ */
+START_TEST(test_GrowHashIndex)
+{
+   int ret = 0;
+   int handle = 0;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   int i = 0;
+   int numKeys = 5000;
+
+   //Cleaning up testdata folder
+   remove("/tmp/grow-hash-index.db");
+
+   handle = persComDbOpen("/tmp/grow-hash-index.db", 0x3); //write through and create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_grow_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+
+   //delete every third key
+   for (i = 0; i < numKeys; i += 3)
+   {
+      snprintf(key, 128, "Key_grow_%d", i);
+      ret = persComDbDeleteKey(handle, key);
+      fail_unless(ret >= 0, "Failed to delete key [%s]: [%d]", key, ret);
+   }
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/grow-hash-index.db", 0x0);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_grow_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      if (i % 3 == 0)
+      {
+         fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key [%s] found: [%d]", key, ret);
+      }
+      else
+      {
+         fail_unless(ret == strlen(write), "Wrong read size for key [%s]: [%d]", key, ret);
+         fail_unless(memcmp(read, write, strlen(write)) == 0, "Buffer not correctly read for key [%s]", key);
+      }
+   }
+
+   ret = persComDbGetSizeKeysList(handle);
+   fail_unless(ret > 0, "Failed to get key list size: [%d]", ret);
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+
+/*
+ * returns the number of page faults (minor and major) of this process
+ */
+static long getPageFaults(void)
+{
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+   return usage.ru_minflt + usage.ru_majflt;
+}
+
+/*
+ * Lookups compare the key length and the key hash stored in the hashtable slots before a data block is read:
+ * the key length or the key hash of the slots of half of the keys is changed in the file (the hashtables of a correctly
+ * closed file are not checked when they are loaded), these keys must not be found although their data blocks are unchanged.
+ * The page faults per lookup on a cold cache are reported by benchmark_kvs_lookup.
+ */
+START_TEST(test_LookupSlotKeyFields)
+{
+   int ret = 0;
+   int handle = 0;
+   int fd = 0;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   int i = 0;
+   int k = 0;
+   int n = 0;
+   int numKeys = 5000;
+   int changed = 0;
+   off_t htOffset = 0;
+   off_t slotOffset = 0;
+   Hashtable_slot_s slot;
+
+   //Cleaning up testdata folder
+   remove("/tmp/lookup-slot-key.db");
+
+   handle = persComDbOpen("/tmp/lookup-slot-key.db", 0x3); //write through and create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_lookup_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   //even keys: the key hash of every fourth key and the key length of the other even keys are changed
+   fd = open("/tmp/lookup-slot-key.db", O_RDWR);
+   fail_unless(fd >= 0, "Failed to open database file");
+   for (n = 0; (htOffset = findHashtable("/tmp/lookup-slot-key.db", n)) > 0; n++)
+   {
+      for (k = 0; k < HASHTABLE_SLOT_COUNT; k++)
+      {
+         slotOffset = htOffset + offsetof(Hashtable_s, slots) + k * sizeof(Hashtable_slot_s);
+         fail_unless(pread(fd, &slot, sizeof(slot), slotOffset) == sizeof(slot), "Failed to read slot");
+         if (slot.offsetA <= 0)
+         {
+            continue;
+         }
+         memset(key, 0, sizeof(key));
+         fail_unless(pread(fd, key, sizeof(key) - 1, slot.offsetA + KVS_DATA_BLOCK_KEY_OFFSET) > 0, "Failed to read key");
+         fail_unless(sscanf(key, "Key_lookup_%d", &i) == 1, "Wrong key in data block: [%s]", key);
+         if (i % 4 == 0)
+         {
+            slot.fingerprint ^= 0x1;
+         }
+         else if (i % 2 == 0)
+         {
+            slot.keyLength++;
+         }
+         else
+         {
+            continue;
+         }
+         fail_unless(pwrite(fd, &slot, sizeof(slot), slotOffset) == sizeof(slot), "Failed to write slot");
+         changed++;
+      }
+   }
+   close(fd);
+   fail_unless(n > 1 && changed == numKeys / 2, "Wrong number of slots changed: [%d] in [%d] hashtables", changed, n);
+
+   handle = persComDbOpen("/tmp/lookup-slot-key.db", 0x2); //write through
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_lookup_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      if (i % 2 == 0)
+      {
+         fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Key [%s] with changed slot found: [%d]", key, ret);
+      }
+      else
+      {
+         fail_unless(ret == strlen(write) && strcmp(read, write) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+      }
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+/*
+ * Values of up to 4 bytes are stored inline in the hashtable slots: lookups of these values on a cold cache
+ * must cause much fewer page faults than lookups of larger values, which are read from the data blocks.
+ * Overwriting a tiny value with a larger one and back and deleting keys must keep the inline values consistent.
+ */
+START_TEST(test_InlineSmallValues)
+{
+   int ret = 0;
+   int handle = 0;
+   int fd = 0;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   int i = 0;
+   int numKeys = 5000;
+   long faults = 0;
+   long inlineFaults = 0;
+   long blockFaults = 0;
+
+   //Cleaning up testdata folder
+   remove("/tmp/inline-values.db");
+
+   handle = persComDbOpen("/tmp/inline-values.db", 0x3); //write through and create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_inline_%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) &i, sizeof(i));
+      fail_unless(ret == sizeof(i), "Wrong write size for key [%s]: [%d]", key, ret);
+      snprintf(key, 128, "Key_block_%d", i);
+      snprintf(write, READ_SIZE, "DATA-BLOCK-%08d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   //tiny value -> large value -> tiny value and deleted tiny values
+   for (i = 0; i < numKeys; i += 10)
+   {
+      snprintf(key, 128, "Key_inline_%d", i);
+      snprintf(write, READ_SIZE, "LARGE-VALUE-%08d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+      if (i % 20 == 0)
+      {
+         ret = persComDbWriteKey(handle, key, "tiny", 4);
+         fail_unless(ret == 4, "Wrong write size for key [%s]: [%d]", key, ret);
+      }
+      snprintf(key, 128, "Key_inline_%d", i + 1);
+      ret = persComDbDeleteKey(handle, key);
+      fail_unless(ret == 0, "Failed to delete key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   //drop the database file from the page cache
+   fd = open("/tmp/inline-values.db", O_RDONLY);
+   fail_unless(fd >= 0, "Failed to open database file");
+   posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+   close(fd);
+
+   handle = persComDbOpen("/tmp/inline-values.db", 0x2); //write through
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+
+   faults = getPageFaults();
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_block_%d", i);
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == 19, "Wrong read size for key [%s]: [%d]", key, ret);
+   }
+   blockFaults = getPageFaults() - faults;
+
+   faults = getPageFaults();
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_inline_%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      if (i % 10 == 1)
+      {
+         fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key [%s] found: [%d]", key, ret);
+      }
+      else if (i % 20 == 0)
+      {
+         fail_unless(ret == 4 && memcmp(read, "tiny", 4) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+      }
+      else if (i % 10 == 0)
+      {
+         snprintf(write, READ_SIZE, "LARGE-VALUE-%08d", i);
+         fail_unless(ret == strlen(write) && memcmp(read, write, ret) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+      }
+      else
+      {
+         fail_unless(ret == sizeof(i) && memcmp(read, &i, sizeof(i)) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+      }
+   }
+   inlineFaults = getPageFaults() - faults;
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   printf("Page faults per lookup on a cold cache: inline values: %.4f - values in data blocks: %.4f \n",
+          (double) inlineFaults / numKeys, (double) blockFaults / numKeys);
+   fail_unless(inlineFaults * 4 < blockFaults, "Too many page faults for inline values: [%ld] (data blocks: [%ld])", inlineFaults, blockFaults);
+}
+END_TEST
+
+
+
+
+/*
+ * Values written with the compression option are stored compressed in the cache and in the file if this saves space.
+ * The database file must be much smaller than the file of the same values written without compression,
+ * and the values must be read correctly after reopening the database without the compression option.
+ */
+START_TEST(test_CompressedValues)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int k = 0;
+   int len = 0;
+   int numKeys = 200;
+   int largeSize = 30000;
+   char key[128] = { 0 };
+   char* write = (char*) malloc(largeSize);
+   char* read = (char*) malloc(largeSize);
+   const char* files[2] = { "/tmp/compressed-values.db", "/tmp/uncompressed-values.db" };
+   struct stat sb[2];
+
+   fail_unless(write != NULL && read != NULL, "Failed to allocate buffers");
+   for (k = 0; k < 2; k++)
+   {
+      //Cleaning up testdata folder
+      remove(files[k]);
+
+      handle = persComDbOpenWithMaxValueSize(files[k], (k == 0) ? 0x9 : 0x1, largeSize); //create and compress values (first file)
+      fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+      for (i = 0; i < numKeys; i++)
+      {
+         snprintf(key, 128, "Key_compressed_%d", i);
+         for (len = 0; len < 4000;)
+         {
+            len += snprintf(write + len, largeSize - len, "{\"name\":\"entry%d\",\"enabled\":true,\"value\":%d},", len, i);
+         }
+         ret = persComDbWriteKey(handle, key, write, len);
+         fail_unless(ret == len, "Wrong write size for key [%s]: [%d]", key, ret);
+         memset(read, 0, largeSize);
+         ret = persComDbReadKey(handle, key, read, largeSize);
+         fail_unless(ret == len && memcmp(read, write, len) == 0, "Wrong value read from cache for key [%s]: [%d]", key, ret);
+      }
+      //values which are not compressed: too small or not compressible
+      ret = persComDbWriteKey(handle, "Key_compressed_small", "tiny", 4);
+      fail_unless(ret == 4, "Wrong write size for small value: [%d]", ret);
+      srand(1);
+      for (i = 0; i < 1000; i++)
+      {
+         write[i] = (char) rand();
+      }
+      ret = persComDbWriteKey(handle, "Key_compressed_random", write, 1000);
+      fail_unless(ret == 1000, "Wrong write size for random value: [%d]", ret);
+      //value larger than the cache: compressed into the cache or written to the file
+      memset(write, 'x', largeSize);
+      ret = persComDbWriteKey(handle, "Key_compressed_large", write, largeSize);
+      fail_unless(ret == largeSize, "Wrong write size for large value: [%d]", ret);
+      ret = persComDbGetKeySize(handle, "Key_compressed_large");
+      fail_unless(ret == largeSize, "Wrong size of large value: [%d]", ret);
+      ret = persComDbClose(handle);
+      fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+      fail_unless(stat(files[k], &sb[k]) == 0, "Failed to get size of database file");
+   }
+   printf("Database file with compressed values: %lld bytes - uncompressed: %lld bytes \n", (long long) sb[0].st_size, (long long) sb[1].st_size);
+   fail_unless(sb[0].st_size * 3 < sb[1].st_size, "Database file with compressed values too large: [%lld]", (long long) sb[0].st_size);
+
+   //the compression is recorded with every value: read without the compression option, in write through mode
+   handle = persComDbOpen(files[0], 0x2);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_compressed_%d", i);
+      for (len = 0; len < 4000;)
+      {
+         len += snprintf(write + len, largeSize - len, "{\"name\":\"entry%d\",\"enabled\":true,\"value\":%d},", len, i);
+      }
+      ret = persComDbGetKeySize(handle, key);
+      fail_unless(ret == len, "Wrong size of key [%s]: [%d]", key, ret);
+      memset(read, 0, largeSize);
+      ret = persComDbReadKey(handle, key, read, largeSize);
+      fail_unless(ret == len && memcmp(read, write, len) == 0, "Wrong value read from file for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbReadKey(handle, "Key_compressed_small", read, largeSize);
+   fail_unless(ret == 4 && memcmp(read, "tiny", 4) == 0, "Wrong small value read: [%d]", ret);
+   srand(1);
+   for (i = 0; i < 1000; i++)
+   {
+      write[i] = (char) rand();
+   }
+   ret = persComDbReadKey(handle, "Key_compressed_random", read, largeSize);
+   fail_unless(ret == 1000 && memcmp(read, write, 1000) == 0, "Wrong random value read: [%d]", ret);
+   memset(write, 'x', largeSize);
+   ret = persComDbReadKey(handle, "Key_compressed_large", read, largeSize);
+   fail_unless(ret == largeSize && memcmp(read, write, largeSize) == 0, "Wrong large value read: [%d]", ret);
+
+   //overwrite a compressed value without compression
+   ret = persComDbWriteKey(handle, "Key_compressed_0", write, 4000);
+   fail_unless(ret == 4000, "Wrong write size for uncompressed value: [%d]", ret);
+   ret = persComDbReadKey(handle, "Key_compressed_0", read, largeSize);
+   fail_unless(ret == 4000 && memcmp(read, write, 4000) == 0, "Wrong uncompressed value read: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   free(write);
+   free(read);
+}
+END_TEST
+
+
+
+/*
+ * The hashtables of a database file are made corrupt, the file is scanned by parallel threads to rebuild them.
+ * The values contain hashtable delimiters at the alignment of the data blocks:
+ * a thread starting its file range inside of a value finds false hashtables, the range must be scanned again in step with the data blocks.
+ */
+START_TEST(test_ParallelRecovery)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int k = 0;
+   int numKeys = 3000;
+   char key[128] = { 0 };
+   char write[READ_SIZE * 2] = { 0 };
+   char read[READ_SIZE * 2] = { 0 };
+   uint64_t flag = 0x01;
+   int fd;
+   FILE* f;
+
+   //Cleaning up testdata folder
+   remove("/tmp/parallel-recovery.db");
+
+   //values with the hashtable start delimiter in every aligned 8 bytes of the file
+   for (k = 0; k < sizeof(write); k++)
+   {
+      write[k] = ((k + KVS_DATA_BLOCK_VALUE_OFFSET) % 8 < 4) ? 0x33 : 0x00;
+   }
+   handle = persComDbOpen("/tmp/parallel-recovery.db", 0x3); //write through and create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_parallel_%d", i);
+      memcpy(write, &i, sizeof(i));
+      ret = persComDbWriteKey(handle, key, write, sizeof(write));
+      fail_unless(ret == sizeof(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   //set the close failed flag and make the first hashtable corrupt
+   fd = open("/tmp/parallel-recovery.db", O_RDWR , S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH  ); //gets closed when f is closed
+   f = fdopen(fd, "w+b");
+   fseeko(f, 16, SEEK_SET);
+   fwrite(&flag, sizeof(uint64_t), 1, f);
+   fseeko(f, KVS_HEADER_SIZE + 100, SEEK_SET);
+   fputc('x', f);
+   fclose(f);
+
+   KISSDB_setRecoveryThreads(4);
+   handle = persComDbOpen("/tmp/parallel-recovery.db", 0x0);
+   KISSDB_setRecoveryThreads(0);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_parallel_%d", i);
+      memcpy(write, &i, sizeof(i));
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      fail_unless(ret == sizeof(write) && memcmp(read, write, sizeof(write)) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+/*
+ * The hashtables of a correctly closed database file are loaded on their first access:
+ * keys are read, added (the index grows behind hashtables not loaded yet) and deleted after the reopen,
+ * all keys must be found after the next reopen and after a reopen without the number of hashtables in the header.
+ */
+START_TEST(test_LazyHashtables)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int numKeys = 10000;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   uint64_t htCount = 0;
+   int fd;
+
+   //Cleaning up testdata folder
+   remove("/tmp/lazy-hashtables.db");
+
+   handle = persComDbOpen("/tmp/lazy-hashtables.db", 0x3); //write through and create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_lazy_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/lazy-hashtables.db", 0x2); //write through
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   ret = persComDbReadKey(handle, "Key_lazy_0", (char*) read, sizeof(read));
+   fail_unless(ret == strlen("DATA-0"), "Failed to read key [Key_lazy_0]: [%d]", ret);
+   //the added keys split hashtables and add new ones
+   for (i = numKeys; i < numKeys * 2; i++)
+   {
+      snprintf(key, 128, "Key_lazy_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   for (i = 0; i < numKeys * 2; i += 7)
+   {
+      snprintf(key, 128, "Key_lazy_%d", i);
+      ret = persComDbDeleteKey(handle, key);
+      fail_unless(ret == 0, "Failed to delete key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/lazy-hashtables.db", 0x2);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = numKeys * 2 - 1; i >= 0; i--)
+   {
+      snprintf(key, 128, "Key_lazy_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      if (i % 7 == 0)
+      {
+         fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key [%s] found: [%d]", key, ret);
+      }
+      else
+      {
+         fail_unless(ret == strlen(write) && strcmp(read, write) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+      }
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   //without the number of hashtables in the header, all hashtables are found along their links when opened
+   fd = open("/tmp/lazy-hashtables.db", O_RDWR);
+   fail_unless(fd >= 0, "Failed to open database file");
+   fail_unless(pwrite(fd, &htCount, sizeof(htCount), offsetof(Header_s, htCount)) == sizeof(htCount), "Failed to clear hashtable count");
+   close(fd);
+
+   handle = persComDbOpen("/tmp/lazy-hashtables.db", 0x2);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 1; i < numKeys * 2; i += 7)
+   {
+      snprintf(key, 128, "Key_lazy_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == strlen(write) && strcmp(read, write) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+}
+END_TEST
+
+
+/*
+ * A correctly closed database file with an invalid link between two hashtables must not lose the keys
+ * of the hashtables behind the link: the open recovers the hashtables from the data blocks.
+ */
+START_TEST(test_LazyHashtableInvalidLink)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int numKeys = 5000;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   int64_t link = 0x7FFFFFFFFFFFLL;
+   int fd;
+
+   //Cleaning up testdata folder
+   remove("/tmp/lazy-hashtable-link.db");
+
+   handle = persComDbOpen("/tmp/lazy-hashtable-link.db", 0x3); //write through and create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_link_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   //the link of the first hashtable points behind the end of the file
+   fd = open("/tmp/lazy-hashtable-link.db", O_RDWR);
+   fail_unless(fd >= 0, "Failed to open database file");
+   fail_unless(pwrite(fd, &link, sizeof(link), sizeof(Header_s) + offsetof(Hashtable_s, slots) + HASHTABLE_SLOT_COUNT * sizeof(Hashtable_slot_s))
+               == sizeof(link), "Failed to write hashtable link");
+   close(fd);
+
+   handle = persComDbOpen("/tmp/lazy-hashtable-link.db", 0x2); //write through
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_link_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == strlen(write) && strcmp(read, write) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+}
+END_TEST
+
+
+/*
+ * Closing a database which was only read writes no hashtable: the stored checksums of the hashtables are changed
+ * in the file (they are not checked when a correctly closed file is opened) and must still be changed after the keys
+ * were read and the database was closed. After all keys were modified the hashtables are written at close.
+ */
+START_TEST(test_CloseWritesOnlyModifiedHashtables)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int numKeys = 5000;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   off_t offset[2] = { 0 };
+   uint64_t crc[2] = { 0 };
+   uint64_t stored = 0;
+   int fd;
+
+   //Cleaning up testdata folder
+   remove("/tmp/close-modified-hashtables.db");
+
+   handle = persComDbOpen("/tmp/close-modified-hashtables.db", 0x3); //write through and create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_close_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   fd = open("/tmp/close-modified-hashtables.db", O_RDWR);
+   fail_unless(fd >= 0, "Failed to open database file");
+   for (i = 0; i < 2; i++)
+   {
+      offset[i] = findHashtable("/tmp/close-modified-hashtables.db", i);
+      fail_unless(offset[i] > 0, "Hashtable [%d] not found", i);
+      fail_unless(pread(fd, &crc[i], sizeof(crc[i]), offset[i] + offsetof(Hashtable_s, crc)) == sizeof(crc[i]), "Failed to read checksum");
+      crc[i] ^= 0x1;
+      fail_unless(pwrite(fd, &crc[i], sizeof(crc[i]), offset[i] + offsetof(Hashtable_s, crc)) == sizeof(crc[i]), "Failed to write checksum");
+   }
+   close(fd);
+
+   handle = persComDbOpen("/tmp/close-modified-hashtables.db", 0x2); //write through
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_close_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == strlen(write) && strcmp(read, write) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   fd = open("/tmp/close-modified-hashtables.db", O_RDONLY);
+   fail_unless(fd >= 0, "Failed to open database file");
+   for (i = 0; i < 2; i++)
+   {
+      fail_unless(pread(fd, &stored, sizeof(stored), offset[i] + offsetof(Hashtable_s, crc)) == sizeof(stored), "Failed to read checksum");
+      fail_unless(stored == crc[i], "Unmodified hashtable [%d] was written at close", i);
+   }
+   close(fd);
+
+   handle = persComDbOpen("/tmp/close-modified-hashtables.db", 0x2); //write through
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_close_%d", i);
+      snprintf(write, READ_SIZE, "NEW-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   fd = open("/tmp/close-modified-hashtables.db", O_RDONLY);
+   fail_unless(fd >= 0, "Failed to open database file");
+   for (i = 0; i < 2; i++)
+   {
+      fail_unless(pread(fd, &stored, sizeof(stored), offset[i] + offsetof(Hashtable_s, crc)) == sizeof(stored), "Failed to read checksum");
+      fail_unless(stored != crc[i], "Modified hashtable [%d] was not written at close", i);
+   }
+   close(fd);
+}
+END_TEST
+
+
+/*
+ * A frozen image built from the keys of a database is opened by persComDbOpen instead of a database:
+ * all keys are read with their values and sizes, missing keys are not found, the list of keys contains all keys
+ * and the image cannot be modified. An image with a wrong version is not opened.
+ */
+START_TEST(test_FrozenDatabase)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int numKeys = 5000;
+   int listSize = 0;
+   int listed = 0;
+   char key[128] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   char* keyList = NULL;
+   char* listedKey = NULL;
+   char* values = NULL;
+   char* keys = NULL;
+   uint32_t version = FROZENDB_VERSION + 1;
+   FrozenDB_Item_s* items = NULL;
+   int fd;
+
+   remove("/tmp/frozen.db");
+
+   keys = (char*) malloc(numKeys * 32);
+   values = (char*) malloc(numKeys * 32);
+   items = (FrozenDB_Item_s*) malloc(numKeys * sizeof(FrozenDB_Item_s));
+   fail_unless(keys != NULL && values != NULL && items != NULL, "Out of memory");
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(keys + i * 32, 32, "Key_frozen_%d", i);
+      snprintf(values + i * 32, 32, "DATA-frozen-%d", i);
+      items[i].key = keys + i * 32;
+      items[i].value = values + i * 32;
+      items[i].valueSize = strlen(values + i * 32);
+   }
+   ret = FROZENDB_build("/tmp/frozen.db", items, numKeys, PERS_DB_MAX_SIZE_KEY_DATA);
+   fail_unless(ret == 0, "Failed to build frozen image: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/frozen.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open frozen image: retval: [%d]", handle);
+   ret = persComDbGetMaxValueSize(handle);
+   fail_unless(ret == PERS_DB_MAX_SIZE_KEY_DATA, "Wrong max value size: [%d]", ret);
+   for (i = 0; i < numKeys; i++)
+   {
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, keys + i * 32, read, sizeof(read));
+      fail_unless(ret == strlen(values + i * 32) && strcmp(read, values + i * 32) == 0, "Wrong value read for key [%s]: [%d]", keys + i * 32, ret);
+      ret = persComDbGetKeySize(handle, keys + i * 32);
+      fail_unless(ret == strlen(values + i * 32), "Wrong size of key [%s]: [%d]", keys + i * 32, ret);
+   }
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_missing_%d", i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Missing key [%s] found: [%d]", key, ret);
+   }
+
+   listSize = persComDbGetSizeKeysList(handle);
+   keyList = (char*) malloc(listSize);
+   fail_unless(keyList != NULL, "Out of memory");
+   ret = persComDbGetKeysList(handle, keyList, listSize);
+   fail_unless(ret == listSize, "Wrong size of the list of keys: [%d]", ret);
+   for (listedKey = keyList; listedKey < keyList + listSize; listedKey += strlen(listedKey) + 1)
+   {
+      fail_unless(strncmp(listedKey, "Key_frozen_", strlen("Key_frozen_")) == 0, "Wrong key listed [%s]", listedKey);
+      listed++;
+   }
+   fail_unless(listed == numKeys, "Wrong number of keys listed: [%d]", listed);
+
+   //the key cursor of a frozen image: Key_frozen_12, Key_frozen_120 .. 129 and Key_frozen_1200 .. 1299
+   ret = persComDbIterOpen(handle, "Key_frozen_12");
+   fail_unless(ret == 0, "Failed to open cursor of frozen image: [%d]", ret);
+   listed = 0;
+   while ((ret = persComDbIterNext(handle, key, sizeof(key))) > 0)
+   {
+      fail_unless(strncmp(key, "Key_frozen_12", strlen("Key_frozen_12")) == 0, "Wrong key returned by cursor [%s]", key);
+      listed++;
+   }
+   fail_unless(ret == 0 && listed == 111, "Wrong number of keys returned by cursor: [%d], retval: [%d]", listed, ret);
+   (void) persComDbIterClose(handle);
+
+   ret = persComDbWriteKey(handle, "Key_frozen_0", "new", 3);
+   fail_unless(ret == PERS_COM_ERR_READONLY, "Frozen image was written: [%d]", ret);
+   ret = persComDbDeleteKey(handle, "Key_frozen_0");
+   fail_unless(ret == PERS_COM_ERR_READONLY, "Key of the frozen image was deleted: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close frozen image: retval: [%d]", ret);
+
+   fd = open("/tmp/frozen.db", O_RDWR);
+   fail_unless(fd >= 0, "Failed to open frozen image file");
+   fail_unless(pwrite(fd, &version, sizeof(version), offsetof(FrozenDB_Header_s, version)) == sizeof(version), "Failed to change the version");
+   close(fd);
+   handle = persComDbOpen("/tmp/frozen.db", 0x0);
+   fail_unless(handle < 0, "Frozen image with wrong version opened: retval: [%d]", handle);
+
+   free(keyList);
+   free(items);
+   free(values);
+   free(keys);
+}
+END_TEST
+
+
+
+/*
+ * Views of values are returned without a copy from the database file. A pending view keeps its value while the key
+ * is overwritten or deleted and while the file grows, the database is not compacted until all views are released.
+ * Inline values and values of the cache are returned as copies.
+ */
+START_TEST(test_ReadKeyView)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int numKeys = 2000;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   char expected[READ_SIZE] = { 0 };
+   const void* view = NULL;
+   const void* deletedView = NULL;
+   const void* smallView = NULL;
+
+   remove("/tmp/read-key-view.db");
+   handle = persComDbOpen("/tmp/read-key-view.db", 0x3); //write through
+   fail_unless(handle >= 0, "Failed to open database: retval: [%d]", handle);
+
+   memset(expected, 'A', 1000);
+   memset(write, 'D', 1000);
+   ret = persComDbWriteKey(handle, "Key_view", expected, 1000);
+   fail_unless(ret == 1000, "Wrong write size: [%d]", ret);
+   ret = persComDbWriteKey(handle, "Key_view_deleted", write, 1000);
+   fail_unless(ret == 1000, "Wrong write size: [%d]", ret);
+   ret = persComDbWriteKey(handle, "Key_view_small", "small", 5);
+   fail_unless(ret == 5, "Wrong write size: [%d]", ret);
+
+   ret = persComDbReadKeyView(handle, "Key_view", &view);
+   fail_unless(ret == 1000 && memcmp(view, expected, 1000) == 0, "Wrong view: [%d]", ret);
+   ret = persComDbReadKeyView(handle, "Key_view_deleted", &deletedView);
+   fail_unless(ret == 1000 && memcmp(deletedView, write, 1000) == 0, "Wrong view: [%d]", ret);
+   ret = persComDbReadKeyView(handle, "Key_view_small", &smallView);
+   fail_unless(ret == 5 && memcmp(smallView, "small", 5) == 0, "Wrong view of inline value: [%d]", ret);
+   ret = persComDbReadKeyView(handle, "Key_view_missing", &smallView);
+   fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Missing key found: [%d]", ret);
+
+   //overwrite and delete the viewed keys and grow the file
+   memset(write, 'B', 1000);
+   for (i = 0; i < 3; i++)
+   {
+      ret = persComDbWriteKey(handle, "Key_view", write, 1000);
+      fail_unless(ret == 1000, "Wrong write size: [%d]", ret);
+   }
+   ret = persComDbDeleteKey(handle, "Key_view_deleted");
+   fail_unless(ret >= 0, "Failed to delete key: [%d]", ret);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_view_%d", i);
+      ret = persComDbWriteKey(handle, key, write, 1000);
+      fail_unless(ret == 1000, "Wrong write size: [%d]", ret);
+   }
+   ret = persComDbReadKey(handle, "Key_view", read, sizeof(read));
+   fail_unless(ret == 1000 && memcmp(read, write, 1000) == 0, "Wrong value read: [%d]", ret);
+   memset(write, 'D', 1000);
+   fail_unless(memcmp(view, expected, 1000) == 0, "Value of the view changed");
+   fail_unless(memcmp(deletedView, write, 1000) == 0, "Value of the view of a deleted key changed");
+
+   ret = persComDbCompact(handle);
+   fail_unless(ret < 0, "Database compacted while views are pending: [%d]", ret);
+   fail_unless(persComDbReleaseView(handle, view) == 0, "Failed to release view");
+   fail_unless(persComDbReleaseView(handle, deletedView) == 0, "Failed to release view");
+   fail_unless(persComDbReleaseView(handle, smallView) == 0, "Failed to release view");
+   ret = persComDbCompact(handle);
+   fail_unless(ret >= 0, "Failed to compact database: [%d]", ret);
+
+   memset(write, 'B', 1000);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_view_%d", i);
+      ret = persComDbReadKeyView(handle, key, &view);
+      fail_unless(ret == 1000 && memcmp(view, write, 1000) == 0, "Wrong view of key [%s]: [%d]", key, ret);
+      fail_unless(persComDbReleaseView(handle, view) == 0, "Failed to release view");
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //the view of a cached value is a copy
+   handle = persComDbOpen("/tmp/read-key-view.db", 0x1);
+   fail_unless(handle >= 0, "Failed to open database: retval: [%d]", handle);
+   memset(write, 'C', 1000);
+   ret = persComDbWriteKey(handle, "Key_view", write, 1000);
+   fail_unless(ret == 1000, "Wrong write size: [%d]", ret);
+   ret = persComDbReadKeyView(handle, "Key_view", &view);
+   fail_unless(ret == 1000 && memcmp(view, write, 1000) == 0, "Wrong view of cached value: [%d]", ret);
+   fail_unless(persComDbReleaseView(handle, view) == 0, "Failed to release view");
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+/*
+ * The views of a process which ended without releasing them must not keep the database from reusing data blocks
+ * and from being compacted. Views requested while all pins are used are returned as copies.
+ */
+START_TEST(test_ReadKeyViewEndedProcess)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int k = 0;
+   int numKeys = 100;
+   int status = 0;
+   pid_t pid = 0;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   const void* views[100] = { NULL };
+   struct stat before;
+   struct stat after;
+
+   //the ended process leaves the shared memory and the semaphore of the database behind, remove them of an earlier run
+   remove("/tmp/read-key-view-ended.db");
+   remove("/dev/shm/sem._tmp_read_key_view_ended_db-sem");
+   remove("/dev/shm/_tmp_read_key_view_ended_db-cache");
+   remove("/dev/shm/_tmp_read_key_view_ended_db-ht");
+   remove("/dev/shm/_tmp_read_key_view_ended_db-shm-info");
+   handle = persComDbOpen("/tmp/read-key-view-ended.db", 0x3); //write through
+   fail_unless(handle >= 0, "Failed to open database: retval: [%d]", handle);
+   memset(write, 'A', 1000);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_view_ended_%d", i);
+      ret = persComDbWriteKey(handle, key, write, 1000);
+      fail_unless(ret == 1000, "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+
+   pid = fork();
+   if (pid == 0)
+   {
+      /*child: ends without releasing its views*/
+      createPidFile(getpid());
+      handle = persComDbOpen("/tmp/read-key-view-ended.db", 0x2);
+      for (i = 0; i < 10 && handle >= 0; i++)
+      {
+         snprintf(key, 128, "Key_view_ended_%d", i);
+         (void) persComDbReadKeyView(handle, key, &views[i]);
+      }
+      _exit(EXIT_SUCCESS);
+   }
+   fail_unless(pid > 0, "Failed to fork");
+   (void) waitpid(pid, &status, 0);
+
+   //the data blocks of the keys viewed by the ended process are reused
+   stat("/tmp/read-key-view-ended.db", &before);
+   for (k = 0; k < 200; k++)
+   {
+      memset(write, 'B' + (k % 20), 1000);
+      for (i = 0; i < 10; i++)
+      {
+         snprintf(key, 128, "Key_view_ended_%d", i);
+         ret = persComDbWriteKey(handle, key, write, 1000);
+         fail_unless(ret == 1000, "Wrong write size for key [%s]: [%d]", key, ret);
+      }
+   }
+   stat("/tmp/read-key-view-ended.db", &after);
+   fail_unless(after.st_size - before.st_size < 256 * 1024, "Database file grew from [%d] to [%d] bytes", (int) before.st_size, (int) after.st_size);
+   ret = persComDbCompact(handle);
+   fail_unless(ret >= 0, "Failed to compact database after the end of a process with views: [%d]", ret);
+
+   //more views than pins: all views return the value
+   memset(write, 'A', 1000);
+   for (i = 10; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_view_ended_%d", i);
+      ret = persComDbReadKeyView(handle, key, &views[i]);
+      fail_unless(ret == 1000 && memcmp(views[i], write, 1000) == 0, "Wrong view of key [%s]: [%d]", key, ret);
+   }
+   for (i = 10; i < numKeys; i++)
+   {
+      fail_unless(persComDbReleaseView(handle, views[i]) == 0, "Failed to release view");
+   }
+   ret = persComDbCompact(handle);
+   fail_unless(ret >= 0, "Failed to compact database after the views were released: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //the reference of the ended process is never released, so this close was not the last one
+   remove("/dev/shm/sem._tmp_read_key_view_ended_db-sem");
+   remove("/dev/shm/_tmp_read_key_view_ended_db-cache");
+   remove("/dev/shm/_tmp_read_key_view_ended_db-ht");
+   remove("/dev/shm/_tmp_read_key_view_ended_db-shm-info");
+}
+END_TEST
+
+
+
+/*
+ * Several keys are written at once to write through, write cached and compressing databases and read back
+ * after the database was reopened. A batch with an invalid key writes no key.
+ */
+START_TEST(test_WriteKeys)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int k = 0;
+   int numKeys = 200;
+   int options[3] = { 0x3, 0x1, 0x9 }; //write through, write cached, compressed
+   char read[READ_SIZE] = { 0 };
+   char* keyBuffer = NULL;
+   char* valueBuffer = NULL;
+   const char** keys = NULL;
+   const char** values = NULL;
+   int* sizes = NULL;
+
+   keyBuffer = (char*) malloc(numKeys * 32);
+   valueBuffer = (char*) malloc(numKeys * 256);
+   keys = (const char**) malloc(numKeys * sizeof(char*));
+   values = (const char**) malloc(numKeys * sizeof(char*));
+   sizes = (int*) malloc(numKeys * sizeof(int));
+   fail_unless(keyBuffer != NULL && valueBuffer != NULL && keys != NULL && values != NULL && sizes != NULL, "Out of memory");
+
+   for (k = 0; k < 3; k++)
+   {
+      remove("/tmp/write-keys.db");
+      handle = persComDbOpen("/tmp/write-keys.db", options[k]);
+      fail_unless(handle >= 0, "Failed to open database: retval: [%d]", handle);
+      for (i = 0; i < numKeys; i++)
+      {
+         snprintf(keyBuffer + i * 32, 32, "Key_batch_%d", i);
+         memset(valueBuffer + i * 256, 'a' + (i % 26), 256);
+         keys[i] = keyBuffer + i * 32;
+         values[i] = valueBuffer + i * 256;
+         sizes[i] = 1 + (i * 13) % 256;
+      }
+      ret = persComDbWriteKeys(handle, keys, values, sizes, numKeys);
+      fail_unless(ret == numKeys, "Failed to write keys: retval: [%d]", ret);
+
+      //overwrite the first keys, the invalid size of the last key rejects the batch
+      sizes[0] = 100;
+      sizes[9] = PERS_DB_MAX_SIZE_KEY_DATA + 1;
+      ret = persComDbWriteKeys(handle, keys, values, sizes, 10);
+      fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Batch with invalid size written: retval: [%d]", ret);
+      sizes[0] = 1;
+      sizes[9] = 1 + (9 * 13) % 256;
+      ret = persComDbClose(handle);
+      fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+      handle = persComDbOpen("/tmp/write-keys.db", options[k] & ~0x1);
+      fail_unless(handle >= 0, "Failed to reopen database: retval: [%d]", handle);
+      for (i = 0; i < numKeys; i++)
+      {
+         memset(read, 0, sizeof(read));
+         ret = persComDbReadKey(handle, keys[i], read, sizeof(read));
+         fail_unless(ret == sizes[i] && memcmp(read, values[i], sizes[i]) == 0, "Wrong value of key [%s]: [%d]", keys[i], ret);
+      }
+      ret = persComDbClose(handle);
+      fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   }
+
+   free(sizes);
+   free(values);
+   free(keys);
+   free(valueBuffer);
+   free(keyBuffer);
+}
+END_TEST
+
+
+
+
+
+/*
+ * Several keys are read at once from write through, write cached and compressing databases. Half of the keys
+ * are read from the file and half from the cache (write cached mode), every third key is missing and one buffer
+ * is too small. Neither the missing keys nor the small buffer fail the other keys.
+ */
+START_TEST(test_ReadKeys)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int k = 0;
+   int numKeys = 150;
+   int found = 0;
+   int options[3] = { 0x3, 0x1, 0x9 }; //write through, write cached, compressed
+   char* keyBuffer = NULL;
+   char* valueBuffer = NULL;
+   char* readBuffer = NULL;
+   const char** keys = NULL;
+   char** buffers = NULL;
+   int* sizes = NULL;
+   int* bufferSizes = NULL;
+   int* results = NULL;
+
+   keyBuffer = (char*) malloc(numKeys * 32);
+   valueBuffer = (char*) malloc(numKeys * 256);
+   readBuffer = (char*) malloc(numKeys * 256);
+   keys = (const char**) malloc(numKeys * sizeof(char*));
+   buffers = (char**) malloc(numKeys * sizeof(char*));
+   sizes = (int*) malloc(numKeys * sizeof(int));
+   bufferSizes = (int*) malloc(numKeys * sizeof(int));
+   results = (int*) malloc(numKeys * sizeof(int));
+   fail_unless(keyBuffer != NULL && valueBuffer != NULL && readBuffer != NULL && keys != NULL && buffers != NULL && sizes != NULL
+               && bufferSizes != NULL && results != NULL, "Out of memory");
+
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(keyBuffer + i * 32, 32, "Key_read_batch_%d", i);
+      memset(valueBuffer + i * 256, 'a' + (i % 26), 256);
+      keys[i] = keyBuffer + i * 32;
+      buffers[i] = readBuffer + i * 256;
+      sizes[i] = 1 + (i * 17) % 256; //inline and data block values
+      bufferSizes[i] = 256;
+   }
+   bufferSizes[4] = sizes[4] - 1;
+
+   for (k = 0; k < 3; k++)
+   {
+      remove("/tmp/read-keys.db");
+      handle = persComDbOpen("/tmp/read-keys.db", options[k] | 0x2);
+      fail_unless(handle >= 0, "Failed to open database: retval: [%d]", handle);
+      for (i = 0; i < numKeys / 2; i++)
+      {
+         if (i % 3 != 2)
+         {
+            ret = persComDbWriteKey(handle, keys[i], valueBuffer + i * 256, sizes[i]);
+            fail_unless(ret == sizes[i], "Failed to write key [%s]: [%d]", keys[i], ret);
+         }
+      }
+      ret = persComDbClose(handle);
+      fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+      handle = persComDbOpen("/tmp/read-keys.db", options[k]);
+      fail_unless(handle >= 0, "Failed to reopen database: retval: [%d]", handle);
+      for (i = numKeys / 2; i < numKeys; i++)
+      {
+         if (i % 3 != 2)
+         {
+            ret = persComDbWriteKey(handle, keys[i], valueBuffer + i * 256, sizes[i]);
+            fail_unless(ret == sizes[i], "Failed to write key [%s]: [%d]", keys[i], ret);
+         }
+      }
+
+      memset(readBuffer, 0, numKeys * 256);
+      found = 0;
+      ret = persComDbReadKeys(handle, keys, buffers, bufferSizes, results, numKeys);
+      for (i = 0; i < numKeys; i++)
+      {
+         if (i % 3 == 2)
+         {
+            fail_unless(results[i] == PERS_COM_ERR_NOT_FOUND, "Missing key [%s] found: [%d]", keys[i], results[i]);
+         }
+         else if (i == 4)
+         {
+            fail_unless(results[i] == PERS_COM_ERR_BUFFER_TOO_SMALL, "Too small buffer of key [%s] accepted: [%d]", keys[i], results[i]);
+         }
+         else
+         {
+            fail_unless(results[i] == sizes[i] && memcmp(buffers[i], valueBuffer + i * 256, sizes[i]) == 0, "Wrong value of key [%s]: [%d]", keys[i], results[i]);
+            found++;
+         }
+      }
+      fail_unless(ret == found, "Wrong number of keys read: [%d] instead of [%d]", ret, found);
+
+      keys[7] = NULL;
+      ret = persComDbReadKeys(handle, keys, buffers, bufferSizes, results, numKeys);
+      fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Batch with invalid key read: retval: [%d]", ret);
+      keys[7] = keyBuffer + 7 * 32;
+
+      ret = persComDbClose(handle);
+      fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   }
+
+   free(results);
+   free(bufferSizes);
+   free(sizes);
+   free(buffers);
+   free(keys);
+   free(readBuffer);
+   free(valueBuffer);
+   free(keyBuffer);
+}
+END_TEST
+
+
+
+
+
+/*
+ * The keys of a database with keys in the file and in the cache (written, overwritten and deleted) are
+ * listed with the key cursor: without prefix the cursor returns the same keys as the key list,
+ * with prefix only the matching keys. A too small buffer does not move the cursor.
+ */
+START_TEST(test_KeyCursor)
+{
+   int ret = 0;
+   int handle = 0;
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char* keyList = NULL;
+   char* entry = NULL;
+   int listSize = 0;
+   int listed = 0;
+   int found = 0;
+   int i = 0;
+   int numKeys = 600;
+
+   remove("/tmp/key-cursor.db");
+   handle = persComDbOpen("/tmp/key-cursor.db", 0x3); //write through
+   fail_unless(handle >= 0, "Failed to create database: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, sizeof(key), (i % 2 == 0) ? "/cursor/even/%d" : "/cursor/odd/%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/key-cursor.db", 0x1); //cached
+   fail_unless(handle >= 0, "Failed to reopen database: retval: [%d]", handle);
+   ret = persComDbIterNext(handle, key, sizeof(key));
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Key returned without open cursor: [%d]", ret);
+
+   //new keys and overwritten keys in cache, every seventh key deleted in cache
+   for (i = numKeys; i < numKeys + 100; i++)
+   {
+      snprintf(key, sizeof(key), (i % 2 == 0) ? "/cursor/even/%d" : "/cursor/odd/%d", i);
+      ret = persComDbWriteKey(handle, key, "cached", 6);
+      fail_unless(ret == 6, "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   for (i = 0; i < numKeys; i += 3)
+   {
+      snprintf(key, sizeof(key), (i % 2 == 0) ? "/cursor/even/%d" : "/cursor/odd/%d", i);
+      ret = persComDbWriteKey(handle, key, "cached", 6);
+      fail_unless(ret == 6, "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   for (i = 0; i < numKeys + 100; i += 7)
+   {
+      snprintf(key, sizeof(key), (i % 2 == 0) ? "/cursor/even/%d" : "/cursor/odd/%d", i);
+      ret = persComDbDeleteKey(handle, key);
+      fail_unless(ret >= 0, "Failed to delete key [%s]: [%d]", key, ret);
+   }
+
+   //without prefix every key of the key list is returned once
+   listSize = persComDbGetSizeKeysList(handle);
+   fail_unless(listSize > 0, "Wrong key list size: [%d]", listSize);
+   keyList = (char*) malloc(listSize);
+   fail_unless(keyList != NULL, "Out of memory");
+   ret = persComDbGetKeysList(handle, keyList, listSize);
+   fail_unless(ret == listSize, "Wrong key list size: [%d]", ret);
+   ret = persComDbIterOpen(handle, NULL);
+   fail_unless(ret == 0, "Failed to open cursor: [%d]", ret);
+   while ((ret = persComDbIterNext(handle, key, sizeof(key))) > 0)
+   {
+      fail_unless(ret == strlen(key), "Wrong key length of key [%s]: [%d]", key, ret);
+      found = 0;
+      for (entry = keyList; entry < keyList + listSize; entry += strlen(entry) + 1)
+      {
+         if (strcmp(entry, key) == 0)
+         {
+            fail_unless(entry[0] != '#', "Key [%s] returned twice", key);
+            entry[0] = '#';
+            found = 1;
+            break;
+         }
+      }
+      fail_unless(found == 1, "Key [%s] not in key list", key);
+      listed++;
+   }
+   fail_unless(ret == 0, "Failed to get next key: [%d]", ret);
+   for (entry = keyList; entry < keyList + listSize; entry += strlen(entry) + 1)
+   {
+      fail_unless(entry[0] == '#', "Key [%s] not returned by cursor", entry);
+   }
+   fail_unless(listed == numKeys + 100 - (numKeys + 100 + 6) / 7, "Wrong number of keys: [%d]", listed);
+   free(keyList);
+
+   //with prefix, a too small buffer does not move the cursor
+   ret = persComDbIterOpen(handle, "/cursor/odd/");
+   fail_unless(ret == 0, "Failed to open cursor: [%d]", ret);
+   ret = persComDbIterNext(handle, key, 4);
+   fail_unless(ret == PERS_COM_ERR_BUFFER_TOO_SMALL, "Key returned into too small buffer: [%d]", ret);
+   listed = 0;
+   while ((ret = persComDbIterNext(handle, key, sizeof(key))) > 0)
+   {
+      fail_unless(strncmp(key, "/cursor/odd/", 12) == 0, "Key [%s] does not match prefix", key);
+      i = atoi(key + 12);
+      fail_unless(i % 7 != 0, "Deleted key [%s] returned", key);
+      listed++;
+   }
+   fail_unless(ret == 0, "Failed to get next key: [%d]", ret);
+   fail_unless(listed == 350 - 50, "Wrong number of keys with prefix: [%d]", listed);
+   ret = persComDbIterClose(handle);
+   fail_unless(ret == 0, "Failed to close cursor: [%d]", ret);
+   ret = persComDbIterNext(handle, key, sizeof(key));
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Key returned by closed cursor: [%d]", ret);
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+
+
+/*
+ * New keys are written to a write through database while its keys are listed with the key cursor.
+ * The hashtables are split during the listing, still every key written before is returned exactly once
+ * and no new key is returned twice.
+ */
+START_TEST(test_KeyCursorWrites)
+{
+   int ret = 0;
+   int handle = 0;
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME] = { 0 };
+   char newKey[PERS_DB_MAX_LENGTH_KEY_NAME] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   int numKeys = 3000;
+   int* returned = NULL;
+   int* newReturned = NULL;
+   int listed = 0;
+   int written = 0;
+   int i = 0;
+
+   returned = (int*) calloc(numKeys, sizeof(int));
+   newReturned = (int*) calloc(numKeys, sizeof(int));
+   fail_unless(returned != NULL && newReturned != NULL, "Out of memory");
+
+   remove("/tmp/key-cursor-writes.db");
+   handle = persComDbOpen("/tmp/key-cursor-writes.db", 0x3); //write through
+   fail_unless(handle >= 0, "Failed to create database: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, sizeof(key), "/cursor/old/%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+
+   //a new key is written and the returned key is overwritten after every returned key
+   ret = persComDbIterOpen(handle, NULL);
+   fail_unless(ret == 0, "Failed to open cursor: [%d]", ret);
+   while ((ret = persComDbIterNext(handle, key, sizeof(key))) > 0)
+   {
+      if (strncmp(key, "/cursor/old/", 12) == 0)
+      {
+         i = atoi(key + 12);
+         fail_unless(i >= 0 && i < numKeys, "Unknown key [%s] returned", key);
+         fail_unless(returned[i] == 0, "Key [%s] returned twice", key);
+         returned[i] = 1;
+         listed++;
+         ret = persComDbWriteKey(handle, key, "overwritten", 11);
+         fail_unless(ret == 11, "Wrong write size for key [%s]: [%d]", key, ret);
+      }
+      else
+      {
+         fail_unless(strncmp(key, "/cursor/new/", 12) == 0, "Unknown key [%s] returned", key);
+         i = atoi(key + 12);
+         fail_unless(i >= 0 && i < written, "Unknown key [%s] returned", key);
+         fail_unless(newReturned[i] == 0, "Key [%s] returned twice", key);
+         newReturned[i] = 1;
+      }
+      if (written < numKeys)
+      {
+         snprintf(newKey, sizeof(newKey), "/cursor/new/%d", written);
+         ret = persComDbWriteKey(handle, newKey, "new", 3);
+         fail_unless(ret == 3, "Wrong write size for key [%s]: [%d]", newKey, ret);
+         written++;
+      }
+   }
+   fail_unless(ret == 0, "Failed to get next key: [%d]", ret);
+   fail_unless(listed == numKeys, "Wrong number of keys: [%d]", listed);
+   ret = persComDbIterClose(handle);
+   fail_unless(ret == 0, "Failed to close cursor: [%d]", ret);
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   free(returned);
+   free(newReturned);
+}
+END_TEST
+
+
+
+
+
+/*
+ * After the first listing the size of the key list is updated by every write and delete. The size must match
+ * the key list after new keys were written, keys were overwritten, deleted (also missing keys) and written again,
+ * in write through and write cached mode and after the database was reopened.
+ */
+START_TEST(test_KeyListSize)
+{
+   int ret = 0;
+   int handle = 0;
+   int size = 0;
+   int listSize = 0;
+   int k = 0;
+   int i = 0;
+   int numKeys = 300;
+   int options[2] = { 0x3, 0x1 }; //write through, write cached
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME] = { 0 };
+   char* keyList = NULL;
+
+   remove("/tmp/key-list-size.db");
+   for (k = 0; k < 2; k++)
+   {
+      handle = persComDbOpen("/tmp/key-list-size.db", options[k]);
+      fail_unless(handle >= 0, "Failed to open database: retval: [%d]", handle);
+      size = persComDbGetSizeKeysList(handle);
+      fail_unless(size >= 0, "Failed to get size of key list: [%d]", size);
+
+      for (i = 0; i < numKeys; i++)
+      {
+         snprintf(key, sizeof(key), "Key_list_size_%d_%d", k, i);
+         ret = persComDbWriteKey(handle, key, key, strlen(key)); //new key
+         fail_unless(ret == strlen(key), "Failed to write key [%s]: [%d]", key, ret);
+         ret = persComDbWriteKey(handle, key, "overwritten", 11);
+         fail_unless(ret == 11, "Failed to write key [%s]: [%d]", key, ret);
+         if (i % 3 == 0)
+         {
+            ret = persComDbDeleteKey(handle, key);
+            fail_unless(ret >= 0, "Failed to delete key [%s]: [%d]", key, ret);
+            (void) persComDbDeleteKey(handle, key); //already deleted
+         }
+         if (i % 9 == 0)
+         {
+            ret = persComDbWriteKey(handle, key, "again", 5);
+            fail_unless(ret == 5, "Failed to write key [%s]: [%d]", key, ret);
+         }
+      }
+      for (i = 0; i < numKeys; i += 5) //keys of the first round deleted in cache
+      {
+         snprintf(key, sizeof(key), "Key_list_size_%d_%d", 0, i);
+         (void) persComDbDeleteKey(handle, key);
+      }
+
+      size = persComDbGetSizeKeysList(handle);
+      keyList = (char*) malloc(size + 1);
+      fail_unless(keyList != NULL, "Out of memory");
+      listSize = persComDbGetKeysList(handle, keyList, size + 1);
+      fail_unless(size == listSize, "Size of key list [%d] does not match key list [%d]", size, listSize);
+      free(keyList);
+
+      ret = persComDbClose(handle);
+      fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   }
+
+   handle = persComDbOpen("/tmp/key-list-size.db", 0x0);
+   fail_unless(handle >= 0, "Failed to reopen database: retval: [%d]", handle);
+   size = persComDbGetSizeKeysList(handle);
+   fail_unless(size == listSize, "Size of key list after reopen [%d] does not match [%d]", size, listSize);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+
+
+/*
+ * Values of changing sizes are written to the cache: keys are overwritten with bigger and smaller values
+ * (the value moves to a chunk of another size class or is overwritten in place), deleted and written again.
+ * Every read must return the last written value, from the cache and after the cache was written back to the file.
+ */
+START_TEST(test_CacheValueSizes)
+{
+   int ret = 0;
+   int handle = 0;
+   int round = 0;
+   int i = 0;
+   int j = 0;
+   int size = 0;
+   int numKeys = 200;
+   int numRounds = 4;
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME] = { 0 };
+   char write[PERS_DB_MAX_SIZE_KEY_DATA] = { 0 };
+   char read[PERS_DB_MAX_SIZE_KEY_DATA] = { 0 };
+
+   remove("/tmp/cache-value-sizes.db");
+   handle = persComDbOpen("/tmp/cache-value-sizes.db", 0x1); //write cached
+   fail_unless(handle >= 0, "Failed to open database: retval: [%d]", handle);
+
+   for (round = 0; round < numRounds; round++)
+   {
+      for (i = 0; i < numKeys; i++)
+      {
+         snprintf(key, sizeof(key), "Key_cache_value_size_%d", i);
+         if ((i + round) % 7 == 0)
+         {
+            ret = persComDbDeleteKey(handle, key);
+            fail_unless(ret >= 0 || round == 0, "Failed to delete key [%s]: [%d]", key, ret);
+            continue;
+         }
+         size = (i * 37 + round * 1013) % PERS_DB_MAX_SIZE_KEY_DATA + 1;
+         for (j = 0; j < size; j++)
+         {
+            write[j] = (char) (i + round * j + j / 7);
+         }
+         ret = persComDbWriteKey(handle, key, write, size);
+         fail_unless(ret == size, "Failed to write key [%s]: [%d]", key, ret);
+      }
+
+      for (i = 0; i < numKeys; i++)
+      {
+         snprintf(key, sizeof(key), "Key_cache_value_size_%d", i);
+         ret = persComDbReadKey(handle, key, read, sizeof(read));
+         if ((i + round) % 7 == 0)
+         {
+            fail_unless(ret < 0, "Deleted key [%s] found in round [%d]: [%d]", key, round, ret);
+            continue;
+         }
+         size = (i * 37 + round * 1013) % PERS_DB_MAX_SIZE_KEY_DATA + 1;
+         fail_unless(ret == size, "Wrong size of key [%s] in round [%d]: [%d]", key, round, ret);
+         for (j = 0; j < size; j++)
+         {
+            fail_unless(read[j] == (char) (i + round * j + j / 7), "Wrong value of key [%s] in round [%d]", key, round);
+         }
+      }
+   }
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/cache-value-sizes.db", 0x0);
+   fail_unless(handle >= 0, "Failed to reopen database: retval: [%d]", handle);
+   round = numRounds - 1;
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, sizeof(key), "Key_cache_value_size_%d", i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      if ((i + round) % 7 == 0)
+      {
+         fail_unless(ret < 0, "Deleted key [%s] found after reopen: [%d]", key, ret);
+         continue;
+      }
+      size = (i * 37 + round * 1013) % PERS_DB_MAX_SIZE_KEY_DATA + 1;
+      fail_unless(ret == size, "Wrong size of key [%s] after reopen: [%d]", key, ret);
+      fail_unless(read[size - 1] == (char) (i + round * (size - 1) + (size - 1) / 7), "Wrong value of key [%s] after reopen", key);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+
+
+/*
+ * The cache is filled with medium sized values which are then overwritten with small values.
+ * The freed chunks are too small for maximum size values: they must be merged, so that
+ * about as many new maximum size values are accepted as by an empty cache.
+ */
+START_TEST(test_CacheShrinkThenGrow)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int medium = 0;
+   int large = 0;
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME] = { 0 };
+   char write[PERS_DB_MAX_SIZE_KEY_DATA] = { 0 };
+   char read[PERS_DB_MAX_SIZE_KEY_DATA] = { 0 };
+
+   remove("/tmp/cache-shrink-grow.db");
+   handle = persComDbOpen("/tmp/cache-shrink-grow.db", 0x1); //write cached
+   fail_unless(handle >= 0, "Failed to open database: retval: [%d]", handle);
+
+   memset(write, 'm', sizeof(write));
+   for (medium = 0; medium < 100000; medium++)
+   {
+      snprintf(key, sizeof(key), "Key_shrink_%d", medium);
+      if (persComDbWriteKey(handle, key, write, 4000) != 4000)
+      {
+         break;
+      }
+   }
+   fail_unless(medium > 0 && medium < 100000, "Cache not filled with medium values: [%d]", medium);
+
+   for (i = 0; i < medium; i++)
+   {
+      snprintf(key, sizeof(key), "Key_shrink_%d", i);
+      snprintf(write, sizeof(write), "small_value_%d", i);
+      ret = persComDbWriteKey(handle, key, write, 16);
+      fail_unless(ret == 16, "Failed to overwrite key [%s] with a small value: [%d]", key, ret);
+   }
+
+   memset(write, 'l', sizeof(write));
+   for (large = 0; large < 100000; large++)
+   {
+      snprintf(key, sizeof(key), "Key_grow_%d", large);
+      if (persComDbWriteKey(handle, key, write, 8000) != 8000)
+      {
+         break;
+      }
+   }
+   fail_unless(large >= 2000, "Freed cache memory not reused for large values: [%d]", large);
+
+   for (i = 0; i < medium; i++)
+   {
+      snprintf(key, sizeof(key), "Key_shrink_%d", i);
+      snprintf(write, sizeof(write), "small_value_%d", i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      fail_unless(ret == 16 && strcmp(read, write) == 0, "Wrong small value of key [%s]: [%d]", key, ret);
+   }
+   for (i = 0; i < large; i++)
+   {
+      snprintf(key, sizeof(key), "Key_grow_%d", i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      fail_unless(ret == 8000 && read[0] == 'l' && read[7999] == 'l', "Wrong large value of key [%s]: [%d]", key, ret);
+   }
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+
+
+/*
+ * Keys with long common prefixes are written to the file and then partially
+ * overwritten and deleted in the cache. The key list must contain every
+ * remaining key exactly once, no matter if it is found in the cache or in the file.
+ */
+START_TEST(test_SharedPrefixKeys)
+{
+   int ret = 0;
+   int handle = 0;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   char* keyList = NULL;
+   char* entry = NULL;
+   int listSize = 0;
+   int expectedSize = 0;
+   int found = 0;
+   int i = 0;
+   int numKeys = 2000;
+
+   //Cleaning up testdata folder
+   remove("/tmp/shared-prefix-keys.db");
+
+   handle = persComDbOpen("/tmp/shared-prefix-keys.db", 0x3); //write through and create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "/node/user/1/seat/%d/setting", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/shared-prefix-keys.db", 0x1); //cached
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+
+   //overwrite every second and delete every fifth key in the cache
+   for (i = 0; i < numKeys; i += 2)
+   {
+      snprintf(key, 128, "/node/user/1/seat/%d/setting", i);
+      snprintf(write, READ_SIZE, "CACHED-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   for (i = 0; i < numKeys; i += 5)
+   {
+      snprintf(key, 128, "/node/user/1/seat/%d/setting", i);
+      ret = persComDbDeleteKey(handle, key);
+      fail_unless(ret >= 0, "Failed to delete key [%s]: [%d]", key, ret);
+   }
+
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "/node/user/1/seat/%d/setting", i);
+      if (i % 5 != 0)
+      {
+         expectedSize += strlen(key) + 1;
+         snprintf(write, READ_SIZE, (i % 2 == 0) ? "CACHED-%d" : "DATA-%d", i);
+         memset(read, 0, sizeof(read));
+         ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+         fail_unless(ret == strlen(write), "Wrong read size for key [%s]: [%d]", key, ret);
+         fail_unless(memcmp(read, write, strlen(write)) == 0, "Buffer not correctly read for key [%s]", key);
+      }
+   }
+
+   listSize = persComDbGetSizeKeysList(handle);
+   fail_unless(listSize == expectedSize, "Wrong key list size: [%d] expected: [%d]", listSize, expectedSize);
+
+   keyList = (char*) malloc(listSize);
+   fail_unless(keyList != NULL, "Failed to allocate the key list");
+   ret = persComDbGetKeysList(handle, keyList, listSize);
+   fail_unless(ret == listSize, "Wrong key list read: [%d]", ret);
+
+   for (entry = keyList; entry < keyList + listSize; entry += strlen(entry) + 1)
+   {
+      fail_unless(sscanf(entry, "/node/user/1/seat/%d/setting", &i) == 1, "Unexpected key in list [%s]", entry);
+      fail_unless(i % 5 != 0, "Deleted key in list [%s]", entry);
+      found++;
+   }
+   fail_unless(found == numKeys - numKeys / 5, "Wrong number of keys in list: [%d]", found);
+   free(keyList);
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+
+/*
+ * The key hash algorithm of a database file is taken from its header:
+ * a file created with djb2 is read, grown, recovered after a power loss and read again by a process using wyhash for new files,
+ * a file with an unknown key hash algorithm is not opened.
+ */
+START_TEST(test_KeyHashAlgorithmOfFile)
+{
+   int ret = 0;
+   int handle = 0;
+   int fd = 0;
+   int i = 0;
+   int numKeys = 3000;
+   uint64_t algorithm = 0;
+   uint64_t flag = 0x01;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+
+   //Cleaning up testdata folder
+   remove("/tmp/key-hash-algorithm.db");
+
+   ret = KISSDB_setAlgorithms(KISSDB_CHECKSUM_ALGORITHM, 99);
+   fail_unless(ret == KISSDB_ERROR_INVALID_PARAMETERS, "Unknown key hash algorithm accepted: retval: [%d]", ret);
+
+   ret = KISSDB_setAlgorithms(KISSDB_CHECKSUM_ALGORITHM, PERS_COM_KEY_HASH_DJB2);
+   fail_unless(ret == 0, "Failed to select djb2: retval: [%d]", ret);
+   handle = persComDbOpen("/tmp/key-hash-algorithm.db", 0x3); //write through and create test.db if not present
+   KISSDB_setAlgorithms(KISSDB_CHECKSUM_ALGORITHM, KISSDB_KEY_HASH_ALGORITHM);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys / 2; i++)
+   {
+      snprintf(key, 128, "/node/user/1/seat/%d/setting", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   fd = open("/tmp/key-hash-algorithm.db", O_RDONLY);
+   fail_unless(pread(fd, &algorithm, sizeof(algorithm), KVS_HEADER_KEY_HASH_ALGORITHM_OFFSET) == sizeof(algorithm), "Failed to read the header");
+   close(fd);
+   fail_unless(algorithm == PERS_COM_KEY_HASH_DJB2, "Wrong key hash algorithm in the header: [%llu]", (unsigned long long) algorithm);
+
+   //the keys are found and the index grows with djb2, the process default is wyhash
+   handle = persComDbOpen("/tmp/key-hash-algorithm.db", 0x2);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys / 2; i++)
+   {
+      snprintf(key, 128, "/node/user/1/seat/%d/setting", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == strlen(write), "Wrong read size for key [%s]: [%d]", key, ret);
+      fail_unless(memcmp(read, write, strlen(write)) == 0, "Buffer not correctly read for key [%s]", key);
+   }
+   for (i = numKeys / 2; i < numKeys; i++)
+   {
+      snprintf(key, 128, "/node/user/1/seat/%d/setting", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   //set the close failed flag and make the first hashtable corrupt -> the hashtables are rebuilt with djb2
+   fd = open("/tmp/key-hash-algorithm.db", O_RDWR);
+   fail_unless(pwrite(fd, &flag, sizeof(flag), 16) == sizeof(flag), "Failed to set the close failed flag");
+   fail_unless(pwrite(fd, "x", 1, KVS_HEADER_SIZE + 100) == 1, "Failed to corrupt the hashtable");
+   close(fd);
+
+   handle = persComDbOpen("/tmp/key-hash-algorithm.db", 0x0);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "/node/user/1/seat/%d/setting", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == strlen(write), "Wrong read size for key [%s]: [%d]", key, ret);
+      fail_unless(memcmp(read, write, strlen(write)) == 0, "Buffer not correctly read for key [%s]", key);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   //a file written with an unknown key hash algorithm
+   algorithm = 99;
+   fd = open("/tmp/key-hash-algorithm.db", O_RDWR);
+   fail_unless(pwrite(fd, &algorithm, sizeof(algorithm), KVS_HEADER_KEY_HASH_ALGORITHM_OFFSET) == sizeof(algorithm), "Failed to write the header");
+   close(fd);
+   handle = persComDbOpen("/tmp/key-hash-algorithm.db", 0x0);
+   fail_unless(handle < 0, "Database with unknown key hash algorithm opened: retval: [%d]", handle);
+}
+END_TEST
+
+
+
+
+/*
+ * Overwritten keys that need a larger data block and deleted keys leave unused space in the database file.
+ * The database is compacted while a second process has it opened, both processes must read
+ * all keys afterwards and the file size must be reduced by the returned number of bytes.
+ */
+START_TEST(test_CompactDatabase)
+{
+   int ret = 0;
+   int handle = 0;
+   int pid = 0;
+   int status = 0;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   int i = 0;
+   int numKeys = 2000;
+   struct stat before, after;
+
+   //Cleaning up testdata folder
+   remove("/tmp/compact-database.db");
+
+   handle = persComDbOpen("/tmp/compact-database.db", 0x3); //write through and create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_compact_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   //every fourth key gets a value which does not fit into the existing data blocks
+   for (i = 0; i < numKeys; i += 4)
+   {
+      snprintf(key, 128, "Key_compact_%d", i);
+      memset(write, 'x', 600);
+      snprintf(write, READ_SIZE, "LARGE-%d", i);
+      write[strlen(write)] = 'x';
+      write[600] = '\0';
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   for (i = 0; i < numKeys; i += 3)
+   {
+      snprintf(key, 128, "Key_compact_%d", i);
+      ret = persComDbDeleteKey(handle, key);
+      fail_unless(ret >= 0, "Failed to delete key [%s]: [%d]", key, ret);
+   }
+
+   pid = fork();
+   if (pid == 0)
+   {
+      /*child: opens the database before and reads the keys after the compaction*/
+      int errors = 0;
+
+      createPidFile(getpid());
+      handle = persComDbOpen("/tmp/compact-database.db", 0x2);
+      if (handle < 0)
+      {
+         _exit(EXIT_FAILURE);
+      }
+      sleep(3);
+      for (i = 0; i < numKeys; i++)
+      {
+         snprintf(key, 128, "Key_compact_%d", i);
+         memset(read, 0, sizeof(read));
+         ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+         if (i % 3 == 0)
+         {
+            errors += (ret != PERS_COM_ERR_NOT_FOUND);
+         }
+         else if (i % 4 == 0)
+         {
+            errors += (ret != 600 || strncmp(read, "LARGE-", 6) != 0);
+         }
+         else
+         {
+            snprintf(write, READ_SIZE, "DATA-%d", i);
+            errors += (ret != strlen(write) || strcmp(read, write) != 0);
+         }
+      }
+      ret = persComDbWriteKey(handle, "Key_compact_child", "123456", 6);
+      errors += (ret != 6);
+      ret = persComDbClose(handle);
+      errors += (ret != 0);
+      remove(gPidfilename);
+      _exit(errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+   }
+   fail_unless(pid > 0, "Failed to fork");
+
+   //wait until the child has opened the database
+   sleep(1);
+   stat("/tmp/compact-database.db", &before);
+   ret = persComDbCompact(handle);
+   stat("/tmp/compact-database.db", &after);
+   fail_unless(ret > 0, "Failed to compact database: [%d]", ret);
+   fail_unless(before.st_size - after.st_size == ret, "Wrong number of bytes reclaimed: [%d] file size before: [%d] after: [%d]",
+               ret, (int) before.st_size, (int) after.st_size);
+   printf("Compaction reduced the database file from %d to %d bytes \n", (int) before.st_size, (int) after.st_size);
+
+   (void) waitpid(pid, &status, 0);
+   fail_unless(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS, "Child failed to read the compacted database");
+
+   //write new keys after the compaction
+   for (i = numKeys; i < numKeys + 100; i++)
+   {
+      snprintf(key, 128, "Key_compact_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/compact-database.db", 0x2);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys + 100; i++)
+   {
+      snprintf(key, 128, "Key_compact_%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      if (i < numKeys && i % 3 == 0)
+      {
+         fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key [%s] found: [%d]", key, ret);
+      }
+      else if (i < numKeys && i % 4 == 0)
+      {
+         fail_unless(ret == 600, "Wrong read size for key [%s]: [%d]", key, ret);
+      }
+      else
+      {
+         snprintf(write, READ_SIZE, "DATA-%d", i);
+         fail_unless(ret == strlen(write), "Wrong read size for key [%s]: [%d]", key, ret);
+         fail_unless(memcmp(read, write, strlen(write)) == 0, "Buffer not correctly read for key [%s]", key);
+      }
+   }
+   ret = persComDbReadKey(handle, "Key_compact_child", (char*) read, sizeof(read));
+   fail_unless(ret == 6, "Key written by child after the compaction not found: [%d]", ret);
+
+   //nothing left to reclaim
+   ret = persComDbCompact(handle);
+   fail_unless(ret == 0, "Second compaction reclaimed bytes: [%d]", ret);
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+
+/* writes the value of key number i in round into value and returns its size: the size class changes with every round */
+static int getCompactionValue(int i, int round, char* value)
+{
+   int size = ((i + round) % 2 == 0) ? 100 : 900;
+
+   memset(value, 'a' + (i + round) % 26, size);
+   snprintf(value, size, "ROUND-%d-KEY-%d", round, i);
+   value[strlen(value)] = '-';
+   return size;
+}
+
+/*
+ * A process compacting the database is killed at a later time in every round: all keys must be found with their
+ * latest values and deleted keys must stay deleted when the database is opened again (recovery of the hashtables).
+ * The database is modified again after every recovery, so a data block repaired by the recovery is written again.
+ * At least one compaction must be stopped midway (the checkpoint in the header is cleared while the data is moved).
+ */
+START_TEST(test_CompactionInterrupted)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int round = 0;
+   int numKeys = 3000;
+   int interrupted = 0;
+   int status = 0;
+   int fd = -1;
+   int pipeFd[2];
+   pid_t pid = 0;
+   uint64_t checkpoint = 0;
+   char key[128] = { 0 };
+   char value[READ_SIZE] = { 0 };
+   char readValue[READ_SIZE] = { 0 };
+   int version[3000];
+
+   //the killed process leaves the shared memory and the semaphore of the database behind, remove them of an earlier run
+   remove("/tmp/compaction-interrupted.db");
+   remove("/dev/shm/sem._tmp_compaction_interrupted_db-sem");
+   remove("/dev/shm/_tmp_compaction_interrupted_db-cache");
+   remove("/dev/shm/_tmp_compaction_interrupted_db-ht");
+   remove("/dev/shm/_tmp_compaction_interrupted_db-shm-info");
+
+   handle = persComDbOpen("/tmp/compaction-interrupted.db", 0x3); //write through and create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_interrupted_%d", i);
+      ret = persComDbWriteKey(handle, key, value, getCompactionValue(i, 0, value));
+      fail_unless(ret > 0, "Wrong write size for key [%s]: [%d]", key, ret);
+      version[i] = 0;
+   }
+
+   for (round = 1; round <= 15; round++)
+   {
+      //a fifth of the keys is deleted, another fifth gets a value of another size class, the keys deleted before are written again
+      for (i = 0; i < numKeys; i++)
+      {
+         snprintf(key, 128, "Key_interrupted_%d", i);
+         if (i % 5 == round % 5)
+         {
+            ret = persComDbDeleteKey(handle, key);
+            fail_unless(ret >= 0, "Failed to delete key [%s]: [%d]", key, ret);
+            version[i] = -1;
+         }
+         else if (i % 5 == (round + 1) % 5 || version[i] < 0)
+         {
+            ret = persComDbWriteKey(handle, key, value, getCompactionValue(i, round, value));
+            fail_unless(ret > 0, "Wrong write size for key [%s]: [%d]", key, ret);
+            version[i] = round;
+         }
+      }
+      ret = persComDbClose(handle);
+      fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+      fail_unless(pipe(pipeFd) == 0, "Failed to create pipe");
+      pid = fork();
+      if (pid == 0)
+      {
+         /*child: compacts the database until it is killed*/
+         createPidFile(getpid());
+         handle = persComDbOpen("/tmp/compaction-interrupted.db", 0x2);
+         if (handle < 0 || write(pipeFd[1], "c", 1) != 1)
+         {
+            _exit(EXIT_FAILURE);
+         }
+         (void) persComDbCompact(handle);
+         pause();
+         _exit(EXIT_SUCCESS);
+      }
+      fail_unless(pid > 0, "Failed to fork");
+      close(pipeFd[1]);
+      fail_unless(read(pipeFd[0], readValue, 1) == 1, "Child failed to open the database");
+      close(pipeFd[0]);
+      usleep(round * 300);
+      kill(pid, SIGKILL);
+      (void) waitpid(pid, &status, 0);
+      remove(gPidfilename);
+
+      fd = open("/tmp/compaction-interrupted.db", O_RDONLY);
+      fail_unless(fd >= 0, "Failed to open database file");
+      fail_unless(pread(fd, &checkpoint, sizeof(checkpoint), KVS_HEADER_CHECKPOINT_OFFSET) == sizeof(checkpoint), "Failed to read the header");
+      close(fd);
+      interrupted += (checkpoint == 0);
+
+      //the objects of the database are gone after a power loss as well
+      remove("/dev/shm/sem._tmp_compaction_interrupted_db-sem");
+      remove("/dev/shm/_tmp_compaction_interrupted_db-cache");
+      remove("/dev/shm/_tmp_compaction_interrupted_db-ht");
+      remove("/dev/shm/_tmp_compaction_interrupted_db-shm-info");
+
+      handle = persComDbOpen("/tmp/compaction-interrupted.db", 0x2); //write through
+      fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+      for (i = 0; i < numKeys; i++)
+      {
+         snprintf(key, 128, "Key_interrupted_%d", i);
+         memset(readValue, 0, sizeof(readValue));
+         ret = persComDbReadKey(handle, key, readValue, sizeof(readValue));
+         if (version[i] < 0)
+         {
+            fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key [%s] found in round [%d]: [%d]", key, round, ret);
+         }
+         else
+         {
+            ret = (ret == getCompactionValue(i, version[i], value) && memcmp(readValue, value, ret) == 0) ? 0 : -1;
+            fail_unless(ret == 0, "Wrong value read for key [%s] in round [%d]", key, round);
+         }
+      }
+   }
+   printf("Compaction stopped midway in %d of %d rounds \n", interrupted, round - 1);
+   fail_unless(interrupted > 0, "No compaction was stopped midway");
+
+   ret = persComDbCompact(handle);
+   fail_unless(ret >= 0, "Failed to compact database: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+
+/*
+ * Test reuse of released data blocks:
+ * keys are deleted and other keys are written in every round, the released data blocks must be reused
+ * for the new keys, so the database file does not grow (also after reopening the database)
+ */
+START_TEST(test_ReuseDeletedDataBlocks)
+{
+   int ret = 0;
+   int handle = 0;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   int i = 0;
+   int round = 0;
+   int numKeys = 1000;
+   int numRoundKeys = 200;
+   struct stat before, after;
+
+   //Cleaning up testdata folder
+   remove("/tmp/reuse-deleted-blocks.db");
+
+   handle = persComDbOpen("/tmp/reuse-deleted-blocks.db", 0x3); //write through and create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_reuse_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+
+   for (round = 1; round <= 20; round++)
+   {
+      if (round == 5) //the index has grown for the slots of the deleted keys of the first rounds
+      {
+         //the preallocated area of the file is cut off when the database is closed
+         ret = persComDbClose(handle);
+         fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+         stat("/tmp/reuse-deleted-blocks.db", &before);
+         handle = persComDbOpen("/tmp/reuse-deleted-blocks.db", 0x3);
+         fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+      }
+      if (round == 11)
+      {
+         ret = persComDbClose(handle);
+         fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+         handle = persComDbOpen("/tmp/reuse-deleted-blocks.db", 0x3);
+         fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+      }
+      for (i = 0; i < numRoundKeys; i++)
+      {
+         snprintf(key, 128, "Key_reuse_round_%d_%d", round - 1, i);
+         ret = persComDbDeleteKey(handle, key);
+         fail_unless(ret >= 0 || round == 1, "Failed to delete key [%s]: [%d]", key, ret);
+         snprintf(key, 128, "Key_reuse_round_%d_%d", round, i);
+         snprintf(write, READ_SIZE, "ROUND-%d-%d", round, i);
+         ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+         fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+      }
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+   stat("/tmp/reuse-deleted-blocks.db", &after);
+   fail_unless(after.st_size == before.st_size, "Database file has grown from [%d] to [%d] bytes", (int) before.st_size, (int) after.st_size);
+   handle = persComDbOpen("/tmp/reuse-deleted-blocks.db", 0x3);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_reuse_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == strlen(write), "Wrong read size for key [%s]: [%d]", key, ret);
+      fail_unless(memcmp(read, write, strlen(write)) == 0, "Buffer not correctly read for key [%s]", key);
+   }
+   for (i = 0; i < numRoundKeys; i++)
+   {
+      snprintf(key, 128, "Key_reuse_round_%d_%d", round - 2, i);
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key [%s] found: [%d]", key, ret);
+      snprintf(key, 128, "Key_reuse_round_%d_%d", round - 1, i);
+      snprintf(write, READ_SIZE, "ROUND-%d-%d", round - 1, i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == strlen(write), "Wrong read size for key [%s]: [%d]", key, ret);
+      fail_unless(memcmp(read, write, strlen(write)) == 0, "Buffer not correctly read for key [%s]", key);
+   }
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+}
+END_TEST
+
+
+/*
+ * A process ends without closing the database right after the file has grown, so the file keeps its preallocated area:
+ * after the reopen (recovery of the hashtables and free lists) all keys must be found and new keys
+ * must be written into the preallocated area without growing the file. The close cuts off the rest of the area.
+ */
+START_TEST(test_UncleanExitPreallocatedArea)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int numKeys = 0;
+   int numNewKeys = 20;
+   int status = 0;
+   pid_t pid = 0;
+   char key[128] = { 0 };
+   char write[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   struct stat before;
+   struct stat after;
+
+   //the ended process leaves the shared memory and the semaphore of the database behind, remove them of an earlier run
+   remove("/tmp/unclean-exit-prealloc.db");
+   remove("/dev/shm/sem._tmp_unclean_exit_prealloc_db-sem");
+   remove("/dev/shm/_tmp_unclean_exit_prealloc_db-cache");
+   remove("/dev/shm/_tmp_unclean_exit_prealloc_db-ht");
+   remove("/dev/shm/_tmp_unclean_exit_prealloc_db-shm-info");
+
+   pid = fork();
+   if (pid == 0)
+   {
+      /*child: writes keys until the file has grown twice and ends without closing the database*/
+      int grown = 0;
+
+      createPidFile(getpid());
+      handle = persComDbOpen("/tmp/unclean-exit-prealloc.db", 0x3); //write through and create test.db if not present
+      if (handle < 0)
+      {
+         _exit(EXIT_FAILURE);
+      }
+      stat("/tmp/unclean-exit-prealloc.db", &before);
+      for (i = 0; i < 100000 && grown < 2; i++)
+      {
+         snprintf(key, 128, "Key_unclean_%d", i);
+         snprintf(write, READ_SIZE, "DATA-%d", i);
+         if (persComDbWriteKey(handle, key, (char*) write, strlen(write)) != strlen(write))
+         {
+            _exit(EXIT_FAILURE);
+         }
+         stat("/tmp/unclean-exit-prealloc.db", &after);
+         if (after.st_size != before.st_size)
+         {
+            grown++;
+            before = after;
+         }
+      }
+      snprintf(write, READ_SIZE, "%d", i);
+      if (persComDbWriteKey(handle, "Key_unclean_count", (char*) write, strlen(write)) != strlen(write))
+      {
+         _exit(EXIT_FAILURE);
+      }
+      remove(gPidfilename);
+      _exit(EXIT_SUCCESS);
+   }
+   fail_unless(pid > 0, "Failed to fork");
+   (void) waitpid(pid, &status, 0);
+   fail_unless(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS, "Child failed to write the keys");
+
+   //the objects of the database are gone after a power loss as well
+   remove("/dev/shm/sem._tmp_unclean_exit_prealloc_db-sem");
+   remove("/dev/shm/_tmp_unclean_exit_prealloc_db-cache");
+   remove("/dev/shm/_tmp_unclean_exit_prealloc_db-ht");
+   remove("/dev/shm/_tmp_unclean_exit_prealloc_db-shm-info");
+
+   stat("/tmp/unclean-exit-prealloc.db", &before);
+   handle = persComDbOpen("/tmp/unclean-exit-prealloc.db", 0x2); //write through
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   memset(read, 0, sizeof(read));
+   ret = persComDbReadKey(handle, "Key_unclean_count", (char*) read, sizeof(read));
+   fail_unless(ret > 0, "Failed to read the number of keys: [%d]", ret);
+   numKeys = atoi(read);
+   for (i = 0; i < numKeys; i++)
+   {
+      snprintf(key, 128, "Key_unclean_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == strlen(write) && strcmp(read, write) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+   }
+   for (i = 0; i < numNewKeys; i++)
+   {
+      snprintf(key, 128, "Key_unclean_new_%d", i);
+      snprintf(write, READ_SIZE, "NEW-%d", i);
+      ret = persComDbWriteKey(handle, key, (char*) write, strlen(write));
+      fail_unless(ret == strlen(write), "Wrong write size for key [%s]: [%d]", key, ret);
+   }
+   stat("/tmp/unclean-exit-prealloc.db", &after);
+   fail_unless(after.st_size == before.st_size, "Database file has grown from [%d] to [%d] bytes", (int) before.st_size, (int) after.st_size);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+   stat("/tmp/unclean-exit-prealloc.db", &after);
+   fail_unless(after.st_size < before.st_size, "Preallocated area not cut off at close: [%d] bytes", (int) after.st_size);
+
+   handle = persComDbOpen("/tmp/unclean-exit-prealloc.db", 0x2);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
+   for (i = 0; i < numKeys; i += 10)
+   {
+      snprintf(key, 128, "Key_unclean_%d", i);
+      snprintf(write, READ_SIZE, "DATA-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == strlen(write) && strcmp(read, write) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+   }
+   for (i = 0; i < numNewKeys; i++)
+   {
+      snprintf(key, 128, "Key_unclean_new_%d", i);
+      snprintf(write, READ_SIZE, "NEW-%d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handle, key, (char*) read, sizeof(read));
+      fail_unless(ret == strlen(write) && strcmp(read, write) == 0, "Wrong value read for key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+}
+END_TEST
+
+
+/*
+ * In this test, the access to databases through symlinks is tested
+ * the symlink named "/tmp/symlink" points to the folder "/tmp"
+ * The database file gets created under the path: "/tmp/symlink/symlink-localdb.db"
+ * Keys get written and must also be readable again if the database under the symlink is reopened.
+ */
+START_TEST(test_LinkedDatabase)
+{
+   int ret = 0;
+   int handle = 0;
+   unsigned char readBuffer[READ_SIZE] = { 0 };
+   char write2[READ_SIZE] = { 0 };
+   char key[128] = { 0 };
+   int i = 0;
+
+   //Cleaning up testdata folder
+   remove("/tmp/symlink-localdb.db");
+   remove("/tmp/symlink");
+
+   ret = symlink("/tmp","/tmp/symlink");
+   fail_unless(ret == 0, "Failed to create symlink /tmp/symlink: [%s]", strerror(errno));
+
+   handle = persComDbOpen("/tmp/symlink/symlink-localdb.db", 0x1); //create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", ret);
+
+   //write keys to cache
+   for(i=0; i< 50; i++)
+   {
+      snprintf(key, 128, "Key_in_loop_%d_%d",i,i*i);
+      memset(write2, 0, sizeof(write2));
+      snprintf(write2, 128, "DATA-%d-%d",i,i*i );
+      ret = persComDbWriteKey(handle, key, (char*) write2, strlen(write2));
+      fail_unless(ret == strlen(write2), "Wrong write size");
+   }
+
+   //Read keys from cache
+   for(i=0; i< 50; i++)
+   {
+      snprintf(key, 128, "Key_in_loop_%d_%d",i,i*i);
+      memset(write2, 0, sizeof(write2));
+      snprintf(write2, sizeof(write2), "DATA-%d-%d",i,i*i );
+      memset(readBuffer, 0, sizeof(readBuffer));
+      ret = persComDbReadKey(handle, key, (char*) readBuffer, sizeof(readBuffer));
+      fail_unless(ret == strlen(write2), "Wrong read size");
+      fail_unless(memcmp(readBuffer, write2, sizeof(readBuffer)) == 0, "Reading Data from Cache failed: Buffer not correctly read");
+   }
+
+   //persist changed data for this lifecycle
+   ret = persComDbClose(handle);
+   if (ret != 0)
+   {
+      printf("persComDbClose() failed: Cached Data was not written back: [%d] \n", ret);
+   }
+   fail_unless(ret == 0, "Failed to close cached database: retval: [%d]", ret);
+
+   //open database again
+   handle = persComDbOpen("/tmp/symlink/symlink-localdb.db", 0x1); //create test.db if not present
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", ret);
+
+   //Read keys from database file
+   for(i=0; i< 50; i++)
+   {
+      snprintf(key, 128, "Key_in_loop_%d_%d",i,i*i);
+      memset(write2, 0, sizeof(write2));
+      snprintf(write2, sizeof(write2), "DATA-%d-%d",i,i*i );
+      memset(readBuffer, 0, sizeof(readBuffer));
+      ret = persComDbReadKey(handle, key, (char*) readBuffer, sizeof(readBuffer));
+      fail_unless(ret == strlen(write2), "Wrong read size");
+      fail_unless(memcmp(readBuffer, write2, sizeof(readBuffer)) == 0, "Reading Data from File failed: Buffer not correctly read");
+   }
+
+   ret = persComDbClose(handle);
+   if (ret != 0)
+   {
+      printf("persComDbClose() failed: [%d] \n", ret);
+   }
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+}
+END_TEST
+
+
+
+
+/*
+ * Write a key value pair into the cache multiple times with same key but different data
+ * Then close the database in order to persist the data.
+ * After reopening the database, the last data written to cache must be returned for the key
+ */
+START_TEST(test_MultipleWrites)
+{
+   int ret = 0;
+   int handle = 0;
+   char write1[READ_SIZE] = { 0 };
+   char write2[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   char key[128] = { 0 };
+   int i =0;
+
+   //Cleaning up testdata folder
+   remove("/tmp/multiple-writes.db");
+
+#if 1
+
+   handle = persComDbOpen("/tmp/multiple-writes.db", 0x1); //create test.db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", ret);
+
+   //use same key for all writes and reads
+   snprintf(key, 128, "Key_in_loop_%d_%d",i,i*i);
+   snprintf(write1, 128, "%s", "1234567890");
+   snprintf(write2, 128, "%s", "12345");
+
+   //write 10 bytes to cache
+   ret = persComDbWriteKey(handle, key, (char*) write1, strlen(write1));
+   fail_unless(ret == strlen(write1) , "Wrong write size while inserting in cache");
+   //write 5 bytes to cache
+   ret = persComDbWriteKey(handle, key, (char*) write2, strlen(write2));
+   fail_unless(ret == strlen(write2) , "Wrong write size while inserting in cache");
+
+   //read must return 5 bytes from cache
+   ret = persComDbReadKey(handle, key, (char*) read, READ_SIZE);
+   //printf("Read from cache write 2: %s \n", read);
+   fail_unless(ret == strlen(write2), "Wrong read size while reading from cache!");
+   fail_unless(memcmp(read, write2, sizeof(write2)) == 0, "Reading Data from Cache failed: Buffer not correctly read!");
+
+   //write 10 bytes to cache
+   ret = persComDbWriteKey(handle, key, (char*) write1, strlen(write1));
+   fail_unless(ret == strlen(write1) , "Wrong write size while inserting in cache");
+
+   //read must return 10 bytes from cache
+   ret = persComDbReadKey(handle, key, (char*) read, READ_SIZE);
+   //printf("Read from cache write 1: %s \n", read);
+   fail_unless(ret == strlen(write1), "Wrong read size while reading from cache!");
+   fail_unless(memcmp(read, write1, sizeof(write1)) == 0, "Reading Data from Cache failed: Buffer not correctly read!");
+
+
+   //persist data in cache to file
+   ret = persComDbClose(handle);
+   if (ret != 0)
+   {
+      printf("persComDbClose() failed: [%d] \n", ret);
+   }
+   fail_unless(ret == 0, "Failed to close cached database: retval: [%d]", ret);
+
+
+   handle = persComDbOpen("/tmp/multiple-writes.db", 0x1); //create test.db if not present
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", ret);
+   //printf("open ok \n");
+
+   //read from database file
+   memset(read, 0, 1024);
+   ret = persComDbReadKey(handle, key, (char*) read, strlen(write1));
+   //printf("read: %d returns: %s \n", i, read);
+   fail_unless(ret == strlen(write1), "Wrong read size");
+   fail_unless(memcmp(read, write1, sizeof(write1)) == 0, "Reading Data from File failed: Buffer not correctly read");
+
+
+
+   ret = persComDbClose(handle);
+   if (ret != 0)
+   {
+      printf("persComDbClose() failed: [%d] \n", ret);
+   }
+   fail_unless(ret == 0, "Failed to close database file: retval: [%d]", ret);
+
+#endif
+}
+END_TEST
+
+
+
+START_TEST(test_WriteThrough)
+{
+   int pid;
+
+      //Cleaning up testdata folder
+      remove("/tmp/writethrough-concurrent.db");
+
+      pid = fork();
+      if (pid == 0)
+      {
+         DLT_REGISTER_APP("PCOt", "tests the persistence common object library");
+
+         /*child*/
+         //printf("Started child process with PID: [%d] \n", pid);
+         int handle = 0;
+         int ret = 0;
+         char childSysTimeBuffer[256] = { 0 };
+         char key[128] = { 0 };
+         char write2[READ_SIZE] = { 0 };
+         int i =0;
 
          createPidFile(getpid());
 
@@ -3682,6 +6597,165 @@ START_TEST(test_Compare_RCT)
 END_TEST
 
 
+
+
+/* value of key i of the version 2.x test database, written in round 0 and overwritten in the rounds 1 and 2 */
+static int getVersion2Value(int i, char* buffer)
+{
+   int round = (i % 6 == 0) ? 2 : (i % 3 == 0) ? 1 : 0;
+   int size = (i * 37 + round * 11) % 2000 + 1;
+   int j;
+
+   for (j = 0; j < size; j++)
+   {
+      buffer[j] = (char) ('a' + (i + round + j) % 26);
+   }
+   return size;
+}
+
+/*
+ * Database files of version 2.x (data blocks of fixed size) written by the former implementation:
+ * a read only open serves the keys of the unchanged file, a writable open converts the file to the current version.
+ * The local database has 600 keys in several hashtables, keys which were overwritten once and twice and deleted keys.
+ */
+START_TEST(test_OpenVersion2Database)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int size = 0;
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME] = { 0 };
+   char expected[PERS_DB_MAX_SIZE_KEY_DATA] = { 0 };
+   char read[PERS_DB_MAX_SIZE_KEY_DATA] = { 0 };
+
+   ret = doUncompress("/usr/local/var/kissdb_v2.tar.gz", "/tmp/");
+   fail_unless(ret == 0, "Failed to extract test data");
+   fail_unless(KISSDB_getFileVersion("/tmp/kissdb_v2/default-data.itz") == KISSDB_MAJOR_VERSION_2, "Test data is not of version 2.x");
+   fail_unless(KISSDB_getFileVersion("/tmp/kissdb_v2/local.db") == KISSDB_MAJOR_VERSION_2, "Test data is not of version 2.x");
+
+   //read only: the file is not converted
+   handle = persComDbOpen("/tmp/kissdb_v2/default-data.itz", 0x4);
+   fail_unless(handle >= 0, "Failed to open database of version 2.x read only: retval: [%d]", handle);
+   for (i = 0; i < 100; i++)
+   {
+      snprintf(key, sizeof(key), "default/key_%d", i);
+      snprintf(expected, sizeof(expected), "default value of key %d", i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      fail_unless(ret == (int) strlen(expected) + 1 && strcmp(read, expected) == 0, "Wrong value of key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbGetKeySize(handle, "default/key_100");
+   fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Key not in the database found: [%d]", ret);
+   ret = persComDbWriteKey(handle, "default/key_100", "new", 4);
+   fail_unless(ret < 0, "Write to a read only database of version 2.x succeeded: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   fail_unless(KISSDB_getFileVersion("/tmp/kissdb_v2/default-data.itz") == KISSDB_MAJOR_VERSION_2, "Read only database was converted");
+
+   //writable: the file is converted by the open
+   handle = persComDbOpen("/tmp/kissdb_v2/local.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open database of version 2.x: retval: [%d]", handle);
+   fail_unless(KISSDB_getFileVersion("/tmp/kissdb_v2/local.db") == KISSDB_MAJOR_VERSION, "Database was not converted");
+   fail_unless(access("/tmp/kissdb_v2/local.db.convert", F_OK) == -1, "Temporary file of the conversion not removed");
+   for (i = 0; i < 600; i++)
+   {
+      snprintf(key, sizeof(key), "v2/key_%d", i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      if (i % 7 == 0)
+      {
+         fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key [%s] found: [%d]", key, ret);
+         continue;
+      }
+      size = getVersion2Value(i, expected);
+      fail_unless(ret == size && memcmp(read, expected, size) == 0, "Wrong value of key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbWriteKey(handle, "v2/key_0", "new value", 10);
+   fail_unless(ret == 10, "Failed to write to converted database: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/kissdb_v2/local.db", 0x0);
+   fail_unless(handle >= 0, "Failed to reopen converted database: retval: [%d]", handle);
+   ret = persComDbGetSizeKeysList(handle);
+   fail_unless(ret > 0, "Failed to get the size of the key list: [%d]", ret);
+   ret = persComDbReadKey(handle, "v2/key_0", read, sizeof(read));
+   fail_unless(ret == 10 && strcmp(read, "new value") == 0, "Wrong value of key written after the conversion: [%d]", ret);
+   size = getVersion2Value(599, expected);
+   ret = persComDbReadKey(handle, "v2/key_599", read, sizeof(read));
+   fail_unless(ret == size && memcmp(read, expected, size) == 0, "Wrong value of converted key after reopen: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+
+/*
+ * Frozen images built from database files of version 2.x (what pers_frozen_db_builder does for baseline .itz files):
+ * the keys are read with the reader of version 2.x, the source files stay unchanged.
+ */
+START_TEST(test_FrozenVersion2Database)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int size = 0;
+   FROZENDB frozenDb;
+   const void* value = NULL;
+   uint32_t valueSize = 0;
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME] = { 0 };
+   char expected[PERS_DB_MAX_SIZE_KEY_DATA] = { 0 };
+   char read[PERS_DB_MAX_SIZE_KEY_DATA] = { 0 };
+
+   ret = doUncompress("/usr/local/var/kissdb_v2.tar.gz", "/tmp/");
+   fail_unless(ret == 0, "Failed to extract test data");
+   remove("/tmp/kissdb_v2/default-data.frz");
+   remove("/tmp/kissdb_v2/local.frz");
+
+   ret = FROZENDB_buildFromVersion2("/tmp/kissdb_v2/default-data.frz", "/tmp/kissdb_v2/default-data.itz");
+   fail_unless(ret == 100, "Failed to build frozen image of version 2.x file: [%d]", ret);
+   fail_unless(KISSDB_getFileVersion("/tmp/kissdb_v2/default-data.itz") == KISSDB_MAJOR_VERSION_2, "Source file was modified");
+   handle = persComDbOpen("/tmp/kissdb_v2/default-data.frz", 0x4);
+   fail_unless(handle >= 0, "Failed to open frozen image: retval: [%d]", handle);
+   for (i = 0; i < 100; i++)
+   {
+      snprintf(key, sizeof(key), "default/key_%d", i);
+      snprintf(expected, sizeof(expected), "default value of key %d", i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      fail_unless(ret == (int) strlen(expected) + 1 && strcmp(read, expected) == 0, "Wrong value of key [%s]: [%d]", key, ret);
+   }
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close frozen image: retval: [%d]", ret);
+
+   //overwritten and deleted keys in several hashtables
+   ret = FROZENDB_buildFromVersion2("/tmp/kissdb_v2/local.frz", "/tmp/kissdb_v2/local.db");
+   fail_unless(ret == 514, "Failed to build frozen image of version 2.x file: [%d]", ret);
+   fail_unless(KISSDB_getFileVersion("/tmp/kissdb_v2/local.db") == KISSDB_MAJOR_VERSION_2, "Source file was modified");
+   ret = FROZENDB_open(&frozenDb, "/tmp/kissdb_v2/local.frz");
+   fail_unless(ret == 0, "Failed to open frozen image: [%d]", ret);
+   fail_unless(frozenDb.header->keyCount == 514, "Wrong number of keys in frozen image: [%u]", frozenDb.header->keyCount);
+   for (i = 0; i < 600; i++)
+   {
+      snprintf(key, sizeof(key), "v2/key_%d", i);
+      ret = FROZENDB_get(&frozenDb, key, &value, &valueSize);
+      if (i % 7 == 0)
+      {
+         fail_unless(ret == 1, "Deleted key [%s] found: [%d]", key, ret);
+         continue;
+      }
+      size = getVersion2Value(i, expected);
+      fail_unless(ret == 0 && valueSize == (uint32_t) size && memcmp(value, expected, size) == 0, "Wrong value of key [%s]: [%d]", key, ret);
+   }
+   FROZENDB_close(&frozenDb);
+
+   //not of version 2.x
+   ret = FROZENDB_buildFromVersion2("/tmp/kissdb_v2/local2.frz", "/tmp/kissdb_v2/local.frz");
+   fail_unless(ret == FROZENDB_ERROR_INVALID_PARAMETERS, "Frozen image built from a file not of version 2.x: [%d]", ret);
+   fail_unless(access("/tmp/kissdb_v2/local2.frz", F_OK) == -1, "Frozen image written for a file not of version 2.x");
+}
+END_TEST
+
+
 static Suite* persistenceCommonLib_suite()
 {
    Suite* s = suite_create("Persistence-common-object-test");
@@ -3746,6 +6820,124 @@ static Suite* persistenceCommonLib_suite()
    TCase* tc_RecoverDatablocks = tcase_create("RecoverDatablocks");
    tcase_add_test(tc_RecoverDatablocks, test_RecoverDatablocks);
 
+   TCase* tc_ChecksumUnusedValueArea = tcase_create("ChecksumUnusedValueArea");
+   tcase_add_test(tc_ChecksumUnusedValueArea, test_ChecksumUnusedValueArea);
+
+   TCase* tc_ChecksumAlgorithmOfFile = tcase_create("ChecksumAlgorithmOfFile");
+   tcase_add_test(tc_ChecksumAlgorithmOfFile, test_ChecksumAlgorithmOfFile);
+
+   TCase* tc_UpdateSingleDataBlock = tcase_create("UpdateSingleDataBlock");
+   tcase_add_test(tc_UpdateSingleDataBlock, test_UpdateSingleDataBlock);
+   tcase_set_timeout(tc_UpdateSingleDataBlock, 60);
+
+   TCase* tc_RecoverFromCheckpoint = tcase_create("RecoverFromCheckpoint");
+   tcase_add_test(tc_RecoverFromCheckpoint, test_RecoverFromCheckpoint);
+   tcase_set_timeout(tc_RecoverFromCheckpoint, 60);
+
+   TCase* tc_LargeValues = tcase_create("LargeValues");
+   tcase_add_test(tc_LargeValues, test_LargeValues);
+   tcase_set_timeout(tc_LargeValues, 60);
+
+   TCase* tc_CompactRctDataBlocks = tcase_create("CompactRctDataBlocks");
+   tcase_add_test(tc_CompactRctDataBlocks, test_CompactRctDataBlocks);
+   tcase_set_timeout(tc_CompactRctDataBlocks, 60);
+
+   TCase* tc_InlineSmallValues = tcase_create("InlineSmallValues");
+   tcase_add_test(tc_InlineSmallValues, test_InlineSmallValues);
+   tcase_set_timeout(tc_InlineSmallValues, 60);
+
+   TCase* tc_CompressedValues = tcase_create("CompressedValues");
+   tcase_add_test(tc_CompressedValues, test_CompressedValues);
+   tcase_set_timeout(tc_CompressedValues, 60);
+
+   TCase* tc_ParallelRecovery = tcase_create("ParallelRecovery");
+   tcase_add_test(tc_ParallelRecovery, test_ParallelRecovery);
+   tcase_set_timeout(tc_ParallelRecovery, 60);
+
+   TCase* tc_LazyHashtables = tcase_create("LazyHashtables");
+   tcase_add_test(tc_LazyHashtables, test_LazyHashtables);
+   tcase_set_timeout(tc_LazyHashtables, 60);
+
+   TCase* tc_LazyHashtableInvalidLink = tcase_create("LazyHashtableInvalidLink");
+   tcase_add_test(tc_LazyHashtableInvalidLink, test_LazyHashtableInvalidLink);
+   tcase_set_timeout(tc_LazyHashtableInvalidLink, 60);
+
+   TCase* tc_CloseWritesOnlyModifiedHashtables = tcase_create("CloseWritesOnlyModifiedHashtables");
+   tcase_add_test(tc_CloseWritesOnlyModifiedHashtables, test_CloseWritesOnlyModifiedHashtables);
+   tcase_set_timeout(tc_CloseWritesOnlyModifiedHashtables, 60);
+
+   TCase* tc_FrozenDatabase = tcase_create("FrozenDatabase");
+   tcase_add_test(tc_FrozenDatabase, test_FrozenDatabase);
+   tcase_set_timeout(tc_FrozenDatabase, 60);
+
+   TCase* tc_ReadKeyView = tcase_create("ReadKeyView");
+   tcase_add_test(tc_ReadKeyView, test_ReadKeyView);
+   tcase_set_timeout(tc_ReadKeyView, 60);
+
+   TCase* tc_ReadKeyViewEndedProcess = tcase_create("ReadKeyViewEndedProcess");
+   tcase_add_test(tc_ReadKeyViewEndedProcess, test_ReadKeyViewEndedProcess);
+   tcase_set_timeout(tc_ReadKeyViewEndedProcess, 60);
+
+   TCase* tc_WriteKeys = tcase_create("WriteKeys");
+   tcase_add_test(tc_WriteKeys, test_WriteKeys);
+   tcase_set_timeout(tc_WriteKeys, 60);
+
+   TCase* tc_ReadKeys = tcase_create("ReadKeys");
+   tcase_add_test(tc_ReadKeys, test_ReadKeys);
+   tcase_set_timeout(tc_ReadKeys, 60);
+
+   TCase* tc_KeyCursor = tcase_create("KeyCursor");
+   tcase_add_test(tc_KeyCursor, test_KeyCursor);
+   tcase_set_timeout(tc_KeyCursor, 60);
+
+   TCase* tc_KeyCursorWrites = tcase_create("KeyCursorWrites");
+   tcase_add_test(tc_KeyCursorWrites, test_KeyCursorWrites);
+   tcase_set_timeout(tc_KeyCursorWrites, 60);
+
+   TCase* tc_KeyListSize = tcase_create("KeyListSize");
+   tcase_add_test(tc_KeyListSize, test_KeyListSize);
+   tcase_set_timeout(tc_KeyListSize, 60);
+
+   TCase* tc_CacheValueSizes = tcase_create("CacheValueSizes");
+   tcase_add_test(tc_CacheValueSizes, test_CacheValueSizes);
+   tcase_set_timeout(tc_CacheValueSizes, 60);
+
+   TCase* tc_CacheShrinkThenGrow = tcase_create("CacheShrinkThenGrow");
+   tcase_add_test(tc_CacheShrinkThenGrow, test_CacheShrinkThenGrow);
+   tcase_set_timeout(tc_CacheShrinkThenGrow, 60);
+
+   TCase* tc_GrowHashIndex = tcase_create("GrowHashIndex");
+   tcase_add_test(tc_GrowHashIndex, test_GrowHashIndex);
+   tcase_set_timeout(tc_GrowHashIndex, 60);
+
+   TCase* tc_LookupSlotKeyFields = tcase_create("LookupSlotKeyFields");
+   tcase_add_test(tc_LookupSlotKeyFields, test_LookupSlotKeyFields);
+   tcase_set_timeout(tc_LookupSlotKeyFields, 60);
+
+   TCase* tc_SharedPrefixKeys = tcase_create("SharedPrefixKeys");
+   tcase_add_test(tc_SharedPrefixKeys, test_SharedPrefixKeys);
+   tcase_set_timeout(tc_SharedPrefixKeys, 60);
+
+   TCase* tc_KeyHashAlgorithmOfFile = tcase_create("KeyHashAlgorithmOfFile");
+   tcase_add_test(tc_KeyHashAlgorithmOfFile, test_KeyHashAlgorithmOfFile);
+   tcase_set_timeout(tc_KeyHashAlgorithmOfFile, 60);
+
+   TCase* tc_CompactDatabase = tcase_create("CompactDatabase");
+   tcase_add_test(tc_CompactDatabase, test_CompactDatabase);
+   tcase_set_timeout(tc_CompactDatabase, 60);
+
+   TCase* tc_CompactionInterrupted = tcase_create("CompactionInterrupted");
+   tcase_add_test(tc_CompactionInterrupted, test_CompactionInterrupted);
+   tcase_set_timeout(tc_CompactionInterrupted, 60);
+
+   TCase* tc_ReuseDeletedDataBlocks = tcase_create("ReuseDeletedDataBlocks");
+   tcase_add_test(tc_ReuseDeletedDataBlocks, test_ReuseDeletedDataBlocks);
+   tcase_set_timeout(tc_ReuseDeletedDataBlocks, 60);
+
+   TCase* tc_UncleanExitPreallocatedArea = tcase_create("UncleanExitPreallocatedArea");
+   tcase_add_test(tc_UncleanExitPreallocatedArea, test_UncleanExitPreallocatedArea);
+   tcase_set_timeout(tc_UncleanExitPreallocatedArea, 60);
+
    TCase* tc_LinkedDatabase = tcase_create("LinkedDatabase");
    tcase_add_test(tc_LinkedDatabase, test_LinkedDatabase);
 
@@ -3766,6 +6958,14 @@ static Suite* persistenceCommonLib_suite()
    TCase* tc_Compare_RCT = tcase_create("Compare_RCT");
    tcase_add_test(tc_Compare_RCT, test_Compare_RCT);
 
+   TCase* tc_OpenVersion2Database = tcase_create("OpenVersion2Database");
+   tcase_add_test(tc_OpenVersion2Database, test_OpenVersion2Database);
+   tcase_set_timeout(tc_OpenVersion2Database, 60);
+
+   TCase* tc_FrozenVersion2Database = tcase_create("FrozenVersion2Database");
+   tcase_add_test(tc_FrozenVersion2Database, test_FrozenVersion2Database);
+   tcase_set_timeout(tc_FrozenVersion2Database, 60);
+
 #if 1
    suite_add_tcase(s, tc_persOpenLocalDB);
    tcase_add_checked_fixture(tc_persOpenLocalDB, data_setup, data_teardown);
@@ -3823,6 +7023,96 @@ static Suite* persistenceCommonLib_suite()
    suite_add_tcase(s, tc_RecoverDatablocks); //add test for writethrough (writeback order is different when using cache)
    tcase_add_checked_fixture(tc_RecoverDatablocks, data_setup, data_teardown);
 
+   suite_add_tcase(s, tc_ChecksumUnusedValueArea);
+   tcase_add_checked_fixture(tc_ChecksumUnusedValueArea, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_ChecksumAlgorithmOfFile);
+   tcase_add_checked_fixture(tc_ChecksumAlgorithmOfFile, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_UpdateSingleDataBlock);
+   tcase_add_checked_fixture(tc_UpdateSingleDataBlock, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_RecoverFromCheckpoint);
+   tcase_add_checked_fixture(tc_RecoverFromCheckpoint, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_LargeValues);
+   tcase_add_checked_fixture(tc_LargeValues, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_CompactRctDataBlocks);
+   tcase_add_checked_fixture(tc_CompactRctDataBlocks, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_InlineSmallValues);
+   tcase_add_checked_fixture(tc_InlineSmallValues, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_CompressedValues);
+   tcase_add_checked_fixture(tc_CompressedValues, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_ParallelRecovery);
+   tcase_add_checked_fixture(tc_ParallelRecovery, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_LazyHashtables);
+   tcase_add_checked_fixture(tc_LazyHashtables, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_LazyHashtableInvalidLink);
+   tcase_add_checked_fixture(tc_LazyHashtableInvalidLink, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_CloseWritesOnlyModifiedHashtables);
+   tcase_add_checked_fixture(tc_CloseWritesOnlyModifiedHashtables, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_FrozenDatabase);
+   tcase_add_checked_fixture(tc_FrozenDatabase, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_ReadKeyView);
+   tcase_add_checked_fixture(tc_ReadKeyView, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_ReadKeyViewEndedProcess);
+   tcase_add_checked_fixture(tc_ReadKeyViewEndedProcess, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_WriteKeys);
+   tcase_add_checked_fixture(tc_WriteKeys, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_ReadKeys);
+   tcase_add_checked_fixture(tc_ReadKeys, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_KeyCursor);
+   tcase_add_checked_fixture(tc_KeyCursor, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_KeyCursorWrites);
+   tcase_add_checked_fixture(tc_KeyCursorWrites, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_KeyListSize);
+   tcase_add_checked_fixture(tc_KeyListSize, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_CacheValueSizes);
+   tcase_add_checked_fixture(tc_CacheValueSizes, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_CacheShrinkThenGrow);
+   tcase_add_checked_fixture(tc_CacheShrinkThenGrow, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_GrowHashIndex);
+   tcase_add_checked_fixture(tc_GrowHashIndex, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_LookupSlotKeyFields);
+   tcase_add_checked_fixture(tc_LookupSlotKeyFields, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_SharedPrefixKeys);
+   tcase_add_checked_fixture(tc_SharedPrefixKeys, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_KeyHashAlgorithmOfFile);
+   tcase_add_checked_fixture(tc_KeyHashAlgorithmOfFile, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_CompactDatabase);
+   tcase_add_checked_fixture(tc_CompactDatabase, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_CompactionInterrupted);
+   tcase_add_checked_fixture(tc_CompactionInterrupted, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_ReuseDeletedDataBlocks);
+   tcase_add_checked_fixture(tc_ReuseDeletedDataBlocks, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_UncleanExitPreallocatedArea);
+   tcase_add_checked_fixture(tc_UncleanExitPreallocatedArea, data_setup, data_teardown);
+
    suite_add_tcase(s, tc_LinkedDatabase);
    tcase_add_checked_fixture(tc_LinkedDatabase, data_setup, data_teardown);
 
@@ -3838,6 +7128,12 @@ static Suite* persistenceCommonLib_suite()
    suite_add_tcase(s, tc_AddKey_DeleteKey_AddShorterKeyName);
 
    suite_add_tcase(s, tc_Compare_RCT);
+
+   suite_add_tcase(s, tc_OpenVersion2Database);
+   tcase_add_checked_fixture(tc_OpenVersion2Database, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_FrozenVersion2Database);
+   tcase_add_checked_fixture(tc_FrozenVersion2Database, data_setup, data_teardown);
 #else
 
 